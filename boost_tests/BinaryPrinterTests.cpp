@@ -4,6 +4,12 @@
 
 #include "PetriEngine/PQL/Expressions.h"
 #include "PetriEngine/PQL/BinaryPrinter.h"
+#include "utils.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
 
 
 using namespace PetriEngine::PQL;
@@ -12,6 +18,113 @@ BOOST_AUTO_TEST_CASE(Dummy) {
     BOOST_REQUIRE(true);
 }
 
+BOOST_AUTO_TEST_CASE(BinaryQueryRoundTrip) {
+    // queries written by --binary-query-io 2 are read back by --binary-query-io 1, decoding only those selected by -x
+    std::set<size_t> all;
+    for (size_t i = 0; i < 16; ++i)
+        all.insert(i);
+    auto [conditions, builder, qstrings, trans_names, place_names] = load_builder("/models/Angiogenesis-PT-01/model.pnml",
+        "/models/Angiogenesis-PT-01/ReachabilityCardinality.xml", all);
+    BOOST_REQUIRE_EQUAL(conditions.size(), all.size());
+    std::vector<uint32_t> order(conditions.size());
+    std::iota(order.begin(), order.end(), 0);
+    auto path = (std::filesystem::temp_directory_path() / "verifypn_binary_query_test.bin").string();
+    writeQueries(conditions, qstrings, order, path, true, builder.getPlaceNames(), true);
+
+    auto text = [](const Condition_ptr& c) {
+        std::stringstream ss;
+        c->toString(ss);
+        return ss.str();
+    };
+    auto read = [&](const std::set<size_t>& selected) {
+        shared_string_set sset;
+        std::vector<std::string> names;
+        auto read = parseXMLQueries(sset, names, path, selected, true);
+        BOOST_REQUIRE_EQUAL(read.size(), selected.size());
+        BOOST_REQUIRE_EQUAL(names.size(), selected.size());
+        size_t k = 0;
+        for (auto i : selected) {
+            BOOST_REQUIRE_EQUAL(names[k], qstrings[i]);
+            BOOST_REQUIRE_EQUAL(text(read[k]), text(conditions[i]));
+            ++k;
+        }
+    };
+    read(all);
+    read({2, 7, 15});
+
+    // with the last query cut short, only selecting it fails, as the others are found through the offsets
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+    read({0, 2, 7, 14});
+    BOOST_REQUIRE_THROW(read({15}), base_error);
+    std::filesystem::remove(path);
+}
+
+
+BOOST_AUTO_TEST_CASE(BinaryQueryUnindexedLayout) {
+    // files written before the indexed container, without magic and offsets, are still read
+    std::set<size_t> all;
+    for (size_t i = 0; i < 16; ++i)
+        all.insert(i);
+    auto [conditions, builder, qstrings, trans_names, place_names] = load_builder("/models/Angiogenesis-PT-01/model.pnml",
+        "/models/Angiogenesis-PT-01/ReachabilityCardinality.xml", all);
+    std::vector<uint32_t> order(conditions.size());
+    std::iota(order.begin(), order.end(), 0);
+    auto path = (std::filesystem::temp_directory_path() / "verifypn_binary_query_unindexed.bin").string();
+    writeQueries(conditions, qstrings, order, path, true, builder.getPlaceNames(), true);
+
+    // rewrite the container in the old layout; the records of the queries are unchanged
+    std::string data;
+    {
+        std::ifstream in(path, std::ios::binary);
+        data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    std::string old;
+    size_t pos = sizeof(binary_query_magic);
+    auto read_u32 = [&]() {
+        uint32_t v;
+        std::memcpy(&v, data.data() + pos, sizeof(v));
+        pos += sizeof(v);
+        return v;
+    };
+    auto write_u32 = [&](uint32_t v) { old.append(reinterpret_cast<const char*>(&v), sizeof(v)); };
+    uint32_t numq = read_u32();
+    uint32_t nnames = read_u32();
+    write_u32(numq);
+    write_u32(nnames);
+    for (uint32_t i = 0; i < nnames; ++i) {
+        write_u32(read_u32());
+        uint32_t length = read_u32();
+        old.append(data, pos, length);
+        old.push_back('\0');
+        pos += length;
+    }
+    pos += (numq + 1) * sizeof(uint64_t);
+    old.append(data, pos, std::string::npos);
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(old.data(), old.size());
+    }
+
+    auto text = [](const Condition_ptr& c) {
+        std::stringstream ss;
+        c->toString(ss);
+        return ss.str();
+    };
+    for (const std::set<size_t>& selected : {all, std::set<size_t>{3, 11}}) {
+        shared_string_set sset;
+        std::vector<std::string> names;
+        auto read = parseXMLQueries(sset, names, path, selected, true);
+        BOOST_REQUIRE_EQUAL(read.size(), selected.size());
+        size_t k = 0;
+        for (auto i : selected) {
+            BOOST_REQUIRE_EQUAL(names[k], qstrings[i]);
+            BOOST_REQUIRE_EQUAL(text(read[k]), text(conditions[i]));
+            ++k;
+        }
+    }
+    std::filesystem::remove(path);
+}
+
 
 //BOOST_AUTO_TEST_CASE(AirplaneLD_PT_0050_x3) {
 //    auto identifier = std::make_shared<IdentifierExpr>("a");
@@ -0,0 +1,123 @@
+/* Copyright (C) 2021 Peter G. Jensen <root@petergjoel.dk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define BOOST_TEST_MODULE PNMLParserTests
+
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "PetriEngine/AbstractPetriNetBuilder.h"
+#include "PetriParse/PNMLParser.h"
+#include "PetriParse/PNMLStreamParser.h"
+#include "utils/mapped_file.h"
+
+using namespace PetriEngine;
+
+// records everything a parser passes to the builder, in an order independent form
+class RecordingBuilder : public AbstractPetriNetBuilder {
+public:
+    void addPlace(const std::string& name, uint32_t tokens, double x, double y) override {
+        record("place ", name, " ", tokens, " ", x, " ", y);
+    }
+    void addTransition(const std::string& name, int32_t player, double x, double y) override {
+        record("transition ", name, " ", player, " ", x, " ", y);
+    }
+    void addInputArc(const std::string& place, const std::string& transition, bool inhibitor, uint32_t weight) override {
+        record("in ", place, " ", transition, " ", inhibitor, " ", weight);
+    }
+    void addOutputArc(const std::string& transition, const std::string& place, uint32_t weight) override {
+        record("out ", transition, " ", place, " ", weight);
+    }
+    void sort() override {}
+
+    std::vector<std::string> entries() const {
+        auto sorted = _entries;
+        std::sort(sorted.begin(), sorted.end());
+        return sorted;
+    }
+
+private:
+    template<typename... Args>
+    void record(Args&&... args) {
+        std::stringstream ss;
+        (ss << ... << args);
+        _entries.push_back(ss.str());
+    }
+
+    std::vector<std::string> _entries;
+};
+
+// @return false if the stream parser leaves the model to the DOM parser, i.e. it is colored
+bool compare_parsers(const std::string& path) {
+    RecordingBuilder streamed;
+    mapped_file file(path);
+    if (!PNMLStreamParser().parse(file.data(), file.size(), &streamed))
+        return false;
+    RecordingBuilder dom;
+    std::ifstream in(path);
+    PNMLParser().parse(in, &dom);
+    BOOST_REQUIRE_EQUAL(dom.isColored(), false);
+    const auto expected = dom.entries();
+    const auto actual = streamed.entries();
+    BOOST_REQUIRE(!expected.empty());
+    BOOST_CHECK_EQUAL_COLLECTIONS(expected.begin(), expected.end(), actual.begin(), actual.end());
+    return true;
+}
+
+BOOST_AUTO_TEST_CASE(DirectoryTest) {
+    BOOST_REQUIRE(getenv("TEST_FILES"));
+}
+
+BOOST_AUTO_TEST_CASE(StreamParserMatchesDOMParser) {
+    size_t compared = 0;
+    for (auto& entry : std::filesystem::recursive_directory_iterator(std::string(getenv("TEST_FILES")) + "/models")) {
+        if (!entry.is_regular_file() || entry.path().extension() != ".pnml")
+            continue;
+        BOOST_TEST_MESSAGE(entry.path().string());
+        compared += compare_parsers(entry.path().string());
+    }
+    BOOST_REQUIRE_GT(compared, 0);
+}
+
+BOOST_AUTO_TEST_CASE(StreamParserEntitiesCDATAAndForwardArcs) {
+    // inhibitor and transport arcs to nodes declared later, entity references in ids and CDATA in values
+    const auto path = std::string(getenv("TEST_FILES")) + "/models/pnml_stream.pnml";
+    BOOST_REQUIRE(compare_parsers(path));
+
+    RecordingBuilder streamed;
+    mapped_file file(path);
+    BOOST_REQUIRE(PNMLStreamParser().parse(file.data(), file.size(), &streamed));
+    const std::vector<std::string> expected{
+        "in p&1 tA 0 2",
+        "in p&1 tB 0 5",
+        "in p3 tA 1 4",
+        "in p<2> tB 1 3",
+        "out tA p<2> 1",
+        "out tB p&1 8",
+        "out tB p3 5",
+        "place p&1 6 10 20",
+        "place p3 0 0 0",
+        "place p<2> 1 0 0",
+        "transition tA 0 50.5 60.5",
+        "transition tB 1 0 0"};
+    const auto actual = streamed.entries();
+    BOOST_CHECK_EQUAL_COLLECTIONS(expected.begin(), expected.end(), actual.begin(), actual.end());
+}
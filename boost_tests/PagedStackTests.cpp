@@ -0,0 +1,127 @@
+/* Copyright (C) 2021 Peter G. Jensen <root@petergjoel.dk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define BOOST_TEST_MODULE PagedStackTests
+
+#include <boost/test/unit_test.hpp>
+#include <cstdint>
+
+#include "utils/structures/paged_stack.h"
+
+// small pages so that a few hundred elements span many of them
+constexpr size_t page = 16;
+using stack_t = paged_stack<uint64_t, page>;
+
+// distinct values, so a page read back from the wrong place in the file is noticed
+static uint64_t value(size_t i) {
+    return i * 2654435761u + 1;
+}
+
+BOOST_AUTO_TEST_CASE(UnboundedNeverPagesOut) {
+    stack_t stack;
+    for (size_t i = 0; i < 40 * page; ++i)
+        stack.push_back(value(i));
+    for (size_t i = 0; i < stack.size(); ++i)
+        BOOST_REQUIRE_EQUAL(stack[i], value(i));
+    while (!stack.empty()) {
+        BOOST_REQUIRE_EQUAL(stack.back(), value(stack.size() - 1));
+        stack.pop_back();
+    }
+    BOOST_REQUIRE_EQUAL(stack.page_outs(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(EvictsLeastRecentlyUsed) {
+    // a bound below one page still keeps the minimum of four pages resident
+    stack_t stack(1);
+    for (size_t i = 0; i < 4 * page; ++i)
+        stack.push_back(value(i));
+    BOOST_REQUIRE_EQUAL(stack.page_outs(), 0);
+
+    // a fifth page evicts the first one
+    stack.push_back(value(4 * page));
+    BOOST_REQUIRE_EQUAL(stack.page_outs(), 1);
+
+    // reading the first page back evicts the second, now the least recently used; reading that back evicts the third
+    BOOST_REQUIRE_EQUAL(stack[0], value(0));
+    BOOST_REQUIRE_EQUAL(stack.page_outs(), 2);
+    BOOST_REQUIRE_EQUAL(stack[page], value(page));
+    BOOST_REQUIRE_EQUAL(stack.page_outs(), 3);
+
+    // pages that are resident are read without paging anything out
+    BOOST_REQUIRE_EQUAL(stack[0], value(0));
+    BOOST_REQUIRE_EQUAL(stack[3 * page], value(3 * page));
+    BOOST_REQUIRE_EQUAL(stack.page_outs(), 3);
+
+    // the fifth page is now the least recently used, so reading the third back evicts it
+    BOOST_REQUIRE_EQUAL(stack[2 * page], value(2 * page));
+    BOOST_REQUIRE_EQUAL(stack.page_outs(), 4);
+    BOOST_REQUIRE_EQUAL(stack.back(), value(4 * page));
+    BOOST_REQUIRE_EQUAL(stack.page_outs(), 5);
+}
+
+BOOST_AUTO_TEST_CASE(WritesThroughReferencesSurvivePaging) {
+    stack_t stack(1);
+    for (size_t i = 0; i < 10 * page; ++i)
+        stack.push_back(value(i));
+    // modify an element of every page, each time paging others out
+    for (size_t p = 0; p < 10; ++p)
+        stack[p * page + 3] = value(p) + 7;
+    BOOST_REQUIRE_GT(stack.page_outs(), 10);
+    for (size_t p = 10; p-- > 0;)
+        BOOST_REQUIRE_EQUAL(stack[p * page + 3], value(p) + 7);
+}
+
+BOOST_AUTO_TEST_CASE(PushPopPastResidentPages) {
+    stack_t stack(1);
+    const size_t n = 25 * page + 5;
+    for (size_t i = 0; i < n; ++i)
+        stack.push_back(value(i));
+    BOOST_REQUIRE_EQUAL(stack.size(), n);
+    BOOST_REQUIRE_EQUAL(stack.page_outs(), 26 - 4);
+
+    // popping everything reads the pages back from the file, last page out first in
+    for (size_t i = n; i-- > 0;) {
+        BOOST_REQUIRE_EQUAL(stack.back(), value(i));
+        stack.pop_back();
+    }
+    BOOST_REQUIRE(stack.empty());
+
+    // emptied pages are dropped with their copy on disk, so pushing again never reads stale elements
+    for (size_t i = 0; i < n; ++i)
+        stack.push_back(value(n - i));
+    for (size_t i = 0; i < n; ++i)
+        BOOST_REQUIRE_EQUAL(stack[i], value(n - i));
+}
+
+BOOST_AUTO_TEST_CASE(OscillatingAtPageBoundary) {
+    stack_t stack(1);
+    for (size_t i = 0; i < 8 * page; ++i)
+        stack.push_back(value(i));
+    BOOST_REQUIRE_EQUAL(stack[0], value(0));
+    const auto page_outs = stack.page_outs();
+
+    // the first push onto a new page evicts one; from then on emptying the top page frees its slot among the
+    // resident ones, and pushing refills it from the spare buffer without paging anything out
+    for (size_t k = 0; k < 100; ++k) {
+        stack.push_back(value(8 * page));
+        BOOST_REQUIRE_EQUAL(stack.back(), value(8 * page));
+        stack.pop_back();
+        BOOST_REQUIRE_EQUAL(stack.back(), value(8 * page - 1));
+    }
+    BOOST_REQUIRE_EQUAL(stack.page_outs(), page_outs + 1);
+    for (size_t i = 8 * page; i-- > 0;)
+        BOOST_REQUIRE_EQUAL(stack[i], value(i));
+}
@@ -26,6 +26,12 @@
 
 #include "utils.h"
 #include "PetriEngine/Colored/PnmlWriter.h"
+#include "PetriEngine/Colored/ColoredExplorer.h"
+#include "PetriEngine/Structures/StateSymmetry.h"
+#include "PetriEngine/Colored/BindingGenerator.h"
+#include "PetriEngine/Colored/CompiledExpression.h"
+#include "PetriEngine/Colored/EvaluationVisitor.h"
+#include "PetriEngine/Colored/VariableVisitor.h"
 
 using namespace PetriEngine;
 using namespace PetriEngine::Colored;
@@ -571,3 +577,273 @@ BOOST_AUTO_TEST_CASE(TokenRingAll2, * utf::timeout(2)) {
         }
     }
 }
+
+BOOST_AUTO_TEST_CASE(PetersonCOL2ColoredExploration, * utf::timeout(100)) {
+
+    std::string model("/models/Peterson-COL-2/model.pnml");
+    std::string query("/models/Peterson-COL-2/ReachabilityCardinality.xml");
+    std::vector<ColoredExplorer::Result> expected{
+        ColoredExplorer::Result::Satisfied,
+        ColoredExplorer::Result::NotSatisfied,
+        ColoredExplorer::Result::NotSatisfied,
+        ColoredExplorer::Result::Satisfied,
+        ColoredExplorer::Result::Satisfied,
+        ColoredExplorer::Result::Satisfied,
+        ColoredExplorer::Result::NotSatisfied,
+        ColoredExplorer::Result::Satisfied,
+        ColoredExplorer::Result::Satisfied,
+        ColoredExplorer::Result::NotSatisfied,
+        ColoredExplorer::Result::Satisfied,
+        ColoredExplorer::Result::NotSatisfied,
+        ColoredExplorer::Result::NotSatisfied,
+        ColoredExplorer::Result::NotSatisfied,
+        ColoredExplorer::Result::NotSatisfied,
+        ColoredExplorer::Result::Satisfied};
+    std::set<size_t> qnums{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15};
+    for(auto reduce : {false, true})
+    {
+        for(auto strategy : {Strategy::DFS, Strategy::BFS})
+        {
+            std::cerr << "\t" << model << ", " << query << std::boolalpha << " reduce=" << reduce << " bfs=" << (strategy == Strategy::BFS) << std::endl;
+            shared_string_set sset;
+            ColoredPetriNetBuilder cpnBuilder(sset);
+            auto f = loadFile(model.c_str());
+            cpnBuilder.parse_model(f);
+            auto q = loadFile(query.c_str());
+            std::vector<std::string> qstrings;
+            auto conditions = parseXMLQueries(sset, qstrings, q, qnums, false);
+            std::vector<uint32_t> reductions {};
+            reduceColored(cpnBuilder, conditions, TemporalLogic::CTL, 5, std::cerr, reduce ? 1 : 0, reductions);
+            ColoredExplorer explorer(cpnBuilder);
+            for(auto i : qnums)
+            {
+                std::cerr << "\t\tQ[" << i << "] " << std::endl;
+                BOOST_REQUIRE(explorer.supports(conditions[i]));
+                BOOST_REQUIRE(expected[i] == explorer.check(conditions[i], strategy, false, 60));
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ColoredExplorationOverflow, * utf::timeout(60)) {
+    // the initial marking holds 40000 distinct colors, more than a stored colored marking can encode
+    std::string model("/models/colored_overflow.pnml");
+    std::string query("/models/colored_overflow.xml");
+    std::set<size_t> qnums{0};
+    shared_string_set sset;
+    ColoredPetriNetBuilder cpnBuilder(sset);
+    auto f = loadFile(model.c_str());
+    cpnBuilder.parse_model(f);
+    auto q = loadFile(query.c_str());
+    std::vector<std::string> qstrings;
+    auto conditions = parseXMLQueries(sset, qstrings, q, qnums, false);
+    ColoredExplorer explorer(cpnBuilder);
+    BOOST_REQUIRE(explorer.supports(conditions[0]));
+    // the query is left to the unfolded net rather than failing the run
+    BOOST_REQUIRE(ColoredExplorer::Result::Unknown == explorer.check(conditions[0], Strategy::BFS, false, 60));
+}
+
+class StoredStates : public Reachability::AbstractHandler {
+public:
+    std::pair<Result, bool> handle(
+        size_t index,
+        PQL::Condition* query,
+        Result result,
+        const std::vector<uint32_t>* maxPlaceBound = nullptr,
+        size_t expandedStates = 0,
+        size_t exploredStates = 0,
+        size_t discoveredStates = 0,
+        int maxTokens = 0,
+        Structures::StateSetInterface* stateset = nullptr, size_t lastmarking = 0, const MarkVal* initialMarking = nullptr, bool trace = true) override {
+        stored = exploredStates;
+        if (result == Unknown) return std::make_pair(Unknown, false);
+        if (result == Satisfied)
+            return std::make_pair(query->isInvariant() ? NotSatisfied : Satisfied, false);
+        return std::make_pair(query->isInvariant() ? Satisfied : NotSatisfied, false);
+    }
+
+    // number of markings stored, one per orbit with symmetry
+    size_t stored = 0;
+};
+
+// unfolds the model like main does with state symmetry enabled, and prepares the queries for reachability.
+// Queries over the unfolded net are analysed by its place names rather than the colored ones.
+auto load_symmetric(const char* model, const char* queries, const std::set<size_t>& qnums, bool unfolded_names = false) {
+    shared_string_set sset;
+    ColoredPetriNetBuilder cpnBuilder(sset);
+    auto f = loadFile(model);
+    cpnBuilder.parse_model(f);
+    auto q = loadFile(queries);
+    std::vector<std::string> qstrings;
+    auto conditions = parseXMLQueries(sset, qstrings, q, qnums, false);
+    std::vector<Structures::place_blocks_t> scalar_sets;
+    auto [builder, trans_names, place_names] = unfold(cpnBuilder, false, false, false, std::cerr,
+        0, 0, 0, 0, false, false, 1, &scalar_sets);
+    builder.sort();
+    PetriNetBuilder copy(builder);
+    std::unique_ptr<PetriNet> pn{copy.makePetriNet()};
+    contextAnalysis(!unfolded_names, trans_names, place_names, copy, pn.get(), conditions);
+    for (auto& c : conditions)
+        c = prepareForReachability(c);
+    return std::make_tuple(std::move(pn), std::move(conditions), std::move(scalar_sets));
+}
+
+BOOST_AUTO_TEST_CASE(StateSymmetryVerdictsAndStates, * utf::timeout(60)) {
+    // four processes competing for one mutex; the queries only count tokens over all processes
+    auto [pn, conditions, scalar_sets] = load_symmetric("/models/symmetric_mutex.pnml",
+        "/models/symmetric_mutex.xml", {0, 1, 2});
+    BOOST_REQUIRE_EQUAL(scalar_sets.size(), 1);
+    const std::vector<Reachability::ResultPrinter::Result> expected{
+        Reachability::ResultPrinter::NotSatisfied,
+        Reachability::ResultPrinter::Satisfied,
+        Reachability::ResultPrinter::Satisfied};
+
+    for (size_t i = 0; i < conditions.size(); ++i) {
+        std::vector<Condition_ptr> vec{conditions[i]};
+        Structures::StateSymmetry symmetry(*pn, scalar_sets, vec);
+        BOOST_REQUIRE_EQUAL(symmetry.size(), 1);
+        std::vector<size_t> stored;
+        for (bool use_symmetry : {false, true}) {
+            std::cerr << "\tQ[" << i << "] symmetry=" << std::boolalpha << use_symmetry << std::endl;
+            StoredStates handler;
+            ReachabilitySearch strategy(*pn, handler, 0);
+            if (use_symmetry)
+                strategy.setSymmetry(&symmetry);
+            std::vector<Reachability::ResultPrinter::Result> results{Reachability::ResultPrinter::Unknown};
+            strategy.reachable(vec, results, Strategy::BFS, false, false, StatisticsLevel::None, false, 0);
+            BOOST_REQUIRE_EQUAL(expected[i], results[0]);
+            stored.push_back(handler.stored);
+        }
+        // the first and last query explore every marking: all idle, or one of the four processes busy
+        if (i != 1) {
+            BOOST_REQUIRE_EQUAL(stored[0], 5);
+            BOOST_REQUIRE_EQUAL(stored[1], 2);
+        }
+        BOOST_REQUIRE_LE(stored[1], stored[0]);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(StateSymmetryRejected, * utf::timeout(60)) {
+    {
+        // a query on the unfolded place of a single process is not preserved by permuting processes
+        auto [pn, conditions, scalar_sets] = load_symmetric("/models/symmetric_mutex.pnml",
+            "/models/symmetric_mutex_unfolded.xml", {0}, true);
+        BOOST_REQUIRE_EQUAL(scalar_sets.size(), 1);
+        BOOST_REQUIRE(Structures::StateSymmetry(*pn, scalar_sets, conditions).empty());
+    }
+    {
+        // only two of the four processes start idle
+        auto [pn, conditions, scalar_sets] = load_symmetric("/models/asymmetric_mutex.pnml",
+            "/models/symmetric_mutex.xml", {0, 1, 2});
+        BOOST_REQUIRE_EQUAL(scalar_sets.size(), 1);
+        BOOST_REQUIRE(Structures::StateSymmetry(*pn, scalar_sets, conditions).empty());
+    }
+}
+
+// the bindings of a generator as (variable, color id) lists, independent of the enumeration order
+template<typename Generator>
+std::set<std::vector<std::pair<std::string, uint32_t>>> bindings_of(Generator& generator) {
+    std::set<std::vector<std::pair<std::string, uint32_t>>> bindings;
+    for (auto it = generator.begin(), end = generator.end(); it != end; ++it) {
+        std::vector<std::pair<std::string, uint32_t>> binding;
+        for (auto& [var, color] : *it)
+            binding.emplace_back(var->name, color->getId());
+        std::sort(binding.begin(), binding.end());
+        BOOST_REQUIRE(bindings.insert(std::move(binding)).second);
+    }
+    return bindings;
+}
+
+BOOST_AUTO_TEST_CASE(PrunedBindingsMatchNaive, * utf::timeout(100)) {
+    // the constraint propagation of FixpointBindingGenerator may only reorder the bindings, never drop or add any
+    for (auto model : {"/models/offset_guards.pnml", "/models/Peterson-COL-2/model.pnml",
+                       "/models/NeoElection-COL-3/model.pnml", "/models/PhilosophersDyn-COL-03/model.pnml",
+                       "/models/UtilityControlRoom-COL-Z2T3N04/model.pnml"}) {
+        shared_string_set sset;
+        ColoredPetriNetBuilder cpnBuilder(sset);
+        auto f = loadFile(model);
+        cpnBuilder.parse_model(f);
+        const std::vector<std::set<const Colored::Variable*>> no_symmetries;
+        size_t nonempty = 0;
+        for (auto& transition : cpnBuilder.transitions()) {
+            std::cerr << "\t" << model << " " << *transition.name << std::endl;
+            NaiveBindingGenerator naive(transition, cpnBuilder.colors());
+            auto expected = bindings_of(naive);
+            if (expected.empty() || expected.begin()->empty())
+                continue;
+            // every variable ranges over its full color type, so only the guard restricts the bindings
+            Colored::ForwardFixedPoint::VarMap var_map(1);
+            for (auto& [var, _] : *naive.begin())
+                var_map[0].emplace(var, Colored::interval_vector_t({var->colorType->getFullInterval()}));
+            FixpointBindingGenerator pruned(transition, cpnBuilder.colors(), no_symmetries, var_map);
+            BOOST_REQUIRE(expected == bindings_of(pruned));
+            ++nonempty;
+        }
+        BOOST_REQUIRE_GT(nonempty, 0);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(CompiledExpressionsMatchEvaluationVisitor, * utf::timeout(100)) {
+    // every binding of the variables, satisfying the guard or not, up to a bound per transition
+    const size_t max_bindings = 5000;
+    for (auto model : {"/models/offset_guards.pnml", "/models/Peterson-COL-2/model.pnml",
+                       "/models/NeoElection-COL-3/model.pnml", "/models/PhilosophersDyn-COL-03/model.pnml",
+                       "/models/UtilityControlRoom-COL-Z2T3N04/model.pnml"}) {
+        shared_string_set sset;
+        ColoredPetriNetBuilder cpnBuilder(sset);
+        auto f = loadFile(model);
+        cpnBuilder.parse_model(f);
+        const EquivalenceVec no_partition;
+        for (auto& transition : cpnBuilder.transitions()) {
+            std::cerr << "\t" << model << " " << *transition.name << std::endl;
+            std::set<const Variable*> varset;
+            if (transition.guard)
+                VariableVisitor::get_variables(*transition.guard, varset);
+            std::vector<const ArcExpression*> arcs;
+            for (auto* arcs_of : {&transition.input_arcs, &transition.output_arcs}) {
+                for (auto& arc : *arcs_of) {
+                    VariableVisitor::get_variables(*arc.expr, varset);
+                    arcs.push_back(arc.expr.get());
+                }
+            }
+            std::vector<const Variable*> variables(varset.begin(), varset.end());
+            CompiledExpression guard;
+            if (transition.guard)
+                guard = CompiledExpression::compile(*transition.guard, variables, cpnBuilder.colors());
+            std::vector<CompiledExpression> compiled;
+            for (auto* arc : arcs)
+                compiled.push_back(CompiledExpression::compile(*arc, variables, cpnBuilder.colors(), no_partition));
+
+            std::vector<const Color*> values;
+            for (auto* var : variables)
+                values.push_back(&(*var->colorType)[size_t{0}]);
+            for (size_t n = 0; n < max_bindings; ++n) {
+                BindingMap binding;
+                for (size_t i = 0; i < variables.size(); ++i)
+                    binding[variables[i]] = values[i];
+                const ExpressionContext context{binding, cpnBuilder.colors(), no_partition};
+                if (transition.guard)
+                    BOOST_REQUIRE_EQUAL(EvaluationVisitor::evaluate(*transition.guard, context), guard.evaluate_guard(values));
+                for (size_t a = 0; a < arcs.size(); ++a) {
+                    std::map<uint32_t, uint32_t> expected, actual;
+                    for (const auto& [color, count] : EvaluationVisitor::evaluate(*arcs[a], context)) {
+                        if (count > 0)
+                            expected[color->getId()] = count;
+                    }
+                    for (const auto& [color, count] : compiled[a].evaluate_arc(values))
+                        BOOST_REQUIRE(actual.emplace(color->getId(), count).second);
+                    BOOST_REQUIRE(expected == actual);
+                }
+                // next binding, the first variable changing fastest
+                size_t i = 0;
+                for (; i < values.size(); ++i) {
+                    values[i] = &++(*values[i]);
+                    if (values[i]->getId() != 0)
+                        break;
+                }
+                if (i == values.size())
+                    break;
+            }
+        }
+    }
+}
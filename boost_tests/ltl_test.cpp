@@ -67,7 +67,7 @@ BOOST_AUTO_TEST_CASE(AngiogenesisPT01LTLCardinality, * utf::timeout(300)) {
                     if(alg == LTL::Algorithm::NDFS && por != LTL::LTLPartialOrder::None)
                         continue;
                     for(auto heur : { LTL::LTLHeuristic::DFS, LTL::LTLHeuristic::Automaton, LTL::LTLHeuristic::Distance,
-                        LTL::LTLHeuristic::FireCount})
+                        LTL::LTLHeuristic::FireCount, LTL::LTLHeuristic::Potency})
                     {
                         std::cerr << "Q[" << i << "] trace=" << std::boolalpha << trace
                             << " por=" << to_underlying(por) << " alg=" << to_underlying(alg) << " heur=" << to_underlying(heur) << std::endl;
@@ -137,4 +137,174 @@ BOOST_AUTO_TEST_CASE(AngiogenesisPT01LTLFireability, * utf::timeout(300)) {
             }
         }
     }
-}
\ No newline at end of file
+}
+BOOST_AUTO_TEST_CASE(AngiogenesisPT01LTLFireabilityLasso, * utf::timeout(300)) {
+
+    const std::set<size_t> qnums{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15};
+    const std::vector<Reachability::ResultPrinter::Result> expected{
+        ResultPrinter::NotSatisfied,
+        ResultPrinter::NotSatisfied,
+        ResultPrinter::NotSatisfied,
+        ResultPrinter::Satisfied,
+        ResultPrinter::NotSatisfied,
+        ResultPrinter::NotSatisfied,
+        ResultPrinter::NotSatisfied,
+        ResultPrinter::NotSatisfied,
+        ResultPrinter::NotSatisfied,
+        ResultPrinter::NotSatisfied,
+        ResultPrinter::NotSatisfied,
+        ResultPrinter::NotSatisfied,
+        ResultPrinter::Satisfied,
+        ResultPrinter::NotSatisfied,
+        ResultPrinter::NotSatisfied,
+        ResultPrinter::Satisfied};
+
+    auto [pn, conditions, qstrings] = load_pn("/models/Angiogenesis-PT-01/model.pnml",
+        "/models/Angiogenesis-PT-01/LTLFireability.xml", qnums, TemporalLogic::LTL);
+
+    // summed over the runs, the lasso phase must have ordered successors and closed cycles
+    size_t guided = 0, closures = 0;
+    for (auto i : qnums) {
+        for (bool trace :{false, true}) {
+            for(auto alg : { LTL::Algorithm::Tarjan, LTL::Algorithm::NDFS})
+            {
+                for(auto por : { LTL::LTLPartialOrder::None, LTL::LTLPartialOrder::Automaton})
+                {
+                    if(alg == LTL::Algorithm::NDFS && por != LTL::LTLPartialOrder::None)
+                        continue;
+                    for(auto heur : { LTL::LTLHeuristic::Automaton, LTL::LTLHeuristic::DFS})
+                    {
+                        std::cerr << "Q[" << i << "] trace=" << std::boolalpha << trace
+                            << " por=" << to_underlying(por) << " heur=" << to_underlying(heur) << " lasso" << std::endl;
+                        Strategy strategy = Strategy::HEUR;
+                        if(heur == LTL::LTLHeuristic::DFS)
+                            strategy = Strategy::DFS;
+                        LTL::LTLSearch search(*pn, conditions[i], LTL::BuchiOptimization::Low, LTL::APCompression::None);
+                        auto r = search.solve(trace, 0, alg, por, strategy, heur, true, 0, true);
+                        auto result = r ? ResultPrinter::Satisfied : ResultPrinter::NotSatisfied;
+                        BOOST_REQUIRE_EQUAL(expected[i], result);
+
+                        auto lasso = search.lasso();
+                        BOOST_REQUIRE(lasso != nullptr);
+                        BOOST_REQUIRE_LE(lasso->closures(), 1);
+                        if (result == ResultPrinter::Satisfied)
+                            BOOST_REQUIRE_EQUAL(lasso->closures(), 0);
+                        // a Tarjan counterexample always has an accepting state on the search path
+                        else if (alg == LTL::Algorithm::Tarjan)
+                            BOOST_REQUIRE_GT(lasso->seeds(), 0);
+                        guided += lasso->guided();
+                        closures += lasso->closures();
+                    }
+                }
+            }
+        }
+    }
+    BOOST_REQUIRE_GT(guided, 0);
+    BOOST_REQUIRE_GT(closures, 0);
+}
+
+BOOST_AUTO_TEST_CASE(AngiogenesisPT01LTLCardinalityTerminalReach, * utf::timeout(300)) {
+
+    const std::set<size_t> qnums{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15};
+    const std::vector<Reachability::ResultPrinter::Result> expected{
+        ResultPrinter::NotSatisfied,
+        ResultPrinter::NotSatisfied,
+        ResultPrinter::NotSatisfied,
+        ResultPrinter::NotSatisfied,
+        ResultPrinter::Satisfied,
+        ResultPrinter::Satisfied,
+        ResultPrinter::Satisfied,
+        ResultPrinter::NotSatisfied,
+        ResultPrinter::NotSatisfied,
+        ResultPrinter::NotSatisfied,
+        ResultPrinter::NotSatisfied,
+        ResultPrinter::NotSatisfied,
+        ResultPrinter::NotSatisfied,
+        ResultPrinter::NotSatisfied,
+        ResultPrinter::NotSatisfied,
+        ResultPrinter::NotSatisfied};
+
+    auto [pn, conditions, qstrings] = load_pn("/models/Angiogenesis-PT-01/model.pnml",
+        "/models/Angiogenesis-PT-01/LTLCardinality.xml", qnums, TemporalLogic::LTL);
+    // the queries with terminal automata must actually be decided by the reachability checker
+    size_t terminal = 0;
+
+    for (auto i : qnums) {
+        for (bool trace :{false, true}) {
+            for(auto por : { LTL::LTLPartialOrder::None, LTL::LTLPartialOrder::Automaton})
+            {
+                for(auto strategy : { Strategy::BFS, Strategy::DFS, Strategy::HEUR})
+                {
+                    std::cerr << "Q[" << i << "] trace=" << std::boolalpha << trace
+                        << " por=" << to_underlying(por) << " strategy=" << to_underlying(strategy) << " terminal" << std::endl;
+                    LTL::LTLSearch search(*pn, conditions[i], LTL::BuchiOptimization::Low, LTL::APCompression::None);
+                    auto r = search.solve(trace, 0, LTL::Algorithm::Tarjan, por, strategy,
+                                          LTL::LTLHeuristic::Distance, true, 0, false, true);
+                    auto result = r ? ResultPrinter::Satisfied : ResultPrinter::NotSatisfied;
+                    BOOST_REQUIRE_EQUAL(expected[i], result);
+                    terminal += search.used_terminal_reach();
+                }
+            }
+        }
+    }
+    BOOST_REQUIRE_GT(terminal, 0);
+}
+
+BOOST_AUTO_TEST_CASE(DeadlockTerminalReachHeuristics) {
+    // the counter-example passes through the self-loop of the deadlock, which fires no transition of the net
+    auto [pn, conditions, qstrings] = load_pn("/models/ltl_kbound.pnml",
+        "/models/ltl_deadlock.xml", {0}, TemporalLogic::LTL);
+
+    for (bool trace : {false, true}) {
+        for (auto heuristic : {LTL::LTLHeuristic::FireCount, LTL::LTLHeuristic::Potency, LTL::LTLHeuristic::Distance}) {
+            std::cerr << "trace=" << std::boolalpha << trace << " heuristic=" << to_underlying(heuristic) << std::endl;
+            LTL::LTLSearch search(*pn, conditions[0], LTL::BuchiOptimization::Low, LTL::APCompression::None);
+            auto r = search.solve(trace, 0, LTL::Algorithm::Tarjan, LTL::LTLPartialOrder::None, Strategy::HEUR,
+                                  heuristic, true, 0, false, true);
+            BOOST_REQUIRE(search.used_terminal_reach());
+            BOOST_REQUIRE_EQUAL(false, r);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(AngiogenesisPT01SharedMarkingGraph, * utf::timeout(300)) {
+    const std::set<size_t> qnums{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15};
+
+    for (auto queries : {"/models/Angiogenesis-PT-01/LTLCardinality.xml",
+                         "/models/Angiogenesis-PT-01/LTLFireability.xml"}) {
+        auto [pn, conditions, qstrings] = load_pn("/models/Angiogenesis-PT-01/model.pnml",
+            queries, qnums, TemporalLogic::LTL);
+
+        LTL::Structures::MarkingGraph graph(*pn);
+        for (auto i : qnums) {
+            std::cerr << queries << " Q[" << i << "] shared" << std::endl;
+            LTL::LTLSearch separate(*pn, conditions[i], LTL::BuchiOptimization::Low, LTL::APCompression::None);
+            auto expected = separate.solve(false, 0, LTL::Algorithm::Tarjan, LTL::LTLPartialOrder::None);
+
+            LTL::LTLSearch shared(*pn, conditions[i], LTL::BuchiOptimization::Low, LTL::APCompression::None);
+            shared.set_marking_graph(&graph);
+            BOOST_REQUIRE_EQUAL(expected, shared.solve(false, 0, LTL::Algorithm::Tarjan, LTL::LTLPartialOrder::None));
+            BOOST_REQUIRE_LE(graph.expansions(), graph.size());
+        }
+
+        // every marking the formulae need has been expanded by now, so checking them again expands none
+        auto expansions = graph.expansions();
+        for (auto i : qnums) {
+            LTL::LTLSearch again(*pn, conditions[i], LTL::BuchiOptimization::Low, LTL::APCompression::None);
+            again.set_marking_graph(&graph);
+            again.solve(false, 0, LTL::Algorithm::Tarjan, LTL::LTLPartialOrder::None);
+        }
+        BOOST_REQUIRE_EQUAL(expansions, graph.expansions());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(DeadlockSharedMarkingGraph) {
+    // the counter-example needs the self-loop of the deadlocked marking
+    auto [pn, conditions, qstrings] = load_pn("/models/ltl_kbound.pnml",
+        "/models/ltl_deadlock.xml", {0}, TemporalLogic::LTL);
+
+    LTL::Structures::MarkingGraph graph(*pn);
+    LTL::LTLSearch search(*pn, conditions[0], LTL::BuchiOptimization::Low, LTL::APCompression::None);
+    search.set_marking_graph(&graph);
+    BOOST_REQUIRE_EQUAL(false, search.solve(false, 0, LTL::Algorithm::Tarjan, LTL::LTLPartialOrder::None));
+}
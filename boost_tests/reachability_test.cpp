@@ -114,3 +114,112 @@ BOOST_AUTO_TEST_CASE(AngiogenesisPT01ReachabilityFireability, * utf::timeout(60)
         }
     }
 }
+
+// Passes results on to a ResultPrinter, keeping the marking the search reports as satisfying
+class ReportedMarking : public Reachability::AbstractHandler {
+public:
+    ReportedMarking(ResultPrinter& printer) : _printer(printer) {}
+
+    std::pair<Result, bool> handle(
+        size_t index,
+        PQL::Condition* query,
+        Result result,
+        const std::vector<uint32_t>* maxPlaceBound = nullptr,
+        size_t expandedStates = 0,
+        size_t exploredStates = 0,
+        size_t discoveredStates = 0,
+        int maxTokens = 0,
+        Structures::StateSetInterface* stateset = nullptr, size_t lastmarking = 0, const MarkVal* initialMarking = nullptr, bool trace = true) override {
+        if (result == Satisfied) {
+            auto* states = dynamic_cast<Structures::EncodingStateSetInterface*>(stateset);
+            BOOST_REQUIRE(states);
+            Structures::State state;
+            state.setMarking(new MarkVal[states->net().numberOfPlaces()]);
+            states->decode(state, lastmarking);
+            marking.assign(state.marking(), state.marking() + states->net().numberOfPlaces());
+        }
+        return _printer.handle(index, query, result, maxPlaceBound, expandedStates, exploredStates, discoveredStates,
+            maxTokens, stateset, lastmarking, initialMarking, trace);
+    }
+
+    std::vector<MarkVal> marking;
+
+private:
+    ResultPrinter& _printer;
+};
+
+BOOST_AUTO_TEST_CASE(ReducedTraceReplaysOnOriginalNet, * utf::timeout(60)) {
+    // as in main, the net the queries are analysed against is made from a copy, which leaves the builder untouched
+    std::set<size_t> qnums{0};
+    shared_string_set sset;
+    ColoredPetriNetBuilder cpnBuilder(sset);
+    auto f = loadFile("/models/rule_ABQ.pnml");
+    cpnBuilder.parse_model(f);
+    auto [builder, trans_names, place_names] = unfold(cpnBuilder, false, false, false, std::cerr, 10, 100, 10, 10, false);
+    builder.sort();
+    auto q = loadFile("/models/rule_ABQ.xml");
+    std::vector<std::string> qstrings;
+    auto conditions = parseXMLQueries(sset, qstrings, q, qnums, false);
+    PetriNetBuilder copy(builder);
+    std::unique_ptr<PetriNet> original{copy.makePetriNet(false)};
+    contextAnalysis(false, trans_names, place_names, copy, original.get(), conditions);
+
+    builder.saveInitialNet();
+    std::vector<Reachability::ResultPrinter::Result> results{Reachability::ResultPrinter::Unknown};
+    // Q first, as A and B would otherwise take the chains it rewrites
+    std::vector<uint32_t> reds{16, 1, 0};
+    builder.reduce(conditions, results, 3, true, nullptr, 10, reds);
+    std::unique_ptr<PetriNet> net{builder.makePetriNet(false)};
+    contextAnalysis(false, trans_names, place_names, builder, net.get(), conditions);
+
+    std::stringstream stats;
+    builder.getReducer()->printStats(stats);
+    for (auto rule : {"A", "B", "Q"})
+        BOOST_REQUIRE_MESSAGE(stats.str().find(std::string("Applications of rule ") + rule + ": 0\n") == std::string::npos,
+            "rule " << rule << " was not applied:\n" << stats.str());
+
+    options_t options;
+    options.trace = TraceLevel::Full;
+    ResultPrinter printer(&builder, &options, qstrings);
+    printer.setReducer(builder.getReducer());
+    ReportedMarking handler(printer);
+
+    std::stringstream printed;
+    auto* cerr = std::cerr.rdbuf(printed.rdbuf());
+    auto c2 = prepareForReachability(conditions[0]);
+    ReachabilitySearch strategy(*net, handler, 0);
+    std::vector<Condition_ptr> vec{c2};
+    strategy.reachable(vec, results, Strategy::BFS, false, false, StatisticsLevel::None, true, 0);
+    std::cerr.rdbuf(cerr);
+    BOOST_REQUIRE_EQUAL(results[0], Reachability::ResultPrinter::Satisfied);
+    BOOST_REQUIRE_EQUAL(handler.marking.size(), net->numberOfPlaces());
+
+    std::unordered_map<std::string, uint32_t> transitions, places;
+    for (uint32_t t = 0; t < original->numberOfTransitions(); ++t)
+        transitions.emplace(*original->transitionNames()[t], t);
+    for (uint32_t p = 0; p < original->numberOfPlaces(); ++p)
+        places.emplace(*original->placeNames()[p], p);
+
+    std::vector<MarkVal> marking(original->initial(), original->initial() + original->numberOfPlaces());
+    const std::string prefix = "<transition id=\"";
+    size_t steps = 0;
+    for (std::string line; std::getline(printed, line);) {
+        auto begin = line.find(prefix);
+        if (begin == std::string::npos) continue;
+        begin += prefix.size();
+        auto name = line.substr(begin, line.find('"', begin) - begin);
+        auto t = transitions.find(name);
+        BOOST_REQUIRE_MESSAGE(t != transitions.end(), "unknown transition " << name);
+        BOOST_REQUIRE_MESSAGE(original->fireable(marking.data(), t->second), "step " << steps << ", " << name << ", is not enabled");
+        auto [pre, pre_end] = original->preset(t->second);
+        for (; pre != pre_end; ++pre)
+            if (!pre->inhibitor) marking[pre->place] -= pre->tokens;
+        auto [post, post_end] = original->postset(t->second);
+        for (; post != post_end; ++post)
+            marking[post->place] += post->tokens;
+        ++steps;
+    }
+    BOOST_REQUIRE_GT(steps, 0);
+    for (uint32_t p = 0; p < net->numberOfPlaces(); ++p)
+        BOOST_REQUIRE_EQUAL(marking[places.at(*net->placeNames()[p])], handler.marking[p]);
+}
@@ -18,6 +18,7 @@
 
 #include <boost/test/unit_test.hpp>
 #include <string>
+#include <filesystem>
 #include <fstream>
 #include <sstream>
 
@@ -25,6 +26,7 @@
 #include "utils.h"
 #include "CTL/CTLResult.h"
 #include "CTL/CTLEngine.h"
+#include "PetriEngine/BinaryNet.h"
 
 using namespace PetriEngine;
 using namespace PetriEngine::Colored;
@@ -155,4 +157,150 @@ BOOST_AUTO_TEST_CASE(ruleGFail, * utf::timeout(60)) {
             ++i;
         }
     }
-}
\ No newline at end of file
+}
+
+// requires the nets to have the same places, transitions and arcs, in the same order
+static void require_same_net(const PetriNet& net, const PetriNet& copy) {
+    BOOST_REQUIRE_EQUAL(net.numberOfPlaces(), copy.numberOfPlaces());
+    BOOST_REQUIRE_EQUAL(net.numberOfTransitions(), copy.numberOfTransitions());
+    for (uint32_t p = 0; p < net.numberOfPlaces(); ++p) {
+        BOOST_REQUIRE_EQUAL(*net.placeNames()[p], *copy.placeNames()[p]);
+        BOOST_REQUIRE_EQUAL(net.initial(p), copy.initial(p));
+    }
+    auto same_arcs = [](auto a, auto b) {
+        BOOST_REQUIRE_EQUAL(a.second - a.first, b.second - b.first);
+        for (; a.first != a.second; ++a.first, ++b.first) {
+            BOOST_REQUIRE_EQUAL(a.first->place, b.first->place);
+            BOOST_REQUIRE_EQUAL(a.first->tokens, b.first->tokens);
+            BOOST_REQUIRE_EQUAL(a.first->inhibitor, b.first->inhibitor);
+            BOOST_REQUIRE_EQUAL(a.first->direction, b.first->direction);
+        }
+    };
+    for (uint32_t t = 0; t < net.numberOfTransitions(); ++t) {
+        BOOST_REQUIRE_EQUAL(*net.transitionNames()[t], *copy.transitionNames()[t]);
+        BOOST_REQUIRE_EQUAL(net.controllable(t), copy.controllable(t));
+        same_arcs(net.preset(t), copy.preset(t));
+        same_arcs(net.postset(t), copy.postset(t));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(BinaryNetRoundTrip, * utf::timeout(60)) {
+    // the reduced net written by --write-reduced-binary is read back by --binary-model as the same net
+    const std::set<size_t> qnums{15};
+    std::vector<Reachability::ResultPrinter::Result> results{
+        Reachability::ResultPrinter::Unknown};
+
+    auto [conditions, builder, qstrings, trans_names, place_names] = load_builder("/models/Referendum-PT-0015/model.pnml",
+        "/models/Referendum-PT-0015/LTLCardinality.xml", qnums);
+    std::vector<uint32_t> reds;
+    std::unique_ptr<PetriNet> net{builder.makePetriNet(false)};
+    contextAnalysis(false, trans_names, place_names, builder, net.get(), conditions);
+    builder.reduce(conditions, results, 1, false, net.get(), 10, reds);
+    net.reset(builder.makePetriNet(true));
+
+    const auto path = (std::filesystem::temp_directory_path() / "verifypn_binary_net_test.bin").string();
+    {
+        std::ofstream file(path, std::ios::binary);
+        BinaryNet::write(*net, file);
+        BOOST_REQUIRE(file);
+    }
+    shared_string_set sset;
+    PetriNetBuilder read(sset);
+    BinaryNet::read(path, read);
+    std::filesystem::remove(path);
+    std::unique_ptr<PetriNet> copy{read.makePetriNet(false)};
+
+    require_same_net(*net, *copy);
+}
+
+// reduces a copy of the net for the queries, returning the rule applications printed by -R and the reduced net
+static std::pair<std::string, std::unique_ptr<PetriNet>> reduce_copy(const PetriNetBuilder& builder,
+        std::vector<Condition_ptr>& conditions, bool colored, const shared_name_name_map& trans_names,
+        const shared_place_color_map& place_names, int rmode, std::vector<uint32_t> reds, uint32_t threads) {
+    PetriNetBuilder copy(builder);
+    std::vector<Reachability::ResultPrinter::Result> results(conditions.size(), Reachability::ResultPrinter::Unknown);
+    std::unique_ptr<PetriNet> net{copy.makePetriNet(false)};
+    contextAnalysis(colored, trans_names, place_names, copy, net.get(), conditions);
+    copy.reduce(conditions, results, rmode, false, net.get(), 60, reds, threads);
+    std::stringstream stats, applications;
+    copy.printStats(stats);
+    for (std::string line; std::getline(stats, line);) {
+        if (line.rfind("Applications", 0) == 0)
+            applications << line << "\n";
+    }
+    net.reset(copy.makePetriNet(false));
+    return {applications.str(), std::move(net)};
+}
+
+BOOST_AUTO_TEST_CASE(ParallelReductionMatchesSequential, * utf::timeout(600)) {
+    // place rules whose checks run ahead on several threads must reduce the net exactly as a single thread does
+    struct instance_t { const char* model; const char* queries; bool colored; };
+    const instance_t instances[] = {
+        {"/models/Angiogenesis-PT-01/model.pnml", "/models/Angiogenesis-PT-01/LTLCardinality.xml", false},
+        {"/models/Angiogenesis-PT-01/model.pnml", "/models/Angiogenesis-PT-01/ReachabilityCardinality.xml", false},
+        {"/models/Referendum-PT-0015/model.pnml", "/models/Referendum-PT-0015/LTLCardinality.xml", false},
+        {"/models/DiscoveryGPU-PT-15a/model.pnml", "/models/DiscoveryGPU-PT-15a/CTLCardinality.xml", false},
+        {"/models/NeoElection-COL-3/model.pnml", "/models/NeoElection-COL-3/ReachabilityCardinality.xml", true},
+        {"/models/PhilosophersDyn-COL-03/model.pnml", "/models/PhilosophersDyn-COL-03/ReachabilityCardinality.xml", true},
+        {"/models/UtilityControlRoom-COL-Z2T3N04/model.pnml", "/models/UtilityControlRoom-COL-Z2T3N04/ReachabilityCardinality.xml", true},
+    };
+    // the default rules, and a sequence of the agglomeration rules R and S between others
+    const std::pair<int, std::vector<uint32_t>> modes[] = {{1, {}}, {3, {0, 1, 18, 17, 3, 6, 18}}};
+    for (auto& instance : instances) {
+        for (size_t q = 0; q < 16; ++q) {
+            // both reductions start from the same unfolded net
+            auto [conditions, builder, qstrings, trans_names, place_names] = load_builder(instance.model, instance.queries, {q});
+            for (auto& [rmode, reds] : modes) {
+                std::cerr << "\t" << instance.queries << " Q" << q << " -R " << rmode << std::endl;
+                auto [rules1, net1] = reduce_copy(builder, conditions, instance.colored, trans_names, place_names, rmode, reds, 1);
+                auto [rules4, net4] = reduce_copy(builder, conditions, instance.colored, trans_names, place_names, rmode, reds, 4);
+                BOOST_REQUIRE_EQUAL(rules1, rules4);
+                require_same_net(*net1, *net4);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ReductionResultsPinned, * utf::timeout(120)) {
+    // the rules applied and the size of the reduced net, so that a change to the reducer that alters them shows up
+    struct pinned_t {
+        const char* model; const char* queries; size_t query; int rmode;
+        uint32_t places; uint32_t transitions; std::vector<uint32_t> applications; // of rules A to S
+    };
+    const std::vector<uint32_t> custom = {0, 1, 2, 3, 4, 5, 6, 7, 8, 11, 12, 16, 17, 18};
+    const char* angiogenesis = "/models/Angiogenesis-PT-01/model.pnml";
+    const char* referendum = "/models/Referendum-PT-0015/model.pnml";
+    const char* discovery = "/models/DiscoveryGPU-PT-15a/model.pnml";
+    const char* kanban = "/models/Kanban-PT-02000/model.pnml";
+    const pinned_t pins[] = {
+        {angiogenesis, "/models/Angiogenesis-PT-01/LTLCardinality.xml", 0, 1, 38, 64, {0,0,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0}},
+        {angiogenesis, "/models/Angiogenesis-PT-01/LTLCardinality.xml", 0, 2, 39, 64, {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0}},
+        {angiogenesis, "/models/Angiogenesis-PT-01/LTLCardinality.xml", 0, 3, 33, 59, {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,7,0}},
+        {angiogenesis, "/models/Angiogenesis-PT-01/ReachabilityCardinality.xml", 3, 1, 31, 60, {0,0,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,10,0}},
+        {angiogenesis, "/models/Angiogenesis-PT-01/ReachabilityCardinality.xml", 3, 2, 39, 64, {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0}},
+        {angiogenesis, "/models/Angiogenesis-PT-01/ReachabilityCardinality.xml", 3, 3, 32, 60, {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,10,0}},
+        {referendum, "/models/Referendum-PT-0015/LTLCardinality.xml", 15, 1, 6, 6, {0,12,0,13,0,28,0,0,0,0,0,0,0,0,0,0,0,0,0}},
+        {referendum, "/models/Referendum-PT-0015/LTLCardinality.xml", 15, 2, 46, 31, {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0}},
+        {referendum, "/models/Referendum-PT-0015/LTLCardinality.xml", 15, 3, 44, 30, {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,3,0}},
+        {discovery, "/models/DiscoveryGPU-PT-15a/CTLCardinality.xml", 0, 1, 153, 196, {0,0,0,0,0,0,0,0,0,0,0,15,0,0,0,0,0,0,0}},
+        {discovery, "/models/DiscoveryGPU-PT-15a/CTLCardinality.xml", 0, 2, 153, 211, {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0}},
+        {discovery, "/models/DiscoveryGPU-PT-15a/CTLCardinality.xml", 0, 3, 126, 169, {27,0,0,0,0,0,0,0,0,0,0,15,0,0,0,0,0,0,0}},
+        {kanban, "/models/Kanban-PT-02000/errG.xml", 0, 1, 11, 12, {0,4,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0}},
+        {kanban, "/models/Kanban-PT-02000/errG.xml", 0, 2, 12, 12, {4,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0}},
+        {kanban, "/models/Kanban-PT-02000/errG.xml", 0, 3, 11, 12, {4,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0}},
+    };
+    for (auto& pin : pins) {
+        std::cerr << "\t" << pin.queries << " Q" << pin.query << " -R " << pin.rmode << std::endl;
+        auto [conditions, builder, qstrings, trans_names, place_names] = load_builder(pin.model, pin.queries, {pin.query});
+        auto [rules, net] = reduce_copy(builder, conditions, false, trans_names, place_names, pin.rmode,
+                                        pin.rmode == 3 ? custom : std::vector<uint32_t>{}, 1);
+        std::vector<uint32_t> applications;
+        std::stringstream lines(rules);
+        for (std::string line; std::getline(lines, line);)
+            applications.push_back(std::stoul(line.substr(line.rfind(' ') + 1)));
+        BOOST_CHECK_EQUAL_COLLECTIONS(applications.begin(), applications.end(),
+                                      pin.applications.begin(), pin.applications.end());
+        BOOST_CHECK_EQUAL(net->numberOfPlaces(), pin.places);
+        BOOST_CHECK_EQUAL(net->numberOfTransitions(), pin.transitions);
+    }
+}
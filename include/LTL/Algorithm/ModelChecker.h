@@ -48,6 +48,7 @@ namespace LTL {
 
         void set_heuristic(Heuristic* heuristic) {
             _heuristic = heuristic;
+            _lasso = dynamic_cast<LassoHeuristic*>(heuristic);
         }
 
         void set_utilize_weak(bool b) {
@@ -56,6 +57,12 @@ namespace LTL {
 
         virtual void set_partial_order(LTLPartialOrder) {}
 
+        /**
+         * Bound the memory used for search stacks, paging colder segments out to disk (0 for unbounded).
+         * Only honoured by checkers that keep explicit search stacks.
+         */
+        virtual void set_stack_memory(size_t) {}
+
         virtual bool check() = 0;
 
         virtual ~ModelChecker() = default;
@@ -105,6 +112,8 @@ namespace LTL {
                     << "\texplored states:   " << _explored << std::endl
                     << "\texpanded states:   " << _expanded << std::endl
                     << "\tmax tokens:        " << max_tokens << std::endl;
+            if (_lasso)
+                _lasso->print_stats(os);
         }
 
         const PetriEngine::PetriNet& _net;
@@ -114,6 +123,8 @@ namespace LTL {
         bool _shortcircuitweak;
         bool _build_trace = false;
         Heuristic* _heuristic = nullptr;
+        // non-null if the heuristic should be told about accepting states on the search path.
+        LassoHeuristic* _lasso = nullptr;
         size_t _loop = std::numeric_limits<size_t>::max();
         std::vector<std::vector<uint32_t>> _trace;
         bool _violation = false;
@@ -0,0 +1,107 @@
+/* Copyright (C) 2021  Nikolaj J. Ulrik <nikolaj@njulrik.dk>,
+ *                     Simon M. Virenfeldt <simon@simwir.dk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef VERIFYPN_SHAREDPRODUCTCHECKER_H
+#define VERIFYPN_SHAREDPRODUCTCHECKER_H
+
+#include "LTL/Algorithm/ModelChecker.h"
+#include "LTL/Structures/MarkingGraph.h"
+#include "LTL/SuccessorGeneration/BuchiSuccessorGenerator.h"
+
+#include <unordered_map>
+#include <vector>
+
+namespace LTL {
+
+    /**
+     * Tarjan-based emptiness check of the product of a Büchi automaton with a MarkingGraph shared between several
+     * formulae. Only the product layer (marking id, Büchi state) belongs to this checker; net successors come
+     * from the shared graph, so markings expanded while checking an earlier formula are not expanded again.
+     * Does not build traces and does not use partial order reduction or heuristics.
+     */
+    class SharedProductChecker : public ModelChecker {
+    public:
+        SharedProductChecker(const PetriEngine::PetriNet& net, const PetriEngine::PQL::Condition_ptr &cond,
+                             const Structures::BuchiAutomaton &buchi, Structures::MarkingGraph& graph);
+
+        bool check() override;
+
+        void print_stats(std::ostream &os) const override {
+            ModelChecker::print_stats(os, _discovered, max_tokens());
+        }
+
+        size_t max_tokens() const override { return _graph.max_tokens(); }
+
+        size_t get_discovered() const override { return _discovered; }
+
+        size_t get_markings() const override { return _markings; }
+
+        size_t get_configurations() const override { return _discovered; }
+
+    private:
+        static constexpr size_t buchi_bits = 20;
+        using product_t = size_t;
+
+        struct node_t {
+            size_t lowlink;
+            bool on_stack = true;
+            bool accepting;
+            bool self_loop = false;
+        };
+
+        struct frame_t {
+            product_t state;
+            size_t index;
+            std::vector<product_t> successors;
+            size_t next = 0;
+        };
+
+        static product_t product(size_t marking, size_t q) { return (marking << buchi_bits) | q; }
+        static size_t marking_of(product_t p) { return p >> buchi_bits; }
+        static size_t buchi_of(product_t p) { return p & ((size_t{1} << buchi_bits) - 1); }
+
+        const std::vector<std::pair<size_t, bdd>>& buchi_edges(size_t q);
+
+        void successors(product_t state, std::vector<product_t>& out);
+
+        // pushes a product state onto the Tarjan stacks, returns false if it witnesses a violation on its own.
+        bool push(product_t state);
+
+        // advances the top frame by one successor, returns false on a violation.
+        bool step();
+
+        void pop_component(size_t root);
+
+        Structures::MarkingGraph& _graph;
+        BuchiSuccessorGenerator _buchi_gen;
+        PetriEngine::Structures::State _state;
+        std::vector<std::vector<std::pair<size_t, bdd>>> _edges;
+        std::vector<bool> _edges_known;
+        std::unordered_map<product_t, size_t> _index;
+        std::vector<node_t> _nodes;
+        // node indices, in discovery order
+        std::vector<size_t> _tarjan;
+        // indices of the accepting states on the Tarjan stack
+        std::vector<size_t> _accepting;
+        std::vector<frame_t> _dstack;
+        std::vector<bool> _seen_markings;
+        size_t _discovered = 0;
+        size_t _markings = 0;
+    };
+}
+
+#endif //VERIFYPN_SHAREDPRODUCTCHECKER_H
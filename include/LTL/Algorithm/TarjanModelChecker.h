@@ -25,6 +25,7 @@
 #include "LTL/SuccessorGeneration/ResumingSuccessorGenerator.h"
 #include "LTL/SuccessorGeneration/SpoolingSuccessorGenerator.h"
 #include "utils/structures/light_deque.h"
+#include "utils/structures/paged_stack.h"
 
 #include <ptrie/ptrie.h>
 
@@ -72,6 +73,10 @@ namespace LTL {
 
         virtual void set_partial_order(LTLPartialOrder);
 
+        void set_stack_memory(size_t bytes) override {
+            _stack_memory = bytes;
+        }
+
         LTLPartialOrder used_partial_order() const {
             return _order;
         }
@@ -80,7 +85,7 @@ namespace LTL {
         template<typename SuccGen>
         bool select_trace_compute(SuccGen& successorGenerator);
 
-        template<bool TRACE, typename SuccGen>
+        template<bool TRACE, bool Paged, typename SuccGen>
         bool compute(SuccGen& successorGenerator);
 
         using State = LTL::Structures::ProductState;
@@ -124,10 +129,19 @@ namespace LTL {
             : _pos(pos), _sucinfo(std::move(info)) {}
         };
 
+        // with a memory bound, entries holding resumable successor positions can be paged out,
+        // entries owning spooled successor buffers have to stay in memory.
+        template<typename T, bool Paged>
+        using dstack_t = std::conditional_t<Paged && std::is_trivially_copyable_v<dentry_t<T>>,
+                paged_stack<dentry_t<T>>, light_deque<dentry_t<T>>>;
+
 
         // cstack positions of accepting states in current search path, for quick access.
         light_deque<idx_t> _astack;
 
+        // scratch state for restoring the lasso seed when backtracking past an accepting state.
+        State _seed_state;
+
         bool _invariant_loop = true;
         size_t _loop_state = std::numeric_limits<size_t>::max();
         uint32_t _loop_trans = std::numeric_limits<uint32_t>::max();
@@ -135,28 +149,31 @@ namespace LTL {
         size_t _max_tokens = std::numeric_limits<size_t>::max();
         size_t _markings = 0;
         size_t _configurations = 0;
+        size_t _stack_memory = 0;
+        size_t _stack_page_outs = 0;
         const uint32_t _k_bound = 0;
         const uint32_t _hyper_traces = 0;
         LTLPartialOrder _order = LTLPartialOrder::None;
 
         // TODO, instead of this template hell, we should really just have a templated state that we shuffle around.
-        template<typename StateSet, typename T, typename D, typename S>
-        void push(StateSet& s, light_deque<T>& cstack, light_deque<D>& dstack, S& successor_generator, State &state, size_t stateid);
+        // the stacks are light_deques, or paged_stacks when their memory is bounded.
+        template<typename StateSet, typename C, typename D, typename S>
+        void push(StateSet& s, C& cstack, D& dstack, S& successor_generator, State &state, size_t stateid);
 
-        template<typename S, typename T, typename D, typename SuccGen>
-        void pop(S& seen, light_deque<T>& cstack, light_deque<D>& dstack, SuccGen& successorGenerator);
+        template<typename S, typename C, typename D, typename SuccGen>
+        void pop(S& seen, C& cstack, D& dstack, SuccGen& successorGenerator);
 
-        template<typename T, typename D, typename SuccGen>
-        void update(light_deque<T>& cstack, light_deque<D>& d, SuccGen& successorGenerator, idx_t to);
+        template<typename C, typename D, typename SuccGen>
+        void update(C& cstack, D& d, SuccGen& successorGenerator, idx_t to);
 
-        template<typename S, typename T, typename SuccGen, typename D>
-        bool next_trans(S& seen, light_deque<T>& cstack, SuccGen& successorGenerator, State &state, State &parent, D &delem);
+        template<typename S, typename C, typename SuccGen, typename D>
+        bool next_trans(S& seen, C& cstack, SuccGen& successorGenerator, State &state, State &parent, D &delem);
 
-        template<typename StateSet, typename T>
-        void popCStack(StateSet& s, light_deque<T>& cstack);
+        template<typename StateSet, typename C>
+        void popCStack(StateSet& s, C& cstack);
 
         template<typename S, typename D, typename C>
-        void build_trace(S& seen, light_deque<D> &&dstack, light_deque<C>& cstack);
+        void build_trace(S& seen, light_deque<D> &&dstack, C& cstack);
     };
 }
 
@@ -0,0 +1,78 @@
+#ifndef VERIFYPN_TERMINALREACHABILITYCHECKER_H
+#define VERIFYPN_TERMINALREACHABILITYCHECKER_H
+
+#include "LTL/Algorithm/ModelChecker.h"
+#include "LTL/Structures/BitProductStateSet.h"
+#include "LTL/Structures/ProductStateFactory.h"
+
+#include <limits>
+
+namespace LTL {
+
+    /**
+     * Model checker for terminal Büchi automata, i.e. automata where every accepting state has an invariant
+     * (true-guarded) self-loop. For such automata every reachable accepting product state closes an accepting
+     * lasso on its own (deadlocks loop by the product semantics), so the emptiness check reduces to plain
+     * reachability of an accepting product state and no cycle detection is needed.
+     * The product is explored with a reachability-style waiting list, BFS/DFS/RDFS or best-first using the
+     * LTL heuristic, instead of the depth-first order required by Tarjan or NDFS.
+     */
+    class TerminalReachabilityChecker : public ModelChecker {
+    public:
+        TerminalReachabilityChecker(const PetriEngine::PetriNet& net, const PetriEngine::PQL::Condition_ptr &cond,
+                                    const Structures::BuchiAutomaton &buchi, uint32_t kbound,
+                                    Strategy strategy, uint64_t seed)
+                : ModelChecker(net, cond, buchi), _k_bound(kbound), _strategy(strategy), _seed(seed)
+        {
+            if (buchi.buchi().num_states() > 1048576) {
+                throw base_error("Cannot handle Büchi automata larger than 2^20 states");
+            }
+        }
+
+        /**
+         * @return true if every accepting state of the automaton has an invariant self-loop.
+         */
+        static bool is_terminal(const Structures::BuchiAutomaton &buchi);
+
+        bool check() override;
+
+        void print_stats(std::ostream &os) const override;
+
+        size_t max_tokens() const override { return _max_tokens; }
+
+        size_t get_discovered() const override { return _discovered; }
+
+        size_t get_markings() const override { return _markings; }
+
+        size_t get_configurations() const override { return _configurations; }
+
+        void set_partial_order(LTLPartialOrder o) override;
+
+        LTLPartialOrder used_partial_order() const override {
+            return _order;
+        }
+
+    private:
+        using State = LTL::Structures::ProductState;
+
+        template<typename SuccGen>
+        bool select_trace_compute(SuccGen& successorGenerator);
+
+        template<bool SaveTrace, typename SuccGen>
+        bool compute(SuccGen& successorGenerator);
+
+        template<typename S>
+        void build_trace(S& seen, size_t stateid, const std::vector<size_t>& initial);
+
+        const uint32_t _k_bound = 0;
+        const Strategy _strategy;
+        const uint64_t _seed;
+        LTLPartialOrder _order = LTLPartialOrder::None;
+        size_t _discovered = 0;
+        size_t _max_tokens = 0;
+        size_t _markings = 0;
+        size_t _configurations = 0;
+    };
+}
+
+#endif //VERIFYPN_TERMINALREACHABILITYCHECKER_H
@@ -56,7 +56,8 @@ namespace LTL {
         Automaton = 1,
         FireCount = 2,
         DFS = 3, // only used for testing atm
-        RDFS = 4 // only used for testing atm
+        RDFS = 4, // only used for testing atm
+        Potency = 5
     };
 
     inline auto to_string(Algorithm alg) {
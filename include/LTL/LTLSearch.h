@@ -33,6 +33,9 @@
 #include "LTLOptions.h"
 #include "Algorithm/ModelChecker.h"
 #include "Algorithm/NestedDepthFirstSearch.h"
+#include "Algorithm/TerminalReachabilityChecker.h"
+#include "Structures/MarkingGraph.h"
+#include "SuccessorGeneration/LassoHeuristic.h"
 
 namespace LTL {
 
@@ -47,6 +50,10 @@ namespace LTL {
         APCompression _compression;
         std::unique_ptr<ModelChecker> _checker;
         std::unique_ptr<Heuristic> _heuristic;
+        Structures::MarkingGraph* _marking_graph = nullptr;
+        size_t _stack_memory = 0;
+        std::vector<uint32_t> _potencies;
+        bool _terminal_reach = false;
         bool _result;
 
     public:
@@ -62,7 +69,40 @@ namespace LTL {
                 const Strategy search_strategy = Strategy::HEUR,
                 const LTLHeuristic heuristics = LTLHeuristic::Automaton,
                 const bool utilize_weak = true,
-                const uint64_t seed = 0);
+                const uint64_t seed = 0,
+                const bool lasso = false,
+                const bool terminal_reach = false);
+        /**
+         * Check the formula on top of a marking graph shared with other searches on the same net, so that markings
+         * already expanded for earlier formulae are not expanded again (see SharedProductChecker).
+         * Ignored when a trace is requested or for hyper-LTL. The graph must outlive the call to solve.
+         */
+        void set_marking_graph(Structures::MarkingGraph* graph) {
+            _marking_graph = graph;
+        }
+
+        /**
+         * Bound the memory of the Tarjan search stacks to the given number of bytes, paging the rest out to disk.
+         */
+        void set_stack_memory(size_t bytes) {
+            _stack_memory = bytes;
+        }
+
+        /**
+         * Seed the transition potencies of LTLHeuristic::Potency, e.g. with the LP-based initial potencies.
+         */
+        void set_initial_potencies(std::vector<uint32_t> potencies) {
+            _potencies = std::move(potencies);
+        }
+
+        /**
+         * @return the path formula the Büchi automaton accepts, i.e. the negation of f for A f and f itself for E f.
+         * A run satisfying it is a counterexample (or witness), so this is the formula to seed potencies from.
+         */
+        PetriEngine::PQL::Condition_ptr searched_formula() const {
+            return std::make_shared<PetriEngine::PQL::NotCondition>(_negated_formula);
+        }
+
         void print_buchi(std::ostream& out, const BuchiOutType type = BuchiOutType::Dot);
         void print_stats(std::ostream& out);
 
@@ -74,6 +114,13 @@ namespace LTL {
             return _checker->is_weak();
         }
 
+        /**
+         * @return true if the automaton was terminal and the formula was decided by reachability of an accepting state.
+         */
+        bool used_terminal_reach() const {
+            return _terminal_reach;
+        }
+
         size_t max_tokens() const {
             return _checker->max_tokens();
         }
@@ -101,6 +148,13 @@ namespace LTL {
             return ss.str();
         }
 
+        /**
+         * @return the lasso heuristic of the last call to solve, or nullptr if it was solved without one.
+         */
+        const LassoHeuristic* lasso() const {
+            return dynamic_cast<const LassoHeuristic*>(_heuristic.get());
+        }
+
         bool print_trace(std::ostream& out, const PetriEngine::Reducer& reducer) const;
 
         const std::vector<std::vector<uint32_t>>& raw_trace() const { return _checker->trace(); }
@@ -108,7 +162,7 @@ namespace LTL {
     private:
         void _print_trace(const PetriEngine::Reducer& reducer, std::ostream& os) const;
         std::ostream &
-        print_transition(uint32_t transition, const PetriEngine::Reducer& reducer, std::ostream &os, const std::string& _indend, const std::string& _token_indent, bool& printed_deadlock) const;
+        print_transition(uint32_t transition, const PetriEngine::TraceExpander& expander, std::ostream &os, const std::string& _indend, const std::string& _token_indent, bool& printed_deadlock) const;
 
     };
 
@@ -0,0 +1,105 @@
+/* Copyright (C) 2021  Nikolaj J. Ulrik <nikolaj@njulrik.dk>,
+ *                     Simon M. Virenfeldt <simon@simwir.dk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef VERIFYPN_MARKINGGRAPH_H
+#define VERIFYPN_MARKINGGRAPH_H
+
+#include "PetriEngine/PetriNet.h"
+#include "PetriEngine/SuccessorGenerator.h"
+#include "PetriEngine/Structures/State.h"
+#include "PetriEngine/Structures/StateSet.h"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+namespace LTL { namespace Structures {
+
+    /**
+     * The reachable markings of a net and their successors, explored on demand and shared between the products
+     * of several Büchi automata (see SharedProductChecker). The successors of a marking are computed by the first
+     * product that expands it and kept for every later one, so each marking is expanded once however many
+     * formulae are checked. As in the product semantics, a deadlocked marking is its own successor.
+     * Markings above the k-bound are left out.
+     */
+    class MarkingGraph {
+    public:
+        static constexpr auto none = std::numeric_limits<size_t>::max();
+
+        explicit MarkingGraph(const PetriEngine::PetriNet& net, uint32_t kbound = 0)
+                : _markings(net, kbound, net.numberOfPlaces()), _generator(net)
+        {
+            _parent.setMarking(net.makeInitialMarking());
+            _working.setMarking(new PetriEngine::MarkVal[net.numberOfPlaces()]);
+            _initial = _markings.add(_parent).second;
+        }
+
+        /** @return the id of the initial marking, or none if it is above the k-bound */
+        size_t initial() const { return _initial; }
+
+        /** @return the ids of the successors of the marking, computed the first time they are asked for */
+        const std::vector<size_t>& successors(size_t id)
+        {
+            if (id < _expanded.size() && _expanded[id])
+                return _successors[id];
+            _markings.decode(_parent, id);
+            _generator.prepare(&_parent);
+            std::vector<size_t> successors;
+            bool deadlock = true;
+            while (_generator.next(_working)) {
+                deadlock = false;
+                auto [_, sid] = _markings.add(_working);
+                if (sid != none)
+                    successors.push_back(sid);
+            }
+            if (deadlock)
+                successors.push_back(id);
+            std::sort(successors.begin(), successors.end());
+            successors.erase(std::unique(successors.begin(), successors.end()), successors.end());
+            if (_expanded.size() < _markings.size()) {
+                _expanded.resize(_markings.size(), false);
+                _successors.resize(_markings.size());
+            }
+            _expanded[id] = true;
+            ++_expansions;
+            _successors[id] = std::move(successors);
+            return _successors[id];
+        }
+
+        void decode(PetriEngine::Structures::State& state, size_t id) { _markings.decode(state, id); }
+
+        /** @return the number of markings discovered so far */
+        size_t size() const { return _markings.size(); }
+
+        /** @return the number of markings whose successors have been computed, each exactly once */
+        size_t expansions() const { return _expansions; }
+
+        size_t max_tokens() const { return _markings.maxTokens(); }
+
+    private:
+        PetriEngine::Structures::StateSet _markings;
+        PetriEngine::SuccessorGenerator _generator;
+        PetriEngine::Structures::State _parent;
+        PetriEngine::Structures::State _working;
+        std::vector<std::vector<size_t>> _successors;
+        std::vector<bool> _expanded;
+        size_t _initial = none;
+        size_t _expansions = 0;
+    };
+} }
+
+#endif //VERIFYPN_MARKINGGRAPH_H
@@ -23,5 +23,7 @@
 #include "AutomatonHeuristic.h"
 #include "FireCountHeuristic.h"
 #include "LogFireCountHeuristic.h"
+#include "LassoHeuristic.h"
+#include "PotencyHeuristic.h"
 
 #endif //VERIFYPN_HEURISTICS_H
@@ -0,0 +1,153 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef VERIFYPN_LASSOHEURISTIC_H
+#define VERIFYPN_LASSOHEURISTIC_H
+
+#include "LTL/SuccessorGeneration/Heuristic.h"
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace LTL {
+    /**
+     * Two-phase heuristic for counter-example search.
+     * Until an accepting product state is on the search path, successors are ordered by the wrapped heuristic
+     * (or not at all if there is none). Once the model checker reports an accepting seed state,
+     * successors are ordered by their token distance to the marking of the seed,
+     * steering the search toward closing the lasso loop as quickly as possible.
+     */
+    class LassoHeuristic : public Heuristic {
+    public:
+        LassoHeuristic(const PetriEngine::PetriNet *net, std::unique_ptr<Heuristic> &&inner)
+                : _net(net), _inner(std::move(inner)), _seed(net->numberOfPlaces()) {}
+
+        void prepare(const Structures::ProductState &state) override
+        {
+            if (!_has_seed && _inner)
+                _inner->prepare(state);
+        }
+
+        uint32_t eval(const Structures::ProductState &state, uint32_t tid) override
+        {
+            if (!_has_seed)
+                return _inner ? _inner->eval(state, tid) : 0;
+            ++_guided;
+            uint64_t dist = 0;
+            for (uint32_t p = 0; p < _net->numberOfPlaces(); ++p) {
+                auto a = state.marking()[p];
+                auto b = _seed[p];
+                dist += a > b ? a - b : b - a;
+            }
+            return static_cast<uint32_t>(std::min<uint64_t>(dist, std::numeric_limits<uint32_t>::max()));
+        }
+
+        bool has_heuristic(const Structures::ProductState &state) override
+        {
+            if (_has_seed)
+                return true;
+            return _inner && _inner->has_heuristic(state);
+        }
+
+        void push(uint32_t tid) override
+        {
+            if (_inner) _inner->push(tid);
+        }
+
+        void pop(uint32_t tid) override
+        {
+            if (_inner) _inner->pop(tid);
+        }
+
+        /**
+         * Make the marking of state the target of the search.
+         * @param state accepting state on the current search path
+         * @param fresh false if the seed is restored after backtracking out of a later seed
+         */
+        void set_seed(const Structures::ProductState &state, bool fresh = true)
+        {
+            std::copy(state.marking(), state.marking() + _net->numberOfPlaces(), _seed.begin());
+            _has_seed = true;
+            if (fresh)
+                ++_seeds;
+        }
+
+        void clear_seed()
+        {
+            _has_seed = false;
+        }
+
+        bool has_seed() const
+        {
+            return _has_seed;
+        }
+
+        /**
+         * Record that an accepting cycle was closed.
+         * @param length number of states on the search path between seed and closing state.
+         */
+        void closed(size_t length)
+        {
+            ++_closures;
+            _closure_length = length;
+            _closed_guided = _has_seed;
+        }
+
+        /** @return the number of accepting states the search was steered towards */
+        size_t seeds() const { return _seeds; }
+
+        /** @return the number of successors ordered by their distance to a seed */
+        size_t guided() const { return _guided; }
+
+        /** @return the number of accepting cycles closed, at most one as the search stops at a violation */
+        size_t closures() const { return _closures; }
+
+        std::ostream &output(std::ostream &os) override
+        {
+            os << "LASSO";
+            if (_inner) {
+                os << "(";
+                _inner->output(os);
+                os << ")";
+            }
+            return os;
+        }
+
+        void print_stats(std::ostream &os) const
+        {
+            os << "\tlasso seeds:       " << _seeds << std::endl
+               << "\tguided successors: " << _guided << std::endl
+               << "\tclosed cycles:     " << _closures << std::endl;
+            if (_closures > 0)
+                os << "\tcycle length:      " << _closure_length
+                   << (_closed_guided ? " (guided)" : "") << std::endl;
+        }
+
+    private:
+        const PetriEngine::PetriNet *_net;
+        std::unique_ptr<Heuristic> _inner;
+        std::vector<PetriEngine::MarkVal> _seed;
+        bool _has_seed = false;
+        bool _closed_guided = false;
+        size_t _seeds = 0;
+        size_t _guided = 0;
+        size_t _closures = 0;
+        size_t _closure_length = 0;
+    };
+}
+
+#endif //VERIFYPN_LASSOHEURISTIC_H
@@ -0,0 +1,102 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef VERIFYPN_POTENCYHEURISTIC_H
+#define VERIFYPN_POTENCYHEURISTIC_H
+
+#include "Heuristic.h"
+#include "AutomatonHeuristic.h"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+namespace LTL {
+    /**
+     * Automaton-driven heuristic where each transition additionally carries a potency that is learned online.
+     * Whenever firing a transition brings the marking closer to (resp. further from) satisfying a progressing
+     * guard of the current Büchi state, the potency of the transition is raised (resp. lowered) by the change in
+     * distance, as done by the reachability PotencyQueue. Successors are ranked by their automaton distance scaled
+     * down by the potency of the transition producing them.
+     * Potencies may be seeded with the LP-based potencies also used for reachability (see initialize_potency).
+     */
+    class PotencyHeuristic : public Heuristic {
+    public:
+        PotencyHeuristic(const PetriEngine::PetriNet *net, const Structures::BuchiAutomaton &aut,
+                         const std::vector<uint32_t> &init_potencies = {})
+                : _progress(net, aut)
+        {
+            if (init_potencies.empty())
+                _potencies.resize(net->numberOfTransitions(), _default_potency);
+            else {
+                assert(init_potencies.size() == net->numberOfTransitions());
+                _potencies.reserve(init_potencies.size());
+                for (auto p : init_potencies)
+                    _potencies.push_back(p * _init_potency_multiplier + _init_potency_constant);
+            }
+        }
+
+        void prepare(const Structures::ProductState &state) override
+        {
+            _parent_dist = _progress.eval(state, 0);
+        }
+
+        uint32_t eval(const Structures::ProductState &state, uint32_t tid) override
+        {
+            const uint32_t dist = _progress.eval(state, tid);
+            learn(tid, dist);
+            if (dist == std::numeric_limits<uint32_t>::max())
+                return dist;
+            const uint64_t weight = (uint64_t{dist} + 1) * _default_potency / _potencies[tid];
+            return static_cast<uint32_t>(std::min<uint64_t>(weight, std::numeric_limits<uint32_t>::max() - 1));
+        }
+
+        bool has_heuristic(const Structures::ProductState &state) override
+        {
+            return _progress.has_heuristic(state);
+        }
+
+        std::ostream &output(std::ostream &os) override
+        {
+            return os << "POTENCY_HEUR";
+        }
+
+    private:
+        void learn(uint32_t tid, uint32_t dist)
+        {
+            constexpr auto inf = std::numeric_limits<uint32_t>::max();
+            if (dist == inf || _parent_dist == inf || dist == _parent_dist)
+                return;
+            auto &p = _potencies[tid];
+            if (dist < _parent_dist)
+                p = static_cast<uint32_t>(std::min<uint64_t>(uint64_t{p} + (_parent_dist - dist), _max_potency));
+            else if (p - 1 >= dist - _parent_dist)
+                p -= dist - _parent_dist;
+            else
+                p = 1;
+        }
+
+        AutomatonHeuristic _progress;
+        std::vector<uint32_t> _potencies;
+        uint32_t _parent_dist = std::numeric_limits<uint32_t>::max();
+
+        static constexpr uint32_t _default_potency = 100;
+        static constexpr uint32_t _max_potency = 1U << 24U;
+        static constexpr uint32_t _init_potency_constant = 1;
+        static constexpr uint32_t _init_potency_multiplier = 60;
+    };
+}
+
+#endif //VERIFYPN_POTENCYHEURISTIC_H
@@ -34,8 +34,9 @@ namespace PetriEngine {
         bool _hasPartition = false;
 
     public:
-        void parse_model(const std::string&& model);
-        void parse_model(std::istream& model);
+        /** Reads a net in PNML, colored expressions are parsed on the given number of threads */
+        void parse_model(const std::string&& model, uint32_t threads = 1);
+        void parse_model(std::istream& model, uint32_t threads = 1);
 
         /** Add a new place with a unique name */
         virtual void addPlace(const std::string& name,
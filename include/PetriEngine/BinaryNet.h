@@ -0,0 +1,48 @@
+/*
+ * File:   BinaryNet.h
+ *
+ * Compact binary format of P/T nets.
+ */
+
+#ifndef BINARYNET_H
+#define BINARYNET_H
+
+#include "PetriEngine/PetriNet.h"
+#include "PetriEngine/PetriNetBuilder.h"
+
+#include <ostream>
+#include <string>
+
+namespace PetriEngine {
+
+    /**
+     * A P/T net as a versioned block of arrays in native byte order, written by --write-reduced-binary and read
+     * by --binary-model. The names are a table of offsets into one block of characters, and the arcs are in
+     * compressed sparse row form: per transition an offset into parallel arrays of places and weights. A file
+     * is memory mapped when read and the arrays are taken from the mapping without parsing, but they are copied
+     * into the PetriNetBuilder, so loading still builds the net as from PNML, only without the XML.
+     *
+     *   char   magic[8]                "VPNNET01"
+     *   uint32 places, transitions
+     *   uint32 name_offsets[places + transitions + 1]    places first, then transitions
+     *   char   names[name_offsets[places + transitions]]
+     *   uint32 marking[places]
+     *   double place_xy[2 * places]
+     *   int32  player[transitions]
+     *   double transition_xy[2 * transitions]
+     *   uint32 pre_offsets[transitions + 1]
+     *   uint32 pre_place[pre], pre_weight[pre]
+     *   uint8  pre_inhibitor[pre]
+     *   uint32 post_offsets[transitions + 1]
+     *   uint32 post_place[post], post_weight[post]
+     */
+    class BinaryNet {
+    public:
+        static void write(const PetriNet& net, std::ostream& out);
+
+        /** Adds the net in the file to the builder. Throws base_error if the file is not a valid binary net. */
+        static void read(const std::string& path, PetriNetBuilder& builder);
+    };
+}
+
+#endif /* BINARYNET_H */
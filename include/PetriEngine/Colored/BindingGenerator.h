@@ -21,6 +21,7 @@
 #include <unordered_map>
 
 #include "ColoredNetStructures.h"
+#include "CompiledExpression.h"
 #include "EquivalenceClass.h"
 #include "ForwardFixedPoint.h"
 
@@ -60,6 +61,12 @@ namespace PetriEngine {
     };
 
 
+    /**
+     * Enumerates the bindings allowed by the forward fixed point, one variable map at a time.
+     * Variables are assigned one by one, smallest domain first, and the top-level comparisons of the guard
+     * prune the domains while assigning: equalities determine variables from those already assigned,
+     * comparisons with constants restrict the domains up front. The full guard is evaluated on every complete binding.
+     */
     class FixpointBindingGenerator {
     public:
         class Iterator {
@@ -76,23 +83,65 @@ namespace PetriEngine {
             const Colored::BindingMap& operator*() const;
         };
     private:
+        // a side of a guard comparison: a variable or constant color, shifted by successor/predecessor applications.
+        struct term_t {
+            // index of the variable, -1 for a constant
+            int32_t _var = -1;
+            const Colored::Color* _constant = nullptr;
+            int32_t _offset = 0;
+        };
+
+        // a top-level conjunct of the guard comparing two terms.
+        struct constraint_t {
+            enum op_t { EQ, NEQ, LT, LEQ };
+            op_t _op;
+            term_t _lhs;
+            term_t _rhs;
+        };
+
+        // unit of assignment; a single variable or a group of symmetric variables assigned jointly.
+        struct slot_t {
+            // indices of the variables
+            std::vector<uint32_t> _vars;
+            int32_t _group = -1;
+            // candidate colors of a single variable, sorted on id.
+            std::vector<const Colored::Color*> _domain;
+            // equality constraint determining the variable from previously assigned slots, -1 if none.
+            int32_t _forcing = -1;
+            // binary constraints decided once this slot is assigned.
+            std::vector<uint32_t> _checks;
+            size_t _next = 0;
+        };
+
         const Colored::GuardExpression_ptr &_expr;
-        Colored::BindingMap _bindings;
+        Colored::CompiledExpression _guard;
+        // built on demand from _values
+        mutable Colored::BindingMap _bindings;
         std::vector<std::vector<std::vector<uint32_t>>> _symmetric_var_combinations;
         const Colored::ColorTypeMap& _colorTypes;
         const Colored::Transition &_transition;
         const std::vector<std::set<const Colored::Variable *>>& _symmetric_vars;
         const Colored::ForwardFixedPoint::VarMap& _var_map;
-        Colored::BindingMap::iterator _bindingIterator;
+        std::vector<const Colored::Variable*> _variables;
+        std::vector<const Colored::Color*> _values;
+        std::vector<constraint_t> _constraints;
+        std::vector<slot_t> _slots;
+        size_t _depth = 0;
+        bool _prepared = false;
         bool _isDone;
         bool _noValidBindings;
         uint32_t _nextIndex = 0;
-        uint32_t _currentOuterId = 0;
-        uint32_t _currentInnerId = 0;
-        uint32_t _symmetric_vars_set = 0;
 
         bool eval() const;
-        bool assignSymmetricVars();
+        void extractConstraints(const Colored::GuardExpression& expr);
+        void addConstraint(constraint_t::op_t op, const Colored::ColorExpression& lhs, const Colored::ColorExpression& rhs);
+        bool prepare(uint32_t index);
+        bool advance(slot_t& slot);
+        bool search();
+        void findBinding();
+        void step();
+        const Colored::Color* value(const term_t& term) const;
+        bool holds(const constraint_t& constraint) const;
         void generateCombinations(
             uint32_t options,
             uint32_t samples,
@@ -109,6 +158,16 @@ namespace PetriEngine {
 
         const Colored::BindingMap& nextBinding();
         const Colored::BindingMap& currentBinding() const;
+
+        // the variables of the transition and their colors in the current binding, indexed alike
+        const std::vector<const Colored::Variable*>& variables() const {
+            return _variables;
+        }
+
+        const std::vector<const Colored::Color*>& values() const {
+            return _values;
+        }
+
         bool isInitial() const;
         Iterator begin();
         Iterator end();
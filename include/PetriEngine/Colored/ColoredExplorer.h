@@ -0,0 +1,125 @@
+/*
+ * File:   ColoredExplorer.h
+ *
+ * Explicit state-space exploration of a colored net, without unfolding it first.
+ */
+
+#ifndef COLOREDEXPLORER_H
+#define COLOREDEXPLORER_H
+
+#include "ColoredNetStructures.h"
+#include "CompiledExpression.h"
+#include "PetriEngine/PQL/PQL.h"
+#include "PetriEngine/options.h"
+
+#include <ptrie/ptrie_map.h>
+
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+namespace PetriEngine {
+    class ColoredPetriNetBuilder;
+    namespace Colored {
+
+        /**
+         * Explores the reachable markings of a colored net directly, for reachability queries (EF/AG) whose atoms
+         * only refer to colored places and transitions. A marking stores, per place, the multiset of tokens as
+         * (color id, count) pairs; states are kept in a ptrie as a compact variable-length encoding of it.
+         * The enabled bindings of a transition are computed lazily for each expanded marking: the candidate colors
+         * of a variable are restricted to the tokens present in the input places it is bound by, and only then is
+         * the guard evaluated and the input arcs checked against the marking.
+         */
+        class ColoredExplorer {
+        public:
+            enum class Result { Satisfied, NotSatisfied, Unknown };
+
+            explicit ColoredExplorer(const ColoredPetriNetBuilder& builder);
+
+            /**
+             * @return true if the query is of the form EF phi or AG phi where phi only uses cardinality,
+             * fireability and deadlock atoms over the colored net.
+             */
+            bool supports(const PQL::Condition_ptr& query);
+
+            /**
+             * Decides a query for which supports() holds. If trace is set and the query is satisfied (for EF) or
+             * violated (for AG), the witness is printed as a sequence of colored transitions and their bindings.
+             * @param timeout seconds after which the exploration gives up with Result::Unknown
+             * @return Result::Unknown also if a reachable marking is too large to be stored
+             */
+            Result check(const PQL::Condition_ptr& query, Strategy strategy, bool trace, double timeout);
+
+            size_t discovered() const {
+                return _discovered;
+            }
+
+            size_t explored() const {
+                return _explored;
+            }
+
+        private:
+            using token_t = std::pair<uint32_t, uint32_t>;      // color id and count, sorted by color id
+            using marking_t = std::vector<std::vector<token_t>>;
+
+            struct history_t {
+                size_t _parent;
+                uint32_t _transition;
+            };
+
+            // variable that is bound by the tokens of an input place, possibly as a component of a tuple
+            struct occurrence_t {
+                uint32_t _variable;
+                uint32_t _place;
+                int32_t _component;
+            };
+
+            struct transition_t {
+                std::vector<const Variable*> _variables;
+                std::vector<occurrence_t> _occurrences;
+                bool _has_guard = false;
+                CompiledExpression _guard;
+                std::vector<CompiledExpression> _input;
+                std::vector<CompiledExpression> _output;
+                std::vector<std::pair<uint32_t, uint32_t>> _inhibitors;   // place and weight
+            };
+
+            using condition_t = std::function<bool()>;
+            using expression_t = std::function<int64_t()>;
+
+            void collect_occurrences(const ArcExpression& expr, uint32_t place, transition_t& t);
+            condition_t compile(const PQL::Condition_ptr& cond);
+            expression_t compile(const PQL::Expr_ptr& expr);
+            const PQL::Condition_ptr* reachability_goal(const PQL::Condition_ptr& query, bool& negate_goal,
+                                                        bool& negate_result) const;
+
+            // enumerates the enabled bindings of a transition in the current marking, stopping early if the
+            // callback returns false. The successor marking is handed to the callback.
+            template<typename F>
+            bool for_each_binding(uint32_t tid, F&& callback);
+            bool is_enabled(uint32_t tid);
+            bool is_deadlock();
+            bool fire(uint32_t tid, const std::vector<const Color*>& values, marking_t& result) const;
+            uint64_t tokens(uint32_t place) const;
+
+            // @return false if the encoding is too large to be stored
+            bool encode(const marking_t& marking);
+            void decode(size_t id, marking_t& marking);
+            void print_trace(size_t state);
+
+            const ColoredPetriNetBuilder& _builder;
+            std::vector<transition_t> _transitions;
+            std::unique_ptr<ptrie::map<unsigned char, history_t>> _states;
+            size_t _initial = 0;
+            // marking the query atoms are evaluated on
+            marking_t _current;
+            std::vector<unsigned char> _encoded;
+            std::vector<unsigned char> _scratch;
+            size_t _discovered = 0;
+            size_t _explored = 0;
+        };
+    }
+}
+
+#endif /* COLOREDEXPLORER_H */
@@ -25,6 +25,7 @@
 #include <istream>
 
 #include "../AbstractPetriNetBuilder.h"
+#include "../BinaryNet.h"
 #include "../PetriNetBuilder.h"
 
 namespace PetriEngine {
@@ -44,6 +45,11 @@ namespace PetriEngine {
         ColoredPetriNetBuilder(const ColoredPetriNetBuilder& orig);
         virtual ~ColoredPetriNetBuilder();
 
+        /** Reads a P/T net written by BinaryNet::write */
+        void parse_binary_model(const std::string& path) {
+            BinaryNet::read(path, _ptBuilder);
+        }
+
         void addPlace(const std::string& name,
                 uint32_t tokens,
                 double x,
@@ -27,6 +27,10 @@
 #include <utility>
 #include <vector>
 #include <unordered_map>
+#ifdef VERIFYPN_MC_Simplification
+#include <mutex>
+#include <shared_mutex>
+#endif
 #include <iostream>
 #include <cassert>
 
@@ -194,6 +198,11 @@ namespace PetriEngine {
         private:
             std::vector<const ColorType*> _constituents;
             mutable std::unordered_map<size_t,Color> _cache;
+#ifdef VERIFYPN_MC_Simplification
+            // colors are created on demand, possibly by several unfolding threads at once; lookups of
+            // colors already created only share the lock, as nodes of the map never move.
+            mutable std::shared_mutex _cache_lock;
+#endif
 
         public:
             ProductType(const std::string& name = "Undefined") : ColorType(name) {}
@@ -0,0 +1,82 @@
+/*
+ * File:   CompiledExpression.h
+ *
+ * Guard and arc expressions of a transition compiled to a flat instruction sequence.
+ */
+
+#ifndef COMPILEDEXPRESSION_H
+#define COMPILEDEXPRESSION_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "Colors.h"
+#include "EquivalenceVec.h"
+#include "Expressions.h"
+
+namespace PetriEngine {
+    namespace Colored {
+
+        /**
+         * Postfix instruction sequence equivalent to a guard or arc expression under EvaluationVisitor.
+         * Variables are read from dense slots, given by their index in the variable vector the expression was
+         * compiled against, and constants are resolved (and mapped through the place partition) at compile time.
+         * The evaluation stacks are kept between calls, so once they have grown evaluating a binding does not
+         * allocate. Because of these mutable stacks an instance is not thread-safe, even through const methods:
+         * threads evaluating the same expression each need their own copy.
+         */
+        class CompiledExpression {
+        public:
+            using token_t = std::pair<const Color*, uint32_t>;
+
+            enum class op_t : uint8_t {
+                Constant, Variable, Successor, Predecessor, Tuple,
+                LessThan, LessThanEq, Equality, Inequality, And, Or,
+                NumberOf, Add, Subtract, Scalar
+            };
+
+            struct instruction_t {
+                op_t _op;
+                // slot, arity or scalar depending on the operation
+                uint32_t _arg = 0;
+                // multiplicity of a number-of expression
+                uint32_t _number = 0;
+                const Color* _color = nullptr;
+                const ProductType* _type = nullptr;
+            };
+
+            static CompiledExpression compile(const GuardExpression& expr, const std::vector<const Variable*>& slots,
+                                              const ColorTypeMap& colorTypes);
+
+            static CompiledExpression compile(const ArcExpression& expr, const std::vector<const Variable*>& slots,
+                                              const ColorTypeMap& colorTypes, const EquivalenceVec& placePartition);
+
+            bool evaluate_guard(const std::vector<const Color*>& values) const;
+
+            /**
+             * @return the tokens of the multiset, one entry per color in order of first occurrence, without zero counts.
+             */
+            const std::vector<token_t>& evaluate_arc(const std::vector<const Color*>& values) const;
+
+            const std::vector<instruction_t>& instructions() const {
+                return _program;
+            }
+
+        private:
+            void run(const std::vector<const Color*>& values) const;
+            void subtract() const;
+            void compact(size_t begin) const;
+
+            std::vector<instruction_t> _program;
+            mutable std::vector<const Color*> _colors;
+            mutable std::vector<uint8_t> _bools;
+            mutable std::vector<uint32_t> _marks;
+            mutable std::vector<token_t> _tokens;
+
+            friend class ExpressionCompiler;
+        };
+    }
+}
+
+#endif /* COMPILEDEXPRESSION_H */
@@ -32,6 +32,8 @@
 #include "Colors.h"
 #include "PartitionBuilder.h"
 
+#include <functional>
+#include <queue>
 #include <vector>
 #include <unordered_map>
 #include <limits>
@@ -53,15 +55,23 @@ namespace PetriEngine {
             double _fixPointCreationTime;
             size_t _max_intervals = 0;
             std::vector<std::unordered_map<uint32_t, Colored::ArcIntervals>> _arcIntervals;
-            std::vector<uint32_t> _placeFixpointQueue;
+            // places to process as (rank, place), places with a lower rank first
+            std::priority_queue<std::pair<uint32_t, uint32_t>, std::vector<std::pair<uint32_t, uint32_t>>, std::greater<>> _placeFixpointQueue;
+            // distance from the initially marked places, such that places are mostly settled before their successors
+            std::vector<uint32_t> _placeRank;
+            // number of times the colors of a place have grown, places growing too often are widened
+            std::vector<uint32_t> _placeUpdates;
+            static constexpr uint32_t _wideningDelay = 32;
             std::vector<Colored::ColorFixpoint> _placeColorFixpoints;
             const PartitionBuilder& _partition;
             std::unordered_map<uint32_t, Colored::ArcIntervals> setupTransitionVars(size_t tid) const;
-            void processInputArcs(const Colored::Transition& transition, uint32_t currentPlaceId, uint32_t transitionId, bool &transitionActivated, uint32_t max_intervals);
+            void processInputArcs(const Colored::Transition& transition, uint32_t transitionId, bool &transitionActivated);
             void processOutputArcs(const Colored::Transition& transition, size_t transition_id);
             void removeInvalidVarmaps(size_t tid);
             void addTransitionVars(size_t tid);
-            void getArcIntervals(const Colored::Transition& transition, bool &transitionActivated, uint32_t max_intervals, uint32_t transitionId);
+            void getArcIntervals(const Colored::Transition& transition, bool &transitionActivated, uint32_t transitionId);
+            void restrictInputPlaces(const Colored::Transition& transition, uint32_t max_intervals);
+            void computeRanks();
             void add_place(const Colored::Place& place);
             void init();
         public:
@@ -70,7 +80,12 @@ namespace PetriEngine {
             }
 
             void printPlaceTable() const;
-            void compute(uint32_t maxIntervals, uint32_t maxIntervalsReduced, int32_t timeout);
+            /**
+             * Places are processed in batches of equal rank. The input side of the transitions in a batch only reads
+             * the place constraints and is evaluated on the given number of threads, the colors they produce are then
+             * added to the output places in transition order.
+             */
+            void compute(uint32_t maxIntervals, uint32_t maxIntervalsReduced, int32_t timeout, uint32_t threads = 1);
 
             double time() const {
                 return _fixPointCreationTime;
@@ -598,6 +598,34 @@ namespace PetriEngine {
 
 
 
+            // Widening w.r.t. the constraints before the latest update: every bound that moved beyond the hull of
+            // before is set to the corresponding bound of full, the interval of the whole color type.
+            void widen(const interval_vector_t& before, const interval_t& full) {
+                if (before.empty()) {
+                    return;
+                }
+                interval_t hull = before.front();
+                for (const auto& interval : before) {
+                    for (uint32_t k = 0; k < hull.size(); k++) {
+                        hull[k]._lower = std::min(hull[k]._lower, interval[k]._lower);
+                        hull[k]._upper = std::max(hull[k]._upper, interval[k]._upper);
+                    }
+                }
+                assert(full.size() == hull.size());
+                for (auto& interval : _intervals) {
+                    for (uint32_t k = 0; k < interval.size(); k++) {
+                        if (interval[k]._lower < hull[k]._lower) {
+                            interval[k]._lower = full[k]._lower;
+                        }
+                        if (interval[k]._upper > hull[k]._upper) {
+                            interval[k]._upper = full[k]._upper;
+                        }
+                    }
+                }
+                combineNeighbours();
+                simplify();
+            }
+
             void restrict(uint32_t k) {
                 simplify();
                 if(k == 0){
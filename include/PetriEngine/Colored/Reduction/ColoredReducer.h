@@ -20,7 +20,7 @@
 #include "RedRuleDeadTransitions.h"
 #include "RedRuleRedundantPlaces.h"
 #include "RedRulePreemptiveFiring.h"
-
+#include "utils/parallel_for.h"
 
 namespace PetriEngine::Colored {
 
@@ -40,7 +40,7 @@ namespace PetriEngine::Colored {
 
         class ColoredReducer {
         public:
-            ColoredReducer(PetriEngine::ColoredPetriNetBuilder &b);
+            ColoredReducer(PetriEngine::ColoredPetriNetBuilder &b, uint32_t threads = 1);
 
             std::vector<ApplicationSummary> createApplicationSummary() const;
 
@@ -48,6 +48,13 @@ namespace PetriEngine::Colored {
                         bool preserveLoops, bool preserveStutter, uint32_t reduceMode,
                         std::vector<uint32_t>& userSequence);
 
+            /**
+             * Applies only the relevance rule, removing the colored places and transitions outside the cone of
+             * influence of the queries, regardless of the reduction mode. Used to unfold only what the queries observe.
+             */
+            bool reduceToQueryCone(uint32_t timeout, const PetriEngine::PQL::ColoredUseVisitor &inQuery,
+                                   QueryType queryType, bool preserveLoops, bool preserveStutter);
+
             double time() const {
                 return _timeSpent;
             }
@@ -119,6 +126,31 @@ namespace PetriEngine::Colored {
 
             void consistent();
 
+            /**
+             * Every modification of the net increments the version and stamps the places whose surroundings
+             * (the place itself, its transitions and their arcs) changed. A rule only needs to revisit the places
+             * stamped after its previous application, the others gave the same result then.
+             */
+            uint32_t version() const {
+                return _version;
+            }
+
+            bool placeChangedSince(uint32_t pid, uint32_t version) const {
+                return pid >= _placeVersion.size() || _placeVersion[pid] > version;
+            }
+
+            // for rules modifying the marking of a place directly
+            void markPlaceChanged(uint32_t pid);
+
+            /**
+             * Calls f(i) for every i in [0, n), on several threads if the reducer was given more than one.
+             * f must only read the net; applying the results is left to the caller.
+             */
+            template<typename F>
+            void parallelFor(size_t n, F&& f) const {
+                parallel_for(n, _threads, std::forward<F>(f));
+            }
+
             std::vector<uint8_t> _tflags;
 
             std::vector<uint8_t> _pflags;
@@ -135,6 +167,11 @@ namespace PetriEngine::Colored {
             uint32_t _tnameid = 1;
             std::vector<uint32_t> _skippedPlaces;
             std::vector<uint32_t> _skippedTransitions;
+            uint32_t _threads;
+            uint32_t _version = 1;
+            std::vector<uint32_t> _placeVersion;
+
+            void markTransitionChanged(uint32_t tid);
 
             std::vector<ReductionRule *> buildApplicationSequence(std::vector<uint32_t>& userReductionSequence) {
                 std::vector<ReductionRule *> resultSequence;
@@ -20,6 +20,15 @@ namespace PetriEngine::Colored::Reduction {
 
         bool apply(ColoredReducer &red, const PetriEngine::PQL::ColoredUseVisitor &inQuery, QueryType queryType,
                    bool preserveLoops, bool preserveStutter) override;
+
+    private:
+        // the place of the pair that can be removed, or -1. Only reads the net.
+        int64_t removablePlace(const ColoredReducer &red, const PetriEngine::PQL::ColoredUseVisitor &inQuery,
+                               uint32_t pid_outer, uint32_t pid_inner) const;
+
+        // whether p2 can be removed in favour of p1; trySwap is cleared if p1 can not be removed in favour of p2 either
+        bool canRemove(const ColoredReducer &red, const PetriEngine::PQL::ColoredUseVisitor &inQuery,
+                       uint32_t p1, uint32_t p2, bool &trySwap) const;
     };
 }
 
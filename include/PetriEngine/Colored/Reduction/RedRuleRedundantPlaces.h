@@ -18,10 +18,17 @@ namespace PetriEngine::Colored::Reduction {
         bool apply(ColoredReducer &red, const PetriEngine::PQL::ColoredUseVisitor &inQuery, QueryType queryType,
                    bool preserveLoops, bool preserveStutter) override;
 
-        bool markingEnablesInArc(Multiset &marking, const Arc &arc,
+        bool markingEnablesInArc(const Multiset &marking, const Arc &arc,
                                  const Colored::Transition &transition,
-                                 PartitionBuilder &partition,
+                                 const PartitionBuilder &partition,
                                  const ColorTypeMap &colors) const;
+
+    private:
+        bool isCandidate(const ColoredReducer &red, const PetriEngine::PQL::ColoredUseVisitor &inQuery,
+                         uint32_t p) const;
+
+        // safe to call concurrently for different places, as long as the net is not modified
+        bool isRedundant(ColoredReducer &red, uint32_t p, const PartitionBuilder &partition) const;
     };
 }
 
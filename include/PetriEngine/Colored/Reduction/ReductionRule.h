@@ -35,8 +35,18 @@ namespace PetriEngine::Colored::Reduction {
         virtual bool apply(ColoredReducer &red, const PetriEngine::PQL::ColoredUseVisitor &inQuery, QueryType queryType,
                            bool preserveLoops, bool preserveStutter) = 0;
 
+        // version of the net (see ColoredReducer::version) when the rule was last applied
+        uint32_t lastVersion() const {
+            return _lastVersion;
+        }
+
+        void setLastVersion(uint32_t version) {
+            _lastVersion = version;
+        }
+
     protected:
         uint32_t _applications = 0;
+        uint32_t _lastVersion = 0;
     };
 }
 
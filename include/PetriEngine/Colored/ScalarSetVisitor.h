@@ -0,0 +1,152 @@
+/*
+ * File:   ScalarSetVisitor.h
+ *
+ * Finds the color types whose colors are not interchangeable in the expressions of a net.
+ */
+
+#ifndef SCALARSETVISITOR_H
+#define SCALARSETVISITOR_H
+
+#include "Expressions.h"
+
+#include <set>
+#include <vector>
+
+namespace PetriEngine {
+    namespace Colored {
+
+        /**
+         * Collects the color types whose colors are ordered by an expression (successor, predecessor, < and <=)
+         * or referred to by name in a guard. The remaining types are candidate scalar sets: permuting their colors
+         * may be a symmetry of the net. Constants on arcs are not collected since T.all is parsed into all of its
+         * constants; whether the arcs and the initial marking are symmetric is decided on the unfolded net.
+         */
+        class ScalarSetVisitor : public ColorExpressionVisitor {
+        private:
+            std::set<const ColorType*>& _ordered;
+            bool _guard = false;
+            // the (flattened) color types of each color expression on the stack
+            std::vector<std::vector<const ColorType*>> _types;
+
+            void push(const ColorType* type) {
+                _types.emplace_back();
+                type->getColortypes(_types.back());
+            }
+
+            void order(size_t operands) {
+                for (size_t i = _types.size() - operands; i < _types.size(); ++i)
+                    _ordered.insert(_types[i].begin(), _types[i].end());
+            }
+
+            template<typename T>
+            void compare(const T* e, bool ordering) {
+                (*e)[0]->visit(*this);
+                (*e)[1]->visit(*this);
+                if (ordering)
+                    order(2);
+                _types.resize(_types.size() - 2);
+            }
+
+        public:
+            ScalarSetVisitor(std::set<const ColorType*>& ordered) : _ordered(ordered) {
+            }
+
+            void visit_guard(const GuardExpression& expr) {
+                _guard = true;
+                expr.visit(*this);
+                _types.clear();
+            }
+
+            void visit_arc(const ArcExpression& expr) {
+                _guard = false;
+                expr.visit(*this);
+                _types.clear();
+            }
+
+            void accept(const DotConstantExpression*) override {
+                push(ColorType::dotInstance());
+            }
+
+            void accept(const VariableExpression* e) override {
+                push(e->variable()->colorType);
+            }
+
+            void accept(const UserOperatorExpression* e) override {
+                push(e->user_operator()->getColorType());
+                if (_guard)
+                    order(1);
+            }
+
+            void accept(const SuccessorExpression* e) override {
+                e->child()->visit(*this);
+                order(1);
+            }
+
+            void accept(const PredecessorExpression* e) override {
+                e->child()->visit(*this);
+                order(1);
+            }
+
+            void accept(const TupleExpression* tup) override {
+                for (const auto& color : *tup)
+                    color->visit(*this);
+                std::vector<const ColorType*> types;
+                for (size_t i = _types.size() - tup->size(); i < _types.size(); ++i)
+                    types.insert(types.end(), _types[i].begin(), _types[i].end());
+                _types.resize(_types.size() - tup->size());
+                _types.push_back(std::move(types));
+            }
+
+            void accept(const LessThanExpression* e) override {
+                compare(e, true);
+            }
+
+            void accept(const LessThanEqExpression* e) override {
+                compare(e, true);
+            }
+
+            void accept(const EqualityExpression* e) override {
+                compare(e, false);
+            }
+
+            void accept(const InequalityExpression* e) override {
+                compare(e, false);
+            }
+
+            void accept(const AndExpression* e) override {
+                (*e)[0]->visit(*this);
+                (*e)[1]->visit(*this);
+            }
+
+            void accept(const OrExpression* e) override {
+                (*e)[0]->visit(*this);
+                (*e)[1]->visit(*this);
+            }
+
+            void accept(const AllExpression*) override {
+            }
+
+            void accept(const NumberOfExpression* no) override {
+                for (const auto& elem : *no)
+                    elem->visit(*this);
+                _types.resize(_types.size() - no->size());
+            }
+
+            void accept(const AddExpression* add) override {
+                for (const auto& expr : *add)
+                    expr->visit(*this);
+            }
+
+            void accept(const SubtractExpression* sub) override {
+                (*sub)[0]->visit(*this);
+                (*sub)[1]->visit(*this);
+            }
+
+            void accept(const ScalarProductExpression* scalar) override {
+                scalar->child()->visit(*this);
+            }
+        };
+    }
+}
+
+#endif /* SCALARSETVISITOR_H */
@@ -0,0 +1,77 @@
+/*
+ * File:   UnfoldCache.h
+ *
+ * On-disk cache of reduced and unfolded colored nets.
+ */
+
+#ifndef UNFOLDCACHE_H
+#define UNFOLDCACHE_H
+
+#include "PetriEngine/PetriNetBuilder.h"
+#include "PetriEngine/Structures/StateSymmetry.h"
+#include "utils/structures/shared_string.h"
+
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace PetriEngine {
+    namespace Colored {
+
+        /**
+         * Stores the result of the colored reductions and the unfolding (the P/T net, the maps from colored to
+         * unfolded names, the printed bindings and the scalar sets) in a directory, one file per key. The key is
+         * a hash of everything the result depends on: the model file, the options and the parts of the queries
+         * the colored reductions preserve. Files are written to a temporary name and renamed, so concurrent runs
+         * sharing a directory never read a partial entry, and they are memory mapped when loaded.
+         */
+        class UnfoldCache {
+        public:
+            struct entry_t {
+                PetriNetBuilder _builder;
+                shared_name_name_map _transition_names;
+                shared_place_color_map _place_names;
+                std::string _bindings;
+                std::vector<Structures::place_blocks_t> _scalar_sets;
+                size_t _arcs = 0;
+            };
+
+            explicit UnfoldCache(std::string directory) : _directory(std::move(directory)) {
+            }
+
+            /** Adds the contents of a file to the key. */
+            void add_file(const std::string& path);
+
+            void add(const void* data, size_t size);
+
+            template<typename T>
+            void add(const T& value) {
+                static_assert(std::is_trivially_copyable_v<T>);
+                add(&value, sizeof(T));
+            }
+
+            void add(const std::vector<uint32_t>& values) {
+                add(values.size());
+                add(values.data(), values.size() * sizeof(uint32_t));
+            }
+
+            std::string path() const;
+
+            /**
+             * @return the entry for the key, with names interned in string_set, or nothing if there is none or it
+             *         cannot be read (it is then rewritten by store()).
+             */
+            std::optional<entry_t> load(shared_string_set& string_set) const;
+
+            void store(const PetriNetBuilder& builder, const shared_name_name_map& transition_names,
+                       const shared_place_color_map& place_names, const std::string& bindings,
+                       const std::vector<Structures::place_blocks_t>* scalar_sets, size_t arcs) const;
+
+        private:
+            std::string _directory;
+            uint64_t _key = 0;
+        };
+    }
+}
+
+#endif /* UNFOLDCACHE_H */
@@ -33,8 +33,13 @@
 #include "SymmetryVisitor.h"
 #include "ForwardFixedPoint.h"
 #include "PetriEngine/PetriNetBuilder.h"
+#include "PetriEngine/Structures/StateSymmetry.h"
 #include "VariableSymmetry.h"
 #include "StablePlaceFinder.h"
+#include "CompiledExpression.h"
+
+#include <iostream>
+#include <limits>
 
 
 namespace PetriEngine {
@@ -45,45 +50,99 @@ namespace PetriEngine {
             const ColoredPetriNetBuilder& _builder;
             void getArcIntervals(const Colored::Transition& transition, bool &transitionActivated, uint32_t max_intervals, uint32_t transitionId);
 
-            void unfoldPlace(PetriNetBuilder& ptBuilder, const Colored::Place* place, const PetriEngine::Colored::Color *color, uint32_t unfoldPlace, uint32_t id);
-            void unfoldTransition(PetriNetBuilder& builder, uint32_t transitionId);
-            void handleOrphanPlace(PetriNetBuilder& ptBuilder, const Colored::Place& place, const shared_name_index_map& unfoldedPlaceMap);
+            // An arc of one unfolded transition, computed without touching the PT builder.
+            struct unfolded_arc_t {
+                uint32_t place;
+                uint32_t id;                        // id of the unfolded place within the colored place
+                const Colored::Color* color;
+                uint32_t weight;
+                bool input;
+                bool sum;                           // arc to the sum place of an inhibited place
+            };
+
+            struct unfolded_binding_t {
+                Colored::BindingMap binding;        // only kept when printing bindings
+                std::vector<unfolded_arc_t> arcs;
+            };
+
+            using unfolded_transition_t = std::vector<unfolded_binding_t>;
+
+            uint32_t unfoldPlace(PetriNetBuilder& ptBuilder, const Colored::Place* place, const PetriEngine::Colored::Color *color, uint32_t placeId, uint32_t id);
+            // calls f with each binding of the transition in turn, evaluated into a buffer that is reused
+            template<typename F>
+            void forEachBinding(uint32_t transitionId, F&& f) const;
+            unfolded_transition_t evaluateTransition(uint32_t transitionId) const;
+            // input arcs followed by output arcs, compiled against the given variable order
+            std::vector<Colored::CompiledExpression> compileArcs(const Colored::Transition& transition,
+                                                                 const std::vector<const Colored::Variable*>& variables) const;
+            void evaluateArcs(const Colored::Transition& transition, const std::vector<Colored::CompiledExpression>& arcs,
+                              const std::vector<const Colored::Color*>& values, std::vector<unfolded_arc_t>& out) const;
+            void evaluateArc(const Colored::Arc& arc, const Colored::CompiledExpression& expr,
+                             const std::vector<const Colored::Color*>& values, std::vector<unfolded_arc_t>& out) const;
+            void mergeBinding(PetriNetBuilder& ptBuilder, uint32_t transitionId, size_t index, unfolded_binding_t& binding);
+            void mergeTransition(PetriNetBuilder& ptBuilder, uint32_t transitionId, unfolded_transition_t&& bindings);
+            // evaluates and merges one binding at a time, as used without threads
+            void unfoldTransition(PetriNetBuilder& ptBuilder, uint32_t transitionId);
+            void handleOrphanPlace(PetriNetBuilder& ptBuilder, uint32_t placeId);
             void createPartionVarmaps();
-            void unfoldInhibitorArc(PetriNetBuilder& ptBuilder, const shared_const_string &oldname, const shared_const_string &newname);
+            void unfoldInhibitorArcs(PetriNetBuilder& ptBuilder, uint32_t transitionId, uint32_t ptTransition);
+            uint32_t sumPlace(PetriNetBuilder& ptBuilder, uint32_t placeId);
             std::string arc_to_string(const Colored::Arc& arc) const;
-            void unfoldArc(PetriNetBuilder& ptBuilder, const Colored::Arc& arc, const Colored::BindingMap& binding, const shared_const_string& name);
             Colored::StablePlaceFinder _stable;
             double _time = 0;
-            shared_place_color_map _ptplacenames;
-            shared_name_name_map _pttransitionnames;
             uint32_t _nptarcs = 0;
-            std::vector<shared_const_string> _sumPlacesNames;
             const VariableSymmetry& _symmetry;
             const PartitionBuilder& _partition;
             const ForwardFixedPoint& _fixed_point;
-            
+
+            // Bookkeeping is done on indices; the name maps handed to the query analysis are only built on request.
+            static constexpr uint32_t no_place = std::numeric_limits<uint32_t>::max();
+            // per colored place, the id of each unfolded place (as used in place_names()) to its index in the PT net
+            std::vector<std::unordered_map<uint32_t, uint32_t>> _unfoldedPlaces;
+            std::vector<uint32_t> _sumPlaces;
+            // per colored transition, the indices of its unfolded transitions
+            std::vector<std::vector<uint32_t>> _unfoldedTransitions;
+            std::vector<bool> _transitionUnfolded;
+            // per colored transition, its inhibitor arcs as indices into the builder's inhibitors
+            std::vector<std::vector<uint32_t>> _inhibitorsOf;
+            std::vector<shared_const_string> _placeNames;
+            // per unfolded place, the color it was unfolded for (null for sum and orphan places)
+            std::vector<const Colored::Color*> _placeColors;
+            std::vector<shared_const_string> _transitionNames;
+            mutable shared_place_color_map _ptplacenames;
+            mutable shared_name_name_map _pttransitionnames;
+            mutable bool _names_built = false;
+            void buildNames() const;
+
             bool _print_bindings;
-            std::unordered_map<std::string, Colored::BindingMap> _transitionBinding;
-            void storeBinding(const shared_const_string& name, const Colored::BindingMap& binding);
+            uint32_t _threads;
+            std::vector<std::pair<uint32_t, Colored::BindingMap>> _transitionBinding;
             
         public:
-            Unfolder(const ColoredPetriNetBuilder& b, const PartitionBuilder& partition, const VariableSymmetry& symmetry, const ForwardFixedPoint& fixed_point, bool print_bindings)
+            /**
+             * @param threads number of threads evaluating bindings and arc expressions. The unfolded net is
+             *        identical for any number of threads (requires VERIFYPN_MC_Simplification, otherwise sequential).
+             */
+            Unfolder(const ColoredPetriNetBuilder& b, const PartitionBuilder& partition, const VariableSymmetry& symmetry, const ForwardFixedPoint& fixed_point, bool print_bindings, uint32_t threads = 1)
             : _builder(b),
               _stable(b),
               _symmetry(symmetry),
               _partition(partition),
               _fixed_point(fixed_point),
-              _print_bindings(print_bindings) {}
+              _print_bindings(print_bindings),
+              _threads(threads) {}
 
             PetriNetBuilder unfold();
 
             size_t number_of_arcs() const { return _nptarcs; }
 
             const shared_place_color_map& place_names() const {
+                buildNames();
                 return _ptplacenames;
             }
 
             const shared_name_name_map& transition_names() const {
+                buildNames();
                 return _pttransitionnames;
             }
 
@@ -91,10 +150,17 @@ namespace PetriEngine {
                 return _time;
             }
 
+            /**
+             * For every color type that is a candidate scalar set (see ScalarSetVisitor), the unfolded places
+             * grouped per color such that permuting the colors permutes the groups. Types occurring twice in
+             * the type of a place, or in a place with a non-trivial partition, are skipped. Call after unfold().
+             */
+            std::vector<Structures::place_blocks_t> scalar_sets() const;
+
             PetriNetBuilder strip_colors();
 
         
-            void printBinding();
+            void printBinding(std::ostream& out = std::cout);
 
 
         };
@@ -20,6 +20,23 @@
 #include "Visitor.h"
 
 namespace PetriEngine { namespace PQL {
+    /**
+     * A file of binary queries (--binary-query-io) is a container, laid out in native byte order as
+     *
+     *   char   magic[8]                  binary_query_magic
+     *   uint32 queries
+     *   uint32 names                     the places of the net the queries were written for, each
+     *          uint32 id, uint32 length, char name[length]
+     *   uint64 offsets[queries + 1]      of every query, relative to the end of this array
+     *          the name of the query, terminated by '\0', followed by the query as written by BinaryPrinter
+     *
+     * Places are referred to by their id, so a reader can select queries through the offsets and needs the
+     * names only of the places the selected queries use. Files written before this container start directly
+     * with the number of queries, store each name as uint32 id followed by a '\0'-terminated string, and have
+     * no offsets; QueryBinaryParser still reads them, decoding every query.
+     */
+    constexpr char binary_query_magic[8] = {'V', 'P', 'N', 'Q', 'R', 'Y', '0', '1'};
+
     class BinaryPrinter : public Visitor {
     public:
         explicit BinaryPrinter(std::ostream& os) :
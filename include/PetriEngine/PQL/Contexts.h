@@ -72,6 +72,14 @@ namespace PetriEngine {
             /** Resolve an identifier */
             virtual ResolutionResult resolve(const shared_const_string& identifier, bool place = true);
 
+            /**
+             * Resolve a place that may already carry its offset, as places read from a binary query file do.
+             * The offset is used if the net has the same name there, which is a pointer comparison as names
+             * are interned; otherwise the name is resolved as usual. Contexts that observe every resolved place
+             * override this to always go through resolve.
+             */
+            virtual ResolutionResult resolvePlace(const shared_const_string& identifier, uint32_t offset);
+
             uint32_t resolve_trace_name(const std::string& s, bool create);
 
             auto& allPlaceNames() const { return _placeNames; }
@@ -150,6 +150,7 @@ namespace PetriEngine {
         friend class ReducingSuccessorGenerator;
         friend class STSolver;
         friend class StubbornSet;
+        friend class BinaryNet;
     };
 
 } // PetriEngine
@@ -30,22 +30,29 @@
 #include "NetStructures.h"
 #include "Reachability/ReachabilityResult.h"
 namespace PetriEngine {
+    namespace Colored {
+        class UnfoldCache;
+    }
+
     /** Builder for building engine representations of PetriNets */
     class PetriNetBuilder : public AbstractPetriNetBuilder {
     public:
         friend class Reducer;
+        friend class Colored::UnfoldCache;
 
     public:
         PetriNetBuilder(shared_string_set& string_set);
         PetriNetBuilder(const PetriNetBuilder& other);
         PetriNetBuilder(PetriNetBuilder&&);
         void addPlace(const std::string& name, uint32_t tokens, double x, double y) override;
-        void addPlace(const shared_const_string& name, uint32_t tokens, double x, double y);
+        /** @return the index of the place */
+        uint32_t addPlace(const shared_const_string& name, uint32_t tokens, double x, double y);
         void addTransition(const std::string& name,
                 int32_t player,
                 double x,
                 double y) override;
-        void addTransition(const shared_const_string& name,
+        /** @return the index of the transition */
+        uint32_t addTransition(const shared_const_string& name,
                 int32_t player,
                 double x,
                 double y);
@@ -55,6 +62,9 @@ namespace PetriEngine {
                 bool inhibitor,
                 uint32_t weight);
         void addOutputArc(const shared_const_string& transition, const shared_const_string& place, uint32_t weight);
+        /** Arcs between a place and a transition given by their indices, avoiding the name lookups */
+        void addInputArc(uint32_t place, uint32_t transition, bool inhibitor, uint32_t weight);
+        void addOutputArc(uint32_t transition, uint32_t place, uint32_t weight);
 
         void addInputArc(const std::string& place,
                 const std::string& transition,
@@ -65,8 +75,12 @@ namespace PetriEngine {
         void saveInitialNet();
 
         virtual void sort() override;
-        /** Make the resulting petri net, you take ownership */
-        PetriNet* makePetriNet(bool reorder = true);
+        /**
+         * Make the resulting petri net, you take ownership
+         * @param reorder renumber places and transitions for faster successor generation
+         * @param locality when reordering, number the places so those sharing transitions are adjacent
+         */
+        PetriNet* makePetriNet(bool reorder = true, bool locality = false);
         /** Make the resulting initial marking, you take ownership */
 
         MarkVal const * initMarking()
@@ -134,7 +148,7 @@ namespace PetriEngine {
         void reduce(std::vector<std::shared_ptr<PQL::Condition> >& query,
                     std::vector<Reachability::ResultPrinter::Result>& results,
                     int reductiontype, bool reconstructTrace, const PetriNet* net, int timeout,
-                    std::vector<uint32_t>& reductions);
+                    std::vector<uint32_t>& reductions, uint32_t threads = 1);
 
         void printStats(std::ostream& out)
         {
@@ -154,7 +168,8 @@ namespace PetriEngine {
         }
 
     private:
-        uint32_t nextPlaceId(std::vector<uint32_t>& counts,  std::vector<uint32_t>& pcounts, std::vector<uint32_t>& ids, bool reorder);
+        /** The places in reverse Cuthill-McKee order of the graph of places sharing a transition */
+        std::vector<uint32_t> localityOrder() const;
         std::chrono::high_resolution_clock::time_point _start;
 
     protected:
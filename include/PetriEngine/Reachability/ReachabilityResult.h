@@ -69,13 +69,17 @@ namespace PetriEngine {
             options_t* options;
             std::vector<std::string>& querynames;
             Reducer* reducer;
+            bool coloredExploration = false;
 
             std::string printTechniques();
+            // the full technique list, starting with the TECHNIQUES keyword
+            std::string usedTechniques();
             void printTrace(Structures::StateSetInterface*, size_t lastmarking);
 
         public:
             const std::string techniques = "TECHNIQUES COLLATERAL_PROCESSING STRUCTURAL_REDUCTION QUERY_REDUCTION SAT_SMT ";
             const std::string techniquesStateSpace = "TECHNIQUES EXPLICIT STATE_COMPRESSION";
+            const std::string techniquesColoredExploration = "TECHNIQUES EXPLICIT COLORED_EXPLORATION ";
 
             ResultPrinter(PetriNetBuilder* b, options_t* o, std::vector<std::string>& querynames)
             : builder(b), options(o), querynames(querynames), reducer(NULL)
@@ -83,6 +87,9 @@ namespace PetriEngine {
 
             void setReducer(Reducer* r) { this->reducer = r; }
 
+            // answers are reported as found by exploring the colored net, without unfolding
+            void setColoredExploration(bool b) { this->coloredExploration = b; }
+
             std::pair<Result, bool> handle(
                 size_t index,
                 PQL::Condition* query,
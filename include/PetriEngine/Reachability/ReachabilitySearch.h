@@ -67,6 +67,14 @@ namespace PetriEngine {
                     const int64_t incRandomWalk = 5000,
                     const std::vector<MarkVal>& initPotencies = std::vector<MarkVal>());
             size_t maxTokens() const;
+
+            /**
+             * Symmetries used to store one marking per orbit. Only used by untraced searches with a StateSet;
+             * it must preserve the queries given to reachable().
+             */
+            void setSymmetry(const Structures::StateSymmetry* symmetry) {
+                _symmetry = symmetry;
+            }
         private:
             struct searchstate_t {
                 size_t expandedStates = 0;
@@ -114,6 +122,7 @@ namespace PetriEngine {
             Structures::State _initial;
             AbstractHandler& _callback;
             size_t _max_tokens = 0;
+            const Structures::StateSymmetry* _symmetry = nullptr;
         };
 
         template <typename G>
@@ -150,6 +159,8 @@ namespace PetriEngine {
             working.setMarking(_net.makeInitialMarking());
 
             W states(_net, _kbound); // stateset
+            if constexpr (std::is_same_v<W, Structures::StateSet>)
+                states.setSymmetry(_symmetry);
 
             Q queue(seed); // Working queue
             if constexpr (std::is_base_of_v<Structures::PotencyQueue, Q>) {
@@ -17,7 +17,12 @@
 #include "PQL/Contexts.h"
 #include "../PetriParse/PNMLParser.h"
 #include "NetStructures.h"
+#include "utils/parallel_for.h"
 
+#include <array>
+#include <functional>
+#include <limits>
+#include <ostream>
 #include <vector>
 #include <optional>
 
@@ -70,6 +75,11 @@ namespace PetriEngine {
             return result;
         }
 
+        // the stored offset must not skip resolve, which counts the places of the query
+        ResolutionResult resolvePlace(const shared_const_string& identifier, uint32_t) override {
+            return resolve(identifier, true);
+        }
+
     };
 
    struct ExpandedArc
@@ -88,13 +98,24 @@ namespace PetriEngine {
         size_t weight;
    };
 
+    /** A transition of a trace through the net before reduction, see TraceExpander */
+    struct TraceStep {
+        static constexpr uint32_t none = std::numeric_limits<uint32_t>::max();
+
+        uint32_t original;  // index in the net before reduction, or none if the net was not saved
+        uint32_t reduced;   // index in the reduced net, or none if fired by a reduction
+    };
+
+    class TraceExpander;
+
     class Reducer {
+        friend class TraceExpander;
     public:
         Reducer(PetriNetBuilder*);
         ~Reducer();
         void Print(QueryPlaceAnalysisContext& context); // prints the net, just for debugging
         void Reduce(QueryPlaceAnalysisContext& context, int enablereduction, bool reconstructTrace, int timeout, bool remove_loops,
-        bool all_reach, bool all_ltl, bool contains_next, std::vector<uint32_t>& reductions);
+        bool all_reach, bool all_ltl, bool contains_next, std::vector<uint32_t>& reductions, uint32_t threads = 1);
 
         size_t numberOfSkippedTransitions() const {
             return _skippedTransitions.size();
@@ -134,10 +155,7 @@ namespace PetriEngine {
                 << "Applications of rule S: " << _ruleS << std::endl;
         }
 
-        void postFire(std::ostream&, const std::string& transition) const;
-        void tokenConsumption(std::ostream&, const std::string& transition) const;
-        void initFire(std::ostream&) const;
-
+        /** Remembers the names and presets of the transitions before reduction, which traces are expanded into */
         void saveInitialNet();
 
     private:
@@ -187,6 +205,159 @@ namespace PetriEngine {
         void skipInArc(uint32_t, uint32_t);
         void skipOutArc(uint32_t, uint32_t);
 
+        // Every change to the net stamps the changed node with a new version, and its neighbours (whose rules
+        // read its arcs and flags) at most once per rule pass. A pass of a rule only examines the candidates
+        // stamped since the start of its previous complete pass, as nothing the others depend on has changed
+        // since they were last rejected, and a pass is skipped entirely if the previous one changed nothing and
+        // the net is unchanged since. This reaches the same fixpoint as examining every candidate in every pass.
+        enum Rule { RuleA, RuleB, RuleC, RuleD, RuleEP, RuleF, RuleFNO, RuleG, RuleH, RuleI, RuleJ, RuleK, RuleL,
+                    RuleM, RuleEFMNOP, RuleQ, RuleR, RuleS, NumberOfRules };
+
+        class RulePass {
+        public:
+            RulePass(Reducer& reducer, Rule rule);
+            ~RulePass();
+
+            // false if the pass is known to change nothing
+            explicit operator bool() const { return _run; }
+
+            bool placeChanged(uint32_t place) const {
+                return _reducer._placeVersion[place] > _since;
+            }
+
+            bool transitionChanged(uint32_t transition) const {
+                return transition >= _reducer._transitionVersion.size() ||
+                       _reducer._transitionVersion[transition] > _since;
+            }
+
+            // true if the place or any of its neighbours changed, for rules that look two arcs away
+            bool neighbourhoodChanged(uint32_t place) const {
+                return _reducer.neighbourhoodChangedSince(place, _since);
+            }
+
+        private:
+            Reducer& _reducer;
+            Rule _rule;
+            size_t _since;
+            size_t _start;
+            bool _run;
+        };
+
+        bool neighbourhoodChangedSince(uint32_t place, size_t version) const;
+
+        /**
+         * Calls f(i) for every i in [0, n), on several threads if the reducer was given more than one.
+         * f must only read the net; applying the results is left to the caller.
+         */
+        template<typename F>
+        void parallelFor(size_t n, F&& f) const {
+            parallel_for(n, _threads, std::forward<F>(f));
+        }
+
+        /**
+         * The checks of a place rule that only read the place, the transitions around it and the places around
+         * those (as rule S does with the presets of the producers). They are evaluated a batch of places at a time
+         * on the reducer's threads, ahead of the loop applying the rule in place order. A place whose surroundings
+         * were changed by that loop after its batch was checked is checked again when it is reached, so the rule is
+         * applied exactly as if each place was checked when reached. Touching a place stamps the transitions around
+         * it, so a change two arcs away shows as a changed transition next to the place.
+         */
+        template<typename T>
+        class PlaceChecks {
+        public:
+            using check_t = std::function<bool(uint32_t, T&)>;
+
+            PlaceChecks(Reducer& reducer, size_t places, check_t check)
+            : _reducer(reducer), _places(places), _check(std::move(check)) {}
+
+            // @return the result of the checks of the place, or nullptr if they failed
+            const T* operator()(uint32_t place) {
+                if (place < _begin || place >= _end) {
+                    checkBatch(place);
+                } else if (_reducer.neighbourhoodChangedSince(place, _snapshot)) {
+                    _results[place - _begin] = T{};
+                    _ok[place - _begin] = _check(place, _results[place - _begin]);
+                }
+                return _ok[place - _begin] ? &_results[place - _begin] : nullptr;
+            }
+
+        private:
+            void checkBatch(uint32_t first) {
+                const size_t size = _reducer._threads > 1 ? 64 * _reducer._threads : 1;
+                _begin = first;
+                _end = std::min(_places, first + size);
+                if (size > 1) {
+                    // changes after the snapshot must stamp the neighbours of the changed nodes
+                    _snapshot = _reducer._version;
+                    _reducer._lastPassStart = _snapshot;
+                }
+                _results.assign(_end - _begin, T{});
+                _ok.assign(_end - _begin, 0);
+                _reducer.parallelFor(_end - _begin, [this](size_t i) {
+                    _ok[i] = _check(_begin + i, _results[i]);
+                });
+            }
+
+            Reducer& _reducer;
+            size_t _places;
+            check_t _check;
+            size_t _begin = 0;
+            size_t _end = 0;
+            size_t _snapshot = 0;
+            std::vector<T> _results;
+            std::vector<uint8_t> _ok;
+        };
+
+        struct agglomeration_t {
+            uint32_t _maxConsumerWeight = 0;    // rule R
+            std::vector<bool> _todo;            // rule S, consumers that can be agglomerated
+            std::vector<bool> _kIsAlwaysOne;    // rule S
+        };
+
+        bool ruleRCandidate(const uint32_t* placeInQuery, uint32_t pid, agglomeration_t& candidate);
+        bool ruleSCandidate(const uint32_t* placeInQuery, uint32_t pid, bool atomic_viable, agglomeration_t& candidate);
+        bool initiallyEnabled(uint32_t transition) const;
+
+        /**
+         * Signature of the arcs of a place or transition, recomputed when its change stamp is newer. Identical
+         * transitions have the same hash, and a node whose pre (post) set is a subset of another's has a subset
+         * of its bits, so most pairs that cannot be parallel are rejected without comparing their arcs.
+         */
+        struct signature_t {
+            size_t _version = 0;    // when it was computed, 0 if never
+            uint64_t _hash = 0;     // of the arcs of a transition
+            uint64_t _pre = 0;      // a bit per pre place, or producer of a place
+            uint64_t _post = 0;     // a bit per post place, or consumer of a place
+        };
+
+        static bool subsetOf(uint64_t bits, uint64_t of) {
+            return (bits & ~of) == 0;
+        }
+
+        const signature_t& placeSignature(uint32_t place);
+        const signature_t& transitionSignature(uint32_t transition);
+
+        void resetVersions();
+        void touchPlace(uint32_t place);
+        void touchTransition(uint32_t transition);
+        void touchArc(uint32_t place, uint32_t transition);
+        // the transition gained or lost arcs, which changes the consumers or producers of its places
+        void touchArcs(uint32_t transition);
+        void stampTransition(uint32_t transition);
+
+        uint32_t _threads = 1;
+        size_t _version = 0;
+        size_t _lastPassStart = 0;
+        std::vector<size_t> _placeVersion;
+        std::vector<size_t> _placeNeighbours;
+        std::vector<size_t> _transitionVersion;
+        std::vector<size_t> _transitionNeighbours;
+        std::array<size_t, NumberOfRules> _passVersion{};
+        std::array<size_t, NumberOfRules> _unchangedVersion{};
+        std::vector<signature_t> _placeSignature;
+        std::vector<signature_t> _transitionSignature;
+        std::vector<uint32_t> _signatureBuffer;
+
         shared_const_string newTransName();
 
         bool consistent();
@@ -200,16 +371,67 @@ namespace PetriEngine {
             return (diff.count() >= timeout);
         }
 
-        std::vector<shared_const_string> _initfire;
-        std::unordered_map<std::string, std::vector<shared_const_string>> _postfire;
-        // _transitionsBeforeReduction[transitionName] = { {placeName, weight}, ... }
-        // Associate a transition with the vector of pre-places and their weights
-        std::unordered_map<std::string, std::vector<ExpandedArc>> _transitionsBeforeReduction;
+        /*
+         * The rewrite log of the reductions that preserve traces. An entry fires a transition a number of times,
+         * either at the initial marking or right after every firing of its trigger. The position of an entry is
+         * the time it was recorded at, and only the entries before it apply to the transitions it fires: later
+         * reductions account for the tokens these firings produced through the initial marking instead. The
+         * transitions are the indices of the net before reduction, which stay valid as long as no rule that
+         * creates transitions is applied, and those rules are disabled when traces are reconstructed.
+         */
+        struct rewrite_t {
+            uint32_t _trigger;      // or TraceStep::none at the initial marking
+            uint32_t _transition;
+            uint32_t _count;
+        };
+        std::vector<rewrite_t> _rewrites;
+        std::vector<uint32_t> _initialRewrites;
+        std::vector<std::vector<uint32_t>> _triggeredRewrites;   // by trigger, in the order of the log
+
+        void fireInitially(uint32_t transition, uint32_t count);
+        void fireAfter(uint32_t trigger, uint32_t transition, uint32_t count);
+
+        // the net before reduction: the names of the transitions, and the tokens each consumes
+        std::vector<shared_const_string> _originalTransitions;
+        std::vector<std::vector<ExpandedArc>> _originalPresets;
         std::vector<uint8_t> _tflags;
         std::vector<uint8_t> _pflags;
         std::vector<uint32_t> _lower;
         size_t _tnameid = 0;
     };
+
+    /**
+     * Expands traces of the reduced net into traces of the net before reduction, by the rewrite log of the
+     * reducer. The transitions of the reduced net are matched to those before reduction once, by name, so a
+     * trace is expanded without any lookup per step. Without a reducer or a saved net the traces are left as
+     * they are. The reducer and the net must outlive the expander.
+     */
+    class TraceExpander {
+    public:
+        TraceExpander(const Reducer* reducer, const PetriNet& net);
+
+        /** Appends the firings of the reductions that lead to the initial marking of the reduced net */
+        void initial(std::vector<TraceStep>& trace) const;
+
+        /** Appends a transition of the reduced net, followed by the firings the reductions attach to it */
+        void fire(std::vector<TraceStep>& trace, uint32_t transition) const;
+
+        /** Prints the step as a transition of a trace, with the tokens it consumes */
+        void print(std::ostream& out, const TraceStep& step) const;
+
+        /** Prints the tokens the step consumes, which are only known for transitions of a saved net */
+        void printTokens(std::ostream& out, const TraceStep& step) const;
+
+        /** Prints the steps, to a buffered_output as the traces can be long */
+        void print(std::ostream& out, const std::vector<TraceStep>& trace) const;
+
+    private:
+        void expand(std::vector<TraceStep>& trace, uint32_t transition, size_t before, uint32_t reduced) const;
+
+        const Reducer* _reducer;
+        const PetriNet& _net;
+        std::vector<uint32_t> _original;
+    };
 }
 
 #endif /* REDUCER_H */
@@ -24,6 +24,7 @@
 #include <iostream>
 
 #include "State.h"
+#include "StateSymmetry.h"
 #include "AlignedEncoder.h"
 #include "utils/structures/binarywrapper.h"
 #include "utils/errors.h"
@@ -453,9 +454,28 @@ namespace PetriEngine {
         public:
             using EncodingStateSetInterface::EncodingStateSetInterface;
 
+            /**
+             * Markings are replaced by the representative of their orbit under the symmetry before they are
+             * stored or looked up, so decode yields representatives. The symmetry must outlive the set.
+             */
+            void setSymmetry(const StateSymmetry* symmetry)
+            {
+                _symmetry = symmetry;
+                if (_symmetry != nullptr && _canonical.marking() == nullptr)
+                    _canonical.setMarking(new MarkVal[_nplaces]);
+            }
+
             std::pair<bool, size_t> add(const State& state) override
             {
-                return _add(state, _trie);
+                if (_symmetry == nullptr)
+                    return _add(state, _trie);
+                _canonical.copy(state.marking(), _nplaces);
+                _symmetry->canonicalize(_canonical.marking());
+                auto r = _add(_canonical, _trie);
+                // only the representative is recorded; its bounds hold for the whole orbit
+                if (r.first)
+                    _symmetry->spread(_maxPlaceBound);
+                return r;
             }
 
             void decode(State& state, size_t id) override
@@ -465,7 +485,11 @@ namespace PetriEngine {
 
             std::pair<bool, size_t> lookup(State& state) override
             {
-                return _lookup(state, _trie);
+                if (_symmetry == nullptr)
+                    return _lookup(state, _trie);
+                _canonical.copy(state.marking(), _nplaces);
+                _symmetry->canonicalize(_canonical.marking());
+                return _lookup(_canonical, _trie);
             }
 
             void setHistory(size_t id, size_t transition) override {}
@@ -482,6 +506,8 @@ namespace PetriEngine {
 
         private:
             ptrie_t _trie;
+            const StateSymmetry* _symmetry = nullptr;
+            State _canonical;
         };
 
         template<typename T>
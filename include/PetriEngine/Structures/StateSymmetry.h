@@ -0,0 +1,74 @@
+/*
+ * File:   StateSymmetry.h
+ *
+ * Symmetries of a net used to store a single marking per orbit during explicit search.
+ */
+
+#ifndef STATESYMMETRY_H
+#define STATESYMMETRY_H
+
+#include "PetriEngine/PetriNet.h"
+#include "PetriEngine/PQL/PQL.h"
+#include "utils/structures/shared_string.h"
+
+#include <tuple>
+#include <vector>
+
+namespace PetriEngine {
+    namespace Structures {
+
+        /**
+         * Places moved block-wise by permuting the colors of one color type: entry [c][s] is the place of slot s
+         * for color c, or null if it was not unfolded. Permuting the colors permutes whole blocks.
+         */
+        using place_blocks_t = std::vector<std::vector<shared_const_string>>;
+
+        /**
+         * A group is the symmetric group acting on the blocks of a place_blocks_t. It is only kept if both its
+         * generators (swapping the first two blocks and rotating all blocks) are shown to be automorphisms of the
+         * final net that preserve the initial marking and every query, so any permutation of the blocks maps a
+         * marking to one with the same behaviour w.r.t. the queries. Markings are canonicalized by sorting the
+         * blocks of each group in turn, which yields a member of the orbit (the unique minimum for one group).
+         */
+        class StateSymmetry {
+        public:
+            StateSymmetry(const PetriNet& net, const std::vector<place_blocks_t>& candidates,
+                          const std::vector<PQL::Condition_ptr>& queries);
+
+            bool empty() const {
+                return _groups.empty();
+            }
+
+            size_t size() const {
+                return _groups.size();
+            }
+
+            /** Replaces the marking by the representative of its orbit. Not thread-safe. */
+            void canonicalize(MarkVal* marking) const;
+
+            /** Raises the bound of every place to the largest bound of the places in its orbit. */
+            void spread(std::vector<uint32_t>& bounds) const;
+
+        private:
+            struct group_t {
+                uint32_t _blocks = 0;
+                uint32_t _slots = 0;
+                // place of slot s in block b at b * _slots + s
+                std::vector<uint32_t> _places;
+            };
+
+            using signature_t = std::vector<std::tuple<uint32_t, uint32_t, uint32_t>>;
+
+            signature_t signature(uint32_t transition, const std::vector<uint32_t>& permutation) const;
+            bool is_automorphism(const std::vector<uint32_t>& permutation, const std::vector<signature_t>& signatures,
+                                 const std::vector<PQL::Condition_ptr>& queries) const;
+
+            const PetriNet& _net;
+            std::vector<group_t> _groups;
+            mutable std::vector<MarkVal> _scratch;
+            mutable std::vector<uint32_t> _order;
+        };
+    }
+}
+
+#endif /* STATESYMMETRY_H */
@@ -45,6 +45,7 @@ struct options_t {
 //    bool outputtrace = false;
     int kbound = 0;
     const char* modelfile = nullptr;
+    bool binary_model = false;
     const char* queryfile = nullptr;
     int enablereduction = 1; // 0 ... disabled,  1 ... aggresive (default), 2 ... k-boundedness preserving, 3 ... selection
     int enablecolreduction = 1;
@@ -53,6 +54,7 @@ struct options_t {
     int reductionTimeout = 60;
     int colReductionTimeout = 30;
     bool stubbornreduction = true;
+    bool locality_order = false;
     bool statespaceexploration = false;
     StatisticsLevel printstatistics = StatisticsLevel::Full;
     std::set<size_t> querynumbers;
@@ -86,6 +88,10 @@ struct options_t {
     LTL::LTLPartialOrder ltl_por = LTL::LTLPartialOrder::Automaton;
     LTL::BuchiOptimization buchiOptimization = LTL::BuchiOptimization::Low;
     LTL::LTLHeuristic ltlHeuristic = LTL::LTLHeuristic::Automaton;
+    bool ltl_lasso = false;
+    bool ltl_shared_markings = false;
+    bool ltl_terminal_reach = false;
+    size_t ltl_stack_memory = 0; // in MB, 0 = unbounded
 
     bool replay_trace = false;
     std::string replay_file;
@@ -93,6 +99,7 @@ struct options_t {
 
     std::string query_out_file;
     std::string model_out_file;
+    std::string model_binary_out_file;
     std::string model_col_out_file;
     std::string unfolded_out_file;
     std::string unfold_query_out_file;
@@ -104,14 +111,22 @@ struct options_t {
     bool computeCFP = true;
     bool computePartition = true;
     bool symmetricVariables = true;
+    bool stateSymmetry = true;
+    bool partialUnfolding = true;
     bool isCPN = false;
     uint32_t seed_offset = 0;
     int max_intervals = 500; //0 disabled
     int max_intervals_reduced = 5;
     bool print_bindings = false;
+    bool exploreColored = false;
+    int exploreColoredTimeout = 30;
+    std::string unfold_cache;
 
     std::string strategy_output;
 
+    std::string json_results_file;
+    std::ostream* json_results = nullptr; // opened on json_results_file by main, see json_record
+
     size_t seed() { return ++seed_offset; }
     void print(std::ostream& out = std::cout);
     bool parse(int argc, const char** argv);
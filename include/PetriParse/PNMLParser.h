@@ -21,6 +21,7 @@
 #define PNMLPARSER_H
 
 #include <map>
+#include <shared_mutex>
 #include <string>
 #include <vector>
 #include <fstream>
@@ -63,6 +64,40 @@ class PNMLParser {
     typedef std::unordered_map<std::string, const PetriEngine::Colored::ColorType*> ColorTypeMap;
     typedef std::unordered_map<std::string, const PetriEngine::Colored::Variable*> VariableMap;
 
+    // the arc expression or guard below node, parsed once the whole net is read
+    struct DeferredExpression {
+        rapidxml::xml_node<>* node;
+        size_t index;   // into arcs, or into _transitions for a guard
+        bool guard;
+    };
+
+    /**
+     * Hash-consed color constants, variables and sorts: each is made into an expression once, which is then
+     * shared by every expression referring to it. Expressions are immutable, so sharing them is safe, and
+     * the pool may be used by several threads at once.
+     */
+    class ExpressionPool {
+    public:
+        PetriEngine::Colored::ColorExpression_ptr dot() const {
+            return _dot;
+        }
+        PetriEngine::Colored::ColorExpression_ptr color(const PetriEngine::Colored::Color* color);
+        PetriEngine::Colored::ColorExpression_ptr variable(const PetriEngine::Colored::Variable* variable);
+        /** The constants of every color of a sort */
+        std::vector<PetriEngine::Colored::ColorExpression_ptr> colors(const PetriEngine::Colored::ColorType* sort);
+        void clear();
+
+    private:
+        template<typename K, typename V, typename F>
+        V get(std::unordered_map<K, V>& map, const K& key, F&& make);
+
+        PetriEngine::Colored::ColorExpression_ptr _dot = std::make_shared<PetriEngine::Colored::DotConstantExpression>();
+        std::shared_mutex _mutex;
+        std::unordered_map<const PetriEngine::Colored::Color*, PetriEngine::Colored::ColorExpression_ptr> _colors;
+        std::unordered_map<const PetriEngine::Colored::Variable*, PetriEngine::Colored::ColorExpression_ptr> _variables;
+        std::unordered_map<const PetriEngine::Colored::ColorType*, std::vector<PetriEngine::Colored::ColorExpression_ptr>> _sorts;
+    };
+
 public:
 
     struct Query {
@@ -72,8 +107,14 @@ public:
     PNMLParser() {
         builder = NULL;
     }
+    /**
+     * The arc expressions and guards of a colored net are independent of each other, so with more than one
+     * thread they are parsed in parallel once the places, transitions and arcs are known. The net is passed
+     * to the builder in document order regardless.
+     */
     void parse(std::istream& xml,
-            PetriEngine::AbstractPetriNetBuilder* builder);
+            PetriEngine::AbstractPetriNetBuilder* builder,
+            uint32_t threads = 1);
 
     std::vector<Query> getQueries() {
         return queries;
@@ -85,6 +126,7 @@ private:
     void parseArc(rapidxml::xml_node<>* element, bool inhibitor = false);
     void parseTransition(rapidxml::xml_node<>* element);
     void parseDeclarations(rapidxml::xml_node<>* element);
+    void parseDeferredExpressions(uint32_t threads);
     void parsePartitions(rapidxml::xml_node<>* element);
     void parseNamedSort(rapidxml::xml_node<>* element);
     PetriEngine::Colored::ArcExpression_ptr parseArcExpression(rapidxml::xml_node<>* element);
@@ -118,6 +160,8 @@ private:
     std::vector<Query> queries;
     std::vector<PetriEngine::Colored::ColorTypePartition> partitions;
     std::vector<std::pair<char *, PetriEngine::Colored::ProductType*>> missingCTs;
+    std::vector<DeferredExpression> deferred;
+    mutable ExpressionPool pool;   // a cache, also used by the const lookups
 };
 
 #endif // PNMLPARSER_H
\ No newline at end of file
@@ -0,0 +1,105 @@
+/*
+ * File:   PNMLStreamParser.h
+ *
+ * Streaming reader of P/T nets in PNML.
+ */
+
+#ifndef PNMLSTREAMPARSER_H
+#define PNMLSTREAMPARSER_H
+
+#include "../PetriEngine/AbstractPetriNetBuilder.h"
+
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * Reads a P/T net in PNML from a block of bytes, typically a memory mapped file, and passes every place and
+ * transition to the builder as soon as its element is closed, without building a DOM of the document. Node ids
+ * are views into the input. An arc is passed on as soon as both of its ends are known, otherwise it is deferred,
+ * by the integer ids of its ends, to the end of the document. Memory use is thus bounded by the size of the net
+ * rather than of the file. Colored nets are left to PNMLParser.
+ */
+class PNMLStreamParser {
+public:
+    /**
+     * @return false, before anything is passed to the builder, if the document has declarations and thus is
+     *         colored, or at least is not a plain P/T net.
+     */
+    bool parse(const char* data, size_t size, PetriEngine::AbstractPetriNetBuilder* builder);
+
+private:
+    static constexpr size_t none = std::numeric_limits<size_t>::max();
+
+    enum class node_kind_t : uint8_t { Unknown, Place, Transition };
+    enum class element_t : uint8_t { None, Place, Transition, Arc, TransportArc };
+    enum class capture_t : uint8_t { None, Marking, Player, Inscription };
+
+    struct node_t {
+        std::string_view _id;
+        node_kind_t _kind = node_kind_t::Unknown;
+    };
+
+    struct arc_t {
+        uint32_t _source;
+        uint32_t _target;
+        uint32_t _weight;
+        bool _inhib;
+    };
+
+    // the tokenizer
+    bool next();
+    void skipPast(const char* terminator);
+    std::string_view name();
+    std::string_view attribute(const char* name);
+    std::string decode(std::string_view raw) const;
+
+    void startElement(std::string_view name, size_t depth, bool empty);
+    void endElement(size_t depth);
+    void startNode(element_t element, size_t depth);
+    void endNode();
+
+    uint32_t node(std::string_view id);
+    std::string_view id(const char* attribute);
+    void addArc(uint32_t source, uint32_t target, uint32_t weight, bool inhib);
+    void emitArc(const arc_t& arc);
+
+    PetriEngine::AbstractPetriNetBuilder* _builder = nullptr;
+    const char* _pos = nullptr;
+    const char* _end = nullptr;
+    std::vector<std::pair<std::string_view, std::string_view>> _attributes;
+    std::vector<std::string_view> _open;
+
+    std::unordered_map<std::string_view, uint32_t> _ids;
+    std::vector<node_t> _nodes;
+    std::deque<std::string> _decoded;   // ids that contained entity references
+    std::vector<arc_t> _deferred;
+
+    // the node or arc being read
+    element_t _element = element_t::None;
+    size_t _elementDepth = none;
+    std::string_view _id, _source, _target, _transition;
+    uint64_t _tokens = 0;
+    double _x = 0, _y = 0;
+    int32_t _player = 0;
+    int _weight = 1;
+    bool _inhib = false;
+    bool _hasWeight = false;
+    bool _hasPlayer = false;
+    bool _hasInscription = false;
+
+    size_t _skipDepth = none;           // inside an element whose contents are ignored
+    size_t _positionDepth = none;       // on the chain of first children of a graphics element
+    capture_t _capture = capture_t::None;
+    size_t _captureDepth = none;
+    size_t _valueDepth = none;
+    bool _valuePending = false;         // the value element has had no text yet
+    std::string _captured;
+};
+
+#endif /* PNMLSTREAMPARSER_H */
@@ -19,11 +19,13 @@
 
 #include <set>
 #include <iostream>
+#include <string_view>
 #include <vector>
 #include <memory>
 
 #include "PNMLParser.h"
 #include "QueryParser.h"
+#include "utils/mapped_file.h"
 using namespace PetriEngine::PQL;
 
 class QueryBinaryParser {
@@ -33,13 +35,27 @@ public:
 
     std::vector<QueryItem>  queries;
 
-    bool parse(std::istream& binary, const std::set<size_t>& );
+    /**
+     * Reads a container of queries (see BinaryPrinter.h), typically from a memory mapped file. Only the
+     * queries in parse_only are parsed, or all of them if it is empty; the others are skipped through the
+     * offsets of the container and left empty in queries. Places keep the ids stored in the file, which
+     * spares the analysis of resolving their names when the queries were written for the same net.
+     * Files without the magic of the container are read in the older, unindexed layout.
+     */
+    bool parse(const char* data, size_t size, const std::set<size_t>& parse_only);
 
 private:
-    Condition_ptr parseQuery(std::istream& binary, const std::vector<shared_const_string>& names);
-    Expr_ptr parseExpr(std::istream& binary, const std::vector<shared_const_string>& names);
-    shared_string_set& _string_set;
+    // the layout written before the container: no magic, names as uint32 id and a '\0'-terminated string,
+    // and the queries back to back, so all of them are decoded even if only some are selected.
+    bool parseUnindexed(const char* data, size_t size, const std::set<size_t>& parse_only);
+    bool parseRecord(mapped_reader& in, QueryItem& item);
+    Condition_ptr parseQuery(mapped_reader& in);
+    Expr_ptr parseExpr(mapped_reader& in);
+    const shared_const_string& name(uint32_t id);
 
+    shared_string_set& _string_set;
+    std::vector<std::string_view> _names;       // by id, viewing the input
+    std::vector<shared_const_string> _interned; // by id, interned when first used
 };
 
 
@@ -94,6 +94,7 @@
 #include "CTL/CTLEngine.h"
 #include "PetriEngine/Colored/ColoredPetriNetBuilder.h"
 #include "PetriEngine/Colored/Unfolder.h"
+#include "PetriEngine/Colored/UnfoldCache.h"
 
 #include "PetriEngine/TraceReplay.h"
 
@@ -110,14 +111,30 @@ using namespace PetriEngine::Reachability;
 bool reduceColored(ColoredPetriNetBuilder &cpnBuilder,
                    std::vector<std::shared_ptr<PQL::Condition> > &queries,
                    TemporalLogic logic, uint32_t timeout, std::ostream &out,
-                   int reductiontype, std::vector<uint32_t>& reductions);
+                   int reductiontype, std::vector<uint32_t>& reductions, uint32_t threads = 1);
+
+/**
+ * Skips the colored places and transitions outside the cone of influence of the (reachability) queries, so
+ * that only the part of the net the queries observe is unfolded.
+ * @return true if anything was skipped
+ */
+bool reduceToQueryCone(ColoredPetriNetBuilder &cpnBuilder,
+                       const std::vector<std::shared_ptr<PQL::Condition> > &queries,
+                       uint32_t timeout, std::ostream &out);
 
 std::tuple<PetriNetBuilder, shared_name_name_map, shared_place_color_map>
 unfold(ColoredPetriNetBuilder& cpnBuilder, bool compute_partiton,
        bool compute_symmetry, bool computed_fixed_point,
        std::ostream& out = std::cout, int32_t partitionTimeout = 0,
        int32_t max_intervals = 0, int32_t intervals_reduced = 0,
-       int32_t interval_timeout = 0, bool over_approx = false, bool print_bindings = false);
+       int32_t interval_timeout = 0, bool over_approx = false, bool print_bindings = false,
+       uint32_t threads = 1, std::vector<Structures::place_blocks_t>* scalar_sets = nullptr,
+       const Colored::UnfoldCache* cache = nullptr);
+
+/** The entry of the unfolding cache in options.unfold_cache for the model, the queries and the options. */
+Colored::UnfoldCache unfoldCache(const ColoredPetriNetBuilder& cpnBuilder,
+                                 const std::vector<std::shared_ptr<PQL::Condition> >& queries,
+                                 const options_t& options, bool scalar_sets);
 
 ReturnValue contextAnalysis(bool colored, const shared_name_name_map& transition_names,
                             const shared_place_color_map& place_names,
@@ -168,4 +185,9 @@ std::vector<Condition_ptr>
 parseXMLQueries(shared_string_set& string_set, std::vector<std::string>& qstrings,
                 std::istream& qfile, const std::set<size_t>& qnums, bool binary = false);
 
+/** As above, but a binary query file is memory mapped rather than read */
+std::vector<Condition_ptr>
+parseXMLQueries(shared_string_set& string_set, std::vector<std::string>& qstrings,
+                const std::string& filename, const std::set<size_t>& qnums, bool binary = false);
+
 #endif /* VERIFYPN_H */
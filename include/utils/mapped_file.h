@@ -0,0 +1,128 @@
+/*
+ * File:   mapped_file.h
+ *
+ * Read-only view of a file, memory mapped where the platform supports it.
+ */
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include "errors.h"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * The contents of a file as a contiguous, read-only block of bytes. On POSIX systems the file is mapped
+ * into memory, elsewhere it is read into a buffer. Throws base_error if the file cannot be opened.
+ */
+class mapped_file {
+    const char* _data = nullptr;
+    size_t _size = 0;
+#ifndef _WIN32
+    bool _mapped = false;
+#endif
+    std::vector<char> _buffer;
+
+public:
+    explicit mapped_file(const std::string& path) {
+#ifndef _WIN32
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw base_error("Could not open ", path);
+        struct stat st{};
+        const bool known = ::fstat(fd, &st) == 0;
+        if (known && st.st_size > 0) {
+            void* data = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED) {
+                _data = static_cast<const char*>(data);
+                _size = st.st_size;
+                _mapped = true;
+            }
+        }
+        ::close(fd);
+        if (_mapped || (known && st.st_size == 0))
+            return;
+#endif
+        std::ifstream in(path, std::ios::binary);
+        if (!in)
+            throw base_error("Could not open ", path);
+        _buffer.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        _data = _buffer.data();
+        _size = _buffer.size();
+    }
+
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+
+    ~mapped_file() {
+#ifndef _WIN32
+        if (_mapped)
+            ::munmap(const_cast<char*>(_data), _size);
+#endif
+    }
+
+    const char* data() const { return _data; }
+    size_t size() const { return _size; }
+};
+
+/**
+ * Sequential reader of trivially copyable values from a block of bytes, as written in native byte order.
+ * Reading past the end throws base_error, so a truncated or corrupted file is detected.
+ */
+class mapped_reader {
+    const char* _pos;
+    const char* _end;
+
+public:
+    mapped_reader(const char* data, size_t size) : _pos(data), _end(data + size) {}
+
+    explicit mapped_reader(const mapped_file& file) : mapped_reader(file.data(), file.size()) {}
+
+    template<typename T>
+    T read() {
+        static_assert(std::is_trivially_copyable_v<T>);
+        T value;
+        std::memcpy(&value, bytes(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+    const char* bytes(size_t n) {
+        if ((size_t)(_end - _pos) < n)
+            throw base_error("Unexpected end of binary file");
+        auto* start = _pos;
+        _pos += n;
+        return start;
+    }
+
+    std::string read_string() {
+        auto length = read<uint32_t>();
+        return std::string(bytes(length), length);
+    }
+
+    /** A string terminated by '\0', which is skipped but not part of the view */
+    std::string_view read_cstring() {
+        auto* end = static_cast<const char*>(std::memchr(_pos, '\0', _end - _pos));
+        if (end == nullptr)
+            throw base_error("Unexpected end of binary file");
+        std::string_view str(_pos, end - _pos);
+        _pos = end + 1;
+        return str;
+    }
+
+    bool done() const { return _pos == _end; }
+};
+
+#endif /* MAPPED_FILE_H */
@@ -0,0 +1,201 @@
+/*
+ * File:   output.h
+ *
+ * Buffered and ordered output of results, traces and strategies.
+ */
+
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <streambuf>
+#include <string>
+
+/** Held while text is passed on to std::cout, std::cerr or a file, so that blocks of text never interleave */
+inline std::mutex& output_lock() {
+    static std::mutex lock;
+    return lock;
+}
+
+/**
+ * A stream that collects text in memory and passes it on to another stream in one write under output_lock.
+ * The text is passed on and the target flushed on std::flush or std::endl and when the stream is destroyed,
+ * so a result written with "\n" between its lines reaches the target as a single block. With a limit, the
+ * text is also passed on, without a flush, whenever that many bytes are collected, which bounds the memory
+ * used for strategies and traces of any size.
+ */
+class buffered_output : private std::streambuf, public std::ostream {
+    std::ostream& _target;
+    std::string _buffer;
+    size_t _limit;
+
+    void pass_on() {
+        if (pptr() != pbase()) {
+            std::lock_guard<std::mutex> guard(output_lock());
+            _target.write(pbase(), pptr() - pbase());
+        }
+        setp(_buffer.data(), _buffer.data() + _buffer.size());
+    }
+
+    std::streambuf::int_type overflow(std::streambuf::int_type c) override {
+        const size_t used = pptr() - pbase();
+        if (used >= _limit) {
+            pass_on();
+        } else {
+            // the put area is the string itself, so it is moved along when the string grows
+            _buffer.resize(2 * _buffer.size());
+            setp(_buffer.data(), _buffer.data() + _buffer.size());
+            for (size_t n = used; n > 0;) {
+                const auto step = std::min<size_t>(n, std::numeric_limits<int>::max());
+                pbump(static_cast<int>(step));
+                n -= step;
+            }
+        }
+        if (!std::streambuf::traits_type::eq_int_type(c, std::streambuf::traits_type::eof())) {
+            *pptr() = std::streambuf::traits_type::to_char_type(c);
+            pbump(1);
+        }
+        return std::streambuf::traits_type::not_eof(c);
+    }
+
+    int sync() override {
+        pass_on();
+        std::lock_guard<std::mutex> guard(output_lock());
+        _target.flush();
+        return _target ? 0 : -1;
+    }
+
+public:
+    explicit buffered_output(std::ostream& target, size_t limit = std::numeric_limits<size_t>::max())
+    : std::ostream(static_cast<std::streambuf*>(this)), _target(target), _buffer(4096, '\0'), _limit(limit) {
+        setp(_buffer.data(), _buffer.data() + _buffer.size());
+    }
+
+    ~buffered_output() override {
+        sync();
+    }
+};
+
+/**
+ * Passes blocks of text, one per index, on to a stream in the order of the indices regardless of the order
+ * they are completed in, as when queries are handled by several threads. A block is held back until every
+ * block before it has been passed on, so every index from 0 and up must get a block, if only an empty one.
+ */
+class ordered_output {
+    std::ostream& _target;
+    std::mutex _lock;
+    size_t _next = 0;
+    std::map<size_t, std::string> _pending;
+
+    void emit(size_t index, std::string text) {
+        std::lock_guard<std::mutex> guard(_lock);
+        _pending.emplace(index, std::move(text));
+        std::string ready;
+        for (auto it = _pending.begin(); it != _pending.end() && it->first == _next; ++_next) {
+            ready += it->second;
+            it = _pending.erase(it);
+        }
+        if (!ready.empty()) {
+            std::lock_guard<std::mutex> out(output_lock());
+            _target.write(ready.data(), ready.size());
+        }
+    }
+
+public:
+    explicit ordered_output(std::ostream& target) : _target(target) {}
+
+    /** The text of one index, handed to the ordered_output when the block is destroyed */
+    class block : public std::ostringstream {
+        ordered_output& _output;
+        size_t _index;
+
+    public:
+        block(ordered_output& output, size_t index) : _output(output), _index(index) {}
+
+        ~block() override {
+            _output.emit(_index, str());
+        }
+    };
+};
+
+/**
+ * One line of JSON Lines, an object with the fields written to it, passed on to a stream through a
+ * buffered_output when the record is destroyed. Records written by several threads never interleave,
+ * and follow each other in the order they are completed.
+ */
+class json_record {
+    buffered_output _out;
+    bool _first = true;
+
+    void key(const char* name) {
+        _out << (_first ? "" : ",");
+        _first = false;
+        quoted(name);
+        _out << ':';
+    }
+
+    void quoted(const std::string& text) {
+        _out << '"';
+        for (unsigned char c : text) {
+            if (c == '"' || c == '\\') {
+                _out << '\\' << c;
+            } else if (c < 0x20) {
+                char escaped[7];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                _out << escaped;
+            } else {
+                _out << c;
+            }
+        }
+        _out << '"';
+    }
+
+public:
+    explicit json_record(std::ostream& target) : _out(target) {
+        _out << '{';
+    }
+
+    ~json_record() {
+        _out << "}\n";
+    }
+
+    json_record& string(const char* name, const std::string& value) {
+        key(name);
+        quoted(value);
+        return *this;
+    }
+
+    json_record& number(const char* name, size_t value) {
+        key(name);
+        _out << value;
+        return *this;
+    }
+
+    json_record& boolean(const char* name, bool value) {
+        key(name);
+        _out << (value ? "true" : "false");
+        return *this;
+    }
+
+    /** An array of the words of a space separated list, such as the TECHNIQUES of a result */
+    json_record& words(const char* name, const std::string& list) {
+        key(name);
+        _out << '[';
+        std::istringstream in(list);
+        bool first = true;
+        for (std::string word; in >> word; first = false) {
+            _out << (first ? "" : ",");
+            quoted(word);
+        }
+        _out << ']';
+        return *this;
+    }
+};
+
+#endif /* OUTPUT_H */
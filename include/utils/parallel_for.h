@@ -0,0 +1,67 @@
+/*
+ * File:   parallel_for.h
+ *
+ * Running the iterations of a loop on several threads.
+ */
+
+#ifndef PARALLEL_FOR_H
+#define PARALLEL_FOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <limits>
+
+#ifdef VERIFYPN_MC_Simplification
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+#endif
+
+/**
+ * Calls f(i) for every i in [0, n), on up to the given number of threads, each taking the next index in turn.
+ * Without VERIFYPN_MC_Simplification, or with one thread, the indices are visited in order on the calling thread.
+ *
+ * If some f(i) throws, no higher indices are started and, once every thread is done, the exception of the
+ * lowest failing index is rethrown. Every index below it has been visited, so the error is the same as when
+ * the loop runs on a single thread.
+ */
+template<typename F>
+void parallel_for(size_t n, uint32_t threads, F&& f) {
+#ifdef VERIFYPN_MC_Simplification
+    if (threads > 1 && n > 1) {
+        constexpr auto none = std::numeric_limits<size_t>::max();
+        const size_t nworkers = std::min<size_t>(threads, n);
+        std::atomic<size_t> next(0);
+        // lowest index that failed so far; indices above it are not started
+        std::atomic<size_t> failure(none);
+        std::vector<size_t> failed_at(nworkers, none);
+        std::vector<std::exception_ptr> errors(nworkers);
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < nworkers; ++t) {
+            workers.emplace_back([&, t] {
+                for (size_t i = next++; i < n && i < failure; i = next++) {
+                    try {
+                        f(i);
+                    } catch (...) {
+                        failed_at[t] = i;
+                        errors[t] = std::current_exception();
+                        for (size_t seen = failure; i < seen && !failure.compare_exchange_weak(seen, i);) {}
+                        return;
+                    }
+                }
+            });
+        }
+        for (auto& w : workers) w.join();
+        const auto first = std::min_element(failed_at.begin(), failed_at.end());
+        if (*first != none)
+            std::rethrow_exception(errors[first - failed_at.begin()]);
+        return;
+    }
+#endif
+    for (size_t i = 0; i < n; ++i)
+        f(i);
+}
+
+#endif /* PARALLEL_FOR_H */
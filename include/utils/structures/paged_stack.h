@@ -0,0 +1,147 @@
+/*
+ * File:   paged_stack.h
+ *
+ * Stack with random access, stored in fixed-size pages such that growing it never copies existing elements.
+ * Optionally only a bounded number of pages is kept in memory; the least recently used pages are then paged
+ * out to an anonymous temporary file and read back on access.
+ */
+
+#ifndef PAGED_STACK_H
+#define PAGED_STACK_H
+
+#include "utils/errors.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+template<typename T, size_t PageElements = 65536>
+class paged_stack
+{
+    static_assert(std::is_trivially_copyable_v<T>, "paged_stack can only page out trivially copyable elements");
+    static constexpr size_t PageBytes = PageElements * sizeof(T);
+    // pages touched by the last few accesses are never paged out, keeping references into them valid.
+    static constexpr size_t MinResident = 4;
+
+    struct page_t {
+        std::unique_ptr<uint8_t[]> _data;
+        size_t _last_use = 0;
+        bool _on_disk = false;
+    };
+
+    std::vector<page_t> _pages;
+    // the buffer of the last page to empty, kept such that a search oscillating around a page boundary
+    // does not allocate and free a page on every push and pop.
+    std::unique_ptr<uint8_t[]> _spare;
+    size_t _size = 0;
+    size_t _max_resident = 0;
+    size_t _resident = 0;
+    size_t _clock = 0;
+    size_t _page_outs = 0;
+    std::FILE* _file = nullptr;
+
+public:
+    /**
+     * @param max_resident_bytes upper bound on the memory used for resident pages, 0 keeps everything in memory.
+     */
+    explicit paged_stack(size_t max_resident_bytes = 0)
+    {
+        if (max_resident_bytes != 0)
+            _max_resident = std::max(MinResident, max_resident_bytes / PageBytes);
+    }
+
+    paged_stack(const paged_stack&) = delete;
+    paged_stack& operator=(const paged_stack&) = delete;
+
+    ~paged_stack() {
+        if (_file != nullptr)
+            std::fclose(_file);
+    }
+
+    inline void push_back(const T& element)
+    {
+        if (_size % PageElements == 0 && _size / PageElements == _pages.size())
+            _pages.emplace_back();
+        new (&slot(_size)) T(element);
+        ++_size;
+    }
+
+    inline void pop_back()
+    {
+        assert(_size > 0);
+        --_size;
+        if (_size % PageElements == 0) {
+            // the top page is now empty, drop it entirely (including any copy on disk).
+            auto& page = _pages[_size / PageElements];
+            if (page._data) {
+                --_resident;
+                if (!_spare)
+                    _spare = std::move(page._data);
+            }
+            page = page_t{};
+        }
+    }
+
+    inline bool empty() const { return _size == 0; }
+
+    inline size_t size() const { return _size; }
+
+    inline T& back() { return (*this)[_size - 1]; }
+
+    inline T& operator[](size_t i) {
+        assert(i < _size);
+        return slot(i);
+    }
+
+    size_t page_outs() const { return _page_outs; }
+
+private:
+    inline T& slot(size_t i) {
+        auto& page = _pages[i / PageElements];
+        if (!page._data)
+            page_in(i / PageElements);
+        page._last_use = ++_clock;
+        return reinterpret_cast<T*>(page._data.get())[i % PageElements];
+    }
+
+    void page_in(size_t p) {
+        if (_max_resident != 0 && _resident >= _max_resident)
+            page_out_lru(p);
+        auto& page = _pages[p];
+        // elements are constructed on push or read back from disk, so the page is not value-initialised.
+        page._data = _spare ? std::move(_spare) : std::unique_ptr<uint8_t[]>(new uint8_t[PageBytes]);
+        ++_resident;
+        if (page._on_disk) {
+            std::fseek(_file, p * PageBytes, SEEK_SET);
+            if (std::fread(page._data.get(), 1, PageBytes, _file) != PageBytes)
+                throw base_error("Could not read paged-out search stack from temporary file");
+        }
+    }
+
+    void page_out_lru(size_t keep) {
+        size_t victim = _pages.size();
+        for (size_t p = 0; p < _pages.size(); ++p) {
+            if (p == keep || !_pages[p]._data) continue;
+            if (victim == _pages.size() || _pages[p]._last_use < _pages[victim]._last_use)
+                victim = p;
+        }
+        assert(victim < _pages.size());
+        // references handed out may have modified the page, so it is always written back.
+        auto& page = _pages[victim];
+        if (_file == nullptr && (_file = std::tmpfile()) == nullptr)
+            throw base_error("Could not create temporary file for paging out the search stack");
+        std::fseek(_file, victim * PageBytes, SEEK_SET);
+        if (std::fwrite(page._data.get(), 1, PageBytes, _file) != PageBytes)
+            throw base_error("Could not page out search stack to temporary file");
+        page._on_disk = true;
+        ++_page_outs;
+        page._data.reset();
+        --_resident;
+    }
+};
+
+#endif /* PAGED_STACK_H */
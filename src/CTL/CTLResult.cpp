@@ -1,23 +1,33 @@
 #include "CTL/CTLResult.h"
+#include "utils/output.h"
+
 #include <iomanip>
 
-void CTLResult::print(const std::string& qname, StatisticsLevel statisticslevel, size_t index, options_t& options, std::ostream& out) const {
+void CTLResult::print(const std::string& qname, StatisticsLevel statisticslevel, size_t index, options_t& options, std::ostream& target) const {
+    // passed on to the target in one block, and flushed, at the end
+    buffered_output out(target);
 
-    const static std::string techniques = "TECHNIQUES COLLATERAL_PROCESSING EXPLICIT STATE_COMPRESSION SAT_SMT ";
+    const static std::string techniques = "COLLATERAL_PROCESSING EXPLICIT STATE_COMPRESSION SAT_SMT ";
+    const std::string used = techniques
+        + (options.isCPN ? "UNFOLDING_TO_PT " : "")
+        + (options.stubbornreduction ? "STUBBORN_SETS " : "")
+        + (options.ctlalgorithm == CTL::CZero ? "CTL_CZERO " : "")
+        + (options.ctlalgorithm == CTL::Local ? "CTL_LOCAL " : "");
 
     out << "\n";
     out << "FORMULA "
          << qname
          << " " << (result ? "TRUE" : "FALSE") << " "
-         << techniques
-         << (options.isCPN ? "UNFOLDING_TO_PT " : "")
-         << (options.stubbornreduction ? "STUBBORN_SETS " : "")
-         << (options.ctlalgorithm == CTL::CZero ? "CTL_CZERO " : "")
-         << (options.ctlalgorithm == CTL::Local ? "CTL_LOCAL " : "")
+         << "TECHNIQUES " << used
             << "\n\n";
     out << "Query index " << index << " was solved" << "\n";
     out << "Query is" << (result ? "" : " NOT") << " satisfied." << "\n";
 
+    if (options.json_results != nullptr) {
+        json_record record(*options.json_results);
+        record.number("index", index).string("query", qname).boolean("result", result).words("techniques", used);
+    }
+
     if(statisticslevel != StatisticsLevel::None){
         out << "\n";
         out << "STATS:" << "\n";
@@ -30,5 +40,5 @@ void CTLResult::print(const std::string& qname, StatisticsLevel statisticslevel,
         out << "	Explored Configs  : " << exploredConfigurations << "\n";
         out << "	max tokens:       : " << maxTokens << "\n"; // kept lower case to be compatible with reachability format 
     }
-    out << std::endl;
+    out << "\n";
 }
\ No newline at end of file
@@ -167,6 +167,9 @@ namespace LTL {
         State curState = _factory.new_state(_hyper_traces);
 
         nested_todo.push_back(stack_entry_t<T>{std::get<1>(states.add(state)), successor_generator.initial_suc_info()});
+        // the nested search looks for exactly this state, so guide it there.
+        if (_lasso)
+            _lasso->set_seed(state);
 
         while (!nested_todo.empty()) {
             auto &top = nested_todo.back();
@@ -177,11 +180,15 @@ namespace LTL {
             }
             if (!successor_generator.next(working, top._sucinfo)) {
                 nested_todo.pop_back();
+                if (nested_todo.empty() && _lasso)
+                    _lasso->clear_seed();
             } else {
                 if(working.get_buchi_state() == state.get_buchi_state() &&
                    std::equal(working.marking(), working.marking() + _net.numberOfPlaces()*_hyper_traces,
                               state.marking())) {
                     _violation = true;
+                    if (_lasso)
+                        _lasso->closed(nested_todo.size());
                     return;
                 }
                 auto [is_new, stateid] = mark(states, working, MARKER2);
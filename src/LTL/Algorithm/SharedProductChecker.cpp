@@ -0,0 +1,158 @@
+/* Copyright (C) 2021  Nikolaj J. Ulrik <nikolaj@njulrik.dk>,
+ *                     Simon M. Virenfeldt <simon@simwir.dk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "LTL/Algorithm/SharedProductChecker.h"
+
+namespace LTL {
+
+    SharedProductChecker::SharedProductChecker(const PetriEngine::PetriNet& net,
+                                               const PetriEngine::PQL::Condition_ptr &cond,
+                                               const Structures::BuchiAutomaton &buchi,
+                                               Structures::MarkingGraph& graph)
+            : ModelChecker(net, cond, buchi), _graph(graph), _buchi_gen(buchi)
+    {
+        if (buchi.buchi().num_states() > (size_t{1} << buchi_bits)) {
+            throw base_error("Cannot handle Büchi automata larger than 2^20 states");
+        }
+        _state.setMarking(new PetriEngine::MarkVal[net.numberOfPlaces()]);
+        _edges.resize(buchi.buchi().num_states());
+        _edges_known.resize(buchi.buchi().num_states(), false);
+    }
+
+    const std::vector<std::pair<size_t, bdd>>& SharedProductChecker::buchi_edges(size_t q)
+    {
+        if (!_edges_known[q]) {
+            _buchi_gen.prepare(q);
+            size_t dest;
+            bdd cond;
+            while (_buchi_gen.next(dest, cond))
+                _edges[q].emplace_back(dest, cond);
+            _edges_known[q] = true;
+        }
+        return _edges[q];
+    }
+
+    void SharedProductChecker::successors(product_t state, std::vector<product_t>& out)
+    {
+        const auto& edges = buchi_edges(buchi_of(state));
+        for (auto m : _graph.successors(marking_of(state))) {
+            _graph.decode(_state, m);
+            PetriEngine::PQL::EvaluationContext ctx{_state.marking(), &_net};
+            for (auto& [q, cond] : edges) {
+                if (_buchi.guard_valid(ctx, cond))
+                    out.push_back(product(m, q));
+            }
+        }
+        _explored += out.size();
+        ++_expanded;
+    }
+
+    bool SharedProductChecker::push(product_t state)
+    {
+        auto index = _nodes.size();
+        _index.emplace(state, index);
+        auto m = marking_of(state);
+        if (m >= _seen_markings.size())
+            _seen_markings.resize(m + 1, false);
+        if (!_seen_markings[m]) {
+            _seen_markings[m] = true;
+            ++_markings;
+        }
+        auto q = buchi_of(state);
+        bool accepting = _buchi_gen.is_accepting(q);
+        // an accepting state whose Büchi state loops on true starts an accepting run, as every marking has a successor
+        if (accepting && _buchi_gen.has_invariant_self_loop(q))
+            return false;
+        _nodes.push_back(node_t{index, true, accepting});
+        _tarjan.push_back(index);
+        if (accepting)
+            _accepting.push_back(index);
+        frame_t frame{state, index, {}};
+        successors(state, frame.successors);
+        _dstack.push_back(std::move(frame));
+        return true;
+    }
+
+    bool SharedProductChecker::step()
+    {
+        auto& top = _dstack.back();
+        if (top.next < top.successors.size()) {
+            auto succ = top.successors[top.next++];
+            auto it = _index.find(succ);
+            if (it == _index.end())
+                return push(succ);
+            auto& node = _nodes[it->second];
+            if (!node.on_stack)
+                return true;
+            if (it->second == top.index)
+                _nodes[top.index].self_loop = true;
+            _nodes[top.index].lowlink = std::min(_nodes[top.index].lowlink, it->second);
+            // every state on the Tarjan stack from the successor up lies on a cycle through the current state
+            return _accepting.empty() || _accepting.back() < it->second;
+        }
+        auto index = top.index;
+        auto lowlink = _nodes[index].lowlink;
+        _dstack.pop_back();
+        if (lowlink == index) {
+            bool nontrivial = _tarjan.back() != index || _nodes[index].self_loop;
+            bool accepting = !_accepting.empty() && _accepting.back() >= index;
+            if (nontrivial && accepting)
+                return false;
+            pop_component(index);
+        }
+        else {
+            auto& parent = _nodes[_dstack.back().index];
+            parent.lowlink = std::min(parent.lowlink, lowlink);
+        }
+        return true;
+    }
+
+    void SharedProductChecker::pop_component(size_t root)
+    {
+        while (!_tarjan.empty() && _tarjan.back() >= root) {
+            _nodes[_tarjan.back()].on_stack = false;
+            _tarjan.pop_back();
+        }
+        while (!_accepting.empty() && _accepting.back() >= root)
+            _accepting.pop_back();
+    }
+
+    bool SharedProductChecker::check()
+    {
+        auto init = _graph.initial();
+        if (init == Structures::MarkingGraph::none)
+            return true;
+        _graph.decode(_state, init);
+        PetriEngine::PQL::EvaluationContext ctx{_state.marking(), &_net};
+        std::vector<product_t> initial;
+        for (auto& [q, cond] : buchi_edges(_buchi_gen.initial_state_number())) {
+            if (_buchi.guard_valid(ctx, cond))
+                initial.push_back(product(init, q));
+        }
+        for (auto state : initial) {
+            if (_index.count(state) != 0)
+                continue;
+            _violation = !push(state);
+            while (!_violation && !_dstack.empty())
+                _violation = !step();
+            if (_violation)
+                break;
+        }
+        _discovered = _nodes.size();
+        return !_violation;
+    }
+}
@@ -22,6 +22,8 @@ namespace LTL {
 
     void TarjanModelChecker::print_stats(std::ostream &os) const {
         ModelChecker::print_stats(os, _discoverd, _max_tokens);
+        if (_stack_page_outs > 0)
+            os << "\tstack page-outs:   " << _stack_page_outs << std::endl;
     }
 
     size_t TarjanModelChecker::max_tokens() const {
@@ -56,6 +58,8 @@ namespace LTL {
     }
 
     bool TarjanModelChecker::check() {
+        if(_lasso)
+            _seed_state = _factory.new_state();
         if(_heuristic != nullptr || _order != LTLPartialOrder::None)
         {
             // we need advanced successor generator pipeline (we need to look at successors)
@@ -95,13 +99,18 @@ namespace LTL {
     template<typename SuccGen>
     bool TarjanModelChecker::select_trace_compute(SuccGen& successorGenerator)
     {
+        // the stacks are only paged when their memory is bounded
+        if (_stack_memory != 0)
+            return _build_trace ?
+                compute<true, true, SuccGen>(successorGenerator) :
+                compute<false, true, SuccGen>(successorGenerator);
         return _build_trace ?
-            compute<true, SuccGen>(successorGenerator) :
-            compute<false, SuccGen>(successorGenerator);
+            compute<true, false, SuccGen>(successorGenerator) :
+            compute<false, false, SuccGen>(successorGenerator);
     }
 
 
-    template<bool SaveTrace, typename SuccGen>
+    template<bool SaveTrace, bool Paged, typename SuccGen>
     bool TarjanModelChecker::compute(SuccGen& successorGenerator)
     {
 
@@ -112,10 +121,22 @@ namespace LTL {
                 plain_centry_t>;
 
         StateSet seen(_net, _k_bound);
+        using cstack_t = std::conditional_t<Paged, paged_stack<centry_t>, light_deque<centry_t>>;
+        using dstack_type = dstack_t<SuccGen, Paged>;
         // master list of state information.
-        light_deque<centry_t> cstack;
+        auto cstack = [&] {
+            if constexpr (Paged)
+                return cstack_t(_stack_memory / 2);
+            else
+                return cstack_t();
+        }();
         // depth-first search stack, contains current search path.
-        light_deque<dentry_t<SuccGen>> dstack;
+        auto dstack = [&] {
+            if constexpr (std::is_same_v<dstack_type, paged_stack<dentry_t<SuccGen>>>)
+                return dstack_type(_stack_memory / 2);
+            else
+                return dstack_type();
+        }();
 
         auto initial_states = successorGenerator.make_initial_state();
         State working = _factory.new_state();
@@ -195,6 +216,11 @@ namespace LTL {
                 }
             }
         }
+        _stack_page_outs = 0;
+        if constexpr (Paged)
+            _stack_page_outs += cstack.page_outs();
+        if constexpr (std::is_same_v<dstack_type, paged_stack<dentry_t<SuccGen>>>)
+            _stack_page_outs += dstack.page_outs();
         _discoverd = seen.discovered();
         _max_tokens = seen.max_tokens();
         _markings = seen.markings();
@@ -206,15 +232,18 @@ namespace LTL {
      * Push a state to the various stacks.
      * @param state
      */
-    template<typename StateSet, typename T, typename D, typename S>
-    void TarjanModelChecker::push(StateSet& s, light_deque<T>& cstack, light_deque<D>& dstack, S& successor_generator, State &state, size_t stateid) {
+    template<typename StateSet, typename C, typename D, typename S>
+    void TarjanModelChecker::push(StateSet& s, C& cstack, D& dstack, S& successor_generator, State &state, size_t stateid) {
+        using T = std::remove_reference_t<decltype(cstack.back())>;
         const auto ctop = static_cast<idx_t>(cstack.size());
         const auto h = hash(StateSet::get_marking_id(stateid), StateSet::get_buchi_state(stateid));
         cstack.push_back(T{ctop, stateid, _chash[h]});
         _chash[h] = ctop;
-        dstack.push_back(D{ctop, successor_generator.initial_suc_info()});
+        dstack.push_back(std::remove_reference_t<decltype(dstack.back())>{ctop, successor_generator.initial_suc_info()});
         if (successor_generator.is_accepting(state)) {
             _astack.push_back(ctop);
+            if (_lasso)
+                _lasso->set_seed(state);
             if (successor_generator.has_invariant_self_loop(state)){
                 _violation = true;
                 _invariant_loop = true;
@@ -225,8 +254,8 @@ namespace LTL {
         }
     }
 
-    template<typename S, typename T, typename D, typename SuccGen>
-    void TarjanModelChecker::pop(S& seen, light_deque<T>& cstack, light_deque<D>& dstack, SuccGen& successorGenerator)
+    template<typename S, typename C, typename D, typename SuccGen>
+    void TarjanModelChecker::pop(S& seen, C& cstack, D& dstack, SuccGen& successorGenerator)
     {
         const auto p = dstack.back()._pos;
         dstack.pop_back();
@@ -238,6 +267,15 @@ namespace LTL {
         }
         if (!_astack.empty() && p == _astack.back()) {
             _astack.pop_back();
+            if (_lasso) {
+                // fall back to the closest accepting state still on the search path.
+                if (_astack.empty())
+                    _lasso->clear_seed();
+                else {
+                    seen.decode(_seed_state, cstack[_astack.back()]._stateid);
+                    _lasso->set_seed(_seed_state, false);
+                }
+            }
         }
         if (!dstack.empty()) {
             update(cstack, dstack, successorGenerator, p);
@@ -247,8 +285,8 @@ namespace LTL {
         }
     }
 
-    template<typename StateSet, typename T>
-    void TarjanModelChecker::popCStack(StateSet& s, light_deque<T>& cstack)
+    template<typename StateSet, typename C>
+    void TarjanModelChecker::popCStack(StateSet& s, C& cstack)
     {
         auto h = hash(StateSet::get_marking_id(cstack.back()._stateid), StateSet::get_buchi_state(cstack.back()._stateid));
         _store.insert(cstack.back()._stateid);
@@ -257,9 +295,10 @@ namespace LTL {
     }
 
 
-    template<typename T, typename D, typename SuccGen>
-    void TarjanModelChecker::update(light_deque<T>& cstack, light_deque<D>& dstack, SuccGen& successorGenerator, idx_t to)
+    template<typename C, typename D, typename SuccGen>
+    void TarjanModelChecker::update(C& cstack, D& dstack, SuccGen& successorGenerator, idx_t to)
     {
+        using T = std::remove_reference_t<decltype(cstack.back())>;
         const auto from = dstack.back()._pos;
         assert(cstack[to]._lowlink != std::numeric_limits<idx_t>::max() && cstack[from]._lowlink != std::numeric_limits<idx_t>::max());
         if (cstack[to]._lowlink <= cstack[from]._lowlink) {
@@ -267,6 +306,8 @@ namespace LTL {
             // if this earlier component precedes an accepting state,
             // the found loop is accepting and thus a violation.
             _violation = (!_astack.empty() && to <= _astack.back());
+            if (_violation && _lasso)
+                _lasso->closed(from - _astack.back());
             // either way update the component ID of the state we came from.
             cstack[from]._lowlink = cstack[to]._lowlink;
             if constexpr (T::save_trace()) {
@@ -277,8 +318,8 @@ namespace LTL {
         }
     }
 
-    template<typename S, typename T, typename SuccGen, typename D>
-    bool TarjanModelChecker::next_trans(S& seen, light_deque<T>& cstack, SuccGen& successorGenerator, State &state, State &parent, D &delem)
+    template<typename S, typename C, typename SuccGen, typename D>
+    bool TarjanModelChecker::next_trans(S& seen, C& cstack, SuccGen& successorGenerator, State &state, State &parent, D &delem)
     {
         seen.decode(parent, cstack[delem._pos]._stateid);
         successorGenerator.prepare(&parent, delem._sucinfo);
@@ -291,7 +332,7 @@ namespace LTL {
     }
 
     template<typename S, typename D, typename C>
-    void TarjanModelChecker::build_trace(S& seen, light_deque<D> &&dstack, light_deque<C>& cstack)
+    void TarjanModelChecker::build_trace(S& seen, light_deque<D> &&dstack, C& cstack)
     {
         assert(_violation);
         if (cstack[dstack.back()._pos]._stateid == _loop_state)
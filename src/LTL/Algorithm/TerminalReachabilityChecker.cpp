@@ -0,0 +1,178 @@
+#include "LTL/Algorithm/TerminalReachabilityChecker.h"
+#include "LTL/SuccessorGeneration/BuchiSuccessorGenerator.h"
+
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <queue>
+#include <random>
+
+namespace LTL {
+
+    bool TerminalReachabilityChecker::is_terminal(const Structures::BuchiAutomaton &buchi)
+    {
+        BuchiSuccessorGenerator gen(buchi);
+        for (unsigned state = 0; state < buchi.buchi().num_states(); ++state) {
+            if (gen.is_accepting(state) && !gen.has_invariant_self_loop(state))
+                return false;
+        }
+        return true;
+    }
+
+    void TerminalReachabilityChecker::print_stats(std::ostream &os) const {
+        ModelChecker::print_stats(os, _discovered, _max_tokens);
+    }
+
+    void TerminalReachabilityChecker::set_partial_order(LTLPartialOrder o)
+    {
+        // the visible stubborn sets rely on the cycle proviso of a depth-first search,
+        // the automaton-based ones define a reduced state space independent of the search order.
+        if (_net.has_inhibitor() || o == LTLPartialOrder::Visible)
+            _order = LTLPartialOrder::None;
+        else
+            _order = o;
+    }
+
+    bool TerminalReachabilityChecker::check()
+    {
+        if (_heuristic != nullptr || _order != LTLPartialOrder::None) {
+            SpoolingSuccessorGenerator gen{_net, _formula};
+            std::unique_ptr<SuccessorSpooler> spooler;
+            if (_order == LTLPartialOrder::Liebke)
+                spooler = std::make_unique<AutomatonStubbornSet>(_net, _buchi);
+            else
+                spooler = std::make_unique<EnabledSpooler>(_net, gen);
+            gen.set_spooler(*spooler);
+            // successors are ordered by the waiting list, not by the successor generator.
+            if (_order == LTLPartialOrder::Automaton) {
+                ReachStubProductSuccessorGenerator succ_gen(_net, _buchi, gen, std::make_unique<EnabledSpooler>(_net, gen));
+                return select_trace_compute(succ_gen);
+            } else {
+                ProductSuccessorGenerator succ_gen(_net, _buchi, gen);
+                return select_trace_compute(succ_gen);
+            }
+        } else {
+            ResumingSuccessorGenerator gen{_net};
+            ProductSuccessorGenerator succ_gen(_net, _buchi, gen);
+            return select_trace_compute(succ_gen);
+        }
+    }
+
+    template<typename SuccGen>
+    bool TerminalReachabilityChecker::select_trace_compute(SuccGen& successorGenerator)
+    {
+        return _build_trace ?
+               compute<true, SuccGen>(successorGenerator) :
+               compute<false, SuccGen>(successorGenerator);
+    }
+
+    template<bool SaveTrace, typename SuccGen>
+    bool TerminalReachabilityChecker::compute(SuccGen& successorGenerator)
+    {
+        using StateSet = std::conditional_t<SaveTrace, LTL::Structures::TraceableBitProductStateSet<>,
+                LTL::Structures::BitProductStateSet<>>;
+        using weighted_t = std::pair<uint32_t, size_t>;
+        constexpr auto err = std::numeric_limits<size_t>::max();
+
+        StateSet seen(_net, _k_bound);
+        const bool best_first = _strategy == Strategy::HEUR && _heuristic != nullptr;
+        const bool fifo = _strategy == Strategy::BFS;
+        // min-heap on weight; ties broken on the most recently discovered state.
+        std::priority_queue<weighted_t, std::vector<weighted_t>, std::function<bool(const weighted_t&, const weighted_t&)>>
+                heap([](const weighted_t& a, const weighted_t& b) {
+                    return a.first == b.first ? a.second < b.second : a.first > b.first;
+                });
+        std::deque<size_t> waiting;
+        std::vector<weighted_t> successors;
+        std::default_random_engine rng(_seed);
+
+        auto waiting_empty = [&] { return best_first ? heap.empty() : waiting.empty(); };
+        auto pop_waiting = [&] {
+            size_t id;
+            if (best_first) {
+                id = heap.top().second;
+                heap.pop();
+            } else if (fifo) {
+                id = waiting.front();
+                waiting.pop_front();
+            } else {
+                id = waiting.back();
+                waiting.pop_back();
+            }
+            return id;
+        };
+
+        State working = _factory.new_state();
+        State parent = _factory.new_state();
+        std::vector<size_t> initial;
+        size_t violating = err;
+        for (auto &state : successorGenerator.make_initial_state()) {
+            const auto [is_new, stateid, _] = seen.add(state);
+            if (!is_new || stateid == err) continue;
+            initial.push_back(stateid);
+            if (successorGenerator.is_accepting(state)) {
+                violating = stateid;
+                break;
+            }
+            if (best_first) heap.emplace(0, stateid);
+            else waiting.push_back(stateid);
+        }
+
+        while (violating == err && !waiting_empty()) {
+            const auto id = pop_waiting();
+            seen.decode(parent, id);
+            auto sucinfo = successorGenerator.initial_suc_info();
+            successorGenerator.prepare(&parent, sucinfo);
+            const bool weigh = best_first && _heuristic->has_heuristic(parent);
+            if (weigh)
+                _heuristic->prepare(parent);
+            successors.clear();
+            while (successorGenerator.next(working, sucinfo)) {
+                ++_explored;
+                const auto [is_new, stateid, _] = seen.add(working);
+                if (!is_new || stateid == err) continue;
+                if constexpr (SaveTrace) {
+                    seen.set_history(stateid, successorGenerator.fired());
+                }
+                if (successorGenerator.is_accepting(working)) {
+                    violating = stateid;
+                    break;
+                }
+                // the self-loop added to a deadlock fires no transition of the net, so it is not weighed
+                const bool deadlock = successorGenerator.fired() >= _net.numberOfTransitions();
+                successors.emplace_back(weigh && !deadlock ? _heuristic->eval(working, successorGenerator.fired()) : 0, stateid);
+            }
+            ++_expanded;
+            if (best_first) {
+                for (auto& s : successors) heap.push(s);
+            } else {
+                if (_strategy == Strategy::RDFS)
+                    std::shuffle(successors.begin(), successors.end(), rng);
+                for (auto& s : successors) waiting.push_back(s.second);
+            }
+        }
+
+        _violation = violating != err;
+        if constexpr (SaveTrace) {
+            if (_violation)
+                build_trace(seen, violating, initial);
+        }
+        _discovered = seen.discovered();
+        _max_tokens = seen.max_tokens();
+        _markings = seen.markings();
+        _configurations = seen.configurations();
+        return !_violation;
+    }
+
+    template<typename S>
+    void TerminalReachabilityChecker::build_trace(S& seen, size_t stateid, const std::vector<size_t>& initial)
+    {
+        // the accepting state has an invariant self-loop, so the path leading to it is the full counter-example.
+        while (std::find(initial.begin(), initial.end(), stateid) == initial.end()) {
+            auto [parent, tid] = seen.get_history(stateid);
+            _trace.push_back({(uint32_t)tid});
+            stateid = parent;
+        }
+        std::reverse(_trace.begin(), _trace.end());
+    }
+}
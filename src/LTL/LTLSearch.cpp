@@ -23,11 +23,13 @@
 #include "LTL/SuccessorGeneration/SpoolingSuccessorGenerator.h"
 #include "LTL/Algorithm/NestedDepthFirstSearch.h"
 #include "LTL/Algorithm/TarjanModelChecker.h"
+#include "LTL/Algorithm/SharedProductChecker.h"
 
 #include "PetriEngine/PQL/PredicateCheckers.h"
 #include "PetriEngine/PQL/PQL.h"
 #include "PetriEngine/PQL/Expressions.h"
 #include "PetriEngine/options.h"
+#include "utils/output.h"
 
 #include <utility>
 
@@ -102,12 +104,13 @@ namespace LTL {
         return std::make_pair(converted, should_negate);
     }
 
-    std::unique_ptr<Heuristic> make_heuristic(const PetriNet& net,
+    std::unique_ptr<Heuristic> make_base_heuristic(const PetriNet& net,
         const Condition_ptr &negated_formula,
         const Structures::BuchiAutomaton& automaton,
         const Strategy search_strategy = Strategy::HEUR,
         const LTLHeuristic heuristics = LTLHeuristic::Automaton,
-        const uint64_t seed = 0) {
+        const uint64_t seed = 0,
+        const std::vector<uint32_t>& potencies = {}) {
         if (search_strategy == Strategy::RDFS || heuristics == LTLHeuristic::RDFS) {
             return std::make_unique<RandomHeuristic>(seed);
         }
@@ -121,6 +124,8 @@ namespace LTL {
                 return std::make_unique<AutomatonHeuristic>(&net, automaton);
             case LTLHeuristic::FireCount:
                 return std::make_unique<LogFireCountHeuristic>(net.numberOfTransitions(), 5000);
+            case LTLHeuristic::Potency:
+                return std::make_unique<PotencyHeuristic>(&net, automaton, potencies);
             case LTLHeuristic::DFS:
             case LTLHeuristic::RDFS:
                 return nullptr;
@@ -129,6 +134,20 @@ namespace LTL {
         }
     }
 
+    std::unique_ptr<Heuristic> make_heuristic(const PetriNet& net,
+        const Condition_ptr &negated_formula,
+        const Structures::BuchiAutomaton& automaton,
+        const Strategy search_strategy = Strategy::HEUR,
+        const LTLHeuristic heuristics = LTLHeuristic::Automaton,
+        const uint64_t seed = 0,
+        const bool lasso = false,
+        const std::vector<uint32_t>& potencies = {}) {
+        auto heuristic = make_base_heuristic(net, negated_formula, automaton, search_strategy, heuristics, seed, potencies);
+        if (lasso)
+            return std::make_unique<LassoHeuristic>(&net, std::move(heuristic));
+        return heuristic;
+    }
+
     LTLSearch::LTLSearch(const PetriEngine::PetriNet& net,
         const PetriEngine::PQL::Condition_ptr &query, const BuchiOptimization optimization, const APCompression compression)
     : _net(net), _query(query), _compression(compression) {
@@ -163,33 +182,38 @@ namespace LTL {
         std::string tindent = ntraces <= 1 ? "" : "  ";
         std::string indent = tindent + "  ";
         std::string token_indent = indent + "  ";
+        PetriEngine::TraceExpander expander(&reducer, _net);
+        // the traces are passed on to the stream in blocks, and flushed, when buffer goes out of scope
+        buffered_output buffer(os, 1 << 16);
         if(!_traces.empty())
-            os << "<trace-list>\n";
+            buffer << "<trace-list>\n";
         for(size_t j = 0; j < ntraces; ++j)
         {
             bool printed_deadlock = false;
-            os << tindent << "<trace";
+            buffer << tindent << "<trace";
             if(!_traces.empty())
-                os << " name=\"" << _traces[j] << "\"";
-            os << ">\n";
-            reducer.initFire(os);
+                buffer << " name=\"" << _traces[j] << "\"";
+            buffer << ">\n";
+            std::vector<PetriEngine::TraceStep> initial;
+            expander.initial(initial);
+            expander.print(buffer, initial);
             for (size_t i = 0; i < trace.size(); ++i) {
                 if (i == _checker->loop_index())
                 {
                     if(trace[i][j] < std::numeric_limits<ptrie::uint>::max() - 1) // otherwise it is a deadlock.
-                        os << indent << "<loop/>\n";
+                        buffer << indent << "<loop/>\n";
                 }
                 assert(trace[i].size() == ntraces);
-                print_transition(trace[i][j], reducer, os, indent, token_indent, printed_deadlock);
+                print_transition(trace[i][j], expander, buffer, indent, token_indent, printed_deadlock);
             }
-            os << std::endl << tindent << "</trace>" << std::endl;
+            buffer << "\n" << tindent << "</trace>\n";
         }
         if(!_traces.empty())
-            os << "</trace-list>\n";
+            buffer << "</trace-list>\n";
     }
 
     std::ostream &
-    LTLSearch::print_transition(uint32_t transition, const PetriEngine::Reducer& reducer, std::ostream &os, const std::string& _indent, const std::string& _token_indent, bool& printed_deadlock) const {
+    LTLSearch::print_transition(uint32_t transition, const PetriEngine::TraceExpander& expander, std::ostream &os, const std::string& _indent, const std::string& _token_indent, bool& printed_deadlock) const {
         if (transition >= std::numeric_limits<ptrie::uint>::max() - 1) {
             if(!printed_deadlock)
                 os << _indent << "<deadlock/>";
@@ -197,14 +221,18 @@ namespace LTL {
             return os;
         }
 
+        // the first step is the transition itself, the rest are fired by reductions right after it
+        std::vector<PetriEngine::TraceStep> steps;
+        expander.fire(steps, transition);
         os << _indent << "<transition id="
                 // field width stuff obsolete without büchi state printing.
                 << std::quoted(*_net.transitionNames()[transition]);
         os << ">\n";
-        reducer.tokenConsumption(os, *_net.transitionNames()[transition]);
-        os << std::endl;
+        expander.printTokens(os, steps.front());
+        os << "\n";
         os << _indent << "</transition>\n";
-        reducer.postFire(os, *_net.transitionNames()[transition]);
+        for (size_t i = 1; i < steps.size(); ++i)
+            expander.print(os, steps[i]);
         return os;
     }
 
@@ -226,11 +254,24 @@ namespace LTL {
                             const Strategy search_strategy,
                             const LTLHeuristic heuristics_flag,
                             const bool utilize_weak,
-                            const uint64_t seed) {
+                            const uint64_t seed,
+                            const bool lasso,
+                            const bool terminal_reach) {
 
-        _heuristic = make_heuristic(_net, _negated_formula, _buchi, search_strategy, heuristics_flag, seed);
+        _heuristic = make_heuristic(_net, _negated_formula, _buchi, search_strategy, heuristics_flag, seed, lasso, _potencies);
 
-        switch (algorithm) {
+        // terminal automata need no cycle detection; hyper-LTL still goes through the compound NDFS.
+        _terminal_reach = terminal_reach && utilize_weak && _traces.empty() &&
+                          algorithm != Algorithm::None && TerminalReachabilityChecker::is_terminal(_buchi);
+        if (_marking_graph != nullptr && !trace && _traces.empty()) {
+            _terminal_reach = false;
+            _checker = std::make_unique<SharedProductChecker>(_net, _negated_formula, _buchi, *_marking_graph);
+        }
+        else if (_terminal_reach) {
+            _checker = std::make_unique<TerminalReachabilityChecker>(_net, _negated_formula, _buchi, k_bound,
+                                                                     search_strategy, seed);
+        }
+        else switch (algorithm) {
             case Algorithm::NDFS:
             {
                 _checker = std::make_unique<NestedDepthFirstSearch>(_net, _negated_formula, _buchi, k_bound, _traces.size());
@@ -244,6 +285,7 @@ namespace LTL {
                 assert(false);
                 std::cerr << "Error: cannot LTL verify with algorithm None";
         }
+        _checker->set_stack_memory(_stack_memory);
         _checker->set_utilize_weak(utilize_weak);
         _checker->set_heuristic(_heuristic.get());
         _checker->set_partial_order(por);
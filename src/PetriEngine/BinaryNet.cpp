@@ -0,0 +1,168 @@
+#include "PetriEngine/BinaryNet.h"
+#include "utils/mapped_file.h"
+
+#include <cstring>
+#include <vector>
+
+namespace PetriEngine {
+
+    namespace {
+        // bumped whenever the layout changes
+        constexpr char magic[8] = {'V', 'P', 'N', 'N', 'E', 'T', '0', '1'};
+
+        template<typename T>
+        void write(std::ostream& out, const T& value) {
+            static_assert(std::is_trivially_copyable_v<T>);
+            out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        template<typename T>
+        void write(std::ostream& out, const std::vector<T>& values) {
+            static_assert(std::is_trivially_copyable_v<T>);
+            out.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+        }
+
+        // an array of the mapped file, read in place; the file gives no alignment, hence the copy per element
+        template<typename T>
+        class section {
+        private:
+            const char* _data;
+            size_t _size;
+
+        public:
+            section(mapped_reader& in, size_t size) : _data(in.bytes(size * sizeof(T))), _size(size) {
+            }
+
+            T operator[](size_t i) const {
+                T value;
+                std::memcpy(&value, _data + i * sizeof(T), sizeof(T));
+                return value;
+            }
+
+            size_t size() const {
+                return _size;
+            }
+        };
+
+        // offsets into an array of entries, which must be ascending and end at the size of the array
+        section<uint32_t> offsets(mapped_reader& in, size_t rows) {
+            section<uint32_t> offsets(in, rows + 1);
+            if (offsets[0] != 0)
+                throw base_error("Invalid offsets in binary model");
+            for (size_t i = 0; i < rows; ++i)
+                if (offsets[i] > offsets[i + 1])
+                    throw base_error("Invalid offsets in binary model");
+            return offsets;
+        }
+    }
+
+    void BinaryNet::write(const PetriNet& net, std::ostream& out) {
+        const uint32_t places = net._nplaces;
+        const uint32_t transitions = net._ntransitions;
+        out.write(magic, sizeof(magic));
+        PetriEngine::write(out, places);
+        PetriEngine::write(out, transitions);
+
+        // the names and locations of places and transitions removed by the reductions follow those of the net
+        const std::pair<const std::vector<shared_const_string>*, uint32_t> names[] = {
+            {&net._placenames, places}, {&net._transitionnames, transitions}};
+        std::vector<uint32_t> name_offsets;
+        name_offsets.reserve(places + transitions + 1);
+        name_offsets.push_back(0);
+        for (auto [of, n] : names)
+            for (uint32_t i = 0; i < n; ++i)
+                name_offsets.push_back(name_offsets.back() + (*of)[i]->size());
+        PetriEngine::write(out, name_offsets);
+        for (auto [of, n] : names)
+            for (uint32_t i = 0; i < n; ++i)
+                out.write((*of)[i]->data(), (*of)[i]->size());
+
+        for (uint32_t p = 0; p < places; ++p)
+            PetriEngine::write<uint32_t>(out, net._initialMarking[p]);
+        for (uint32_t p = 0; p < places; ++p) {
+            PetriEngine::write(out, std::get<0>(net._placelocations[p]));
+            PetriEngine::write(out, std::get<1>(net._placelocations[p]));
+        }
+        for (uint32_t t = 0; t < transitions; ++t)
+            PetriEngine::write<int32_t>(out, net._controllable[t] ? 0 : 1);
+        for (uint32_t t = 0; t < transitions; ++t) {
+            PetriEngine::write(out, std::get<0>(net._transitionlocations[t]));
+            PetriEngine::write(out, std::get<1>(net._transitionlocations[t]));
+        }
+
+        // the arcs of a transition are already contiguous in the net, inputs and outputs alternating
+        auto arcs = [&](bool pre) {
+            std::vector<uint32_t> offsets{0}, place, weight;
+            std::vector<uint8_t> inhibitor;
+            for (uint32_t t = 0; t < transitions; ++t) {
+                auto first = pre ? net._transitions[t].inputs : net._transitions[t].outputs;
+                auto last = pre ? net._transitions[t].outputs : net._transitions[t + 1].inputs;
+                for (auto i = first; i < last; ++i) {
+                    auto& arc = net._invariants[i];
+                    place.push_back(arc.place);
+                    weight.push_back(arc.tokens);
+                    inhibitor.push_back(arc.inhibitor ? 1 : 0);
+                }
+                offsets.push_back(place.size());
+            }
+            PetriEngine::write(out, offsets);
+            PetriEngine::write(out, place);
+            PetriEngine::write(out, weight);
+            if (pre)
+                PetriEngine::write(out, inhibitor);
+        };
+        arcs(true);
+        arcs(false);
+    }
+
+    void BinaryNet::read(const std::string& path, PetriNetBuilder& builder) {
+        mapped_file file(path);
+        mapped_reader in(file);
+        if (std::memcmp(in.bytes(sizeof(magic)), magic, sizeof(magic)) != 0)
+            throw base_error("Not a binary model (or written by another version): ", path);
+        const auto places = in.read<uint32_t>();
+        const auto transitions = in.read<uint32_t>();
+        const size_t nodes = (size_t)places + transitions;
+
+        auto name_offsets = offsets(in, nodes);
+        const char* names = in.bytes(name_offsets[nodes]);
+        auto name = [&](size_t i) {
+            return std::make_shared<const_string>(names + name_offsets[i], name_offsets[i + 1] - name_offsets[i]);
+        };
+
+        section<uint32_t> marking(in, places);
+        section<double> place_xy(in, 2 * (size_t)places);
+        for (uint32_t p = 0; p < places; ++p)
+            builder.addPlace(name(p), marking[p], place_xy[2 * p], place_xy[2 * p + 1]);
+        section<int32_t> player(in, transitions);
+        section<double> transition_xy(in, 2 * (size_t)transitions);
+        for (uint32_t t = 0; t < transitions; ++t)
+            builder.addTransition(name(places + t), player[t], transition_xy[2 * t], transition_xy[2 * t + 1]);
+        if (builder.numberOfPlaces() != places || builder.numberOfTransitions() != transitions)
+            throw base_error("Duplicate names in binary model");
+
+        auto pre_offsets = offsets(in, transitions);
+        section<uint32_t> pre_place(in, pre_offsets[transitions]);
+        section<uint32_t> pre_weight(in, pre_offsets[transitions]);
+        section<uint8_t> pre_inhibitor(in, pre_offsets[transitions]);
+        auto post_offsets = offsets(in, transitions);
+        section<uint32_t> post_place(in, post_offsets[transitions]);
+        section<uint32_t> post_weight(in, post_offsets[transitions]);
+        if (!in.done())
+            throw base_error("Trailing data in binary model");
+
+        for (uint32_t t = 0; t < transitions; ++t) {
+            for (auto i = pre_offsets[t]; i < pre_offsets[t + 1]; ++i) {
+                if (pre_place[i] >= places)
+                    throw base_error("Invalid arc in binary model");
+                builder.addInputArc(pre_place[i], t, pre_inhibitor[i] != 0, pre_weight[i]);
+            }
+            for (auto i = post_offsets[t]; i < post_offsets[t + 1]; ++i) {
+                if (post_place[i] >= places)
+                    throw base_error("Invalid arc in binary model");
+                builder.addOutputArc(t, post_place[i], post_weight[i]);
+            }
+        }
+        builder.sort();
+    }
+}
@@ -22,6 +22,9 @@
 #include "PetriEngine/Colored/VariableVisitor.h"
 #include "PetriEngine/Colored/ForwardFixedPoint.h"
 
+#include <algorithm>
+#include <limits>
+
 namespace PetriEngine {
 
     NaiveBindingGenerator::Iterator::Iterator(NaiveBindingGenerator* generator)
@@ -139,7 +142,7 @@ namespace PetriEngine {
         if (_generator->_isDone) {
             _generator = nullptr;
         } else {
-            _generator->nextBinding();
+            _generator->step();
             if (_generator->_isDone) {
                 _generator = nullptr;
             }
@@ -171,6 +174,14 @@ namespace PetriEngine {
             assert(arc.expr != nullptr);
             Colored::VariableVisitor::get_variables(*arc.expr, variables);
         }
+        _variables.assign(variables.begin(), variables.end());
+        // the enumeration order should not depend on where the variables happen to be allocated
+        std::sort(_variables.begin(), _variables.end(), [](auto* a, auto* b) { return a->name < b->name; });
+        _values.resize(_variables.size());
+        if (_expr != nullptr) {
+            _guard = Colored::CompiledExpression::compile(*_expr, _variables, _colorTypes);
+            extractConstraints(*_expr);
+        }
 
         for(const auto &varSet : symmetric_vars){
             std::vector<std::vector<uint32_t>> combinations;
@@ -179,117 +190,311 @@ namespace PetriEngine {
             _symmetric_var_combinations.push_back(combinations);
         }
 
-
-        for (auto* var : variables) {
-            if(var_map.empty() || var_map[_nextIndex].find(var)->second.empty()){
-                _noValidBindings = true;
-                break;
-            }
-            auto color = var->colorType->getColor(var_map[_nextIndex].find(var)->second.front().getLowerIds());
-            _bindings[var] = color;
+        if (_variables.empty()) {
+            _noValidBindings = !eval();
+            return;
         }
-        assignSymmetricVars();
-
-        if (!_noValidBindings && !eval())
-            nextBinding();
+        if (_var_map.empty()) {
+            _noValidBindings = true;
+            return;
+        }
+        _prepared = prepare(0);
+        findBinding();
+        _noValidBindings = _isDone;
     }
 
-    bool FixpointBindingGenerator::assignSymmetricVars(){
-        if(_currentOuterId < _symmetric_vars.size()){
-            if(_currentInnerId >= _symmetric_var_combinations[_currentOuterId].size()){
-                _currentOuterId++;
-                _currentInnerId = 0;
-            }
-        } else {
-            return false;
-        }
-        uint32_t j = 0;
-        for(auto var : _symmetric_vars[_currentOuterId]){
-            _bindings[var] = &var->colorType->operator[](_symmetric_var_combinations[_currentOuterId][_currentInnerId][j]);
-            j++;
-        }
-        _currentInnerId++;
-        if(_currentInnerId >= _symmetric_var_combinations[_currentOuterId].size()){
-            if(_currentOuterId < _symmetric_vars.size()){
-                _currentOuterId++;
-                _currentInnerId = 0;
+    void FixpointBindingGenerator::extractConstraints(const Colored::GuardExpression& expr) {
+        // only conjuncts are necessary for the guard to hold, anything below a disjunction is left to eval()
+        if (auto* e = dynamic_cast<const Colored::AndExpression*>(&expr)) {
+            extractConstraints(*(*e)[0]);
+            extractConstraints(*(*e)[1]);
+        } else if (auto* e = dynamic_cast<const Colored::EqualityExpression*>(&expr)) {
+            if ((*e)[0]->is_tuple() && (*e)[1]->is_tuple()) {
+                auto* lhs = static_cast<const Colored::TupleExpression*>((*e)[0].get());
+                auto* rhs = static_cast<const Colored::TupleExpression*>((*e)[1].get());
+                if (lhs->size() == rhs->size()) {
+                    for (auto l = lhs->begin(), r = rhs->begin(); l != lhs->end(); ++l, ++r)
+                        addConstraint(constraint_t::EQ, **l, **r);
+                }
             } else {
-                return false;
+                addConstraint(constraint_t::EQ, *(*e)[0], *(*e)[1]);
             }
+        } else if (auto* e = dynamic_cast<const Colored::InequalityExpression*>(&expr)) {
+            addConstraint(constraint_t::NEQ, *(*e)[0], *(*e)[1]);
+        } else if (auto* e = dynamic_cast<const Colored::LessThanExpression*>(&expr)) {
+            addConstraint(constraint_t::LT, *(*e)[0], *(*e)[1]);
+        } else if (auto* e = dynamic_cast<const Colored::LessThanEqExpression*>(&expr)) {
+            addConstraint(constraint_t::LEQ, *(*e)[0], *(*e)[1]);
         }
-        return true;
     }
 
+    void FixpointBindingGenerator::addConstraint(constraint_t::op_t op, const Colored::ColorExpression& lhs, const Colored::ColorExpression& rhs) {
+        auto to_term = [this](const Colored::ColorExpression* e, term_t& term) {
+            while (true) {
+                if (e->is_successor()) {
+                    ++term._offset;
+                    e = static_cast<const Colored::SuccessorExpression*>(e)->child().get();
+                } else if (e->is_predecessor()) {
+                    --term._offset;
+                    e = static_cast<const Colored::PredecessorExpression*>(e)->child().get();
+                } else {
+                    break;
+                }
+            }
+            if (e->is_variable()) {
+                auto* var = static_cast<const Colored::VariableExpression*>(e)->variable();
+                term._var = std::find(_variables.begin(), _variables.end(), var) - _variables.begin();
+                return true;
+            }
+            if (auto* c = dynamic_cast<const Colored::UserOperatorExpression*>(e)) {
+                term._constant = c->user_operator();
+                return true;
+            }
+            return false;
+        };
+        constraint_t c{op, {}, {}};
+        if (!to_term(&lhs, c._lhs) || !to_term(&rhs, c._rhs))
+            return;
+        if (c._lhs._var == -1 && c._rhs._var == -1)
+            return;
+        auto type_of = [this](const term_t& t) {
+            return t._var != -1 ? _variables[t._var]->colorType : t._constant->getColorType();
+        };
+        const auto* type = type_of(c._lhs);
+        if (type != type_of(c._rhs))
+            return;
+        // eval() orders colors by address, which only coincides with their id for non-product types
+        if ((op == constraint_t::LT || op == constraint_t::LEQ) && type->isProduct())
+            return;
+        _constraints.push_back(c);
+    }
 
-    bool FixpointBindingGenerator::eval() const{
-        if (_expr == nullptr)
-            return true;
+    const Colored::Color* FixpointBindingGenerator::value(const term_t& term) const {
+        const Colored::Color* color = term._var != -1 ? _values[term._var] : term._constant;
+        if (term._offset == 0)
+            return color;
+        const auto* type = color->getColorType();
+        const int64_t size = type->size();
+        const int64_t id = ((int64_t{color->getId()} + term._offset) % size + size) % size;
+        return &(*type)[id];
+    }
 
-        Colored::EquivalenceVec placePartition;
-        const Colored::ExpressionContext context {_bindings, _colorTypes, placePartition};
-        return Colored::EvaluationVisitor::evaluate(*_expr, context);
+    bool FixpointBindingGenerator::holds(const constraint_t& constraint) const {
+        const auto* lhs = value(constraint._lhs);
+        const auto* rhs = value(constraint._rhs);
+        switch (constraint._op) {
+            case constraint_t::EQ: return lhs == rhs;
+            case constraint_t::NEQ: return lhs != rhs;
+            case constraint_t::LT: return lhs->getId() < rhs->getId();
+            case constraint_t::LEQ: return lhs->getId() <= rhs->getId();
+        }
+        return true;
     }
 
-    const Colored::BindingMap& FixpointBindingGenerator::nextBinding() {
-        bool test = false;
-        while (!test) {
-            bool next = true;
+    bool FixpointBindingGenerator::prepare(uint32_t index) {
+        const auto& var_map = _var_map[index];
+        _slots.clear();
 
-            if(assignSymmetricVars()){
-                next = false;
-            } else {
-                for (auto& binding : _bindings) {
-                    bool varSymmetric = false;
-                    for(auto& set : _symmetric_vars){
-                        if(set.find(binding.first) != set.end()){
-                            varSymmetric = true;
+        std::vector<int32_t> group_of(_variables.size(), -1);
+        for (size_t i = 0; i < _variables.size(); ++i) {
+            auto* var = _variables[i];
+            auto it = var_map.find(var);
+            if (it == var_map.end() || it->second.empty())
+                return false;
+            for (size_t g = 0; g < _symmetric_vars.size(); ++g) {
+                if (_symmetric_vars[g].count(var) > 0)
+                    group_of[i] = g;
+            }
+        }
+
+        std::vector<slot_t> pending;
+        for (size_t g = 0; g < _symmetric_vars.size(); ++g) {
+            auto& slot = pending.emplace_back();
+            slot._group = g;
+            for (auto* var : _symmetric_vars[g])
+                slot._vars.push_back(std::find(_variables.begin(), _variables.end(), var) - _variables.begin());
+        }
+        for (size_t i = 0; i < _variables.size(); ++i) {
+            if (group_of[i] != -1)
+                continue;
+            auto* var = _variables[i];
+            auto& slot = pending.emplace_back();
+            slot._vars.push_back(i);
+            std::vector<uint32_t> ids;
+            for (const auto& interval : var_map.find(var)->second) {
+                ids.resize(interval.size());
+                for (size_t k = 0; k < interval.size(); ++k)
+                    ids[k] = interval[k]._lower;
+                while (true) {
+                    slot._domain.push_back(var->colorType->getColor(ids));
+                    size_t k = 0;
+                    for (; k < interval.size(); ++k) {
+                        if (ids[k] < interval[k]._upper) {
+                            ++ids[k];
                             break;
                         }
+                        ids[k] = interval[k]._lower;
                     }
-                    if(varSymmetric){
-                        continue;
-                    }
-
-                    const auto &varInterval = _var_map[_nextIndex].find(binding.first)->second;
-                    std::vector<uint32_t> colorIds;
-                    binding.second->getTupleId(colorIds);
-                    const auto &nextIntervalBinding = varInterval.nextInterval(colorIds);
-
-                    if (nextIntervalBinding.size() == 0){
-                        binding.second = &binding.second->operator++();
-                        _currentInnerId = 0;
-                        _currentOuterId = 0;
-                        assignSymmetricVars();
-                        next = false;
+                    if (k == interval.size())
                         break;
-                    } else {
-                        binding.second = binding.second->getColorType()->getColor(nextIntervalBinding.getLowerIds());
-                        _currentInnerId = 0;
-                        _currentOuterId = 0;
-                        assignSymmetricVars();
-                        if(!nextIntervalBinding.equals(varInterval.front())){
-                            next = false;
+                }
+            }
+            // comparisons with constants restrict the domain up front
+            for (const auto& c : _constraints) {
+                if (c._lhs._var != -1 && c._rhs._var != -1)
+                    continue;
+                if (c._lhs._var != (int32_t)i && c._rhs._var != (int32_t)i)
+                    continue;
+                slot._domain.erase(std::remove_if(slot._domain.begin(), slot._domain.end(), [&](const Colored::Color* color) {
+                    _values[i] = color;
+                    return !holds(c);
+                }), slot._domain.end());
+            }
+            std::sort(slot._domain.begin(), slot._domain.end(), [](auto* a, auto* b) { return a->getId() < b->getId(); });
+            slot._domain.erase(std::unique(slot._domain.begin(), slot._domain.end()), slot._domain.end());
+            if (slot._domain.empty())
+                return false;
+        }
 
-                            break;
-                        }
+        // order slots smallest domain first, preferring variables determined by an equality on assigned ones
+        std::vector<bool> assigned(_variables.size(), false);
+        auto binary = [](const constraint_t& c) { return c._lhs._var != -1 && c._rhs._var != -1; };
+        while (!pending.empty()) {
+            size_t best = 0;
+            size_t best_size = std::numeric_limits<size_t>::max();
+            int32_t best_forcing = -1;
+            for (size_t s = 0; s < pending.size(); ++s) {
+                auto& slot = pending[s];
+                int32_t forcing = -1;
+                if (slot._group == -1) {
+                    const int32_t var = slot._vars[0];
+                    for (size_t c = 0; c < _constraints.size() && forcing == -1; ++c) {
+                        const auto& con = _constraints[c];
+                        if (con._op != constraint_t::EQ || !binary(con) || con._lhs._var == con._rhs._var)
+                            continue;
+                        if ((con._lhs._var == var && assigned[con._rhs._var]) ||
+                            (con._rhs._var == var && assigned[con._lhs._var]))
+                            forcing = c;
                     }
                 }
+                const size_t size = forcing != -1 ? 1 : slot._group != -1 ?
+                        _symmetric_var_combinations[slot._group].size() : slot._domain.size();
+                if (size < best_size) {
+                    best = s;
+                    best_size = size;
+                    best_forcing = forcing;
+                }
             }
+            auto& slot = _slots.emplace_back(std::move(pending[best]));
+            pending.erase(pending.begin() + best);
+            slot._forcing = best_forcing;
+            for (auto v : slot._vars)
+                assigned[v] = true;
+            for (size_t c = 0; c < _constraints.size(); ++c) {
+                const auto& con = _constraints[c];
+                if (!binary(con) || (int32_t)c == slot._forcing)
+                    continue;
+                const bool mine = std::find(slot._vars.begin(), slot._vars.end(), con._lhs._var) != slot._vars.end() ||
+                                  std::find(slot._vars.begin(), slot._vars.end(), con._rhs._var) != slot._vars.end();
+                if (mine && assigned[con._lhs._var] && assigned[con._rhs._var])
+                    slot._checks.push_back(c);
+            }
+        }
+        _depth = 0;
+        _slots[0]._next = 0;
+        return true;
+    }
 
-            if(next){
-                _nextIndex++;
-                if(isInitial()){
-                    _isDone = true;
-                    break;
+    bool FixpointBindingGenerator::advance(slot_t& slot) {
+        auto consistent = [&] {
+            for (auto c : slot._checks) {
+                if (!holds(_constraints[c]))
+                    return false;
+            }
+            return true;
+        };
+        if (slot._group != -1) {
+            const auto& combinations = _symmetric_var_combinations[slot._group];
+            while (slot._next < combinations.size()) {
+                const auto& combination = combinations[slot._next++];
+                for (size_t j = 0; j < slot._vars.size(); ++j) {
+                    const auto* type = _variables[slot._vars[j]]->colorType;
+                    _values[slot._vars[j]] = &(*type)[combination[j]];
                 }
-                for(auto& binding : _bindings){
-                    binding.second =  binding.second->getColorType()->getColor(_var_map[_nextIndex].find(binding.first)->second.front().getLowerIds());
+                if (consistent())
+                    return true;
+            }
+            return false;
+        }
+        const auto var = slot._vars[0];
+        if (slot._forcing != -1) {
+            if (slot._next++ > 0)
+                return false;
+            // solve lhs + l == rhs + r for the unassigned side
+            const auto& con = _constraints[slot._forcing];
+            const bool left = con._lhs._var == (int32_t)var;
+            term_t other = left ? con._rhs : con._lhs;
+            other._offset -= left ? con._lhs._offset : con._rhs._offset;
+            const auto* color = value(other);
+            auto it = std::lower_bound(slot._domain.begin(), slot._domain.end(), color,
+                    [](auto* a, auto* b) { return a->getId() < b->getId(); });
+            if (it == slot._domain.end() || *it != color)
+                return false;
+            _values[var] = color;
+            return consistent();
+        }
+        while (slot._next < slot._domain.size()) {
+            _values[var] = slot._domain[slot._next++];
+            if (consistent())
+                return true;
+        }
+        return false;
+    }
+
+    bool FixpointBindingGenerator::search() {
+        while (true) {
+            if (advance(_slots[_depth])) {
+                if (_depth + 1 == _slots.size()) {
+                    if (eval())
+                        return true;
+                } else {
+                    _slots[++_depth]._next = 0;
                 }
+            } else if (_depth == 0) {
+                return false;
+            } else {
+                --_depth;
             }
-            test = eval();
         }
+    }
 
-        return _bindings;
+    void FixpointBindingGenerator::findBinding() {
+        while (!_prepared || !search()) {
+            _prepared = false;
+            if (++_nextIndex >= _var_map.size()) {
+                _isDone = true;
+                return;
+            }
+            _prepared = prepare(_nextIndex);
+        }
+    }
+
+    bool FixpointBindingGenerator::eval() const{
+        if (_expr == nullptr)
+            return true;
+        return _guard.evaluate_guard(_values);
+    }
+
+    void FixpointBindingGenerator::step() {
+        if (_variables.empty())
+            _isDone = true;
+        else
+            findBinding();
+    }
+
+    const Colored::BindingMap& FixpointBindingGenerator::nextBinding() {
+        step();
+        return currentBinding();
     }
 
     void FixpointBindingGenerator::generateCombinations(
@@ -309,6 +514,9 @@ namespace PetriEngine {
     }
 
     const Colored::BindingMap& FixpointBindingGenerator::currentBinding() const {
+        _bindings.clear();
+        for (size_t i = 0; i < _variables.size(); ++i)
+            _bindings[_variables[i]] = _values[i];
         return _bindings;
     }
 
@@ -0,0 +1,497 @@
+#include "PetriEngine/Colored/ColoredExplorer.h"
+#include "PetriEngine/Colored/ColoredPetriNetBuilder.h"
+#include "PetriEngine/Colored/VariableVisitor.h"
+#include "PetriEngine/PQL/Expressions.h"
+#include "utils/output.h"
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <limits>
+#include <set>
+
+namespace PetriEngine {
+    namespace Colored {
+
+        // ptrie keys are limited to 16 bit lengths
+        static constexpr size_t MaxEncodedSize = std::numeric_limits<uint16_t>::max();
+
+        ColoredExplorer::ColoredExplorer(const ColoredPetriNetBuilder& builder)
+        : _builder(builder), _scratch(MaxEncodedSize) {
+            const EquivalenceVec no_partition;
+            _transitions.resize(builder.transitions().size());
+            for (uint32_t tid = 0; tid < builder.transitions().size(); ++tid) {
+                const auto& transition = builder.transitions()[tid];
+                auto& t = _transitions[tid];
+                if (transition.skipped)
+                    continue;
+                std::set<const Variable*> vars;
+                if (transition.guard != nullptr)
+                    VariableVisitor::get_variables(*transition.guard, vars);
+                for (const auto& arc : transition.input_arcs)
+                    VariableVisitor::get_variables(*arc.expr, vars);
+                for (const auto& arc : transition.output_arcs)
+                    VariableVisitor::get_variables(*arc.expr, vars);
+                t._variables.assign(vars.begin(), vars.end());
+                std::sort(t._variables.begin(), t._variables.end(), [](auto* a, auto* b) { return a->name < b->name; });
+
+                if (transition.guard != nullptr) {
+                    t._has_guard = true;
+                    t._guard = CompiledExpression::compile(*transition.guard, t._variables, builder.colors());
+                }
+                for (const auto& arc : transition.input_arcs) {
+                    t._input.push_back(CompiledExpression::compile(*arc.expr, t._variables, builder.colors(), no_partition));
+                    collect_occurrences(*arc.expr, arc.place, t);
+                }
+                for (const auto& arc : transition.output_arcs)
+                    t._output.push_back(CompiledExpression::compile(*arc.expr, t._variables, builder.colors(), no_partition));
+            }
+            for (const auto& inhibitor : builder.inhibitors())
+                _transitions[inhibitor.transition]._inhibitors.emplace_back(inhibitor.place, inhibitor.inhib_weight);
+        }
+
+        void ColoredExplorer::collect_occurrences(const ArcExpression& expr, uint32_t place, transition_t& t) {
+            auto index_of = [&t](const Variable* var) {
+                return (uint32_t)(std::find(t._variables.begin(), t._variables.end(), var) - t._variables.begin());
+            };
+            // only positive occurrences force a token of the variable's color in the place; subtractions and
+            // successor/predecessor expressions do not restrict the binding in an obvious way and are skipped.
+            if (auto* no = dynamic_cast<const NumberOfExpression*>(&expr)) {
+                if (no->number() == 0)
+                    return;
+                for (const auto& color : *no) {
+                    if (auto* var = dynamic_cast<const VariableExpression*>(color.get())) {
+                        t._occurrences.push_back({index_of(var->variable()), place, -1});
+                    } else if (auto* tuple = dynamic_cast<const TupleExpression*>(color.get())) {
+                        int32_t component = 0;
+                        for (const auto& elem : *tuple) {
+                            if (auto* v = dynamic_cast<const VariableExpression*>(elem.get()))
+                                t._occurrences.push_back({index_of(v->variable()), place, component});
+                            ++component;
+                        }
+                    }
+                }
+            } else if (auto* add = dynamic_cast<const AddExpression*>(&expr)) {
+                for (const auto& elem : *add)
+                    collect_occurrences(*elem, place, t);
+            } else if (auto* scalar = dynamic_cast<const ScalarProductExpression*>(&expr)) {
+                if (scalar->scalar() != 0)
+                    collect_occurrences(*scalar->child(), place, t);
+            }
+        }
+
+        const PQL::Condition_ptr* ColoredExplorer::reachability_goal(const PQL::Condition_ptr& query, bool& negate_goal,
+                                                                    bool& negate_result) const {
+            if (auto* n = dynamic_cast<PQL::NotCondition*>(query.get())) {
+                auto* goal = reachability_goal(n->getCond(), negate_goal, negate_result);
+                negate_result = !negate_result;
+                return goal;
+            }
+            negate_goal = false;
+            negate_result = false;
+            if (auto* ef = dynamic_cast<PQL::EFCondition*>(query.get()))
+                return &ef->getCond();
+            if (auto* ag = dynamic_cast<PQL::AGCondition*>(query.get())) {
+                negate_goal = negate_result = true;
+                return &ag->getCond();
+            }
+            if (auto* e = dynamic_cast<PQL::ECondition*>(query.get())) {
+                if (auto* f = dynamic_cast<PQL::FCondition*>(e->getCond().get()))
+                    return &f->getCond();
+            }
+            if (auto* a = dynamic_cast<PQL::ACondition*>(query.get())) {
+                if (auto* g = dynamic_cast<PQL::GCondition*>(a->getCond().get())) {
+                    negate_goal = negate_result = true;
+                    return &g->getCond();
+                }
+            }
+            return nullptr;
+        }
+
+        bool ColoredExplorer::supports(const PQL::Condition_ptr& query) {
+            bool negate_goal, negate_result;
+            auto* goal = reachability_goal(query, negate_goal, negate_result);
+            if (goal == nullptr)
+                return false;
+            try {
+                compile(*goal);
+            } catch (const base_error&) {
+                return false;
+            }
+            return true;
+        }
+
+        ColoredExplorer::condition_t ColoredExplorer::compile(const PQL::Condition_ptr& cond) {
+            using namespace PQL;
+            auto* c = cond.get();
+            if (auto* b = dynamic_cast<BooleanCondition*>(c)) {
+                const bool value = b->value;
+                return [value] { return value; };
+            }
+            if (dynamic_cast<DeadlockCondition*>(c))
+                return [this] { return is_deadlock(); };
+            if (auto* n = dynamic_cast<NotCondition*>(c)) {
+                auto sub = compile(n->getCond());
+                return [sub] { return !sub(); };
+            }
+            if (auto* l = dynamic_cast<LogicalCondition*>(c)) {
+                if (dynamic_cast<AndCondition*>(c) == nullptr && dynamic_cast<OrCondition*>(c) == nullptr)
+                    throw base_error("Unsupported logical condition in colored exploration");
+                std::vector<condition_t> subs;
+                for (const auto& op : l->getOperands())
+                    subs.push_back(compile(op));
+                if (dynamic_cast<AndCondition*>(c))
+                    return [subs] { return std::all_of(subs.begin(), subs.end(), [](auto& s) { return s(); }); };
+                return [subs] { return std::any_of(subs.begin(), subs.end(), [](auto& s) { return s(); }); };
+            }
+            if (auto* cmp = dynamic_cast<CompareCondition*>(c)) {
+                auto lhs = compile(cmp->getExpr1());
+                auto rhs = compile(cmp->getExpr2());
+                if (dynamic_cast<EqualCondition*>(c))
+                    return [lhs, rhs] { return lhs() == rhs(); };
+                if (dynamic_cast<NotEqualCondition*>(c))
+                    return [lhs, rhs] { return lhs() != rhs(); };
+                if (dynamic_cast<LessThanCondition*>(c))
+                    return [lhs, rhs] { return lhs() < rhs(); };
+                if (dynamic_cast<LessThanOrEqualCondition*>(c))
+                    return [lhs, rhs] { return lhs() <= rhs(); };
+                throw base_error("Unsupported comparison in colored exploration");
+            }
+            if (auto* f = dynamic_cast<FireableCondition*>(c)) {
+                auto it = _builder.colored_transitionnames().find(f->getName());
+                if (it == _builder.colored_transitionnames().end() || _builder.transitions()[it->second].skipped)
+                    throw base_error("Unknown colored transition ", *f->getName(), " in colored exploration");
+                const uint32_t tid = it->second;
+                return [this, tid] { return is_enabled(tid); };
+            }
+            throw base_error("Unsupported condition in colored exploration");
+        }
+
+        ColoredExplorer::expression_t ColoredExplorer::compile(const PQL::Expr_ptr& expr) {
+            using namespace PQL;
+            auto place_of = [this](const shared_const_string& name) {
+                auto it = _builder.colored_placenames().find(name);
+                if (it == _builder.colored_placenames().end() || _builder.places()[it->second].skipped)
+                    throw base_error("Unknown colored place ", *name, " in colored exploration");
+                return it->second;
+            };
+            auto* e = expr.get();
+            if (auto* lit = dynamic_cast<LiteralExpr*>(e)) {
+                const int64_t value = lit->value();
+                return [value] { return value; };
+            }
+            if (auto* id = dynamic_cast<IdentifierExpr*>(e)) {
+                if (id->compiled())
+                    return compile(id->compiled());
+                const uint32_t place = place_of(id->name());
+                return [this, place] { return (int64_t)tokens(place); };
+            }
+            if (auto* minus = dynamic_cast<MinusExpr*>(e)) {
+                auto sub = compile((*minus)[0]);
+                return [sub] { return -sub(); };
+            }
+            if (auto* sub = dynamic_cast<SubtractExpr*>(e)) {
+                std::vector<expression_t> subs;
+                for (const auto& op : sub->expressions())
+                    subs.push_back(compile(op));
+                return [subs] {
+                    int64_t value = subs[0]();
+                    for (size_t i = 1; i < subs.size(); ++i)
+                        value -= subs[i]();
+                    return value;
+                };
+            }
+            if (auto* com = dynamic_cast<CommutativeExpr*>(e)) {
+                const bool plus = dynamic_cast<PlusExpr*>(e) != nullptr;
+                std::vector<uint32_t> places;
+                for (const auto& [_, name] : com->places())
+                    places.push_back(place_of(name));
+                std::vector<expression_t> subs;
+                for (const auto& op : com->expressions())
+                    subs.push_back(compile(op));
+                const int64_t constant = com->constant();
+                return [this, plus, places, subs, constant] {
+                    int64_t value = constant;
+                    for (auto p : places)
+                        value = plus ? value + (int64_t)tokens(p) : value * (int64_t)tokens(p);
+                    for (const auto& s : subs)
+                        value = plus ? value + s() : value * s();
+                    return value;
+                };
+            }
+            throw base_error("Unsupported expression in colored exploration");
+        }
+
+        uint64_t ColoredExplorer::tokens(uint32_t place) const {
+            uint64_t sum = 0;
+            for (const auto& [_, count] : _current[place])
+                sum += count;
+            return sum;
+        }
+
+        bool ColoredExplorer::fire(uint32_t tid, const std::vector<const Color*>& values, marking_t& result) const {
+            const auto& transition = _builder.transitions()[tid];
+            const auto& t = _transitions[tid];
+            result = _current;
+            for (size_t i = 0; i < transition.input_arcs.size(); ++i) {
+                auto& place = result[transition.input_arcs[i].place];
+                for (const auto& [color, count] : t._input[i].evaluate_arc(values)) {
+                    auto it = std::lower_bound(place.begin(), place.end(), token_t{color->getId(), 0});
+                    if (it == place.end() || it->first != color->getId() || it->second < count)
+                        return false;
+                    it->second -= count;
+                    if (it->second == 0)
+                        place.erase(it);
+                }
+            }
+            for (size_t i = 0; i < transition.output_arcs.size(); ++i) {
+                auto& place = result[transition.output_arcs[i].place];
+                for (const auto& [color, count] : t._output[i].evaluate_arc(values)) {
+                    auto it = std::lower_bound(place.begin(), place.end(), token_t{color->getId(), 0});
+                    if (it != place.end() && it->first == color->getId())
+                        it->second += count;
+                    else
+                        place.emplace(it, color->getId(), count);
+                }
+            }
+            return true;
+        }
+
+        template<typename F>
+        bool ColoredExplorer::for_each_binding(uint32_t tid, F&& callback) {
+            const auto& t = _transitions[tid];
+            for (const auto& [place, weight] : t._inhibitors) {
+                if (tokens(place) >= weight)
+                    return true;
+            }
+            const size_t n = t._variables.size();
+            std::vector<std::vector<uint32_t>> candidates(n);
+            std::vector<bool> restricted(n, false);
+            std::vector<uint32_t> found;
+            for (const auto& o : t._occurrences) {
+                found.clear();
+                const auto* type = _builder.places()[o._place].type;
+                for (const auto& [id, _] : _current[o._place]) {
+                    if (o._component < 0)
+                        found.push_back(id);
+                    else
+                        found.push_back((*type)[id].getTupleColors()[o._component]->getId());
+                }
+                std::sort(found.begin(), found.end());
+                found.erase(std::unique(found.begin(), found.end()), found.end());
+                auto& cand = candidates[o._variable];
+                if (!restricted[o._variable]) {
+                    cand = found;
+                    restricted[o._variable] = true;
+                } else {
+                    auto end = std::set_intersection(cand.begin(), cand.end(), found.begin(), found.end(), cand.begin());
+                    cand.erase(end, cand.end());
+                }
+                if (cand.empty())
+                    return true;
+            }
+            for (size_t i = 0; i < n; ++i) {
+                if (restricted[i])
+                    continue;
+                candidates[i].resize(t._variables[i]->colorType->size());
+                for (uint32_t c = 0; c < candidates[i].size(); ++c)
+                    candidates[i][c] = c;
+            }
+
+            std::vector<size_t> index(n, 0);
+            std::vector<const Color*> values(n);
+            marking_t successor;
+            while (true) {
+                for (size_t i = 0; i < n; ++i)
+                    values[i] = &(*t._variables[i]->colorType)[candidates[i][index[i]]];
+                if ((!t._has_guard || t._guard.evaluate_guard(values)) && fire(tid, values, successor)) {
+                    if (!callback(values, successor))
+                        return false;
+                }
+                size_t i = 0;
+                for (; i < n; ++i) {
+                    if (++index[i] < candidates[i].size())
+                        break;
+                    index[i] = 0;
+                }
+                if (i == n)
+                    return true;
+            }
+        }
+
+        bool ColoredExplorer::is_enabled(uint32_t tid) {
+            return !for_each_binding(tid, [](auto&, auto&) { return false; });
+        }
+
+        bool ColoredExplorer::is_deadlock() {
+            for (uint32_t tid = 0; tid < _transitions.size(); ++tid) {
+                if (!_builder.transitions()[tid].skipped && is_enabled(tid))
+                    return false;
+            }
+            return true;
+        }
+
+        bool ColoredExplorer::encode(const marking_t& marking) {
+            auto put = [this](uint64_t value) {
+                while (value >= 0x80) {
+                    _encoded.push_back((unsigned char)(value | 0x80));
+                    value >>= 7;
+                }
+                _encoded.push_back((unsigned char)value);
+            };
+            // per place the number of distinct colors, followed by the delta-coded color ids and their counts
+            _encoded.clear();
+            for (const auto& place : marking) {
+                put(place.size());
+                uint32_t last = 0;
+                for (const auto& [id, count] : place) {
+                    put(id - last);
+                    put(count);
+                    last = id;
+                }
+            }
+            return _encoded.size() <= MaxEncodedSize;
+        }
+
+        void ColoredExplorer::decode(size_t id, marking_t& marking) {
+            const size_t length = _states->unpack(id, _scratch.data());
+            size_t pos = 0;
+            auto get = [&] {
+                uint64_t value = 0;
+                for (uint32_t shift = 0; ; shift += 7) {
+                    assert(pos < length);
+                    const auto byte = _scratch[pos++];
+                    value |= uint64_t{byte & 0x7Fu} << shift;
+                    if ((byte & 0x80) == 0)
+                        return value;
+                }
+            };
+            marking.resize(_builder.places().size());
+            for (auto& place : marking) {
+                place.resize(get());
+                uint32_t last = 0;
+                for (auto& [id, count] : place) {
+                    id = last + get();
+                    count = get();
+                    last = id;
+                }
+            }
+        }
+
+        ColoredExplorer::Result ColoredExplorer::check(const PQL::Condition_ptr& query, Strategy strategy, bool trace, double timeout) {
+            const auto start = std::chrono::steady_clock::now();
+            bool negate_goal, negate_result;
+            auto* body = reachability_goal(query, negate_goal, negate_result);
+            if (body == nullptr)
+                throw base_error("Colored exploration only supports EF and AG queries");
+            auto goal = compile(*body);
+            auto satisfies = [&] { return goal() != negate_goal; };
+
+            _states = std::make_unique<ptrie::map<unsigned char, history_t>>();
+            _discovered = 0;
+            _explored = 0;
+            _current.assign(_builder.places().size(), {});
+            for (uint32_t p = 0; p < _builder.places().size(); ++p) {
+                for (const auto& [color, count] : _builder.places()[p].marking) {
+                    if (count > 0)
+                        _current[p].emplace_back(color->getId(), count);
+                }
+                std::sort(_current[p].begin(), _current[p].end());
+            }
+            if (!encode(_current))
+                return Result::Unknown;
+            _initial = _states->insert(_encoded.data(), _encoded.size()).second;
+            _states->get_data(_initial) = {_initial, std::numeric_limits<uint32_t>::max()};
+            ++_discovered;
+
+            constexpr auto none = std::numeric_limits<size_t>::max();
+            size_t found = satisfies() ? _initial : none;
+            std::deque<size_t> waiting;
+            if (found == none)
+                waiting.push_back(_initial);
+            std::vector<size_t> fresh;
+            size_t expanded = 0;
+            // a marking too large to be stored leaves the query to the unfolded net
+            bool overflow = false;
+            while (found == none && !waiting.empty()) {
+                // the clock is only read now and then, an expansion is cheap compared to it
+                if ((expanded++ & 1023) == 0 &&
+                    std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() >= timeout)
+                    return Result::Unknown;
+                size_t id;
+                if (strategy == Strategy::BFS) {
+                    id = waiting.front();
+                    waiting.pop_front();
+                } else {
+                    id = waiting.back();
+                    waiting.pop_back();
+                }
+                decode(id, _current);
+                fresh.clear();
+                for (uint32_t tid = 0; tid < _transitions.size(); ++tid) {
+                    if (_builder.transitions()[tid].skipped)
+                        continue;
+                    for_each_binding(tid, [&](auto&, const marking_t& successor) {
+                        ++_explored;
+                        if (!encode(successor)) {
+                            overflow = true;
+                            return false;
+                        }
+                        auto [is_new, sid] = _states->insert(_encoded.data(), _encoded.size());
+                        if (is_new) {
+                            _states->get_data(sid) = {id, tid};
+                            fresh.push_back(sid);
+                        }
+                        return true;
+                    });
+                    if (overflow)
+                        return Result::Unknown;
+                }
+                // the query is evaluated after expanding, as fireability atoms enumerate bindings themselves
+                _discovered += fresh.size();
+                for (auto sid : fresh) {
+                    decode(sid, _current);
+                    if (satisfies()) {
+                        found = sid;
+                        break;
+                    }
+                    waiting.push_back(sid);
+                }
+            }
+
+            if (found != none && trace)
+                print_trace(found);
+            return (found != none) != negate_result ? Result::Satisfied : Result::NotSatisfied;
+        }
+
+        void ColoredExplorer::print_trace(size_t state) {
+            std::vector<size_t> path;
+            for (size_t id = state; id != _initial; id = _states->get_data(id)._parent)
+                path.push_back(id);
+            std::reverse(path.begin(), path.end());
+
+            buffered_output out(std::cerr, 1 << 16);
+            out << "Trace:\n<trace>\n";
+            std::vector<unsigned char> target;
+            for (auto id : path) {
+                const auto history = _states->get_data(id);
+                target.assign(_scratch.begin(), _scratch.begin() + _states->unpack(id, _scratch.data()));
+                decode(history._parent, _current);
+                const auto& t = _transitions[history._transition];
+                // the binding is not stored, so find one leading to the recorded successor
+                for_each_binding(history._transition, [&](const std::vector<const Color*>& values, const marking_t& successor) {
+                    encode(successor);
+                    if (_encoded != target)
+                        return true;
+                    out << "\t<transition id=\"" << *_builder.transitions()[history._transition].name << "\">\n";
+                    for (size_t i = 0; i < values.size(); ++i)
+                        out << "\t\t<binding variable=\"" << t._variables[i]->name << "\" color=\""
+                                  << values[i]->toString() << "\"/>\n";
+                    out << "\t</transition>\n";
+                    return false;
+                });
+            }
+            out << "</trace>\n\n";
+        }
+    }
+}
@@ -0,0 +1,330 @@
+#include "PetriEngine/Colored/CompiledExpression.h"
+#include "PetriEngine/Colored/ColorExpressionVisitor.h"
+
+#include <algorithm>
+
+namespace PetriEngine {
+    namespace Colored {
+
+        class ExpressionCompiler : public ColorExpressionVisitor {
+        private:
+            CompiledExpression& _result;
+            const std::vector<const Variable*>& _slots;
+            const ColorTypeMap& _colorTypes;
+            const EquivalenceVec* _placePartition;
+            // static type of every color on the evaluation stack, needed to resolve tuple types
+            std::vector<const ColorType*> _types;
+
+            void emit(CompiledExpression::op_t op, uint32_t arg = 0, const Color* color = nullptr, const ProductType* type = nullptr) {
+                _result._program.push_back({op, arg, 0, color, type});
+            }
+
+            void push_constant(const Color* color) {
+                emit(CompiledExpression::op_t::Constant, 0, color);
+                _types.push_back(color->getColorType());
+            }
+
+            template<typename T>
+            void compare(const T* e, CompiledExpression::op_t op) {
+                (*e)[0]->visit(*this);
+                (*e)[1]->visit(*this);
+                _types.resize(_types.size() - 2);
+                emit(op);
+            }
+
+        public:
+            ExpressionCompiler(CompiledExpression& result, const std::vector<const Variable*>& slots,
+                               const ColorTypeMap& colorTypes, const EquivalenceVec* placePartition)
+            : _result(result), _slots(slots), _colorTypes(colorTypes), _placePartition(placePartition) {}
+
+            void accept(const DotConstantExpression*) override {
+                push_constant(&(*ColorType::dotInstance()->begin()));
+            }
+
+            void accept(const VariableExpression* e) override {
+                auto it = std::find(_slots.begin(), _slots.end(), e->variable());
+                if (it == _slots.end())
+                    throw base_error("Cannot compile expression, unknown variable ", e->variable()->name);
+                emit(CompiledExpression::op_t::Variable, it - _slots.begin());
+                _types.push_back(e->variable()->colorType);
+            }
+
+            void accept(const UserOperatorExpression* e) override {
+                if (_placePartition == nullptr || _placePartition->getEquivalenceClasses().empty()) {
+                    push_constant(e->user_operator());
+                } else {
+                    std::vector<uint32_t> tupleIds;
+                    e->user_operator()->getTupleId(tupleIds);
+                    _placePartition->applyPartition(tupleIds);
+                    push_constant(e->user_operator()->getColorType()->getColor(tupleIds));
+                }
+            }
+
+            void accept(const SuccessorExpression* e) override {
+                e->child()->visit(*this);
+                emit(CompiledExpression::op_t::Successor);
+            }
+
+            void accept(const PredecessorExpression* e) override {
+                e->child()->visit(*this);
+                emit(CompiledExpression::op_t::Predecessor);
+            }
+
+            void accept(const TupleExpression* tup) override {
+                for (const auto& color : *tup) {
+                    color->visit(*this);
+                }
+                std::vector<const ColorType*> types(_types.end() - tup->size(), _types.end());
+                _types.resize(_types.size() - tup->size());
+                // same lookup as EvaluationVisitor, done once instead of per binding
+                const ProductType* pt = nullptr;
+                for (auto& elem : _colorTypes) {
+                    auto* candidate = dynamic_cast<const ProductType*>(elem.second);
+                    if (candidate && candidate->containsTypes(types)) {
+                        pt = candidate;
+                        break;
+                    }
+                }
+                if (pt == nullptr)
+                    pt = dynamic_cast<const ProductType*>(tup->colorType());
+                if (pt == nullptr)
+                    throw base_error("Cannot compile expression, no product type for tuple");
+                emit(CompiledExpression::op_t::Tuple, tup->size(), nullptr, pt);
+                _types.push_back(pt);
+            }
+
+            void accept(const LessThanExpression* e) override {
+                compare(e, CompiledExpression::op_t::LessThan);
+            }
+
+            void accept(const LessThanEqExpression* e) override {
+                compare(e, CompiledExpression::op_t::LessThanEq);
+            }
+
+            void accept(const EqualityExpression* e) override {
+                compare(e, CompiledExpression::op_t::Equality);
+            }
+
+            void accept(const InequalityExpression* e) override {
+                compare(e, CompiledExpression::op_t::Inequality);
+            }
+
+            void accept(const AndExpression* e) override {
+                (*e)[0]->visit(*this);
+                (*e)[1]->visit(*this);
+                emit(CompiledExpression::op_t::And);
+            }
+
+            void accept(const OrExpression* e) override {
+                (*e)[0]->visit(*this);
+                (*e)[1]->visit(*this);
+                emit(CompiledExpression::op_t::Or);
+            }
+
+            void accept(const AllExpression*) override {
+                throw base_error("AllExpression cannot be compiled");
+            }
+
+            void accept(const NumberOfExpression* no) override {
+                for (const auto& elem : *no) {
+                    elem->visit(*this);
+                }
+                _types.resize(_types.size() - no->size());
+                emit(CompiledExpression::op_t::NumberOf, no->size());
+                _result._program.back()._number = no->number();
+            }
+
+            void accept(const AddExpression* add) override {
+                for (const auto& expr : *add) {
+                    expr->visit(*this);
+                }
+                emit(CompiledExpression::op_t::Add, add->size());
+            }
+
+            void accept(const SubtractExpression* sub) override {
+                (*sub)[0]->visit(*this);
+                (*sub)[1]->visit(*this);
+                emit(CompiledExpression::op_t::Subtract);
+            }
+
+            void accept(const ScalarProductExpression* scalar) override {
+                scalar->child()->visit(*this);
+                emit(CompiledExpression::op_t::Scalar, scalar->scalar());
+            }
+        };
+
+        CompiledExpression CompiledExpression::compile(const GuardExpression& expr, const std::vector<const Variable*>& slots,
+                                                       const ColorTypeMap& colorTypes) {
+            CompiledExpression result;
+            ExpressionCompiler compiler(result, slots, colorTypes, nullptr);
+            expr.visit(compiler);
+            return result;
+        }
+
+        CompiledExpression CompiledExpression::compile(const ArcExpression& expr, const std::vector<const Variable*>& slots,
+                                                       const ColorTypeMap& colorTypes, const EquivalenceVec& placePartition) {
+            CompiledExpression result;
+            ExpressionCompiler compiler(result, slots, colorTypes, &placePartition);
+            expr.visit(compiler);
+            return result;
+        }
+
+        bool CompiledExpression::evaluate_guard(const std::vector<const Color*>& values) const {
+            run(values);
+            assert(_bools.size() == 1);
+            return _bools.back();
+        }
+
+        const std::vector<CompiledExpression::token_t>& CompiledExpression::evaluate_arc(const std::vector<const Color*>& values) const {
+            run(values);
+            compact(0);
+            return _tokens;
+        }
+
+        void CompiledExpression::run(const std::vector<const Color*>& values) const {
+            _colors.clear();
+            _bools.clear();
+            _marks.clear();
+            _tokens.clear();
+            auto pop_color = [this] {
+                auto* c = _colors.back();
+                _colors.pop_back();
+                return c;
+            };
+            auto pop_bool = [this] {
+                bool b = _bools.back();
+                _bools.pop_back();
+                return b;
+            };
+            for (const auto& ins : _program) {
+                switch (ins._op) {
+                    case op_t::Constant:
+                        _colors.push_back(ins._color);
+                        break;
+                    case op_t::Variable:
+                        assert(ins._arg < values.size());
+                        _colors.push_back(values[ins._arg]);
+                        break;
+                    case op_t::Successor:
+                        _colors.back() = &++(*_colors.back());
+                        break;
+                    case op_t::Predecessor:
+                        _colors.back() = &--(*_colors.back());
+                        break;
+                    case op_t::Tuple: {
+                        // mirrors ProductType::getColor, the constituent types are checked at compile time
+                        size_t product = 1;
+                        size_t sum = 0;
+                        const auto first = _colors.size() - ins._arg;
+                        for (size_t i = first; i < _colors.size(); ++i) {
+                            sum += product * _colors[i]->getId();
+                            product *= _colors[i]->getColorType()->size();
+                        }
+                        _colors.resize(first);
+                        _colors.push_back(&(*ins._type)[sum]);
+                        break;
+                    }
+                    // these comparisons work because we know the colors are allocated
+                    // consequtively in memory in correct order.
+                    case op_t::LessThan:
+                    case op_t::LessThanEq: {
+                        auto* rhs = pop_color();
+                        auto* lhs = pop_color();
+                        if (lhs->isTuple() || rhs->isTuple()) throw base_error("Tuple-tuple comparison are not allowed: Unknown semantics");
+                        _bools.push_back(ins._op == op_t::LessThan ? lhs < rhs : lhs <= rhs);
+                        break;
+                    }
+                    case op_t::Equality:
+                    case op_t::Inequality: {
+                        auto* rhs = pop_color();
+                        auto* lhs = pop_color();
+                        _bools.push_back((lhs == rhs) == (ins._op == op_t::Equality));
+                        break;
+                    }
+                    case op_t::And: {
+                        auto rhs = pop_bool();
+                        _bools.back() = _bools.back() && rhs;
+                        break;
+                    }
+                    case op_t::Or: {
+                        auto rhs = pop_bool();
+                        _bools.back() = _bools.back() || rhs;
+                        break;
+                    }
+                    case op_t::NumberOf: {
+                        const auto first = _colors.size() - ins._arg;
+                        _marks.push_back(_tokens.size());
+                        for (size_t i = first; i < _colors.size(); ++i)
+                            _tokens.emplace_back(_colors[i], ins._number);
+                        _colors.resize(first);
+                        break;
+                    }
+                    case op_t::Add:
+                        // the operands are adjacent ranges of tokens, so adding them is just joining the ranges
+                        if (ins._arg == 0) {
+                            _marks.push_back(_tokens.size());
+                        } else {
+                            const auto begin = _marks[_marks.size() - ins._arg];
+                            _marks.resize(_marks.size() - ins._arg);
+                            _marks.push_back(begin);
+                        }
+                        break;
+                    case op_t::Subtract:
+                        subtract();
+                        break;
+                    case op_t::Scalar:
+                        for (size_t i = _marks.back(); i < _tokens.size(); ++i)
+                            _tokens[i].second *= ins._arg;
+                        break;
+                }
+            }
+        }
+
+        void CompiledExpression::subtract() const {
+            const size_t rhs = _marks.back();
+            _marks.pop_back();
+            const size_t lhs = _marks.back();
+            // merge duplicates of the left operand into their first occurrence, marking the rest as dead
+            for (size_t i = lhs; i < rhs; ++i) {
+                for (size_t j = lhs; j < i; ++j) {
+                    if (_tokens[j].first == _tokens[i].first) {
+                        _tokens[j].second += _tokens[i].second;
+                        _tokens[i].first = nullptr;
+                        break;
+                    }
+                }
+            }
+            for (size_t i = lhs; i < rhs; ++i) {
+                if (_tokens[i].first == nullptr)
+                    continue;
+                uint32_t removed = 0;
+                for (size_t k = rhs; k < _tokens.size(); ++k) {
+                    if (_tokens[k].first == _tokens[i].first)
+                        removed += _tokens[k].second;
+                }
+                _tokens[i].second = _tokens[i].second < removed ? 0 : _tokens[i].second - removed;
+            }
+            _tokens.resize(rhs);
+            _tokens.erase(std::remove_if(_tokens.begin() + lhs, _tokens.end(),
+                                         [](const token_t& t) { return t.first == nullptr; }), _tokens.end());
+        }
+
+        void CompiledExpression::compact(size_t begin) const {
+            size_t out = begin;
+            for (size_t i = begin; i < _tokens.size(); ++i) {
+                size_t j = begin;
+                for (; j < out; ++j) {
+                    if (_tokens[j].first == _tokens[i].first) {
+                        _tokens[j].second += _tokens[i].second;
+                        break;
+                    }
+                }
+                if (j == out)
+                    _tokens[out++] = _tokens[i];
+            }
+            _tokens.resize(out);
+            _tokens.erase(std::remove_if(_tokens.begin() + begin, _tokens.end(),
+                                         [](const token_t& t) { return t.second == 0; }), _tokens.end());
+        }
+    }
+}
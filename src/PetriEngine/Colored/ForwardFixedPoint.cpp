@@ -7,7 +7,9 @@
 #include "PetriEngine/Colored/ArcIntervalVisitor.h"
 #include "PetriEngine/Colored/RestrictVisitor.h"
 #include "PetriEngine/Colored/OutputIntervalVisitor.h"
+#include "utils/parallel_for.h"
 
+#include <algorithm>
 #include <chrono>
 
 namespace PetriEngine {
@@ -89,6 +91,32 @@ namespace PetriEngine {
             _arcIntervals.resize(transitions.size());
             for (size_t t = 0; t < transitions.size(); ++t)
                 _arcIntervals[t] = setupTransitionVars(t);
+            _placeUpdates.assign(places.size(), 0);
+        }
+
+        void ForwardFixedPoint::computeRanks() {
+            auto& places = _builder.places();
+            auto& transitions = _builder.transitions();
+            _placeRank.assign(places.size(), std::numeric_limits<uint32_t>::max());
+            std::vector<uint32_t> waiting;
+            for (uint32_t p = 0; p < places.size(); ++p) {
+                if (places[p].skipped || places[p].marking.empty()) continue;
+                _placeRank[p] = 0;
+                waiting.push_back(p);
+            }
+            std::vector<bool> seen(transitions.size(), false);
+            for (size_t i = 0; i < waiting.size(); ++i) {
+                const uint32_t p = waiting[i];
+                for (auto t : places[p]._post) {
+                    if (seen[t]) continue;
+                    seen[t] = true;
+                    for (const auto& arc : transitions[t].output_arcs) {
+                        if (_placeRank[arc.place] != std::numeric_limits<uint32_t>::max()) continue;
+                        _placeRank[arc.place] = _placeRank[p] + 1;
+                        waiting.push_back(arc.place);
+                    }
+                }
+            }
         }
 
         void ForwardFixedPoint::set_default() {
@@ -131,14 +159,15 @@ namespace PetriEngine {
             }
         }
 
-        void ForwardFixedPoint::compute(uint32_t maxIntervals, uint32_t maxIntervalsReduced, int32_t timeout) {
+        void ForwardFixedPoint::compute(uint32_t maxIntervals, uint32_t maxIntervalsReduced, int32_t timeout, uint32_t threads) {
             if (_builder.isColored()) {
                 init();
+                computeRanks();
                 auto& places = _builder.places();
                 auto& transitions = _builder.transitions();
                 for (size_t i = 0; i < places.size(); ++i) {
                     if (places[i].skipped) continue;
-                    _placeFixpointQueue.emplace_back(i);
+                    _placeFixpointQueue.emplace(_placeRank[i], i);
                 }
                 _considered.resize(transitions.size());
                 std::fill(_considered.begin(), _considered.end(), false);
@@ -147,35 +176,53 @@ namespace PetriEngine {
                 auto start = std::chrono::high_resolution_clock::now();
                 auto end = std::chrono::high_resolution_clock::now();
                 auto reduceTimer = std::chrono::high_resolution_clock::now();
+                std::vector<uint32_t> batch;
+                std::vector<uint8_t> activated;
                 while (!_placeFixpointQueue.empty()) {
                     //Reduce max interval once timeout passes
                     if (maxIntervals > maxIntervalsReduced && timeout > 0 && std::chrono::duration_cast<std::chrono::seconds>(end - reduceTimer).count() >= timeout) {
                         maxIntervals = maxIntervalsReduced;
                     }
 
-                    uint32_t currentPlaceId = _placeFixpointQueue.back();
-                    _placeFixpointQueue.pop_back();
-                    _placeColorFixpoints[currentPlaceId].inQueue = false;
-
-                    for (auto transitionId : places[currentPlaceId]._post) {
-                        const Colored::Transition& transition = _builder.transitions()[transitionId];
-                        // Skip transitions that cannot add anything new,
-                        // such as transitions with only constants on their arcs that have been processed once
-                        assert(transitionId < _builder.transitions().size());
-                        assert(transitionId < _considered.size());
-                        if (_considered[transitionId]) continue;
-                        bool transitionActivated = true;
-                        _transition_variable_maps[transitionId].clear();
+                    // Collect the post sets of all queued places of the lowest rank
+                    const uint32_t rank = _placeFixpointQueue.top().first;
+                    batch.clear();
+                    while (!_placeFixpointQueue.empty() && _placeFixpointQueue.top().first == rank) {
+                        uint32_t currentPlaceId = _placeFixpointQueue.top().second;
+                        _placeFixpointQueue.pop();
+                        _placeColorFixpoints[currentPlaceId].inQueue = false;
+                        for (auto transitionId : places[currentPlaceId]._post) {
+                            // Skip transitions that cannot add anything new,
+                            // such as transitions with only constants on their arcs that have been processed once
+                            assert(transitionId < _builder.transitions().size());
+                            assert(transitionId < _considered.size());
+                            if (_considered[transitionId]) continue;
+                            batch.push_back(transitionId);
+                        }
+                    }
+                    std::sort(batch.begin(), batch.end());
+                    batch.erase(std::unique(batch.begin(), batch.end()), batch.end());
 
-                        processInputArcs(transition, currentPlaceId, transitionId, transitionActivated, maxIntervals);
+                    for (auto transitionId : batch) {
+                        restrictInputPlaces(transitions[transitionId], maxIntervals);
+                    }
 
-                        //If there were colors which activated the transitions, compute the intervals produced
-                        if (transitionActivated)
-                        {
-                            processOutputArcs(transition, transitionId);
-                        }
+                    activated.assign(batch.size(), 0);
+                    auto processInput = [&](size_t i) {
+                        const uint32_t transitionId = batch[i];
+                        bool transitionActivated = true;
+                        _transition_variable_maps[transitionId].clear();
+                        processInputArcs(transitions[transitionId], transitionId, transitionActivated);
+                        activated[i] = transitionActivated;
+                    };
+                    parallel_for(batch.size(), threads, processInput);
+
+                    //If there were colors which activated the transitions, compute the intervals produced
+                    for (size_t i = 0; i < batch.size(); ++i) {
+                        if (activated[i])
+                            processOutputArcs(transitions[batch[i]], batch[i]);
                         else
-                            _transition_variable_maps[transitionId].clear();
+                            _transition_variable_maps[batch[i]].clear();
                     }
                     end = std::chrono::high_resolution_clock::now();
                 }
@@ -187,8 +234,8 @@ namespace PetriEngine {
 
         //Retreive interval colors from the input arcs restricted by the transition guard
 
-        void ForwardFixedPoint::processInputArcs(const Colored::Transition& transition, uint32_t currentPlaceId, uint32_t transitionId, bool &transitionActivated, uint32_t max_intervals) {
-            getArcIntervals(transition, transitionActivated, max_intervals, transitionId);
+        void ForwardFixedPoint::processInputArcs(const Colored::Transition& transition, uint32_t transitionId, bool &transitionActivated) {
+            getArcIntervals(transition, transitionActivated, transitionId);
 
             if (!transitionActivated) {
                 return;
@@ -211,11 +258,17 @@ namespace PetriEngine {
             }
         }
 
-        void ForwardFixedPoint::getArcIntervals(const Colored::Transition& transition, bool &transitionActivated, uint32_t max_intervals, uint32_t transitionId) {
+        void ForwardFixedPoint::restrictInputPlaces(const Colored::Transition& transition, uint32_t max_intervals) {
             for (auto& arc : transition.input_arcs) {
                 PetriEngine::Colored::ColorFixpoint& curCFP = _placeColorFixpoints[arc.place];
                 curCFP.constraints.restrict(max_intervals);
                 _max_intervals = std::max(_max_intervals, curCFP.constraints.size());
+            }
+        }
+
+        void ForwardFixedPoint::getArcIntervals(const Colored::Transition& transition, bool &transitionActivated, uint32_t transitionId) {
+            for (auto& arc : transition.input_arcs) {
+                const PetriEngine::Colored::ColorFixpoint& curCFP = _placeColorFixpoints[arc.place];
                 assert(_arcIntervals.size() >= transitionId);
                 Colored::ArcIntervals& arcInterval = _arcIntervals[transitionId][arc.place];
                 arcInterval._intervalTupleVec.clear();
@@ -273,6 +326,11 @@ namespace PetriEngine {
                 //lower bounds should grow when more colors are added and as we cannot remove colors this
                 //can be checked by summing the differences
                 uint32_t colorsBefore = placeFixpoint.constraints.getContainedColors();
+                const bool widen = _placeUpdates[arc.place] >= _wideningDelay;
+                Colored::interval_vector_t constraintsBefore;
+                if (widen) {
+                    constraintsBefore = placeFixpoint.constraints;
+                }
 
                 std::set<const Colored::Variable *> variables;
                 Colored::VariableVisitor::get_variables(*arc.expr, variables);
@@ -334,11 +392,18 @@ namespace PetriEngine {
                 }
                 placeFixpoint.constraints.simplify();
 
-                //Check if the place should be added to the queue
-                if (!placeFixpoint.inQueue) {
-                    uint32_t colorsAfter = placeFixpoint.constraints.getContainedColors();
-                    if (colorsAfter > colorsBefore) {
-                        _placeFixpointQueue.push_back(arc.place);
+                uint32_t colorsAfter = placeFixpoint.constraints.getContainedColors();
+                if (colorsAfter > colorsBefore) {
+                    // a place that keeps growing jumps to the bounds of its color type, such that chains of
+                    // successors converge at once instead of one color per iteration
+                    if (widen) {
+                        placeFixpoint.constraints.widen(constraintsBefore, _builder.places()[arc.place].type->getFullInterval());
+                    }
+                    ++_placeUpdates[arc.place];
+
+                    //Check if the place should be added to the queue
+                    if (!placeFixpoint.inQueue) {
+                        _placeFixpointQueue.emplace(_placeRank[arc.place], arc.place);
                         placeFixpoint.inQueue = true;
                     }
                 }
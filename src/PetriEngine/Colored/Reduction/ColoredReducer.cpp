@@ -13,11 +13,13 @@
 
 namespace PetriEngine::Colored::Reduction {
 
-    ColoredReducer::ColoredReducer(PetriEngine::ColoredPetriNetBuilder &b) : _builder(b),
+    ColoredReducer::ColoredReducer(PetriEngine::ColoredPetriNetBuilder &b, uint32_t threads) : _builder(b),
                                                                              _origPlaceCount(b.getPlaceCount()),
                                                                              _origTransitionCount(
-                                                                                     b.getTransitionCount()) {
+                                                                                     b.getTransitionCount()),
+                                                                             _threads(threads) {
         b.sort();
+        _placeVersion.resize(b.getPlaceCount(), _version);
 
 #ifndef NDEBUG
         // All rule names must be unique
@@ -61,7 +63,11 @@ namespace PetriEngine::Colored::Reduction {
         do {
             changed = false;
             for (auto &rule: reductionsToUse) {
+                // the rule has already been applied to the net as it is now
+                if (rule->lastVersion() == _version) continue;
+                const auto version = _version;
                 changed |= rule->apply(*this, inQuery, queryType, preserveLoops, preserveStutter);
+                rule->setLastVersion(version);
             }
             any |= changed;
         } while (changed && !hasTimedOut());
@@ -73,6 +79,22 @@ namespace PetriEngine::Colored::Reduction {
         return any;
     }
 
+    bool ColoredReducer::reduceToQueryCone(uint32_t timeout, const PetriEngine::PQL::ColoredUseVisitor &inQuery,
+                                           QueryType queryType, bool preserveLoops, bool preserveStutter) {
+        _startTime = std::chrono::high_resolution_clock::now();
+        if (timeout <= 0 || !_redRuleRelevance.isApplicable(queryType, preserveLoops, preserveStutter))
+            return false;
+        _timeout = timeout;
+
+        // the rule computes the whole cone in one application
+        bool changed = _redRuleRelevance.apply(*this, inQuery, queryType, preserveLoops, preserveStutter);
+        consistent();
+
+        auto now = std::chrono::high_resolution_clock::now();
+        _timeSpent = (std::chrono::duration_cast<std::chrono::microseconds>(now - _startTime).count()) * 0.000001;
+        return changed;
+    }
+
     CArcIter ColoredReducer::getInArc(uint32_t pid, const Colored::Transition &tran) const {
         auto in = tran.input_arcs.begin();
         for (; in != tran.input_arcs.end(); ++in)
@@ -97,9 +119,35 @@ namespace PetriEngine::Colored::Reduction {
         }
     }
 
+    void ColoredReducer::markPlaceChanged(uint32_t pid) {
+        ++_version;
+        if (pid >= _placeVersion.size()) _placeVersion.resize(_builder.getPlaceCount(), _version);
+        _placeVersion[pid] = _version;
+    }
+
+    void ColoredReducer::markTransitionChanged(uint32_t tid) {
+        ++_version;
+        if (_placeVersion.size() < _builder.getPlaceCount()) _placeVersion.resize(_builder.getPlaceCount(), _version);
+        const Transition &tran = _builder._transitions[tid];
+        for (const auto &arc: tran.input_arcs) _placeVersion[arc.place] = _version;
+        for (const auto &arc: tran.output_arcs) _placeVersion[arc.place] = _version;
+        if (tran.inhibited) {
+            for (const auto &arc: _builder._inhibitorArcs)
+                if (arc.transition == tid) _placeVersion[arc.place] = _version;
+        }
+    }
+
     void ColoredReducer::skipPlace(uint32_t pid) {
         Place &place = _builder._places[pid];
         assert(!place.skipped);
+        // the remaining places of the surrounding transitions lose an arc
+        for (auto tid: place._pre) markTransitionChanged(tid);
+        for (auto tid: place._post) markTransitionChanged(tid);
+        if (place.inhibitor) {
+            for (const auto &arc: _builder._inhibitorArcs)
+                if (arc.place == pid) markTransitionChanged(arc.transition);
+        }
+        markPlaceChanged(pid);
         place.skipped = true;
         _skippedPlaces.push_back(pid);
         for (auto &tid: place._pre) {
@@ -135,6 +183,7 @@ namespace PetriEngine::Colored::Reduction {
     void ColoredReducer::skipTransition(uint32_t tid) {
         Transition &tran = _builder._transitions[tid];
         assert(!tran.skipped);
+        markTransitionChanged(tid);
         tran.skipped = true;
         _skippedTransitions.push_back(tid);
         for (auto &pid: tran.input_arcs) {
@@ -292,11 +341,13 @@ namespace PetriEngine::Colored::Reduction {
         {
             _builder.addTransition(newTransitionName(), guard, 0,0,0);
         }
+        ++_version;
         return id;
     }
 
     void ColoredReducer::addDummyPlace(){
         _builder.addPlace("Dummy", ColorType::dotInstance(), Multiset(), 0, 0);
+        ++_version;
     }
 
     void ColoredReducer::renameVariables(uint32_t transId){
@@ -330,18 +381,21 @@ namespace PetriEngine::Colored::Reduction {
         for (auto& arc : transition.output_arcs) {
             arc.expr = varvis.makeReplacementArcExpr(arc.expr);
         }
+        markTransitionChanged(transId);
     }
 
     void ColoredReducer::addInputArc(uint32_t pid, uint32_t tid, ArcExpression_ptr& expr, uint32_t inhib_weight){
         _builder.addInputArc(*_builder._places[pid].name, *_builder._transitions[tid].name, expr, inhib_weight);
         std::sort(_builder._places[pid]._post.begin(), _builder._places[pid]._post.end());
         std::sort(_builder._transitions[tid].input_arcs.begin(), _builder._transitions[tid].input_arcs.end(), ArcLessThanByPlace);
+        markTransitionChanged(tid);
     }
 
     void ColoredReducer::addOutputArc(uint32_t tid, uint32_t pid, ArcExpression_ptr expr){
         _builder.addOutputArc(*_builder._transitions[tid].name.get(), *_builder._places[pid].name, expr);
         std::sort(_builder._places[pid]._pre.begin(), _builder._places[pid]._pre.end());
         std::sort(_builder._transitions[tid].output_arcs.begin(), _builder._transitions[tid].output_arcs.end(), ArcLessThanByPlace);
+        markTransitionChanged(tid);
     }
 
     uint32_t ColoredReducer::getBindingCount(const Transition &transition) {
@@ -20,172 +20,182 @@ namespace PetriEngine::Colored::Reduction {
         red._pflags.resize(red.placeCount(), 0);
         std::fill(red._pflags.begin(), red._pflags.end(), 0);
 
+        // Pairs of places sharing a producer, where at least one of them changed since the last application
+        std::vector<std::pair<uint32_t, uint32_t>> pairs;
         for (uint32_t tid_outer = 0; tid_outer < red.transitionCount(); ++tid_outer) {
-            for (size_t aid_outer = 0; aid_outer < red.transitions()[tid_outer].output_arcs.size(); ++aid_outer) {
+            const auto &arcs = red.transitions()[tid_outer].output_arcs;
+            for (size_t aid_outer = 0; aid_outer < arcs.size(); ++aid_outer) {
 
-                auto pid_outer = red.transitions()[tid_outer].output_arcs[aid_outer].place;
+                auto pid_outer = arcs[aid_outer].place;
                 if (red._pflags[pid_outer] > 0) continue;
                 red._pflags[pid_outer] = 1;
 
-                if (red.hasTimedOut()) return false;
-
                 const Place &pout = red.places()[pid_outer];
                 if (pout.skipped) continue;
 
-                for (size_t aid_inner = aid_outer + 1; aid_inner < red.transitions()[tid_outer].output_arcs.size(); ++aid_inner) {
-                    if (pout.skipped) break;
-                    auto pid_inner = red.transitions()[tid_outer].output_arcs[aid_inner].place;
+                for (size_t aid_inner = aid_outer + 1; aid_inner < arcs.size(); ++aid_inner) {
+                    auto pid_inner = arcs[aid_inner].place;
                     if (red.places()[pid_inner].skipped) continue;
 
                     if (red.places()[pid_inner].type != red.places()[pid_outer].type) continue;
 
-                    for (size_t swp = 0; swp < 2; ++swp) {
-                        if (red.hasTimedOut()) return false;
-                        if (red.places()[pid_inner].skipped ||
-                            red.places()[pid_outer].skipped)
-                            break;
+                    if (!red.placeChangedSince(pid_outer, lastVersion()) && !red.placeChangedSince(pid_inner, lastVersion()))
+                        continue;
+
+                    pairs.emplace_back(pid_outer, pid_inner);
+                }
+            }
+        }
+
+        std::vector<int64_t> removable(pairs.size(), -1);
+        red.parallelFor(pairs.size(), [&](size_t i) {
+            if (!red.hasTimedOut())
+                removable[i] = removablePlace(red, inQuery, pairs[i].first, pairs[i].second);
+        });
+
+        // Apply in order, checking again the pairs surrounded by an earlier removal
+        const auto version = red.version();
+        for (size_t i = 0; i < pairs.size(); ++i) {
+            if (red.hasTimedOut()) return false;
+            const auto [pid_outer, pid_inner] = pairs[i];
+            if (red.places()[pid_outer].skipped || red.places()[pid_inner].skipped) continue;
+
+            auto p2 = removable[i];
+            if (red.placeChangedSince(pid_outer, version) || red.placeChangedSince(pid_inner, version))
+                p2 = removablePlace(red, inQuery, pid_outer, pid_inner);
+            if (p2 < 0) continue;
+
+            continueReductions = true;
+            _applications++;
+            red.skipPlace(p2);
+        }
+        red.consistent();
+        return continueReductions;
+    }
+
+    int64_t RedRuleParallelPlaces::removablePlace(const ColoredReducer &red, const PetriEngine::PQL::ColoredUseVisitor &inQuery,
+                                                  uint32_t pid_outer, uint32_t pid_inner) const {
+        bool trySwap = true;
+        if (canRemove(red, inQuery, pid_outer, pid_inner, trySwap)) return pid_inner;
+        if (trySwap && canRemove(red, inQuery, pid_inner, pid_outer, trySwap)) return pid_outer;
+        return -1;
+    }
+
+    bool RedRuleParallelPlaces::canRemove(const ColoredReducer &red, const PetriEngine::PQL::ColoredUseVisitor &inQuery,
+                                          uint32_t p1, uint32_t p2, bool &trySwap) const {
+        assert(p1 != p2);
+
+        if (inQuery.isPlaceUsed(p2)) return false;
+
+        const Place &place1 = red.places()[p1];
+        const Place &place2 = red.places()[p2];
+
+        if (place2.inhibitor) return false;
+        if (place2._pre.empty() || place1._post.empty()) return false;
+
+        if (place1._post.size() < place2._post.size() ||
+            place1._pre.size() > place2._pre.size())
+            return false;
+
+        // Initial marking must share support
+        if (place1.marking.distinctSize() != place2.marking.distinctSize()
+                || (place1.marking + place2.marking).distinctSize() != place1.marking.distinctSize()) {
+            trySwap = false;
+            return false;
+        }
+
+        double maxDrainRatio = 0;
+
+        uint32_t i = 0, j = 0;
+        while (i < place1._post.size() && j < place2._post.size()) {
 
-                        uint p1 = pid_outer;
-                        uint p2 = pid_inner;
+            uint32_t p1t = place1._post[i];
+            uint32_t p2t = place2._post[j];
 
-                        assert(p1 != p2);
-                        if (swp == 1) std::swap(p1, p2);
+            if (p2t < p1t) {
+                // place2._post is not a subset of place1._post
+                return false;
+            }
 
-                        if (inQuery.isPlaceUsed(p2)) continue;
+            i++;
+            if (p2t > p1t) {
+                trySwap = false; // We can't remove p1, so don't try swap
+                continue;
+            }
+            j++;
 
-                        const Place &place1 = red.places()[p1];
-                        const Place &place2 = red.places()[p2];
+            const Transition &tran = red.transitions()[p1t];
+            const auto &p1Arc = red.getInArc(p1, tran);
+            const auto &p2Arc = red.getInArc(p2, tran);
 
-                        if (place2.inhibitor) continue;
-                        if (place2._pre.empty() || place1._post.empty()) continue;
+            if (to_string(*p1Arc->expr) == to_string(*p2Arc->expr)) {
+                maxDrainRatio = std::max(maxDrainRatio, 1.0);
+                continue;
+            }
 
-                        if (place1._post.size() < place2._post.size() ||
-                            place1._pre.size() > place2._pre.size())
-                            continue;
+            const auto ms1 = PetriEngine::Colored::extractVarMultiset(*p1Arc->expr);
+            const auto ms2 = PetriEngine::Colored::extractVarMultiset(*p2Arc->expr);
 
-                        // Initial marking must share support
-                        if (place1.marking.distinctSize() != place2.marking.distinctSize()
-                                || (place1.marking + place2.marking).distinctSize() != place1.marking.distinctSize())
-                            break;
+            // ms1 and ms2 must share support
 
-                        bool ok = true;
+            if (!ms1 || !ms2 || ms1->distinctSize() != ms2->distinctSize() || ((*ms1) + (*ms2)).distinctSize() != ms1->distinctSize()) {
+                trySwap = false;
+                return false;
+            }
 
-                        double maxDrainRatio = 0;
+            for (const auto& [varvec, multiplicity] : *ms1) {
+                maxDrainRatio = std::max(maxDrainRatio, (double)(*ms2)[varvec] / (double)multiplicity);
+            }
+        }
 
-                        uint32_t i = 0, j = 0;
-                        while (i < place1._post.size() && j < place2._post.size()) {
+        if (j != place2._post.size()) return false;
 
-                            uint32_t p1t = place1._post[i];
-                            uint32_t p2t = place2._post[j];
+        if (!(place1.marking * maxDrainRatio).isSubsetOrEqTo(place2.marking)) return false;
 
-                            if (p2t < p1t) {
-                                // place2._post is not a subset of place1._post
-                                ok = false;
-                                break;
-                            }
-
-                            i++;
-                            if (p2t > p1t) {
-                                swp = 2; // We can't remove p1, so don't try swap
-                                continue;
-                            }
-                            j++;
-
-                            const Transition &tran = red.transitions()[p1t];
-                            const auto &p1Arc = red.getInArc(p1, tran);
-                            const auto &p2Arc = red.getInArc(p2, tran);
-
-                            if (to_string(*p1Arc->expr) == to_string(*p2Arc->expr)) {
-                                maxDrainRatio = std::max(maxDrainRatio, 1.0);
-                                continue;
-                            }
-
-                            const auto ms1 = PetriEngine::Colored::extractVarMultiset(*p1Arc->expr);
-                            const auto ms2 = PetriEngine::Colored::extractVarMultiset(*p2Arc->expr);
-
-                            // ms1 and ms2 must share support
-
-                            if (!ms1 || !ms2 || ms1->distinctSize() != ms2->distinctSize() || ((*ms1) + (*ms2)).distinctSize() != ms1->distinctSize()) {
-                                ok = false;
-                                swp = 2;
-                                break;
-                            }
-
-                            for (const auto& [varvec, multiplicity] : *ms1) {
-                                maxDrainRatio = std::max(maxDrainRatio, (double)(*ms2)[varvec] / (double)multiplicity);
-                            }
-                        }
-
-                        if (!ok || j != place2._post.size()) continue;
-
-                        if (!(place1.marking * maxDrainRatio).isSubsetOrEqTo(place2.marking)) continue;
-
-                        i = 0, j = 0;
-                        while (i < place1._pre.size() && j < place2._pre.size()) {
-                            if (red.hasTimedOut()) return false;
-
-                            uint32_t p1t = place1._pre[i];
-                            uint32_t p2t = place2._pre[j];
-
-                            if (p1t < p2t) {
-                                // place1._pre is not a subset of place2._pre
-                                ok = false;
-                                break;
-                            }
-
-                            j++;
-                            if (p1t > p2t) {
-                                swp = 2; // We can't remove p1, so don't try swap
-                                continue;
-                            }
-                            i++;
-
-                            const Transition &tran = red.transitions()[p2t];
-                            const auto &p2Arc = red.getOutArc(tran, p2);
-                            const auto &p1Arc = red.getOutArc(tran, p1);
+        i = 0, j = 0;
+        while (i < place1._pre.size() && j < place2._pre.size()) {
+            if (red.hasTimedOut()) return false;
+
+            uint32_t p1t = place1._pre[i];
+            uint32_t p2t = place2._pre[j];
+
+            if (p1t < p2t) {
+                // place1._pre is not a subset of place2._pre
+                return false;
+            }
+
+            j++;
+            if (p1t > p2t) {
+                trySwap = false; // We can't remove p1, so don't try swap
+                continue;
+            }
+            i++;
 
-                            if (to_string(*p1Arc->expr) == to_string(*p2Arc->expr) && maxDrainRatio > 1.0) {
-                                ok = false;
-                                break;
-                            }
-
-                            const auto ms1 = PetriEngine::Colored::extractVarMultiset(*p1Arc->expr);
-                            const auto ms2 = PetriEngine::Colored::extractVarMultiset(*p2Arc->expr);
-
-                            // ms1 and ms2 must share support
-
-                            if (!ms1 || !ms2 || ms1->distinctSize() != ms2->distinctSize() || ((*ms1) + (*ms2)).distinctSize() != ms1->distinctSize()) {
-                                ok = false;
-                                swp = 2;
-                                break;
-                            }
-
-                            for (const auto& [varvec, multiplicity] : *ms1) {
-                                if (maxDrainRatio > (double)(*ms2)[varvec] / (double)multiplicity) {
-                                    ok = false;
-                                    break;
-                                }
-                            }
-                            if (!ok) break;
-                        }
-
-                        if (!ok || i != place1._pre.size()) continue;
-
-                        continueReductions = true;
-                        _applications++;
-                        red.skipPlace(p2);
-
-                        // p2 has now been removed from tid_outer.output_arcs, so update arc indexes to not miss any places
-                        if (p2 == pid_outer) {
-                            aid_outer--;
-                            aid_inner--;
-                        } else if (p2 == pid_inner) aid_inner--;
-                        break;
-                    }
+            const Transition &tran = red.transitions()[p2t];
+            const auto &p2Arc = red.getOutArc(tran, p2);
+            const auto &p1Arc = red.getOutArc(tran, p1);
+
+            if (to_string(*p1Arc->expr) == to_string(*p2Arc->expr) && maxDrainRatio > 1.0) {
+                return false;
+            }
+
+            const auto ms1 = PetriEngine::Colored::extractVarMultiset(*p1Arc->expr);
+            const auto ms2 = PetriEngine::Colored::extractVarMultiset(*p2Arc->expr);
+
+            // ms1 and ms2 must share support
+
+            if (!ms1 || !ms2 || ms1->distinctSize() != ms2->distinctSize() || ((*ms1) + (*ms2)).distinctSize() != ms1->distinctSize()) {
+                trySwap = false;
+                return false;
+            }
+
+            for (const auto& [varvec, multiplicity] : *ms1) {
+                if (maxDrainRatio > (double)(*ms2)[varvec] / (double)multiplicity) {
+                    return false;
                 }
             }
         }
-        red.consistent();
-        return continueReductions;
+
+        return i == place1._pre.size();
     }
 }
\ No newline at end of file
@@ -43,12 +43,14 @@ namespace PetriEngine::Colored::Reduction {
             for (auto &out: transition.output_arcs) {
                 auto &otherplace = const_cast<Place &>(red.places()[out.place]);
                 otherplace.marking += tokens;
+                red.markPlaceChanged(out.place);
             }
 
             if (place._pre.empty()) {
                 red.skipPlace(p);
             } else {
                 place.marking = Multiset();
+                red.markPlaceChanged(p);
             }
 
             _applications++;
@@ -18,63 +18,71 @@ namespace PetriEngine::Colored::Reduction {
 
         Colored::PartitionBuilder partition(red.transitions(), red.places());
 
-        bool continueReductions = false;
-        const size_t numberofplaces = red.placeCount();
-        for (uint32_t p = 0; p < numberofplaces; ++p) {
-
-            if (red.unskippedPlacesCount() <= 1) break;
-            if (red.hasTimedOut()) return false;
+        // places whose surroundings are unchanged since the last application were not redundant then
+        std::vector<uint32_t> candidates;
+        for (uint32_t p = 0; p < red.placeCount(); ++p) {
+            if (red.placeChangedSince(p, lastVersion()) && isCandidate(red, inQuery, p))
+                candidates.push_back(p);
+        }
 
-            Place place = red.places()[p];
-            if (place.skipped) continue;
-            if (place.inhibitor) continue;
-            if (place._pre.size() < place._post.size()) continue;
-            if (inQuery.isPlaceUsed(p)) continue;
+        // checking the consumers is the expensive part and only reads the net, so it is done up front
+        std::vector<uint8_t> redundant(candidates.size(), 0);
+        red.parallelFor(candidates.size(), [&](size_t i) {
+            if (!red.hasTimedOut())
+                redundant[i] = isRedundant(red, candidates[i], partition);
+        });
+        if (red.hasTimedOut()) return false;
 
-            bool ok = true;
-            for (uint cons: place._post) {
-                const Transition &transition = red.transitions()[cons];
+        const auto version = red.version();
+        bool continueReductions = false;
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            if (red.unskippedPlacesCount() <= 1) break;
+            if (!redundant[i]) continue;
 
-                uint32_t bindingCount = red.getBindingCount(transition);
-                if (bindingCount > 10000) {
-                    ok = false;
-                    break;
-                }
+            const uint32_t p = candidates[i];
+            // removing an earlier place may have changed the consumers of this one
+            if (red.placeChangedSince(p, version) && !(isCandidate(red, inQuery, p) && isRedundant(red, p, partition)))
+                continue;
 
-                const auto &outArc = red.getOutArc(transition, p);
-                if (outArc == transition.output_arcs.end()) {
-                    ok = false;
-                    break;
-                }
+            ++_applications;
+            red.skipPlace(p);
+            continueReductions = true;
+        }
+        red.consistent();
+        return continueReductions;
+    }
 
-                const auto &inArc = red.getInArc(p, transition);
+    bool RedRuleRedundantPlaces::isCandidate(const ColoredReducer &red, const PetriEngine::PQL::ColoredUseVisitor &inQuery,
+                                             uint32_t p) const {
+        const Place &place = red.places()[p];
+        return !place.skipped && !place.inhibitor && place._pre.size() >= place._post.size() && !inQuery.isPlaceUsed(p);
+    }
 
-                ok = markingEnablesInArc(place.marking, *inArc, transition, partition, red.colors());
+    bool RedRuleRedundantPlaces::isRedundant(ColoredReducer &red, uint32_t p, const PartitionBuilder &partition) const {
+        const Place &place = red.places()[p];
+        for (uint cons: place._post) {
+            const Transition &transition = red.transitions()[cons];
 
-                if (!ok) break;
+            uint32_t bindingCount = red.getBindingCount(transition);
+            if (bindingCount > 10000) return false;
 
-                auto inSet = PetriEngine::Colored::extractVarMultiset(*inArc->expr);
-                auto outSet = PetriEngine::Colored::extractVarMultiset(*outArc->expr);
-                if (!inSet || !outSet || !(*inSet).isSubsetOrEqTo(*outSet)) {
-                    ok = false;
-                    break;
-                }
-            }
+            const auto &outArc = red.getOutArc(transition, p);
+            if (outArc == transition.output_arcs.end()) return false;
 
-            if (!ok) continue;
+            const auto &inArc = red.getInArc(p, transition);
 
-            ++_applications;
-            red.skipPlace(p);
-            continueReductions = true;
+            if (!markingEnablesInArc(place.marking, *inArc, transition, partition, red.colors())) return false;
 
+            auto inSet = PetriEngine::Colored::extractVarMultiset(*inArc->expr);
+            auto outSet = PetriEngine::Colored::extractVarMultiset(*outArc->expr);
+            if (!inSet || !outSet || !(*inSet).isSubsetOrEqTo(*outSet)) return false;
         }
-        red.consistent();
-        return continueReductions;
+        return true;
     }
 
-    bool RedRuleRedundantPlaces::markingEnablesInArc(Multiset &marking, const Arc &arc,
+    bool RedRuleRedundantPlaces::markingEnablesInArc(const Multiset &marking, const Arc &arc,
                                                      const Colored::Transition &transition,
-                                                     PartitionBuilder &partition,
+                                                     const PartitionBuilder &partition,
                                                      const ColorTypeMap &colors) const {
         assert(arc.input);
 
@@ -0,0 +1,257 @@
+#include "PetriEngine/Colored/UnfoldCache.h"
+#include "PetriEngine/Simplification/MurmurHash2.h"
+#include "utils/mapped_file.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <sstream>
+
+namespace PetriEngine {
+    namespace Colored {
+
+        namespace {
+            // bumped whenever the layout below or the unfolding itself changes
+            constexpr char magic[8] = {'V', 'P', 'N', 'U', 'N', 'F', '0', '1'};
+            constexpr uint32_t no_string = std::numeric_limits<uint32_t>::max();
+
+            template<typename T>
+            void write(std::ostream& out, const T& value) {
+                static_assert(std::is_trivially_copyable_v<T>);
+                out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+            }
+
+            void write_string(std::ostream& out, const std::string& str) {
+                write<uint32_t>(out, str.size());
+                out.write(str.data(), str.size());
+            }
+
+            // every name is written once, and referred to by its index
+            class string_table {
+            private:
+                shared_name_index_map _index;
+                std::vector<shared_const_string> _strings;
+
+            public:
+                uint32_t operator()(const shared_const_string& str) {
+                    if (!str)
+                        return no_string;
+                    auto [it, inserted] = _index.emplace(str, _strings.size());
+                    if (inserted)
+                        _strings.push_back(str);
+                    return it->second;
+                }
+
+                void write(std::ostream& out) const {
+                    Colored::write<uint32_t>(out, _strings.size());
+                    for (auto& str : _strings)
+                        write_string(out, *str);
+                }
+            };
+        }
+
+        void UnfoldCache::add_file(const std::string& path) {
+            mapped_file file(path);
+            add(file.size());
+            add(file.data(), file.size());
+        }
+
+        void UnfoldCache::add(const void* data, size_t size) {
+            _key = MurmurHash64A(data, size, _key ^ 0x9e3779b97f4a7c15ULL);
+        }
+
+        std::string UnfoldCache::path() const {
+            std::stringstream ss;
+            ss << _directory << "/" << std::hex << std::setw(16) << std::setfill('0') << _key << ".unf";
+            return ss.str();
+        }
+
+        std::optional<UnfoldCache::entry_t> UnfoldCache::load(shared_string_set& string_set) const {
+            const auto file_name = path();
+            {
+                std::ifstream exists(file_name);
+                if (!exists)
+                    return std::nullopt;
+            }
+            try {
+                mapped_file file(file_name);
+                mapped_reader in(file);
+                if (std::memcmp(in.bytes(sizeof(magic)), magic, sizeof(magic)) != 0 || in.read<uint64_t>() != _key)
+                    throw base_error("Not an unfolding of this model");
+
+                std::vector<shared_const_string> strings(in.read<uint32_t>());
+                for (auto& str : strings)
+                    str = *string_set.insert(std::make_shared<const_string>(in.read_string())).first;
+                auto string = [&]() -> shared_const_string {
+                    auto id = in.read<uint32_t>();
+                    if (id == no_string)
+                        return nullptr;
+                    if (id >= strings.size())
+                        throw base_error("Invalid name in unfolding cache");
+                    return strings[id];
+                };
+
+                entry_t entry{PetriNetBuilder(string_set), {}, {}, {}, {}, 0};
+                auto& builder = entry._builder;
+                const auto places = in.read<uint32_t>();
+                for (uint32_t p = 0; p < places; ++p) {
+                    auto name = string();
+                    auto tokens = in.read<uint32_t>();
+                    auto x = in.read<double>();
+                    auto y = in.read<double>();
+                    builder.addPlace(name, tokens, x, y);
+                }
+                const auto transitions = in.read<uint32_t>();
+                for (uint32_t t = 0; t < transitions; ++t) {
+                    auto name = string();
+                    auto player = in.read<int32_t>();
+                    auto x = in.read<double>();
+                    auto y = in.read<double>();
+                    builder.addTransition(name, player, x, y);
+                    for (auto n = in.read<uint32_t>(); n > 0; --n) {
+                        auto place = in.read<uint32_t>();
+                        auto weight = in.read<uint32_t>();
+                        auto inhibitor = in.read<uint8_t>() != 0;
+                        if (place >= places)
+                            throw base_error("Invalid arc in unfolding cache");
+                        builder.addInputArc(place, t, inhibitor, weight);
+                    }
+                    for (auto n = in.read<uint32_t>(); n > 0; --n) {
+                        auto place = in.read<uint32_t>();
+                        auto weight = in.read<uint32_t>();
+                        if (place >= places)
+                            throw base_error("Invalid arc in unfolding cache");
+                        builder.addOutputArc(t, place, weight);
+                    }
+                }
+                if (builder.numberOfPlaces() != places || builder.numberOfTransitions() != transitions)
+                    throw base_error("Duplicate names in unfolding cache");
+
+                for (auto n = in.read<uint32_t>(); n > 0; --n) {
+                    auto& unfolded = entry._transition_names[string()];
+                    unfolded.resize(in.read<uint32_t>());
+                    for (auto& name : unfolded)
+                        name = string();
+                }
+                for (auto n = in.read<uint32_t>(); n > 0; --n) {
+                    auto& unfolded = entry._place_names[string()];
+                    for (auto k = in.read<uint32_t>(); k > 0; --k) {
+                        auto color = in.read<uint32_t>();
+                        unfolded[color] = string();
+                    }
+                }
+                entry._bindings = in.read_string();
+                entry._scalar_sets.resize(in.read<uint32_t>());
+                for (auto& blocks : entry._scalar_sets) {
+                    blocks.resize(in.read<uint32_t>());
+                    const auto slots = in.read<uint32_t>();
+                    for (auto& block : blocks) {
+                        block.resize(slots);
+                        for (auto& place : block)
+                            place = string();
+                    }
+                }
+                entry._arcs = in.read<uint64_t>();
+                if (!in.done())
+                    throw base_error("Trailing data in unfolding cache");
+                return entry;
+            } catch (const base_error& err) {
+                std::cerr << "Ignoring unfolding cache " << file_name << ": " << err.what() << std::endl;
+                return std::nullopt;
+            }
+        }
+
+        void UnfoldCache::store(const PetriNetBuilder& builder, const shared_name_name_map& transition_names,
+                                const shared_place_color_map& place_names, const std::string& bindings,
+                                const std::vector<Structures::place_blocks_t>* scalar_sets, size_t arcs) const {
+            string_table strings;
+            std::vector<shared_const_string> place_name(builder.numberOfPlaces());
+            for (auto& [name, id] : builder.getPlaceNames())
+                place_name[id] = name;
+            std::vector<shared_const_string> transition_name(builder.numberOfTransitions());
+            for (auto& [name, id] : builder.getTransitionNames())
+                transition_name[id] = name;
+
+            // the names are only known once the body is serialized, so the body is written to memory first
+            std::stringstream body;
+            write<uint32_t>(body, place_name.size());
+            for (uint32_t p = 0; p < place_name.size(); ++p) {
+                write(body, strings(place_name[p]));
+                write<uint32_t>(body, builder.initialMarking[p]);
+                write(body, std::get<0>(builder._placelocations[p]));
+                write(body, std::get<1>(builder._placelocations[p]));
+            }
+            write<uint32_t>(body, transition_name.size());
+            for (uint32_t t = 0; t < transition_name.size(); ++t) {
+                const auto& transition = builder._transitions[t];
+                write(body, strings(transition_name[t]));
+                write<int32_t>(body, transition._player);
+                write(body, std::get<0>(builder._transitionlocations[t]));
+                write(body, std::get<1>(builder._transitionlocations[t]));
+                write<uint32_t>(body, transition.pre.size());
+                for (auto& arc : transition.pre) {
+                    write<uint32_t>(body, arc.place);
+                    write<uint32_t>(body, arc.weight);
+                    write<uint8_t>(body, arc.inhib ? 1 : 0);
+                }
+                write<uint32_t>(body, transition.post.size());
+                for (auto& arc : transition.post) {
+                    write<uint32_t>(body, arc.place);
+                    write<uint32_t>(body, arc.weight);
+                }
+            }
+            write<uint32_t>(body, transition_names.size());
+            for (auto& [name, unfolded] : transition_names) {
+                write(body, strings(name));
+                write<uint32_t>(body, unfolded.size());
+                for (auto& u : unfolded)
+                    write(body, strings(u));
+            }
+            write<uint32_t>(body, place_names.size());
+            for (auto& [name, unfolded] : place_names) {
+                write(body, strings(name));
+                write<uint32_t>(body, unfolded.size());
+                for (auto& [color, u] : unfolded) {
+                    write<uint32_t>(body, color);
+                    write(body, strings(u));
+                }
+            }
+            write_string(body, bindings);
+            write<uint32_t>(body, scalar_sets ? scalar_sets->size() : 0);
+            if (scalar_sets) {
+                for (auto& blocks : *scalar_sets) {
+                    write<uint32_t>(body, blocks.size());
+                    write<uint32_t>(body, blocks.empty() ? 0 : blocks[0].size());
+                    for (auto& block : blocks)
+                        for (auto& place : block)
+                            write(body, strings(place));
+                }
+            }
+            write<uint64_t>(body, arcs);
+
+            const auto file_name = path();
+            const auto tmp_name = file_name + ".tmp" + std::to_string(std::random_device{}());
+            {
+                std::ofstream out(tmp_name, std::ios::binary);
+                out.write(magic, sizeof(magic));
+                write(out, _key);
+                strings.write(out);
+                out << body.rdbuf();
+                if (!out) {
+                    std::cerr << "Could not write the unfolding cache " << tmp_name << std::endl;
+                    out.close();
+                    std::remove(tmp_name.c_str());
+                    return;
+                }
+            }
+            if (std::rename(tmp_name.c_str(), file_name.c_str()) != 0) {
+                std::cerr << "Could not write the unfolding cache " << file_name << std::endl;
+                std::remove(tmp_name.c_str());
+            }
+        }
+    }
+}
@@ -2,6 +2,12 @@
 #include "PetriEngine/Colored/EvaluationVisitor.h"
 #include "PetriEngine/Colored/Unfolder.h"
 #include "PetriEngine/Colored/BindingGenerator.h"
+#include "PetriEngine/Colored/VariableVisitor.h"
+#include "PetriEngine/Colored/ScalarSetVisitor.h"
+#include "utils/parallel_for.h"
+
+#include <algorithm>
+#include <map>
 
 namespace PetriEngine {
     namespace Colored {
@@ -65,14 +71,40 @@ namespace PetriEngine {
                     _stable.compute();
                 }
 
-                for (uint32_t transitionId = 0; transitionId < _builder.transitions().size(); transitionId++) {
+                const uint32_t ntransitions = _builder.transitions().size();
+                _unfoldedPlaces.assign(_builder.places().size(), {});
+                _sumPlaces.assign(_builder.places().size(), no_place);
+                _unfoldedTransitions.assign(ntransitions, {});
+                _transitionUnfolded.assign(ntransitions, false);
+                _inhibitorsOf.assign(ntransitions, {});
+                for (uint32_t i = 0; i < _builder.inhibitors().size(); ++i) {
+                    _inhibitorsOf[_builder.inhibitors()[i].transition].push_back(i);
+                }
+                _names_built = false;
+#ifdef VERIFYPN_MC_Simplification
+                if (_threads > 1) {
+                    // Bindings and arc expressions of a window of transitions are evaluated in parallel,
+                    // the window is then merged into the builder in transition order, such that names
+                    // and ids do not depend on the number of threads.
+                    const uint32_t window = _threads * 64;
+                    std::vector<unfolded_transition_t> evaluated(window);
+                    for (uint32_t first = 0; first < ntransitions; first += window) {
+                        const uint32_t last = std::min(ntransitions, first + window);
+                        parallel_for(last - first, _threads, [&](size_t i) {
+                            evaluated[i] = evaluateTransition(first + i);
+                        });
+                        for (uint32_t id = first; id < last; ++id)
+                            mergeTransition(ptBuilder, id, std::move(evaluated[id - first]));
+                    }
+                } else
+#endif
+                for (uint32_t transitionId = 0; transitionId < ntransitions; transitionId++) {
                     unfoldTransition(ptBuilder, transitionId);
                 }
 
-                const auto& unfoldedPlaceMap = ptBuilder.getPlaceNames();
-                for (auto& place : _builder.places()) {
-                    if (place.skipped) continue;
-                    handleOrphanPlace(ptBuilder, place, unfoldedPlaceMap);
+                for (uint32_t placeId = 0; placeId < _builder.places().size(); ++placeId) {
+                    if (_builder.places()[placeId].skipped) continue;
+                    handleOrphanPlace(ptBuilder, placeId);
                 }
 
                 auto end = std::chrono::high_resolution_clock::now();
@@ -86,30 +118,31 @@ namespace PetriEngine {
         //so we make a placeholder place which just has tokens equal to the number of colored tokens
         //Ideally, orphan places should just be translated to a constant in the query
 
-        void Unfolder::handleOrphanPlace(PetriNetBuilder& ptBuilder, const Colored::Place& place,
-            const shared_name_index_map& unfoldedPlaceMap) {
-            if (_ptplacenames.count(place.name) <= 0 && place.marking.size() > 0) {
+        void Unfolder::handleOrphanPlace(PetriNetBuilder& ptBuilder, uint32_t placeId) {
+            const Colored::Place& place = _builder.places()[placeId];
+            auto& unfolded = _unfoldedPlaces[placeId];
+            if (unfolded.empty() && place.marking.size() > 0) {
                 auto name = std::make_shared<const_string>(*place.name + "_orphan");
-                ptBuilder.addPlace(name, place.marking.size(), place._x, place._y);
-                _ptplacenames[place.name][0] = std::move(name);
+                unfolded[0] = ptBuilder.addPlace(name, place.marking.size(), place._x, place._y);
+                _placeNames.push_back(std::move(name));
+                _placeColors.push_back(nullptr);
             } else {
                 uint32_t usedTokens = 0;
-                bool any = false;
-                for (const auto &unfoldedPlace : _ptplacenames[place.name]) {
-                    any = true;
-                    auto unfoldedMarking = ptBuilder.initMarking();
-                    usedTokens += unfoldedMarking[unfoldedPlaceMap.find(unfoldedPlace.second)->second];
+                const auto& unfoldedMarking = ptBuilder.initMarking();
+                for (const auto &unfoldedPlace : unfolded) {
+                    usedTokens += unfoldedMarking[unfoldedPlace.second];
                 }
 
-                if (place.marking.size() > usedTokens || !any) {
+                if (place.marking.size() > usedTokens || unfolded.empty()) {
                     auto name = std::make_shared<const_string>(*place.name + "_orphan");
-                    ptBuilder.addPlace(name, place.marking.size() - usedTokens, place._x, place._y);
-                    _ptplacenames[place.name][std::numeric_limits<uint32_t>::max()] = std::move(name);
+                    unfolded[std::numeric_limits<uint32_t>::max()] = ptBuilder.addPlace(name, place.marking.size() - usedTokens, place._x, place._y);
+                    _placeNames.push_back(std::move(name));
+                    _placeColors.push_back(nullptr);
                 }
             }
         }
 
-        void Unfolder::unfoldPlace(PetriNetBuilder& ptBuilder, const Colored::Place* place, const PetriEngine::Colored::Color *color, uint32_t placeId, uint32_t id) {
+        uint32_t Unfolder::unfoldPlace(PetriNetBuilder& ptBuilder, const Colored::Place* place, const PetriEngine::Colored::Color *color, uint32_t placeId, uint32_t id) {
             size_t tokenSize = 0;
             if (!_partition.computed() || _partition.partition()[placeId].isDiagonal()) {
                 tokenSize = place->marking[color];
@@ -137,87 +170,180 @@ namespace PetriEngine {
             }
             auto name = std::make_shared<const_string>(*place->name + "_" + std::to_string(color->getId()));
 
-            ptBuilder.addPlace(name, tokenSize, place->_x, place->_y + (15 * color->getId()));
-            _ptplacenames[place->name][id] = std::move(name);
+            const auto index = ptBuilder.addPlace(name, tokenSize, place->_x, place->_y + (15 * color->getId()));
+            _unfoldedPlaces[placeId][id] = index;
+            _placeNames.push_back(std::move(name));
+            _placeColors.push_back(color);
+            return index;
         }
 
-        void Unfolder::unfoldTransition(PetriNetBuilder& ptBuilder, uint32_t transitionId) {
-            double offset = 0;
+        template<typename F>
+        void Unfolder::forEachBinding(uint32_t transitionId, F&& f) const {
             const Colored::Transition &transition = _builder.transitions()[transitionId];
             if (transition.skipped) return;
+            unfolded_binding_t unfolded;
             if (_fixed_point.computed() || _partition.computed()) {
                 assert(_fixed_point.variable_map().size() > transitionId);
                 assert(_symmetry.symmetries().size() > transitionId);
                 FixpointBindingGenerator gen(transition, _builder.colors(), _symmetry.symmetries()[transitionId],
                     _fixed_point.variable_map()[transitionId]);
-                size_t i = 0;
-                bool hasBindings = false;
-                for (const auto &b : gen) {
-                    auto name = std::make_shared<const_string>(*transition.name + "_" + std::to_string(i++));
-
-                    storeBinding(name, b);
-                   
-                    hasBindings = true;
-                    ptBuilder.addTransition(name, transition._player, transition._x, transition._y + offset);
-                    offset += 15;
-
-                    for (auto& arc : transition.input_arcs) {
-                        unfoldArc(ptBuilder, arc, b, name);
-                    }
-                    for (auto& arc : transition.output_arcs) {
-                        unfoldArc(ptBuilder, arc, b, name);
-                    }
-
-                    _pttransitionnames[transition.name].push_back(name);
-                    unfoldInhibitorArc(ptBuilder, transition.name, name);
-                }
-                if (!hasBindings) {
-                    _pttransitionnames[transition.name] = std::vector<shared_const_string>();
+                const auto arcs = compileArcs(transition, gen.variables());
+                for (auto it = gen.begin(), end = gen.end(); it != end; ++it) {
+                    unfolded.arcs.clear();
+                    if (_print_bindings)
+                        unfolded.binding = *it;
+                    evaluateArcs(transition, arcs, gen.values(), unfolded.arcs);
+                    f(unfolded);
                 }
             } else {
+                std::set<const Colored::Variable*> vars;
+                for (const auto& arc : transition.input_arcs)
+                    Colored::VariableVisitor::get_variables(*arc.expr, vars);
+                for (const auto& arc : transition.output_arcs)
+                    Colored::VariableVisitor::get_variables(*arc.expr, vars);
+                const std::vector<const Colored::Variable*> variables(vars.begin(), vars.end());
+                std::vector<const Colored::Color*> values(variables.size());
+                const auto arcs = compileArcs(transition, variables);
                 NaiveBindingGenerator gen(transition, _builder.colors());
-                size_t i = 0;
                 for (const auto &b : gen) {
-                    auto name = std::make_shared<const_string>(*transition.name + "_" + std::to_string(i++));
-                    ptBuilder.addTransition(name, transition._player, transition._x, transition._y + offset);
-                    offset += 15;
+                    unfolded.arcs.clear();
+                    if (_print_bindings)
+                        unfolded.binding = b;
+                    for (size_t i = 0; i < variables.size(); ++i)
+                        values[i] = b.find(variables[i])->second;
+                    evaluateArcs(transition, arcs, values, unfolded.arcs);
+                    f(unfolded);
+                }
+            }
+        }
 
-                    storeBinding(name, b);
+        Unfolder::unfolded_transition_t Unfolder::evaluateTransition(uint32_t transitionId) const {
+            unfolded_transition_t result;
+            forEachBinding(transitionId, [&](unfolded_binding_t& b) {
+                result.push_back(std::move(b));
+            });
+            return result;
+        }
 
-                    for (const auto& arc : transition.input_arcs) {
-                        unfoldArc(ptBuilder, arc, b, name);
+        std::vector<Colored::CompiledExpression> Unfolder::compileArcs(const Colored::Transition& transition,
+                                                                       const std::vector<const Colored::Variable*>& variables) const {
+            std::vector<Colored::CompiledExpression> arcs;
+            arcs.reserve(transition.input_arcs.size() + transition.output_arcs.size());
+            for (const auto* arcs_of : {&transition.input_arcs, &transition.output_arcs}) {
+                for (const auto& arc : *arcs_of) {
+                    // arcs to stable places are not unfolded
+                    if (_fixed_point.computed() && _stable[arc.place]) {
+                        arcs.emplace_back();
+                        continue;
                     }
-                    for (const auto& arc : transition.output_arcs) {
-                        unfoldArc(ptBuilder, arc, b, name);
-                    }
-                    _pttransitionnames[transition.name].push_back(name);
-                    unfoldInhibitorArc(ptBuilder, transition.name, name);
+                    assert(_partition.partition().size() > arc.place);
+                    arcs.push_back(Colored::CompiledExpression::compile(*arc.expr, variables, _builder.colors(),
+                                                                        _partition.partition()[arc.place]));
                 }
             }
+            return arcs;
+        }
+
+        void Unfolder::evaluateArcs(const Colored::Transition& transition, const std::vector<Colored::CompiledExpression>& arcs,
+                                    const std::vector<const Colored::Color*>& values, std::vector<unfolded_arc_t>& out) const {
+            size_t i = 0;
+            for (const auto& arc : transition.input_arcs) {
+                evaluateArc(arc, arcs[i++], values, out);
+            }
+            for (const auto& arc : transition.output_arcs) {
+                evaluateArc(arc, arcs[i++], values, out);
+            }
         }
 
-        void Unfolder::unfoldInhibitorArc(PetriNetBuilder& ptBuilder, const shared_const_string &oldname, const shared_const_string &newname) {
-            for (uint32_t i = 0; i < _builder.inhibitors().size(); ++i) {
-                if (*_builder.transitions()[_builder.inhibitors()[i].transition].name == *oldname) {
-                    const Colored::Arc &inhibArc = _builder.inhibitors()[i];
-                    if (_sumPlacesNames.size() < inhibArc.place) _sumPlacesNames.resize(inhibArc.place + 1);
-                    auto placeName = _sumPlacesNames[inhibArc.place];
-
-                    if (placeName == nullptr || placeName->empty()) {
-                        const PetriEngine::Colored::Place& place = _builder.places()[inhibArc.place];
-                        auto sumPlaceName = std::make_shared<const_string>(*place.name + "Sum");
-                        ptBuilder.addPlace(sumPlaceName, place.marking.size(), place._x + 30, place._y - 30);
-                        if (_ptplacenames.count(place.name) <= 0) {
-                            _ptplacenames[place.name][place.type->size()] = sumPlaceName;
+        void Unfolder::mergeBinding(PetriNetBuilder& ptBuilder, uint32_t transitionId, size_t index, unfolded_binding_t& b) {
+            const Colored::Transition &transition = _builder.transitions()[transitionId];
+            auto name = std::make_shared<const_string>(*transition.name + "_" + std::to_string(index));
+            const auto tid = ptBuilder.addTransition(name, transition._player, transition._x, transition._y + 15.0 * index);
+            _transitionNames.push_back(std::move(name));
+            if (_print_bindings)
+                _transitionBinding.emplace_back(tid, std::move(b.binding));
+
+            for (const auto& arc : b.arcs) {
+                const PetriEngine::Colored::Place& place = _builder.places()[arc.place];
+                if (arc.sum) {
+                    if (arc.weight > 0) {
+                        const auto sum = sumPlace(ptBuilder, arc.place);
+                        if (!arc.input) {
+                            ptBuilder.addOutputArc(tid, sum, arc.weight);
+                        } else {
+                            ptBuilder.addInputArc(sum, tid, false, arc.weight);
                         }
-                        placeName = _sumPlacesNames[inhibArc.place] = std::move(sumPlaceName);
+                        ++_nptarcs;
+                    } else {
+                        sumPlace(ptBuilder, arc.place);
+                    }
+                    continue;
+                }
+                auto& unfolded = _unfoldedPlaces[arc.place];
+                auto it = unfolded.find(arc.id);
+                const auto pid = it != unfolded.end() ? it->second : unfoldPlace(ptBuilder, &place, arc.color, arc.place, arc.id);
+                if (arc.input) {
+                    ptBuilder.addInputArc(pid, tid, false, arc.weight);
+                } else {
+                    ptBuilder.addOutputArc(tid, pid, arc.weight);
+                }
+                ++_nptarcs;
+            }
+
+            _unfoldedTransitions[transitionId].push_back(tid);
+            _transitionUnfolded[transitionId] = true;
+            unfoldInhibitorArcs(ptBuilder, transitionId, tid);
+        }
+
+        void Unfolder::mergeTransition(PetriNetBuilder& ptBuilder, uint32_t transitionId, unfolded_transition_t&& bindings) {
+            if (_builder.transitions()[transitionId].skipped) return;
+            for (size_t i = 0; i < bindings.size(); ++i)
+                mergeBinding(ptBuilder, transitionId, i, bindings[i]);
+            if (bindings.empty() && (_fixed_point.computed() || _partition.computed())) {
+                _transitionUnfolded[transitionId] = true;
+            }
+        }
+
+        void Unfolder::unfoldTransition(PetriNetBuilder& ptBuilder, uint32_t transitionId) {
+            if (_builder.transitions()[transitionId].skipped) return;
+            size_t i = 0;
+            forEachBinding(transitionId, [&](unfolded_binding_t& b) {
+                mergeBinding(ptBuilder, transitionId, i++, b);
+            });
+            if (i == 0 && (_fixed_point.computed() || _partition.computed())) {
+                _transitionUnfolded[transitionId] = true;
+            }
+        }
+
+        uint32_t Unfolder::sumPlace(PetriNetBuilder& ptBuilder, uint32_t placeId) {
+            auto& sum = _sumPlaces[placeId];
+            if (sum == no_place) {
+                const PetriEngine::Colored::Place& place = _builder.places()[placeId];
+                auto name = std::make_shared<const_string>(*place.name + "Sum");
+                sum = ptBuilder.addPlace(name, place.marking.size(), place._x + 30, place._y - 30);
+                _placeNames.push_back(std::move(name));
+                _placeColors.push_back(nullptr);
+            }
+            return sum;
+        }
+
+        void Unfolder::unfoldInhibitorArcs(PetriNetBuilder& ptBuilder, uint32_t transitionId, uint32_t ptTransition) {
+            for (auto i : _inhibitorsOf[transitionId]) {
+                const Colored::Arc &inhibArc = _builder.inhibitors()[i];
+                if (_sumPlaces[inhibArc.place] == no_place) {
+                    const auto sum = sumPlace(ptBuilder, inhibArc.place);
+                    // a place only read by inhibitor arcs is queried through its sum place
+                    auto& unfolded = _unfoldedPlaces[inhibArc.place];
+                    if (unfolded.empty()) {
+                        unfolded[_builder.places()[inhibArc.place].type->size()] = sum;
                     }
-                    ptBuilder.addInputArc(placeName, newname, true, inhibArc.inhib_weight);
                 }
+                ptBuilder.addInputArc(_sumPlaces[inhibArc.place], ptTransition, true, inhibArc.inhib_weight);
             }
         }
 
-        void Unfolder::unfoldArc(PetriNetBuilder& ptBuilder, const Colored::Arc& arc, const Colored::BindingMap& binding, const shared_const_string& tName) {
+        void Unfolder::evaluateArc(const Colored::Arc& arc, const Colored::CompiledExpression& expr,
+                                   const std::vector<const Colored::Color*>& values, std::vector<unfolded_arc_t>& out) const {
             const PetriEngine::Colored::Place& place = _builder.places()[arc.place];
             //If the place is stable, the arc does not need to be unfolded.
             //This exploits the fact that since the transition is being unfolded with this binding
@@ -228,10 +354,9 @@ namespace PetriEngine {
             }
 
             assert(_partition.partition().size() > arc.place);
-            const Colored::ExpressionContext context{binding, _builder.colors(), _partition.partition()[arc.place]};
-            const auto ms = Colored::EvaluationVisitor::evaluate(*arc.expr, context);
-            int shadowWeight = 0;
-            
+            const auto& ms = expr.evaluate_arc(values);
+            uint32_t shadowWeight = 0;
+
             const Colored::Color *newColor;
             std::vector<uint32_t> tupleIds;
             for (const auto& color : ms) {
@@ -256,67 +381,108 @@ namespace PetriEngine {
                 } else {
                     id = _partition.partition()[arc.place].getUniqueIdForColor(newColor);
                 }
-                auto pName = _ptplacenames[place.name][id];
-
-                if (pName == nullptr || pName->empty()) {
-                    unfoldPlace(ptBuilder, &place, newColor, arc.place, id);
-                    pName = _ptplacenames[place.name][id];
-                }
-
-                if (arc.input) {
-                    ptBuilder.addInputArc(pName, tName, false, color.second);
-                } else {
-                    ptBuilder.addOutputArc(tName, pName, color.second);
-                }
-                ++_nptarcs;
+                out.push_back({arc.place, id, newColor, color.second, arc.input, false});
             }
 
+            // the sum place is created even if no tokens move, as in the colored net the arc exists.
             if (place.inhibitor) {
-                if (_sumPlacesNames.size() <= arc.place) _sumPlacesNames.resize(arc.place + 1);
-                auto& sumPlaceName = _sumPlacesNames[arc.place];
-                if (sumPlaceName == nullptr || sumPlaceName->empty()) {
-                    auto newSumPlaceName = std::make_shared<const_string>(*place.name + "Sum");
-                    ptBuilder.addPlace(newSumPlaceName, place.marking.size(), place._x + 30, place._y - 30);
-                    sumPlaceName = _sumPlacesNames[arc.place] = std::move(newSumPlaceName);
-                }
-
+                out.push_back({arc.place, 0, nullptr, shadowWeight, arc.input, true});
+            }
+        }
 
-                if (shadowWeight > 0) {
-                    if (!arc.input) {
-                        ptBuilder.addOutputArc(tName, sumPlaceName, shadowWeight);
-                    } else {
-                        ptBuilder.addInputArc(sumPlaceName, tName, false, shadowWeight);
+        void Unfolder::printBinding(std::ostream& out) {
+            if (_print_bindings) {
+                out << "<bindings>\n";
+                for (auto const transition : _transitionBinding) {
+                    out << "   <transition id=\"" << *_transitionNames[transition.first] << "\">\n";    
+                    for(auto const var: transition.second) {
+                        out << "      <variable id=\"" << var.first->name << "\">\n";
+                        out << "         <color>" << var.second->getColorName() << "</color>\n";
+                        out << "      </variable>\n";
                     }
-                    ++_nptarcs;
+                    out << "   </transition>\n";
                 }
+                out << "</bindings>\n";
             }
         }
 
-    
-        void Unfolder::storeBinding(const shared_const_string& name, const Colored::BindingMap& binding) {
-            if (_print_bindings) { 
-                Colored::BindingMap b;
-                for (auto var: binding) {
-                    b[var.first] = var.second;
-                } 
-                _transitionBinding[*name] = b;
+        void Unfolder::buildNames() const {
+            if (_names_built) return;
+            _names_built = true;
+            _ptplacenames.clear();
+            _pttransitionnames.clear();
+            for (uint32_t p = 0; p < _unfoldedPlaces.size(); ++p) {
+                if (_unfoldedPlaces[p].empty()) continue;
+                auto& names = _ptplacenames[_builder.places()[p].name];
+                for (const auto& unfolded : _unfoldedPlaces[p])
+                    names[unfolded.first] = _placeNames[unfolded.second];
+            }
+            for (uint32_t t = 0; t < _unfoldedTransitions.size(); ++t) {
+                if (!_transitionUnfolded[t]) continue;
+                auto& names = _pttransitionnames[_builder.transitions()[t].name];
+                for (auto tid : _unfoldedTransitions[t])
+                    names.push_back(_transitionNames[tid]);
             }
         }
 
-        void  Unfolder::printBinding(){
-            if (_print_bindings) {
-                std::cout << "<bindings>\n";
-                for (auto const transition : _transitionBinding) {
-                    std::cout << "   <transition id=\"" << transition.first << "\">\n";    
-                    for(auto const var: transition.second) {
-                        std::cout << "      <variable id=\"" << var.first->name << "\">\n";
-                        std::cout << "         <color>" << var.second->getColorName() << "</color>\n";
-                        std::cout << "      </variable>\n";
+        std::vector<Structures::place_blocks_t> Unfolder::scalar_sets() const {
+            std::set<const Colored::ColorType*> ordered;
+            ScalarSetVisitor visitor(ordered);
+            for (const auto& transition : _builder.transitions()) {
+                if (transition.skipped) continue;
+                if (transition.guard)
+                    visitor.visit_guard(*transition.guard);
+                for (const auto* arcs : {&transition.input_arcs, &transition.output_arcs}) {
+                    for (const auto& arc : *arcs)
+                        visitor.visit_arc(*arc.expr);
+                }
+            }
+
+            std::vector<Structures::place_blocks_t> result;
+            std::set<const Colored::ColorType*> seen;
+            std::vector<const Colored::ColorType*> types;
+            std::vector<uint32_t> ids;
+            for (const auto& named : _builder.colors()) {
+                const auto* type = named.second;
+                if (type->isProduct() || type->size() < 2 || ordered.count(type) > 0 || !seen.insert(type).second)
+                    continue;
+                // slots are identified by the colored place and the colors of the other components
+                std::map<std::vector<uint32_t>, uint32_t> slots;
+                std::vector<std::vector<std::pair<uint32_t, uint32_t>>> blocks(type->size());
+                bool ok = true;
+                for (uint32_t placeId = 0; ok && placeId < _unfoldedPlaces.size(); ++placeId) {
+                    const auto& place = _builder.places()[placeId];
+                    if (place.skipped) continue;
+                    types.clear();
+                    place.type->getColortypes(types);
+                    const auto occurrences = std::count(types.begin(), types.end(), type);
+                    if (occurrences == 0) continue;
+                    if (occurrences > 1 || (_partition.computed() && !_partition.partition()[placeId].isDiagonal())) {
+                        ok = false;
+                        break;
                     }
-                    std::cout << "   </transition>\n";
+                    const size_t component = std::find(types.begin(), types.end(), type) - types.begin();
+                    for (const auto& unfolded : _unfoldedPlaces[placeId]) {
+                        const auto* color = _placeColors[unfolded.second];
+                        // sum and orphan places count all colors alike
+                        if (color == nullptr) continue;
+                        ids.clear();
+                        color->getTupleId(ids);
+                        const auto block = ids[component];
+                        ids[component] = 0;
+                        ids.push_back(placeId);
+                        const auto slot = slots.emplace(ids, slots.size()).first->second;
+                        blocks[block].emplace_back(slot, unfolded.second);
+                    }
+                }
+                if (!ok || slots.empty()) continue;
+                auto& sets = result.emplace_back(type->size(), std::vector<shared_const_string>(slots.size()));
+                for (size_t b = 0; b < blocks.size(); ++b) {
+                    for (const auto& [slot, index] : blocks[b])
+                        sets[b][slot] = _placeNames[index];
                 }
-                std::cout << "</bindings>\n";
             }
+            return result;
         }
     }
 }
@@ -142,7 +142,7 @@ namespace PetriEngine { namespace PQL {
     }
 
     void AnalyzeVisitor::_accept(UnfoldedIdentifierExpr *element) {
-        AnalysisContext::ResolutionResult result = _context.resolve(element->name());
+        AnalysisContext::ResolutionResult result = _context.resolvePlace(element->name(), element->offset());
         if (result.success) {
             element->_offsetInMarking = result.offset;
         } else {
@@ -234,7 +234,10 @@ namespace PetriEngine { namespace PQL {
 
     void AnalyzeVisitor::_accept(CompareConjunction *element) {
         for(auto& c : element->_constraints){
-            c._place = getPlace(_context, c._name);
+            auto result = _context.resolvePlace(c._name, c._place);
+            if (!result.success)
+                throw base_error("Unable to resolve identifier \"", *c._name, "\"");
+            c._place = result.offset;
             assert(c._place >= 0);
         }
         std::sort(std::begin(element->_constraints), std::end(element->_constraints));
@@ -441,7 +444,7 @@ namespace PetriEngine { namespace PQL {
 
     void AnalyzeVisitor::_accept(UnfoldedUpperBoundsCondition *element) {
         for (auto &p: element->_places) {
-            AnalysisContext::ResolutionResult result = _context.resolve(p._name);
+            AnalysisContext::ResolutionResult result = _context.resolvePlace(p._name, p._place);
             if (result.success) {
                 p._place = result.offset;
             } else {
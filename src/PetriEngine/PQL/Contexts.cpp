@@ -58,6 +58,13 @@ namespace PetriEngine {
             return result;
         }
 
+        AnalysisContext::ResolutionResult AnalysisContext::resolvePlace(const shared_const_string& identifier, uint32_t offset)
+        {
+            if (_net != nullptr && offset < _net->numberOfPlaces() && _net->placeNames()[offset] == identifier)
+                return {(int) offset, true};
+            return resolve(identifier);
+        }
+
         uint32_t SimplificationContext::getLpTimeout() const
         {
             return _lpTimeout;
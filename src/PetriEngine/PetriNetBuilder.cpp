@@ -20,6 +20,8 @@
 
 #include <assert.h>
 #include <algorithm>
+#include <limits>
+#include <set>
 
 #include "PetriEngine/PetriNetBuilder.h"
 #include "PetriEngine/PetriNet.h"
@@ -56,10 +58,10 @@ namespace PetriEngine {
     void PetriNetBuilder::addPlace(const std::string &name, uint32_t tokens, double x, double y)
     {
         auto spn = std::make_shared<const_string>(name);
-        return addPlace(spn, tokens, x, y);
+        addPlace(spn, tokens, x, y);
     }
 
-    void PetriNetBuilder::addPlace(const shared_const_string &_name, uint32_t tokens, double x, double y) {
+    uint32_t PetriNetBuilder::addPlace(const shared_const_string &_name, uint32_t tokens, double x, double y) {
         auto name = *_string_set.insert(_name).first;
         size_t size = _placenames.size();
         auto [it, inserted] = _placenames.insert(std::make_pair(name, size));
@@ -72,15 +74,16 @@ namespace PetriEngine {
         if(initialMarking.size() <= it->second)
             initialMarking.resize(initialMarking.size() + 1, 0);
         initialMarking[it->second] = tokens;
+        return it->second;
     }
 
     void PetriNetBuilder::addTransition(const std::string &name,
             int32_t player, double x, double y) {
         auto stn = std::make_shared<const_string>(name);
-        return addTransition(stn, player, x, y);
+        addTransition(stn, player, x, y);
     }
 
-    void PetriNetBuilder::addTransition(const shared_const_string &_name,
+    uint32_t PetriNetBuilder::addTransition(const shared_const_string &_name,
             int32_t player, double x, double y) {
         auto name = *_string_set.insert(_name).first;
         size_t size = _transitionnames.size();
@@ -91,6 +94,7 @@ namespace PetriEngine {
             _transitions.back()._player = player;
             _transitionlocations.push_back(std::tuple<double, double>(x,y));
         }
+        return it->second;
     }
 
     void PetriNetBuilder::addInputArc(const std::string &place, const std::string &transition, bool inhibitor, uint32_t weight)
@@ -109,9 +113,10 @@ namespace PetriEngine {
         {
             addPlace(place,0,0,0);
         }
-        uint32_t p = _placenames[place];
-        uint32_t t = _transitionnames[transition];
+        addInputArc(_placenames[place], _transitionnames[transition], inhibitor, weight);
+    }
 
+    void PetriNetBuilder::addInputArc(uint32_t p, uint32_t t, bool inhibitor, uint32_t weight) {
         for (Arc& arc : _transitions[t].pre){
             if (arc.place == p){
                 if (inhibitor == arc.inhib) {
@@ -121,7 +126,7 @@ namespace PetriEngine {
                         arc.weight = std::min(arc.weight, weight);
                     }
                 } else {
-                    throw base_error("Adding an inhibitor and a non-inhibitor arc to the same Place/Transition pair:", place, transition);
+                    throw base_error("Adding an inhibitor and a non-inhibitor arc to the same Place/Transition pair: place ", p, ", transition ", t);
                 }
                 return;
             }
@@ -155,8 +160,10 @@ namespace PetriEngine {
         {
             addPlace(place,0,0,0);
         }
-        uint32_t p = _placenames[place];
-        uint32_t t = _transitionnames[transition];
+        addOutputArc(_transitionnames[transition], _placenames[place], weight);
+    }
+
+    void PetriNetBuilder::addOutputArc(uint32_t t, uint32_t p, uint32_t weight) {
         assert(t < _transitions.size());
         assert(p < _places.size());
 
@@ -176,26 +183,133 @@ namespace PetriEngine {
         _places[p].producers.push_back(t);
     }
 
-    uint32_t PetriNetBuilder::nextPlaceId(std::vector<uint32_t>& counts, std::vector<uint32_t>& pcounts, std::vector<uint32_t>& ids, bool reorder)
+    namespace {
+        constexpr uint32_t none = std::numeric_limits<uint32_t>::max();
+
+        /*
+         * Hands out the places in the order in which makePetriNet numbers them. Without reordering that is the
+         * order of the builder; otherwise the place next numbered is the one with the fewest unplaced consumers
+         * and producers, lowest index first, which the candidates are kept sorted by to avoid a pass over every
+         * place per pick. A fixed order, such as the one of localityOrder, can also be given.
+         */
+        class place_picker_t {
+        private:
+            std::vector<uint32_t>& _consumers;
+            std::vector<uint32_t>& _producers;
+            std::vector<uint32_t> _order;
+            std::set<std::pair<uint32_t, uint32_t>> _queue;
+            std::vector<bool> _picked;
+            size_t _cursor = 0;
+            bool _greedy;
+
+            uint32_t key(uint32_t p) const {
+                return _producers[p] == 0 ? 0 : std::max(_consumers[p], _producers[p]);
+            }
+
+            // the first place of the order not yet picked
+            uint32_t next_in_order() {
+                while (_cursor < _order.size() && _picked[_order[_cursor]])
+                    ++_cursor;
+                return _cursor < _order.size() ? _order[_cursor] : none;
+            }
+
+            void update(uint32_t p, uint32_t& count) {
+                if (!_greedy || _picked[p]) {
+                    --count;
+                    return;
+                }
+                auto erased = _queue.erase({key(p), p});
+                --count;
+                if (erased)
+                    _queue.emplace(key(p), p);
+            }
+
+        public:
+            place_picker_t(const std::vector<Place>& places, std::vector<uint32_t>& consumers,
+                           std::vector<uint32_t>& producers, std::vector<uint32_t> order, bool greedy)
+            : _consumers(consumers), _producers(producers), _order(std::move(order)), _picked(places.size(), false),
+              _greedy(greedy) {
+                if (_greedy)
+                    for (auto p : _order)
+                        _queue.emplace(key(p), p);
+            }
+
+            uint32_t pick() {
+                uint32_t p;
+                // once the first place is fully consumed every candidate ties, leaving the lowest index
+                if (!_greedy || _consumers.empty() || _consumers[0] == 0)
+                    p = next_in_order();
+                else
+                    p = _queue.empty() ? none : _queue.begin()->second;
+                if (p != none) {
+                    _picked[p] = true;
+                    if (_greedy)
+                        _queue.erase({key(p), p});
+                }
+                return p;
+            }
+
+            void consumed(uint32_t p) {
+                update(p, _consumers[p]);
+            }
+
+            void produced(uint32_t p) {
+                update(p, _producers[p]);
+            }
+        };
+    }
+
+    std::vector<uint32_t> PetriNetBuilder::localityOrder() const
     {
-        uint32_t cand = std::numeric_limits<uint32_t>::max();
-        uint32_t cnt =  std::numeric_limits<uint32_t>::max();
-        for(uint32_t i = 0; i < _places.size(); ++i)
-        {
-            uint32_t nnum = (pcounts[i] == 0 ? 0 : (counts[0] == 0 ? 0 : std::max(counts[i], pcounts[i])));
-            if( ids[i] == std::numeric_limits<uint32_t>::max() &&
-                nnum < cnt &&
-                !_places[i].skip)
-            {
-                if(!reorder) return i;
-                cand = i;
-                cnt = nnum;
+        /*
+         * Reverse Cuthill-McKee on the graph where places are adjacent if they share a transition: a breadth first
+         * search from a place of least degree, visiting the new neighbours of each place in order of increasing
+         * degree. Every transition is expanded once, so shared transitions are never turned into a quadratic
+         * number of place pairs. Places read or written by the same transition thereby end up close together.
+         */
+        std::vector<uint32_t> degree(_places.size(), 0);
+        std::vector<uint32_t> candidates;
+        for (uint32_t p = 0; p < _places.size(); ++p) {
+            if (_places[p].skip) continue;
+            degree[p] = _places[p].consumers.size() + _places[p].producers.size();
+            candidates.push_back(p);
+        }
+        std::stable_sort(candidates.begin(), candidates.end(), [&](auto a, auto b) { return degree[a] < degree[b]; });
+
+        std::vector<bool> seen(_places.size(), false);
+        std::vector<bool> expanded(_transitions.size(), false);
+        std::vector<uint32_t> order;
+        std::vector<uint32_t> neighbours;
+        order.reserve(candidates.size());
+        for (auto root : candidates) {
+            if (seen[root]) continue;
+            seen[root] = true;
+            order.push_back(root);
+            for (size_t head = order.size() - 1; head < order.size(); ++head) {
+                auto& place = _places[order[head]];
+                neighbours.clear();
+                for (auto* ts : {&place.consumers, &place.producers}) {
+                    for (auto t : *ts) {
+                        if (expanded[t] || _transitions[t].skip) continue;
+                        expanded[t] = true;
+                        for (auto* arcs : {&_transitions[t].pre, &_transitions[t].post}) {
+                            for (auto& arc : *arcs) {
+                                if (seen[arc.place] || _places[arc.place].skip) continue;
+                                seen[arc.place] = true;
+                                neighbours.push_back(arc.place);
+                            }
+                        }
+                    }
+                }
+                std::stable_sort(neighbours.begin(), neighbours.end(), [&](auto a, auto b) { return degree[a] < degree[b]; });
+                order.insert(order.end(), neighbours.begin(), neighbours.end());
             }
         }
-        return cand;
+        std::reverse(order.begin(), order.end());
+        return order;
     }
 
-    PetriNet* PetriNetBuilder::makePetriNet(bool reorder) {
+    PetriNet* PetriNetBuilder::makePetriNet(bool reorder, bool locality) {
 
         /*
          * The basic idea is to construct three arrays, the first array,
@@ -215,6 +329,11 @@ namespace PetriEngine {
          *
          * If anybody wants to spend time on it, this is the first step towards
          * a decision-tree like construction, possibly improving successor generation.
+         *
+         * The places are numbered in the order they are visited, see place_picker_t.
+         * With locality, that is the order of localityOrder, so the places of a
+         * transition are close in the marking and the transitions, grouped by place,
+         * follow along.
          */
 
         uint32_t nplaces = numberOfUnskippedPlaces();
@@ -283,7 +402,17 @@ namespace PetriEngine {
 
         PetriNet* net = new PetriNet(ntrans, invariants, nplaces);
 
-        uint32_t next = nextPlaceId(place_cons_count, place_prod_count, place_idmap, reorder);
+        std::vector<uint32_t> order;
+        if(reorder && locality)
+            order = localityOrder();
+        else
+        {
+            for(uint32_t i = 0; i < _places.size(); ++i)
+                if(!_places[i].skip) order.push_back(i);
+        }
+        place_picker_t picker(_places, place_cons_count, place_prod_count, std::move(order), reorder && !locality);
+
+        uint32_t next = picker.pick();
         uint32_t free = 0;
         uint32_t freeinv = 0;
         uint32_t freetrans = 0;
@@ -310,7 +439,7 @@ namespace PetriEngine {
                     iv.inhibitor = pre.inhib;
                     assert(pre.inhib);
                     assert(place_cons_count[pre.place] > 0);
-                    --place_cons_count[pre.place];
+                    picker.consumed(pre.place);
                     ++freeinv;
                 }
 
@@ -392,7 +521,7 @@ namespace PetriEngine {
                     iv.inhibitor = pre.inhib;
                     ++freeinv;
                     assert(place_cons_count[pre.place] > 0);
-                    --place_cons_count[pre.place];
+                    picker.consumed(pre.place);
                 }
 
                 net->_transitions[freetrans].outputs = freeinv;
@@ -402,7 +531,7 @@ namespace PetriEngine {
                     auto& post_inv = net->_invariants[freeinv];
                     post_inv.place = post.place;
                     post_inv.tokens = post.weight;
-                    --place_prod_count[post.place];
+                    picker.produced(post.place);
                     ++freeinv;
                 }
 
@@ -412,7 +541,7 @@ namespace PetriEngine {
                 assert(freeinv <= invariants);
             }
             ++free;
-            next = nextPlaceId(place_cons_count, place_prod_count, place_idmap, reorder);
+            next = picker.pick();
         }
 
 
@@ -545,7 +674,7 @@ namespace PetriEngine {
     void PetriNetBuilder::reduce(   std::vector<std::shared_ptr<PQL::Condition> >& queries,
                                     std::vector<Reachability::ResultPrinter::Result>& results,
                                     int reductiontype, bool reconstructTrace, const PetriNet* net, int timeout,
-                                    std::vector<uint32_t>& reductions)
+                                    std::vector<uint32_t>& reductions, uint32_t threads)
     {
         QueryPlaceAnalysisContext placecontext(getPlaceNames(), getTransitionNames(), net);
         bool all_reach = true;
@@ -576,7 +705,7 @@ namespace PetriEngine {
                 contains_next |= PetriEngine::PQL::containsNext(queries[i]) || PetriEngine::PQL::hasNestedDeadlock(queries[i]);
             }
         }
-        reducer.Reduce(placecontext, reductiontype, reconstructTrace, timeout, remove_loops, all_reach, all_ltl, contains_next, reductions);
+        reducer.Reduce(placecontext, reductiontype, reconstructTrace, timeout, remove_loops, all_reach, all_ltl, contains_next, reductions, threads);
     }
 
     void PetriNetBuilder::saveInitialNet()
@@ -3,6 +3,7 @@
 #include "PetriEngine/PetriNetBuilder.h"
 #include "PetriEngine/options.h"
 #include "PetriEngine/PQL/Expressions.h"
+#include "utils/output.h"
 
 namespace PetriEngine {
     namespace Reachability {
@@ -32,6 +33,9 @@ namespace PetriEngine {
         {
             if(result == Unknown) return std::make_pair(Unknown,false);
 
+            // the result is passed on in one block, and flushed, when out goes out of scope
+            buffered_output out(std::cout);
+
             Result retval = result;
 
             if(options->cpnOverApprox)
@@ -49,18 +53,18 @@ namespace PetriEngine {
                     retval = query->isInvariant() ? Satisfied : NotSatisfied;
                 if(retval == Unknown)
                 {
-                    std::cout << "\nUnable to decide if " << querynames[index] << " is satisfied.\n\n";
-                    std::cout << "Query is MAYBE satisfied.\n" << std::endl;
+                    out << "\nUnable to decide if " << querynames[index] << " is satisfied.\n\n";
+                    out << "Query is MAYBE satisfied.\n\n";
                     return std::make_pair(Ignore,false);
                 }
-                std::cout << std::endl;
+                out << "\n";
             }
 
             bool showTrace = (result == Satisfied);
 
             if(!options->statespaceexploration && retval != Unknown)
             {
-                std::cout << "FORMULA " << querynames[index] << " ";
+                out << "FORMULA " << querynames[index] << " ";
             }
             else {
                 retval = Satisfied;
@@ -72,14 +76,14 @@ namespace PetriEngine {
                     }
                 }
                 // fprintf(stdout,"STATE_SPACE %lli -1 %d %d TECHNIQUES EXPLICIT\n", result.exploredStates(), result.maxTokens(), placeBound);
-                std::cout   << "STATE_SPACE STATES "<< exploredStates           << " " << techniquesStateSpace
-                            << std::endl
-                            << "STATE_SPACE TRANSITIONS "<< -1                  << " " << techniquesStateSpace
-                            << std::endl
-                            << "STATE_SPACE MAX_TOKEN_PER_MARKING "<< maxTokens << " " << techniquesStateSpace
-                            << std::endl
-                            << "STATE_SPACE MAX_TOKEN_IN_PLACE "<< placeBound   << " " << techniquesStateSpace
-                            << std::endl;
+                out << "STATE_SPACE STATES "<< exploredStates           << " " << techniquesStateSpace
+                    << "\n"
+                    << "STATE_SPACE TRANSITIONS "<< -1                  << " " << techniquesStateSpace
+                    << "\n"
+                    << "STATE_SPACE MAX_TOKEN_PER_MARKING "<< maxTokens << " " << techniquesStateSpace
+                    << "\n"
+                    << "STATE_SPACE MAX_TOKEN_IN_PLACE "<< placeBound   << " " << techniquesStateSpace
+                    << "\n";
                 return std::make_pair(retval,false);
             }
 
@@ -98,30 +102,43 @@ namespace PetriEngine {
 
             if (retval == Unknown)
             {
-                std::cout << "\nUnable to decide if " << querynames[index] << " is satisfied.";
+                out << "\nUnable to decide if " << querynames[index] << " is satisfied.";
             }
             else if(bound)
             {
-                std::cout << ((PQL::UnfoldedUpperBoundsCondition*)bound)->bounds() << " " << techniques << printTechniques() << std::endl;
-                std::cout << "Query index " << index << " was solved" << std::endl;
+                out << ((PQL::UnfoldedUpperBoundsCondition*)bound)->bounds() << " " << usedTechniques() << "\n";
+                out << "Query index " << index << " was solved\n";
             }
             else if (retval == Satisfied) {
                 if(!options->statespaceexploration)
                 {
-                    std::cout << "TRUE " << techniques << printTechniques() << std::endl;
-                    std::cout << "Query index " << index << " was solved" << std::endl;
+                    out << "TRUE " << usedTechniques() << "\n";
+                    out << "Query index " << index << " was solved\n";
                 }
             } else if (retval == NotSatisfied) {
                 if(!options->statespaceexploration)
                 {
-                    std::cout << "FALSE " << techniques << printTechniques() << std::endl;
-                    std::cout << "Query index " << index << " was solved" << std::endl;
+                    out << "FALSE " << usedTechniques() << "\n";
+                    out << "Query index " << index << " was solved\n";
                 }
             }
 
-            std::cout << std::endl;
+            if(options->json_results != nullptr && retval != Unknown)
+            {
+                json_record record(*options->json_results);
+                record.number("index", index).string("query", querynames[index]);
+                if(bound)
+                    record.number("bound", static_cast<size_t>(((PQL::UnfoldedUpperBoundsCondition*)bound)->bounds()));
+                else
+                    record.boolean("result", retval == Satisfied);
+                // without the TECHNIQUES keyword that starts the list
+                const auto used = usedTechniques();
+                record.words("techniques", used.substr(used.find(' ') + 1));
+            }
+
+            out << "\n";
 
-            std::cout << "Query is ";
+            out << "Query is ";
             if(options->statespaceexploration)
             {
                 retval = Satisfied;
@@ -135,32 +152,40 @@ namespace PetriEngine {
             //Print result
             if (retval == Unknown)
             {
-                std::cout << "MAYBE ";
+                out << "MAYBE ";
             }
             else if (retval == NotSatisfied) {
-                std::cout << "NOT ";
+                out << "NOT ";
             }
-            std::cout << "satisfied." << std::endl;
+            out << "satisfied.\n";
 
             if(options->cpnOverApprox)
-                std::cout << "\nSolved using CPN Approximation\n" << std::endl;
+                out << "\nSolved using CPN Approximation\n\n";
 
             if(showTrace && options->trace != TraceLevel::None && trace)
             {
                 if(stateset == nullptr)
                 {
-                    std::cout << "No trace could be generated" << std::endl;
+                    out << "No trace could be generated\n";
                 }
                 else
                 {
+                    // the verdict is shown before the trace, which goes to another stream
+                    out << std::flush;
                     printTrace(stateset, lastmarking);
                 }
             }
 
-            std::cout << std::endl;
+            out << "\n";
             return std::make_pair(retval, false);
         }
 
+        std::string ResultPrinter::usedTechniques() {
+            if(coloredExploration)
+                return techniquesColoredExploration;
+            return techniques + printTechniques();
+        }
+
         std::string ResultPrinter::printTechniques() {
             std::string out;
 
@@ -203,7 +228,8 @@ namespace PetriEngine {
 
         void ResultPrinter::printTrace(Structures::StateSetInterface* ss, size_t lastmarking)
         {
-            std::cerr << "Trace:\n<trace>\n";
+            buffered_output out(std::cerr, 1 << 16);
+            out << "Trace:\n<trace>\n";
             std::stack<size_t> transitions;
             size_t next = lastmarking;
             while(next != 0) // assume 0 is the index of the first marking.
@@ -215,26 +241,17 @@ namespace PetriEngine {
             }
 
             reducer = reducer ? reducer : builder->getReducer();
-            
-            if(reducer != nullptr)
-                reducer->initFire(std::cerr);
 
+            TraceExpander expander(reducer, ss->net());
+            std::vector<TraceStep> trace;
+            expander.initial(trace);
             while(transitions.size() > 0)
             {
-                size_t trans = transitions.top();
+                expander.fire(trace, transitions.top());
                 transitions.pop();
-                const auto& tname = ss->net().transitionNames()[trans];
-                std::cerr << "\t<transition id=\"" << *tname << "\" index=\"" << trans << "\">\n";
-
-                if(reducer != nullptr)
-                    reducer->tokenConsumption(std::cerr, *tname);
-
-                std::cerr << "\t</transition>\n";
-
-                if(reducer != nullptr)
-                    reducer->postFire(std::cerr, *tname);
             }
-            std::cerr << "</trace>\n" << std::endl;
+            expander.print(out, trace);
+            out << "</trace>\n\n";
         }
     }
 }
@@ -14,6 +14,7 @@
 #include "PetriEngine/PetriNet.h"
 #include "PetriEngine/PetriNetBuilder.h"
 #include "PetriParse/PNMLParser.h"
+#include "PetriEngine/Simplification/MurmurHash2.h"
 #include <queue>
 #include <set>
 #include <algorithm>
@@ -167,6 +168,7 @@ namespace PetriEngine {
     {
         Transition& trans = getTransition(t);
         assert(!trans.skip);
+        touchArcs(t);
         for(auto p : trans.post)
         {
             eraseTransition(parent->_places[p.place].producers, t);
@@ -187,6 +189,11 @@ namespace PetriEngine {
         ++_skippedPlaces;
         Place& pl = parent->_places[place];
         assert(!pl.skip);
+        touchPlace(place);
+        for(auto t : pl.consumers)
+            touchTransition(t);
+        for(auto t : pl.producers)
+            touchTransition(t);
         pl.skip = true;
         for(auto& t : pl.consumers)
         {
@@ -213,6 +220,7 @@ namespace PetriEngine {
         Place& place = parent->_places[p];
         Transition& trans = parent->_transitions[t];
 
+        touchArc(p, t);
         eraseTransition(place.consumers, t);
 
         Arc a;
@@ -228,6 +236,7 @@ namespace PetriEngine {
         Place& place = parent->_places[p];
         Transition& trans = parent->_transitions[t];
 
+        touchArc(p, t);
         eraseTransition(place.producers, t);
 
         Arc a;
@@ -238,6 +247,145 @@ namespace PetriEngine {
         assert(consistent());
     }
 
+    void Reducer::resetVersions()
+    {
+        _version = 1;
+        _lastPassStart = 0;
+        _placeVersion.assign(parent->_places.size(), _version);
+        _placeNeighbours.assign(parent->_places.size(), 0);
+        _transitionVersion.assign(parent->_transitions.size(), _version);
+        _transitionNeighbours.assign(parent->_transitions.size(), 0);
+        _passVersion.fill(0);
+        _unchangedVersion.fill(0);
+        _placeSignature.assign(parent->_places.size(), signature_t{});
+        _transitionSignature.assign(parent->_transitions.size(), signature_t{});
+    }
+
+    const Reducer::signature_t& Reducer::placeSignature(uint32_t place)
+    {
+        auto& sig = _placeSignature[place];
+        if(_placeVersion[place] <= sig._version)
+            return sig;
+        const auto& pl = parent->_places[place];
+        sig = signature_t{};
+        sig._version = _version;
+        for(auto t : pl.producers)
+            sig._pre |= 1ULL << (t & 63);
+        for(auto t : pl.consumers)
+            sig._post |= 1ULL << (t & 63);
+        return sig;
+    }
+
+    const Reducer::signature_t& Reducer::transitionSignature(uint32_t transition)
+    {
+        if(transition >= _transitionSignature.size())
+            _transitionSignature.resize(parent->_transitions.size());
+        auto& sig = _transitionSignature[transition];
+        if(transition < _transitionVersion.size() && _transitionVersion[transition] <= sig._version)
+            return sig;
+        const auto& trans = parent->_transitions[transition];
+        sig = signature_t{};
+        sig._version = _version;
+        // the padding of Arc is not hashed
+        _signatureBuffer.clear();
+        for(auto& arc : trans.pre)
+        {
+            _signatureBuffer.insert(_signatureBuffer.end(), {arc.place, arc.weight, arc.inhib});
+            sig._pre |= 1ULL << (arc.place & 63);
+        }
+        _signatureBuffer.push_back(std::numeric_limits<uint32_t>::max());
+        for(auto& arc : trans.post)
+        {
+            _signatureBuffer.insert(_signatureBuffer.end(), {arc.place, arc.weight});
+            sig._post |= 1ULL << (arc.place & 63);
+        }
+        sig._hash = MurmurHash64A(_signatureBuffer.data(), _signatureBuffer.size() * sizeof(uint32_t), 0);
+        return sig;
+    }
+
+    void Reducer::stampTransition(uint32_t transition)
+    {
+        if(transition >= _transitionVersion.size())
+        {
+            _transitionVersion.resize(parent->_transitions.size(), _version);
+            _transitionNeighbours.resize(parent->_transitions.size(), 0);
+        }
+        _transitionVersion[transition] = _version;
+    }
+
+    void Reducer::touchPlace(uint32_t place)
+    {
+        _placeVersion[place] = ++_version;
+        // the neighbours are already newer than any pass that could have rejected them
+        if(_placeNeighbours[place] > _lastPassStart)
+            return;
+        _placeNeighbours[place] = _version;
+        for(auto t : parent->_places[place].consumers)
+            stampTransition(t);
+        for(auto t : parent->_places[place].producers)
+            stampTransition(t);
+    }
+
+    void Reducer::touchTransition(uint32_t transition)
+    {
+        ++_version;
+        stampTransition(transition);
+        if(_transitionNeighbours[transition] > _lastPassStart)
+            return;
+        _transitionNeighbours[transition] = _version;
+        auto& trans = parent->_transitions[transition];
+        for(auto& arc : trans.pre)
+            _placeVersion[arc.place] = _version;
+        for(auto& arc : trans.post)
+            _placeVersion[arc.place] = _version;
+    }
+
+    void Reducer::touchArc(uint32_t place, uint32_t transition)
+    {
+        touchPlace(place);
+        touchTransition(transition);
+    }
+
+    void Reducer::touchArcs(uint32_t transition)
+    {
+        auto& trans = parent->_transitions[transition];
+        for(auto& arc : trans.pre)
+            touchPlace(arc.place);
+        for(auto& arc : trans.post)
+            touchPlace(arc.place);
+        touchTransition(transition);
+    }
+
+    Reducer::RulePass::RulePass(Reducer& reducer, Rule rule)
+    : _reducer(reducer), _rule(rule), _since(reducer._passVersion[rule]), _start(reducer._version)
+    {
+        _run = reducer._unchangedVersion[rule] != reducer._version;
+        if(_run)
+            reducer._lastPassStart = _start;
+    }
+
+    Reducer::RulePass::~RulePass()
+    {
+        // an interrupted pass has not examined all candidates
+        if(!_run || _reducer.hasTimedout())
+            return;
+        _reducer._passVersion[_rule] = _start;
+        if(_reducer._version == _start)
+            _reducer._unchangedVersion[_rule] = _start;
+    }
+
+    bool Reducer::neighbourhoodChangedSince(uint32_t place, size_t version) const
+    {
+        auto changed = [&](uint32_t t) {
+            return t >= _transitionVersion.size() || _transitionVersion[t] > version;
+        };
+        if(_placeVersion[place] > version)
+            return true;
+        auto& pl = parent->_places[place];
+        return std::any_of(pl.consumers.begin(), pl.consumers.end(), changed) ||
+               std::any_of(pl.producers.begin(), pl.producers.end(), changed);
+    }
+
     bool Reducer::consistent()
     {
 #ifndef NDEBUG
@@ -302,6 +450,8 @@ namespace PetriEngine {
 
     bool Reducer::ReducebyRuleA(uint32_t* placeInQuery) {
         // Rule A  - find transition t that has exactly one place in pre and post and remove one of the places (and t)
+        RulePass pass(*this, RuleA);
+        if(!pass) return false;
         bool continueReductions = false;
         const size_t numberoftransitions = parent->numberOfTransitions();
         for (uint32_t t = 0; t < numberoftransitions; t++) {
@@ -310,6 +460,7 @@ namespace PetriEngine {
 
             // we have already removed
             if(trans.skip) continue;
+            if(!pass.transitionChanged(t)) continue;
 
             // A2. we have more/less than one arc in pre or post
             // checked first to avoid out-of-bounds when looking up indexes.
@@ -357,25 +508,19 @@ namespace PetriEngine {
             // here we need to remember when a token is created in pPre (some
             // transition with an output in P is fired), t is fired instantly!.
             if(reconstructTrace) {
-                Place& pre = parent->_places[pPre];
-                auto tname = getTransitionName(t);
-                for(size_t pp : pre.producers)
-                {
-                    auto prefire = getTransitionName(pp);
-                    _postfire[*prefire].push_back(tname);
-                }
-                for(size_t i = 0; i < parent->initMarking()[pPre]; ++i)
-                {
-                    _initfire.push_back(tname);
-                }
+                for(auto pp : parent->_places[pPre].producers)
+                    fireAfter(pp, t, getOutArc(parent->_transitions[pp], pPre)->weight / w);
+                fireInitially(t, parent->initialMarking[pPre] / w);
             }
 
             for(auto& pPost : trans.post)
             {
                 // UA2. move the token for the initial marking, makes things simpler.
                 parent->initialMarking[pPost.place] += ((parent->initialMarking[pPre]/w) * pPost.weight);
+                touchPlace(pPost.place);
             }
             parent->initialMarking[pPre] = 0;
+            touchPlace(pPre);
 
             // Remove transition t and the place that has no tokens in m0
             // UA1. remove transition
@@ -409,6 +554,7 @@ namespace PetriEngine {
                         dest->weight += ((source.weight/w) * pPost.weight);
                     }
                     assert(dest->weight > 0);
+                    touchArc(pPost.place, _t);
                 }
             }
             // UA1. remove place
@@ -420,6 +566,8 @@ namespace PetriEngine {
     bool Reducer::ReducebyRuleB(uint32_t* placeInQuery, bool remove_deadlocks, bool remove_consumers) {
 
         // Rule B - find place p that has exactly one transition in pre and exactly one in post and remove the place
+        RulePass pass(*this, RuleB);
+        if(!pass) return false;
         bool continueReductions = false;
         const size_t numberofplaces = parent->numberOfPlaces();
         for (uint32_t p = 0; p < numberofplaces; p++) {
@@ -427,6 +575,8 @@ namespace PetriEngine {
             Place& place = parent->_places[p];
 
             if(place.skip) continue;    // already removed
+            // the rule looks at the places around the consumer
+            if(!pass.neighbourhoodChanged(p)) continue;
             // B5. dont mess up query
             if(placeInQuery[p] > 0)
                 continue;
@@ -536,21 +686,13 @@ namespace PetriEngine {
                 _ruleB++;
                 if(reconstructTrace)
                 {
-                    auto toutname = getTransitionName(tOut);
-                    auto tinname  = getTransitionName(tIn);
-                    for(size_t i = 0; i < multiplier; ++i)
-                    {
-                        _postfire[*toutname].push_back(tinname);
-                    }
-
-                    for(size_t i = 0; initm > 0 && i < initm / inArc->weight; ++i )
-                    {
-                        _initfire.push_back(tinname);
-                    }
+                    fireAfter(tOut, tIn, multiplier);
+                    fireInitially(tIn, initm);
                 }
 
                  // UB1. Remove place p
                 parent->initialMarking[p] = 0;
+                touchPlace(p);
                 // We need to remember that when tOut fires, tIn fires just after.
                 // this should fix the trace
 
@@ -573,6 +715,7 @@ namespace PetriEngine {
                         std::sort(parent->_places[arc.place].producers.begin(),
                                   parent->_places[arc.place].producers.end());
                     }
+                    touchArc(arc.place, tOut);
                 }
                 for (auto& arc : in.pre) { // remove tPost
                     if(arc.place == p)
@@ -594,8 +737,10 @@ namespace PetriEngine {
                         std::sort(parent->_places[arc.place].consumers.begin(),
                                   parent->_places[arc.place].consumers.end());
                     }
+                    touchArc(arc.place, tOut);
                 }
 
+                touchArc(p, tOut);
                 for(auto it = out.post.begin(); it != out.post.end(); ++it)
                 {
                     if(it->place == p)
@@ -626,6 +771,8 @@ namespace PetriEngine {
 
     bool Reducer::ReducebyRuleC(uint32_t* placeInQuery) {
         // Rule C - Places in parallel where one accumulates tokens while the others disable their post set
+        RulePass pass(*this, RuleC);
+        if(!pass) return false;
         bool continueReductions = false;
         _pflags.resize(parent->_places.size(), 0);
         std::fill(_pflags.begin(), _pflags.end(), 0);
@@ -646,6 +793,15 @@ namespace PetriEngine {
                     if (pout.skip) break;
                     auto pid_inner = parent->_transitions[tid_outer].post[aid_inner].place;
                     if (parent->_places[pid_inner].skip) continue;
+                    if (!pass.placeChanged(pid_outer) && !pass.placeChanged(pid_inner)) continue;
+                    {
+                        // the consumers of the removed place and the producers of the kept one must be subsets
+                        const auto& sout = placeSignature(pid_outer);
+                        const auto& sin = placeSignature(pid_inner);
+                        if (!(subsetOf(sin._post, sout._post) && subsetOf(sout._pre, sin._pre)) &&
+                            !(subsetOf(sout._post, sin._post) && subsetOf(sin._pre, sout._pre)))
+                            continue;
+                    }
 
                     for (size_t swp = 0; swp < 2; ++swp) {
                         if (hasTimedout()) return false;
@@ -758,6 +914,8 @@ namespace PetriEngine {
     bool Reducer::ReducebyRuleD(uint32_t* placeInQuery, bool all_reach, bool remove_loops_no_branch) {
         // Rule D - two transitions with the same pre and post and same inhibitor arcs
         // This does not alter the trace.
+        RulePass pass(*this, RuleD);
+        if(!pass) return false;
         bool continueReductions = false;
         _tflags.resize(parent->_transitions.size(), 0);
         std::fill(_tflags.begin(), _tflags.end(), 0);
@@ -777,6 +935,37 @@ namespace PetriEngine {
 
         }
 
+        if(!remove_loops_no_branch)
+        {
+            // Only identical transitions are parallel, so they are found in buckets of equal hashes
+            // rather than by comparing every pair of consumers of each place.
+            std::unordered_map<uint64_t, std::vector<uint32_t>> buckets;
+            for(uint32_t t = 0; t < parent->numberOfTransitions(); ++t)
+            {
+                if(hasTimedout()) return false;
+                const Transition& trans = parent->_transitions[t];
+                // D2. No inhibitors, and like above only consumers of some place are considered
+                if(trans.skip || trans.inhib || trans.pre.empty()) continue;
+                auto& bucket = buckets[transitionSignature(t)._hash];
+                auto parallel = std::find_if(bucket.begin(), bucket.end(), [&](uint32_t kept) {
+                    const Transition& other = parent->_transitions[kept];
+                    return (pass.transitionChanged(kept) || pass.transitionChanged(t)) &&
+                           other.pre == trans.pre && other.post == trans.post;
+                });
+                if(parallel == bucket.end())
+                {
+                    bucket.push_back(t);
+                    continue;
+                }
+                // UD1. Remove the transition with the larger index
+                continueReductions = true;
+                _ruleD++;
+                skipTransition(t);
+            }
+            assert(consistent());
+            return continueReductions;
+        }
+
         for(auto& op : parent->_places)
         for(size_t outer = 0; outer < op.consumers.size(); ++outer)
         {
@@ -798,6 +987,15 @@ namespace PetriEngine {
 
                 // D2. No inhibitors
                 if (tin.inhib) continue;
+                if (!pass.transitionChanged(touter) && !pass.transitionChanged(tinner)) continue;
+                {
+                    // the pre set of the kept transition and the post set of the removed one must be subsets
+                    const auto& sout = transitionSignature(touter);
+                    const auto& sin = transitionSignature(tinner);
+                    if (!(subsetOf(sout._pre, sin._pre) && subsetOf(sin._post, sout._post)) &&
+                        !(subsetOf(sin._pre, sout._pre) && subsetOf(sout._post, sin._post)))
+                        continue;
+                }
 
                 for (size_t swp = 0; swp < 2; ++swp) {
                     if(hasTimedout()) return false;
@@ -945,6 +1143,8 @@ namespace PetriEngine {
 
     bool Reducer::ReducebyRuleEP(uint32_t* placeInQuery) {
         // Rule P is an extension on Rule E
+        RulePass pass(*this, RuleEP);
+        if(!pass) return false;
         bool continueReductions = false;
         const size_t numberofplaces = parent->numberOfPlaces();
         for(uint32_t p = 0; p < numberofplaces; ++p)
@@ -952,6 +1152,7 @@ namespace PetriEngine {
             if(hasTimedout()) return false;
             Place& place = parent->_places[p];
             if(place.skip) continue;
+            if(!pass.placeChanged(p)) continue;
             // If more producers, we are guaranteed that one producer have a positive effect on the place, and as such E1 precondition is false
             if(place.producers.size() > place.consumers.size()) continue;
 
@@ -1032,6 +1233,8 @@ namespace PetriEngine {
     }
 
     bool Reducer::ReducebyRuleI(uint32_t* placeInQuery, bool remove_consumers) {
+        RulePass pass(*this, RuleI);
+        if(!pass) return false;
         bool reduced = false;
 
         auto result = relevant(placeInQuery, remove_consumers);
@@ -1049,6 +1252,8 @@ namespace PetriEngine {
     }
 
     bool Reducer::ReducebyRuleF(uint32_t* placeInQuery) {
+        RulePass pass(*this, RuleF);
+        if(!pass) return false;
         bool continueReductions = false;
         const size_t numberofplaces = parent->numberOfPlaces();
         for(uint32_t p = 0; p < numberofplaces; ++p)
@@ -1056,6 +1261,7 @@ namespace PetriEngine {
             if(hasTimedout()) return false;
             Place& place = parent->_places[p];
             if(place.skip) continue;
+            if(!pass.placeChanged(p)) continue;
             if(place.inhib) continue;
             if(place.producers.size() < place.consumers.size()) continue;
             if(placeInQuery[p] != 0) continue;
@@ -1104,6 +1310,8 @@ namespace PetriEngine {
         // transitions as long as the effect is maintained (Rule N). Similarly, we can remove
         // transitions that are always inhibited (Rule O). If all arcs to a place is removed,
         // then we remove the place too (Rule F).
+        RulePass pass(*this, RuleFNO);
+        if(!pass) return false;
         bool continueReductions = false;
         const size_t numberofplaces = parent->numberOfPlaces();
 
@@ -1112,6 +1320,7 @@ namespace PetriEngine {
             if (hasTimedout()) return false;
             Place& place = parent->_places[p];
             if (place.skip) continue;
+            if (!pass.placeChanged(p)) continue;
 
             bool removePlace = placeInQuery[p] == 0;
 
@@ -1198,6 +1407,7 @@ namespace PetriEngine {
                         else
                         {
                             outArc->weight -= inArc->weight;
+                            touchArc(p, cons);
                         }
                         skipInArc(p, cons);
 
@@ -1222,9 +1432,10 @@ namespace PetriEngine {
                 continueReductions = true;
                 _ruleF++;
             }
-            else if (inhibArcs == 0)
+            else if (inhibArcs == 0 && place.inhib)
             {
                 place.inhib = false;
+                touchPlace(p);
             }
         }
         assert(consistent());
@@ -1233,12 +1444,15 @@ namespace PetriEngine {
 
     bool Reducer::ReducebyRuleG(uint32_t* placeInQuery, bool remove_loops, bool remove_consumers) {
         if(!remove_loops) return false;
+        RulePass pass(*this, RuleG);
+        if(!pass) return false;
         bool continueReductions = false;
         for(uint32_t t = 0; t < parent->numberOfTransitions(); ++t)
         {
             if(hasTimedout()) return false;
             Transition& trans = parent->_transitions[t];
             if(trans.skip) continue;
+            if(!pass.transitionChanged(t)) continue;
             if(trans.inhib) continue;
             if(trans.pre.size() < trans.post.size()) continue;
             if(!remove_loops && trans.pre.size() == 0) continue;
@@ -1317,6 +1531,8 @@ namespace PetriEngine {
     {
         if(reconstructTrace)
             return false; // we don't know where in the loop the tokens are needed
+        RulePass pass(*this, RuleH);
+        if(!pass) return false;
         auto transok = [this](uint32_t t) -> uint32_t {
             auto& trans = parent->_transitions[t];
             if(_tflags[t] != 0)
@@ -1436,6 +1652,7 @@ namespace PetriEngine {
                         {
                             dest->weight += a.weight;
                         }
+                        touchArc(p1, p2it);
                         consistent();
                     }
                 }
@@ -1457,10 +1674,12 @@ namespace PetriEngine {
                         {
                             dest->weight += a.weight;
                         }
+                        touchArc(p1, p2it);
                         consistent();
                     }
                 }
                 parent->initialMarking[p1] += parent->initialMarking[p2];
+                touchPlace(p1);
                 skipPlace(p2);
                 assert(placeInQuery[p2] == 0);
             }
@@ -1547,12 +1766,15 @@ namespace PetriEngine {
     bool Reducer::ReducebyRuleJ(uint32_t* placeInQuery) {
         if(reconstructTrace)
             return false;
+        RulePass pass(*this, RuleJ);
+        if(!pass) return false;
         bool any = false;
         for(std::size_t p = 0; p < parent->numberOfPlaces(); ++p)
         {
             if(placeInQuery[p] > 0) continue;
             auto& place = parent->_places[p];
             if(place.skip) continue;
+            if(!pass.placeChanged(p)) continue;
             if(place.consumers.empty() && place.producers.empty())
                 continue;
             uint32_t mod = std::numeric_limits<uint32_t>::max();
@@ -1599,12 +1821,15 @@ namespace PetriEngine {
                 arc->weight /= mod;
             }
             parent->initialMarking[p] /= mod;
+            touchPlace(p);
             any = true;
         }
         return any;
     }
 
     bool Reducer::ReducebyRuleK(uint32_t *placeInQuery, bool remove_consumers) {
+        RulePass pass(*this, RuleK);
+        if(!pass) return false;
         bool reduced = false;
         auto opt = relevant(placeInQuery, remove_consumers);
         if (!opt)
@@ -1764,6 +1989,8 @@ namespace PetriEngine {
         // which can happen due to read arc behavior, t1 can be discarded.
         // Rule 2 from "Structural Reductions Revisited" by yann thierry-mieg
 
+        RulePass pass(*this, RuleL);
+        if(!pass) return false;
         bool continueReductions = false;
         if(parent->numberOfTransitions() == 0)
             return false;
@@ -1882,9 +2109,23 @@ namespace PetriEngine {
         return continueReductions;
     }
 
+    bool Reducer::initiallyEnabled(uint32_t t) const
+    {
+        const Transition& tran = parent->_transitions[t];
+        if (tran.skip)
+            return false;
+        for (const Arc& prearc : tran.pre) {
+            if (prearc.inhib != (prearc.weight > parent->initialMarking[prearc.place]))
+                return false;
+        }
+        return true;
+    }
+
     bool Reducer::ReducebyRuleM(uint32_t* placeInQuery) {
         // Dead places and transitions
         if (hasTimedout()) return false;
+        RulePass pass(*this, RuleM);
+        if(!pass) return false;
 
         // Use pflags and bits to keep track of places that can increase or decrease their number of tokens
         const uint8_t CAN_INC = 0b01;
@@ -1960,18 +2201,12 @@ namespace PetriEngine {
         };
 
         // Process initially enabled transitions
+        std::vector<uint8_t> enabled(parent->_transitions.size());
+        parallelFor(enabled.size(), [&](size_t t) {
+            enabled[t] = initiallyEnabled(t);
+        });
         for (uint32_t t = 0; t < parent->_transitions.size(); ++t) {
-            Transition& tran = parent->_transitions[t];
-            if (tran.skip)
-                continue;
-            bool enabled = true;
-            for (Arc& prearc : tran.pre) {
-                if (prearc.inhib != (prearc.weight > parent->initialMarking[prearc.place])) {
-                    enabled = false;
-                    break;
-                }
-            }
-            if (enabled) {
+            if (enabled[t]) {
                 processEnabled(t);
             }
         }
@@ -2034,6 +2269,8 @@ namespace PetriEngine {
         // If a place only has transitions with positive effect and no inhibitor arcs, then it is removed too (Rule F).
 
         if (hasTimedout()) return false;
+        RulePass pass(*this, RuleEFMNOP);
+        if(!pass) return false;
         bool continue_reductions = false;
         // Use two greatest bits of pflags to keep track of places that can increase or decrease their number of tokens.
         const uint8_t CAN_INC =  0b10000000u;
@@ -2117,18 +2354,12 @@ namespace PetriEngine {
         };
 
         // Process initially enabled transitions
+        std::vector<uint8_t> enabled(parent->_transitions.size());
+        parallelFor(enabled.size(), [&](size_t t) {
+            enabled[t] = initiallyEnabled(t);
+        });
         for (uint32_t t = 0; t < parent->_transitions.size(); ++t) {
-            Transition& tran = parent->_transitions[t];
-            if (tran.skip)
-                continue;
-            bool enabled = true;
-            for (Arc& prearc : tran.pre) {
-                if (prearc.inhib != (prearc.weight > parent->initialMarking[prearc.place])) {
-                    enabled = false;
-                    break;
-                }
-            }
-            if (enabled) {
+            if (enabled[t]) {
                 processEnabled(t);
             }
         }
@@ -2179,17 +2410,20 @@ namespace PetriEngine {
                 }
                 else
                 {
+                    touchPlace(p);
                     for(auto t : place.consumers)
                     {
                         auto& trans = getTransition(t);
                         auto inArc = getInArc(p, trans);
                         trans.pre.erase(inArc);
+                        touchTransition(t);
                     }
                     for(auto t : place.producers)
                     {
                         auto& trans = getTransition(t);
                         auto arc = getOutArc(trans, p);
                         trans.post.erase(arc);
+                        touchTransition(t);
                     }
                     continue_reductions |= (place.consumers.size() + place.producers.size()) > 0;
                     place.producers.clear();
@@ -2218,6 +2452,7 @@ namespace PetriEngine {
                         else if((_pflags[p] & CAN_INC) == 0 && inArc->weight > parent->initialMarking[p])
                         {
                             // inhibitor is useless
+                            touchArc(p, t);
                             trans.pre.erase(inArc);
                             place.consumers.erase(place.consumers.begin() + i);
                             ++_ruleP;
@@ -2247,6 +2482,7 @@ namespace PetriEngine {
                         auto out = getOutArc(trans, p);
                         if(out != std::end(trans.post))
                         {
+                            touchArc(p, t);
                             if(out->weight > inArc->weight)
                             {
                                 out->weight -= inArc->weight;
@@ -2297,8 +2533,8 @@ namespace PetriEngine {
     bool Reducer::ReducebyRuleQ(uint32_t* placeInQuery)
     {
         // Fire initially enabled transitions if they are the single consumer of their preset
-        if(reconstructTrace)
-            return false;
+        RulePass pass(*this, RuleQ);
+        if(!pass) return false;
         bool continueReductions = false;
 
         for (uint32_t t = 0; t < parent->numberOfTransitions(); ++t)
@@ -2359,16 +2595,15 @@ namespace PetriEngine {
             for (const Arc& prearc : tran.pre)
             {
                 parent->initialMarking[prearc.place] -= prearc.weight * k;
+                touchPlace(prearc.place);
             }
             for (const Arc& postarc : tran.post)
             {
                 parent->initialMarking[postarc.place] += postarc.weight * k;
+                touchPlace(postarc.place);
             }
             if(reconstructTrace)
-            {
-                for(size_t i = 0; i < k; ++i)
-                    _initfire.emplace_back(getTransitionName(t));
-            }
+                fireInitially(t, k);
 
             _ruleQ++;
             continueReductions = true;
@@ -2377,13 +2612,63 @@ namespace PetriEngine {
         return continueReductions;
     }
 
+    bool Reducer::ruleRCandidate(const uint32_t* placeInQuery, uint32_t pid, agglomeration_t& candidate)
+    {
+        const Place& place = parent->_places[pid];
+
+        if (place.skip || place.inhib || placeInQuery[pid] > 0 || place.producers.empty() || place.consumers.empty())
+            return false;
+
+        // Check that prod and cons are disjoint
+        const auto presize = place.producers.size();
+        const auto postsize = place.consumers.size();
+        uint32_t i = 0, j = 0;
+        while (i < presize && j < postsize)
+        {
+            if (place.producers[i] < place.consumers[j])
+                i++;
+            else if (place.consumers[j] < place.producers[i])
+                j++;
+            else
+                return false;
+        }
+
+        // Now we analyze consumers further
+        uint32_t maxConW = 0;
+        for (auto con : place.consumers)
+        {
+            // Consumers may not be inhibited and only consume from pid.
+            const Transition& tran = parent->_transitions[con];
+            if (tran.inhib || tran.pre.size() != 1)
+                return false;
+
+            // Post-set of consumers may not inhibit or appear in query.
+            for (const Arc& arc : tran.post)
+            {
+                if (placeInQuery[arc.place] > 0 || parent->_places[arc.place].inhib)
+                    return false;
+            }
+
+            // Find the greatest weight between pid and consumers
+            maxConW = std::max(maxConW, tran.pre[0].weight);
+        }
+        candidate._maxConsumerWeight = maxConW;
+        return true;
+    }
+
     bool Reducer::ReducebyRuleR(uint32_t* placeInQuery, uint32_t explosion_limiter)
     {
         // Rule R performs post agglomeration on a single producer, merging its firing with all consumers
         if(reconstructTrace) // current reconstruction concept does not extend to handle ruleS. The trivial cases are already dealt with in ruleA and ruleB
             return false;
+        RulePass pass(*this, RuleR);
+        if(!pass) return false;
         bool continueReductions = false;
 
+        PlaceChecks<agglomeration_t> candidates(*this, parent->numberOfPlaces(), [&](uint32_t pid, agglomeration_t& candidate) {
+            return ruleRCandidate(placeInQuery, pid, candidate);
+        });
+
         for (uint32_t pid = 0; pid < parent->numberOfPlaces(); pid++)
         {
             if (hasTimedout())
@@ -2394,59 +2679,17 @@ namespace PetriEngine {
             if (place.skip || place.inhib || placeInQuery[pid] > 0 || place.producers.empty() || place.consumers.empty())
                 continue;
 
-            // Check that prod and cons are disjoint
             const auto presize = place.producers.size();
             const auto postsize = place.consumers.size();
             const auto expl = presize*postsize;
             int64_t n_new_trans = 0;
             if(expl > std::max(explosion_limiter, (uint32_t)_skippedTransitions.size()))
                 continue;
-            bool ok = true;
-            uint32_t i = 0, j = 0;
-            while (i < presize && j < postsize)
-            {
-                if (place.producers[i] < place.consumers[j])
-                    i++;
-                else if (place.consumers[j] < place.producers[i])
-                    j++;
-                else
-                {
-                    ok = false;
-                    break;
-                }
-            }
-
-            if (!ok) continue;
-
-            // Now we analyze consumers further
-            uint32_t maxConW = 0;
-            for (auto con : place.consumers)
-            {
-                // Consumers may not be inhibited and only consume from pid.
-                const Transition& tran = parent->_transitions[con];
-                if (tran.inhib || tran.pre.size() != 1)
-                {
-                    ok = false;
-                    break;
-                }
 
-                // Post-set of consumers may not inhibit or appear in query.
-                for (const Arc& arc : tran.post)
-                {
-                    if (placeInQuery[arc.place] > 0 || parent->_places[arc.place].inhib)
-                    {
-                        ok = false;
-                        break;
-                    }
-                }
-
-                if (!ok) break;
-
-                // Find the greatest weight between pid and consumers
-                maxConW = std::max(maxConW, tran.pre[0].weight);
-            }
-
-            if (!ok) continue;
+            const auto* candidate = candidates(pid);
+            if (candidate == nullptr)
+                continue;
+            const uint32_t maxConW = candidate->_maxConsumerWeight;
 
             // Find producers for which we can fuse its firing with a consumer
             bool removedAllProducers = true;
@@ -2523,6 +2766,7 @@ namespace PetriEngine {
                         parent->_places[arc.place].addConsumer(id);
                     for(const auto& arc : newtran.post)
                         parent->_places[arc.place].addProducer(id);
+                    touchArcs(id);
                 }
 
                 skipTransition(prod_id);
@@ -2550,119 +2794,119 @@ namespace PetriEngine {
         return continueReductions;
     }
 
-    bool Reducer::ReducebyRuleS(uint32_t* placeInQuery, bool remove_consumers, bool remove_loops, bool allReach, uint32_t explosion_limiter) {
-        if(reconstructTrace) // current reconstruction concept does not extend to handle ruleS. The trivial cases are already dealt with in ruleA and ruleB
+    bool Reducer::ruleSCandidate(const uint32_t* placeInQuery, uint32_t pid, bool atomic_viable, agglomeration_t& candidate)
+    {
+        const Place &place = parent->_places[pid];
+
+        // T8/S8--1, T7/S7--1
+        if (place.skip || place.inhib || placeInQuery[pid] > 0 || place.producers.empty() ||
+            place.consumers.empty())
             return false;
-        bool continueReductions = false;
-        bool atomic_viable = allReach && remove_loops;
 
-        for (uint32_t pid = 0; pid < parent->numberOfPlaces(); pid++) {
-            if (hasTimedout())
+        // Check that prod and cons are disjoint
+        // T4/S4
+        const auto presize = place.producers.size();
+        const auto postsize = place.consumers.size();
+        uint32_t i = 0, j = 0;
+        while (i < presize && j < postsize) {
+            if (place.producers[i] < place.consumers[j])
+                i++;
+            else if (place.consumers[j] < place.producers[i])
+                j++;
+            else
                 return false;
+        }
 
-            const Place &place = parent->_places[pid];
-
-            // T8/S8--1, T7/S7--1
-            if (place.skip || place.inhib || placeInQuery[pid] > 0 || place.producers.empty() ||
-                place.consumers.empty())
-                continue;
-
-            int64_t n_added = 0;
+        // S5
+        auto& todo = candidate._todo;
+        todo.assign(postsize, true);
+        bool todoAllGood = true;
+        // S10, S11
+        auto& kIsAlwaysOne = candidate._kIsAlwaysOne;
+        kIsAlwaysOne.assign(postsize, true);
+
+        for (const auto& prod : place.producers){
+            Transition& producer = getTransition(prod);
+            // T8/S8--2, T6/S6
+            if(producer.inhib || producer.post.size() != 1)
+                return false;
 
-            // Check that prod and cons are disjoint
-            // T4/S4
-            const auto presize = place.producers.size();
-            const auto postsize = place.consumers.size();
-            bool ok = true;
-            uint32_t i = 0, j = 0;
-            while (i < presize && j < postsize) {
-                if (place.producers[i] < place.consumers[j])
-                    i++;
-                else if (place.consumers[j] < place.producers[i])
-                    j++;
-                else {
-                    ok = false;
-                    break;
+            uint32_t kw = getOutArc(producer, pid)->weight;
+            for (uint32_t n = 0; n < place.consumers.size(); n++) {
+                uint32_t w = getInArc(pid, getTransition(place.consumers[n]))->weight;
+                if (atomic_viable){
+                    // S3, S9
+                    if (parent->initialMarking[pid] >= w || kw % w != 0) {
+                        // Atomic is only valid for reachability without deadlock.
+                        todo[n] = false;
+                        todoAllGood = false;
+                    } else if (kw != w) {
+                        kIsAlwaysOne[n] = false;
+                    }
+                // T3, T9
+                } else if (parent->initialMarking[pid] >= w || kw != w) {
+                    return false;
                 }
             }
 
-            if (!ok) continue;
-
-            // S5
-            std::vector<bool> todo (postsize, true);
-            bool todoAllGood = true;
-            // S10, S11
-            std::vector<bool> kIsAlwaysOne (postsize, true);
-
-            for (const auto& prod : place.producers){
-                Transition& producer = getTransition(prod);
-                // T8/S8--2, T6/S6
-                if(producer.inhib || producer.post.size() != 1){
-                    ok = false;
-                    break;
-                }
+            // Check if we have any qualifying consumers left
+            if (!todoAllGood && std::lower_bound(todo.begin(), todo.end(), true) == todo.end())
+                return false;
 
-                uint32_t kw = getOutArc(producer, pid)->weight;
-                for (uint32_t n = 0; n < place.consumers.size(); n++) {
-                    uint32_t w = getInArc(pid, getTransition(place.consumers[n]))->weight;
-                    if (atomic_viable){
-                        // S3, S9
-                        if (parent->initialMarking[pid] >= w || kw % w != 0) {
-                            // Atomic is only valid for reachability without deadlock.
-                            todo[n] = false;
-                            todoAllGood = false;
-                        } else if (kw != w) {
-                            kIsAlwaysOne[n] = false;
+            for (const auto& prearc : producer.pre){
+                const auto& preplace = parent->_places[prearc.place];
+                // T8/S8--3, T7/S7--2
+                if (preplace.inhib || placeInQuery[prearc.place] > 0){
+                    return false;
+                } else if (!atomic_viable) {
+                    // For reachability we can do free agglomeration which avoids this condition
+                    // T5: Only transitions in place.producers are allowed in preplace.consumers.
+                    i = 0;
+                    j = 0;
+                    while (i < preplace.consumers.size() && j < place.producers.size()) {
+                        if (preplace.consumers[i] > place.producers[j])
+                            j++;
+                        else if (preplace.consumers[i] == place.producers[j]){
+                            i++;
+                            j++;
+                        } else {
+                            return false;
                         }
-                    // T3, T9
-                    } else if (parent->initialMarking[pid] >= w || kw != w) {
-                        ok = false;
-                        break;
+                    }
+                    if (i < preplace.consumers.size()){
+                        // In case the while was exited by reaching the end of place.producers
+                        return false;
                     }
                 }
+            }
+        }
+        return true;
+    }
 
-                if (!ok) break;
+    bool Reducer::ReducebyRuleS(uint32_t* placeInQuery, bool remove_consumers, bool remove_loops, bool allReach, uint32_t explosion_limiter) {
+        if(reconstructTrace) // current reconstruction concept does not extend to handle ruleS. The trivial cases are already dealt with in ruleA and ruleB
+            return false;
+        RulePass pass(*this, RuleS);
+        if(!pass) return false;
+        bool continueReductions = false;
+        bool atomic_viable = allReach && remove_loops;
 
-                // Check if we have any qualifying consumers left
-                if (!todoAllGood && std::lower_bound(todo.begin(), todo.end(), true) == todo.end()){
-                    ok = false;
-                    break;
-                }
+        PlaceChecks<agglomeration_t> candidates(*this, parent->numberOfPlaces(), [&](uint32_t pid, agglomeration_t& candidate) {
+            return ruleSCandidate(placeInQuery, pid, atomic_viable, candidate);
+        });
 
-                for (const auto& prearc : producer.pre){
-                    const auto& preplace = parent->_places[prearc.place];
-                    // T8/S8--3, T7/S7--2
-                    if (preplace.inhib || placeInQuery[prearc.place] > 0){
-                        ok = false;
-                        break;
-                    } else if (!atomic_viable) {
-                        // For reachability we can do free agglomeration which avoids this condition
-                        // T5: Only transitions in place.producers are allowed in preplace.consumers.
-                        // Reuses i and j that are done being used but still in scope.
-                        i = 0;
-                        j = 0;
-                        while (i < preplace.consumers.size() && j < place.producers.size()) {
-                            if (preplace.consumers[i] > place.producers[j])
-                                j++;
-                            else if (preplace.consumers[i] == place.producers[j]){
-                                i++;
-                                j++;
-                            } else {
-                                ok = false;
-                                break;
-                            }
-                        }
-                        if (i < preplace.consumers.size()){
-                            // In case the while was exited by reaching the end of place.producers
-                            ok = false;
-                        }
-                    }
-                    if (!ok) break;
-                }
-                if (!ok) break;
-            }
+        for (uint32_t pid = 0; pid < parent->numberOfPlaces(); pid++) {
+            if (hasTimedout())
+                return false;
+
+            const Place &place = parent->_places[pid];
+            const auto* candidate = candidates(pid);
+            if (candidate == nullptr)
+                continue;
 
-            if (!ok) continue;
+            int64_t n_added = 0;
+            const auto& todo = candidate->_todo;
+            const auto& kIsAlwaysOne = candidate->_kIsAlwaysOne;
             std::vector<uint32_t> originalConsumers = place.consumers;
             std::vector<uint32_t> originalProducers = place.producers;
             for (uint32_t n = 0; n < originalConsumers.size(); n++)
@@ -2672,7 +2916,7 @@ namespace PetriEngine {
                 if (!todo[n])
                     continue;
 
-                ok = true;
+                bool ok = true;
                 Transition &consumer = getTransition(originalConsumers[n]);
                 // S10, S11
                 if (atomic_viable && !kIsAlwaysOne[n]) {
@@ -2761,6 +3005,7 @@ namespace PetriEngine {
                             }
                             for(const auto& arc : newtran.post)
                                 parent->_places[arc.place].addProducer(id);
+                            touchArcs(id);
                         }
                     } else {
                         // Rule T updates
@@ -2808,6 +3053,7 @@ namespace PetriEngine {
 
                         for(const auto& arc : newtran.post)
                             parent->_places[arc.place].addProducer(id);
+                        touchArcs(id);
                     }
                 }
                 skipTransition(originalConsumers[n]);
@@ -2835,13 +3081,15 @@ namespace PetriEngine {
     }
 
     void Reducer::Reduce(QueryPlaceAnalysisContext& context, int enablereduction, bool reconstructTrace, int timeout, bool remove_loops,
-            bool all_reach, bool all_ltl, bool contains_next, std::vector<uint32_t>& reduction) {
+            bool all_reach, bool all_ltl, bool contains_next, std::vector<uint32_t>& reduction, uint32_t threads) {
         this->_timeout = timeout;
+        _threads = std::max<uint32_t>(threads, 1);
         _timer = std::chrono::high_resolution_clock::now();
         assert(consistent());
         constexpr uint32_t explosion_limiter = 6;
 
         this->reconstructTrace = reconstructTrace;
+        resetVersions();
         if (enablereduction == 2) { // for k-boundedness checking only rules A, D and H are applicable
             bool changed = true;
             while (changed && !hasTimedout()) {
@@ -3011,53 +3259,117 @@ restart:
 
     void Reducer::saveInitialNet() {
         // Called by PetriNetBuilder::saveInitialNet()
-        _transitionsBeforeReduction.reserve(parent->_transitions.size());
-        uint32_t i = 0;
-        for (const auto& trans : parent->_transitions) {
-            for (const auto& arc : trans.pre) {
+        _originalTransitions.resize(parent->_transitions.size());
+        for (const auto& [name, id] : parent->_transitionnames)
+            _originalTransitions[id] = name;
+        std::vector<shared_const_string> places(parent->_places.size());
+        for (const auto& [name, id] : parent->_placenames)
+            places[id] = name;
+        _originalPresets.resize(parent->_transitions.size());
+        for (size_t t = 0; t < parent->_transitions.size(); ++t) {
+            for (const auto& arc : parent->_transitions[t].pre) {
                 if (!arc.inhib)
-                    _transitionsBeforeReduction[*getTransitionName(i)].emplace_back(getPlaceName(arc.place), arc.weight);
+                    _originalPresets[t].emplace_back(places[arc.place], arc.weight);
             }
-            ++i;
         }
+        _triggeredRewrites.resize(parent->_transitions.size());
     }
 
-    void Reducer::postFire(std::ostream& out, const std::string& transition) const
+    void Reducer::fireInitially(uint32_t transition, uint32_t count)
     {
-        auto it = _postfire.find(transition);
-        if (it != std::end(_postfire))
-        {
-            for (const auto& el : it->second)
-            {
-                out << "\t<transition id=\"" << *el << "\">\n";
-                tokenConsumption(out, *el);
-                out << "\t</transition>\n";
-                postFire(out, *el);
-            }
+        if (count == 0) return;
+        _initialRewrites.push_back(_rewrites.size());
+        _rewrites.push_back({TraceStep::none, transition, count});
+    }
+
+    void Reducer::fireAfter(uint32_t trigger, uint32_t transition, uint32_t count)
+    {
+        if (count == 0) return;
+        if (trigger >= _triggeredRewrites.size())
+            _triggeredRewrites.resize(trigger + 1);
+        _triggeredRewrites[trigger].push_back(_rewrites.size());
+        _rewrites.push_back({trigger, transition, count});
+    }
+
+    TraceExpander::TraceExpander(const Reducer* reducer, const PetriNet& net)
+    : _reducer(reducer), _net(net), _original(net.numberOfTransitions(), TraceStep::none)
+    {
+        if (_reducer == nullptr || _reducer->_originalTransitions.empty())
+            return;
+        shared_name_index_map index;
+        for (uint32_t t = 0; t < _reducer->_originalTransitions.size(); ++t)
+            if (_reducer->_originalTransitions[t])
+                index.emplace(_reducer->_originalTransitions[t], t);
+        for (uint32_t t = 0; t < net.numberOfTransitions(); ++t) {
+            auto it = index.find(net.transitionNames()[t]);
+            if (it != index.end())
+                _original[t] = it->second;
         }
     }
 
-    void Reducer::initFire(std::ostream& out) const
+    void TraceExpander::initial(std::vector<TraceStep>& trace) const
     {
-        for (const auto& init : _initfire)
-        {
-            out << "\t<transition id=\"" << *init << "\">\n";
-            tokenConsumption(out, *init);
-            out << "\t</transition>\n";
-            postFire(out, *init);
+        if (_reducer == nullptr) return;
+        for (auto r : _reducer->_initialRewrites) {
+            const auto& rewrite = _reducer->_rewrites[r];
+            for (uint32_t i = 0; i < rewrite._count; ++i)
+                expand(trace, rewrite._transition, r, TraceStep::none);
         }
     }
 
-    void Reducer::tokenConsumption(std::ostream& out, const std::string& transition) const
+    void TraceExpander::fire(std::vector<TraceStep>& trace, uint32_t transition) const
     {
-        auto it = _transitionsBeforeReduction.find(transition);
-        if (it != std::end(_transitionsBeforeReduction))
-        {
-            for (const auto& arc : it->second)
-            {
-                out << arc;
+        if (_original[transition] == TraceStep::none)
+            trace.push_back({TraceStep::none, transition});
+        else
+            expand(trace, _original[transition], _reducer->_rewrites.size(), transition);
+    }
+
+    void TraceExpander::expand(std::vector<TraceStep>& trace, uint32_t transition, size_t before, uint32_t reduced) const
+    {
+        // depth first, a firing followed by everything it triggers, from a stack of (transition, time) left to fire
+        std::vector<std::pair<uint32_t, size_t>> stack{{transition, before}};
+        while (!stack.empty()) {
+            auto [t, time] = stack.back();
+            stack.pop_back();
+            trace.push_back({t, reduced});
+            reduced = TraceStep::none;
+            if (t >= _reducer->_triggeredRewrites.size())
+                continue;
+            const auto& triggered = _reducer->_triggeredRewrites[t];
+            auto end = std::lower_bound(triggered.begin(), triggered.end(), time);
+            for (auto it = std::make_reverse_iterator(end); it != triggered.rend(); ++it) {
+                const auto& rewrite = _reducer->_rewrites[*it];
+                for (uint32_t i = 0; i < rewrite._count; ++i)
+                    stack.emplace_back(rewrite._transition, *it);
             }
         }
     }
 
+    void TraceExpander::print(std::ostream& out, const TraceStep& step) const
+    {
+        const auto& name = step.original == TraceStep::none
+            ? _net.transitionNames()[step.reduced]
+            : _reducer->_originalTransitions[step.original];
+        out << "\t<transition id=\"" << *name << "\"";
+        if (step.reduced != TraceStep::none)
+            out << " index=\"" << step.reduced << "\"";
+        out << ">\n";
+        printTokens(out, step);
+        out << "\t</transition>\n";
+    }
+
+    void TraceExpander::printTokens(std::ostream& out, const TraceStep& step) const
+    {
+        if (step.original != TraceStep::none)
+            for (const auto& arc : _reducer->_originalPresets[step.original])
+                out << arc;
+    }
+
+    void TraceExpander::print(std::ostream& out, const std::vector<TraceStep>& trace) const
+    {
+        for (const auto& step : trace)
+            print(out, step);
+    }
+
 } //PetriNet namespace
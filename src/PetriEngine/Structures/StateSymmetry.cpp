@@ -0,0 +1,275 @@
+#include "PetriEngine/Structures/StateSymmetry.h"
+#include "PetriEngine/PQL/Visitor.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace PetriEngine {
+    namespace Structures {
+
+        namespace {
+            // Checks that a query is mapped onto itself by a permutation of the places. The check is syntactic
+            // and conservative: sums, products, conjunctions of comparisons and upper bounds may be permuted
+            // internally, every other subformula must be mapped onto itself.
+            class SymmetricQueryVisitor : public PQL::Visitor {
+            private:
+                const std::vector<uint32_t>& _permutation;
+                bool _symmetric = true;
+
+                template<typename T>
+                bool same_after(std::vector<T> before, std::vector<T> after) {
+                    std::sort(before.begin(), before.end());
+                    std::sort(after.begin(), after.end());
+                    return before == after;
+                }
+
+                void visit_commutative(const PQL::CommutativeExpr* element) {
+                    std::vector<uint32_t> before, after;
+                    for (auto& p : element->places()) {
+                        before.push_back(p.first);
+                        after.push_back(_permutation[p.first]);
+                    }
+                    _symmetric = _symmetric && same_after(std::move(before), std::move(after));
+                    for (auto& e : element->expressions())
+                        Visitor::visit(this, e);
+                }
+
+            public:
+                SymmetricQueryVisitor(const std::vector<uint32_t>& permutation) : _permutation(permutation) {
+                }
+
+                bool symmetric() const {
+                    return _symmetric;
+                }
+
+            protected:
+                void _accept(const PQL::NotCondition* element) override {
+                    Visitor::visit(this, (*element)[0]);
+                }
+
+                void _accept(const PQL::LogicalCondition* element) override {
+                    for (auto& e : *element)
+                        Visitor::visit(this, e);
+                }
+
+                void _accept(const PQL::CompareCondition* element) override {
+                    Visitor::visit(this, (*element)[0]);
+                    Visitor::visit(this, (*element)[1]);
+                }
+
+                void _accept(const PQL::CompareConjunction* element) override {
+                    std::vector<std::tuple<uint32_t, uint32_t, uint32_t>> before, after;
+                    for (auto& c : *element) {
+                        before.emplace_back(c._place, c._lower, c._upper);
+                        after.emplace_back(_permutation[c._place], c._lower, c._upper);
+                    }
+                    _symmetric = _symmetric && same_after(std::move(before), std::move(after));
+                }
+
+                void _accept(const PQL::UnfoldedUpperBoundsCondition* element) override {
+                    std::vector<std::pair<uint32_t, double>> before, after;
+                    for (auto& p : element->places()) {
+                        before.emplace_back(p._place, p._max);
+                        after.emplace_back(_permutation[p._place], p._max);
+                    }
+                    _symmetric = _symmetric && same_after(std::move(before), std::move(after));
+                }
+
+                void _accept(const PQL::PlusExpr* element) override {
+                    visit_commutative(element);
+                }
+
+                void _accept(const PQL::MultiplyExpr* element) override {
+                    visit_commutative(element);
+                }
+
+                void _accept(const PQL::SubtractExpr* element) override {
+                    for (auto& e : element->expressions())
+                        Visitor::visit(this, e);
+                }
+
+                void _accept(const PQL::MinusExpr* element) override {
+                    Visitor::visit(this, (*element)[0]);
+                }
+
+                void _accept(const PQL::UnfoldedIdentifierExpr* element) override {
+                    _symmetric = _symmetric && _permutation[element->offset()] == (uint32_t)element->offset();
+                }
+
+                void _accept(const PQL::LiteralExpr*) override {
+                }
+
+                void _accept(const PQL::DeadlockCondition*) override {
+                }
+
+                void _accept(const PQL::BooleanCondition*) override {
+                }
+
+                // anything else (temporal operators in particular) is not analysed
+                void _accept(const PQL::SimpleQuantifierCondition*) override {
+                    _symmetric = false;
+                }
+
+                void _accept(const PQL::UntilCondition*) override {
+                    _symmetric = false;
+                }
+
+                void _accept(const PQL::PathQuant*) override {
+                    _symmetric = false;
+                }
+
+                void _accept(const PQL::PathSelectCondition*) override {
+                    _symmetric = false;
+                }
+
+                void _accept(const PQL::PathSelectExpr*) override {
+                    _symmetric = false;
+                }
+            };
+        }
+
+        StateSymmetry::StateSymmetry(const PetriNet& net, const std::vector<place_blocks_t>& candidates,
+                                     const std::vector<PQL::Condition_ptr>& queries)
+        : _net(net) {
+            if (candidates.empty())
+                return;
+            shared_name_index_map index;
+            for (uint32_t p = 0; p < _net.numberOfPlaces(); ++p)
+                index[_net.placeNames()[p]] = p;
+
+            std::vector<uint32_t> identity(_net.numberOfPlaces());
+            std::iota(identity.begin(), identity.end(), 0);
+            std::vector<signature_t> signatures;
+
+            for (const auto& blocks : candidates) {
+                if (blocks.size() < 2)
+                    continue;
+                // a slot is kept if its place exists for every color, and dropped (e.g. by the color fixpoint or
+                // the structural reductions) if it exists for none of them
+                group_t group;
+                group._blocks = blocks.size();
+                std::vector<std::vector<uint32_t>> places(blocks.size());
+                std::vector<bool> used(_net.numberOfPlaces(), false);
+                bool ok = true;
+                for (size_t s = 0; ok && s < blocks[0].size(); ++s) {
+                    size_t present = 0;
+                    for (size_t b = 0; b < blocks.size(); ++b) {
+                        assert(blocks[b].size() == blocks[0].size());
+                        if (!blocks[b][s])
+                            continue;
+                        auto it = index.find(blocks[b][s]);
+                        if (it == index.end())
+                            continue;
+                        ++present;
+                        ok = ok && !used[it->second];
+                        used[it->second] = true;
+                        places[b].push_back(it->second);
+                    }
+                    if (present != 0 && present != blocks.size())
+                        ok = false;
+                }
+                if (!ok || places[0].empty())
+                    continue;
+                group._slots = places[0].size();
+                for (auto& block : places)
+                    group._places.insert(group._places.end(), block.begin(), block.end());
+
+                if (signatures.empty()) {
+                    signatures.reserve(_net.numberOfTransitions());
+                    for (uint32_t t = 0; t < _net.numberOfTransitions(); ++t)
+                        signatures.push_back(signature(t, identity));
+                    std::sort(signatures.begin(), signatures.end());
+                }
+
+                // swapping the first two blocks and rotating all blocks generate every permutation of the blocks
+                auto swap = identity;
+                auto rotate = identity;
+                for (uint32_t s = 0; s < group._slots; ++s) {
+                    std::swap(swap[places[0][s]], swap[places[1][s]]);
+                    for (uint32_t b = 0; b < group._blocks; ++b)
+                        rotate[places[b][s]] = places[(b + 1) % group._blocks][s];
+                }
+                if (!is_automorphism(swap, signatures, queries))
+                    continue;
+                if (group._blocks > 2 && !is_automorphism(rotate, signatures, queries))
+                    continue;
+                _groups.push_back(std::move(group));
+            }
+        }
+
+        StateSymmetry::signature_t StateSymmetry::signature(uint32_t transition, const std::vector<uint32_t>& permutation) const {
+            signature_t result;
+            auto [pre, pre_end] = _net.preset(transition);
+            for (; pre != pre_end; ++pre)
+                result.emplace_back(pre->inhibitor ? 1 : 0, permutation[pre->place], pre->tokens);
+            auto [post, post_end] = _net.postset(transition);
+            for (; post != post_end; ++post)
+                result.emplace_back(2, permutation[post->place], post->tokens);
+            if (!_net.controllable(transition))
+                result.emplace_back(3, 0, 0);
+            std::sort(result.begin(), result.end());
+            return result;
+        }
+
+        bool StateSymmetry::is_automorphism(const std::vector<uint32_t>& permutation, const std::vector<signature_t>& signatures,
+                                            const std::vector<PQL::Condition_ptr>& queries) const {
+            for (uint32_t p = 0; p < _net.numberOfPlaces(); ++p) {
+                if (_net.initial(permutation[p]) != _net.initial(p))
+                    return false;
+            }
+            for (auto& q : queries) {
+                SymmetricQueryVisitor visitor(permutation);
+                try {
+                    PQL::Visitor::visit(visitor, q);
+                } catch (const base_error&) {
+                    return false;
+                }
+                if (!visitor.symmetric())
+                    return false;
+            }
+            std::vector<signature_t> image;
+            image.reserve(_net.numberOfTransitions());
+            for (uint32_t t = 0; t < _net.numberOfTransitions(); ++t)
+                image.push_back(signature(t, permutation));
+            std::sort(image.begin(), image.end());
+            return image == signatures;
+        }
+
+        void StateSymmetry::canonicalize(MarkVal* marking) const {
+            for (const auto& group : _groups) {
+                const auto slots = group._slots;
+                const auto* places = group._places.data();
+                _order.resize(group._blocks);
+                std::iota(_order.begin(), _order.end(), 0);
+                std::sort(_order.begin(), _order.end(), [&](uint32_t a, uint32_t b) {
+                    for (uint32_t s = 0; s < slots; ++s) {
+                        const auto va = marking[places[a * slots + s]];
+                        const auto vb = marking[places[b * slots + s]];
+                        if (va != vb)
+                            return va < vb;
+                    }
+                    return false;
+                });
+                _scratch.resize(group._places.size());
+                for (uint32_t b = 0; b < group._blocks; ++b) {
+                    for (uint32_t s = 0; s < slots; ++s)
+                        _scratch[b * slots + s] = marking[places[_order[b] * slots + s]];
+                }
+                for (size_t i = 0; i < group._places.size(); ++i)
+                    marking[places[i]] = _scratch[i];
+            }
+        }
+
+        void StateSymmetry::spread(std::vector<uint32_t>& bounds) const {
+            for (const auto& group : _groups) {
+                for (uint32_t s = 0; s < group._slots; ++s) {
+                    uint32_t bound = 0;
+                    for (uint32_t b = 0; b < group._blocks; ++b)
+                        bound = std::max(bound, bounds[group._places[b * group._slots + s]]);
+                    for (uint32_t b = 0; b < group._blocks; ++b)
+                        bounds[group._places[b * group._slots + s]] = bound;
+                }
+            }
+        }
+    }
+}
@@ -27,6 +27,7 @@
 #include "PetriEngine/Synthesis/GamePORSuccessorGenerator.h"
 #include "PetriEngine/options.h"
 #include "utils/stopwatch.h"
+#include "utils/output.h"
 #include "PetriEngine/Synthesis/GameSuccessorGenerator.h"
 #include "PetriEngine/PQL/PredicateCheckers.h"
 #include "PetriEngine/PQL/Evaluation.h"
@@ -339,8 +340,10 @@ namespace PetriEngine {
         }
 #endif
 
-        void SimpleSynthesis::print_strategy(std::ostream& out) {
+        void SimpleSynthesis::print_strategy(std::ostream& target) {
             std::stack<size_t> missing;
+            // the strategy is passed on to the target in blocks rather than a few bytes at a time
+            buffered_output out(target, 1 << 16);
 
             Structures::State parent(_net.makeInitialMarking());
             Structures::State working(_net.makeInitialMarking());
@@ -348,7 +351,7 @@ namespace PetriEngine {
                 auto res = _stateset.add(working);
                 missing.emplace(res.second);
             }
-            if (&out == &std::cout) out << "\n##BEGIN STRATEGY##\n";
+            if (&target == &std::cout) out << "\n##BEGIN STRATEGY##\n";
             out << "{\n";
             GameSuccessorGenerator generator(_net);
             bool first_marking = true;
@@ -425,7 +428,7 @@ namespace PetriEngine {
                 }
             }
             out << "\n}\n";
-            if (&out == &std::cout)
+            if (&target == &std::cout)
                 out << "##END STRATEGY##\n";
         }
 
@@ -30,6 +30,7 @@
 #include "PetriEngine/PQL/PlaceUseVisitor.h"
 #include "PetriEngine/PQL/Evaluation.h"
 #include "utils/stopwatch.h"
+#include "utils/output.h"
 
 
 namespace PetriEngine {
@@ -413,28 +414,20 @@ namespace PetriEngine {
 
         void TARReachabilitySearch::printTrace(trace_t& stack)
         {
-            std::cerr << "Trace:\n<trace>\n";
-
-            if(_reducer != NULL)
-                _reducer->initFire(std::cerr);
+            buffered_output out(std::cerr, 1 << 16);
+            out << "Trace:\n<trace>\n";
 
+            TraceExpander expander(_reducer, _net);
+            std::vector<TraceStep> trace;
+            expander.initial(trace);
             for(auto& t : stack)
             {
                 if(t.get_edge_cnt() == 0) break;
-                auto& tname = _net.transitionNames()[t.get_edge_cnt() - 1];
-                std::cerr << "\t<transition id=\"" << *tname << "\" index=\"" << (t.get_edge_cnt() - 1) <<  "\">\n";
-
-                if(_reducer != nullptr)
-                    _reducer->tokenConsumption(std::cerr, *tname);
-
-                std::cerr << "\t</transition>\n";
-
-                if(_reducer != nullptr)
-                    _reducer->postFire(std::cerr, *tname);
-
+                expander.fire(trace, t.get_edge_cnt() - 1);
             }
+            expander.print(out, trace);
 
-            std::cerr << "</trace>\n" << std::endl;
+            out << "</trace>\n\n";
         }
         void TARReachabilitySearch::reachable(std::vector<std::shared_ptr<PQL::Condition> >& queries,
                                               std::vector<ResultPrinter::Result>& results,
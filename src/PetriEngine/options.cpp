@@ -177,6 +177,8 @@ void printHelp() {
         "  --partition-timeout <timeout>        Timeout for color partitioning in seconds (default 5)\n"
         "  -l, --lpsolve-timeout <timeout>      LPSolve timeout in seconds, default 10\n"
         "  -p, --disable-partial-order          Disable partial order reduction (stubborn sets)\n"
+        "  --locality-order                     Number the places of the net such that places sharing transitions are\n"
+        "                                       adjacent in the marking (reverse Cuthill-McKee)\n"
         "  --ltl-por <type>                     Select partial order method to use with LTL engine (default automaton).\n"
         "                                       - automaton  apply Büchi-guided stubborn set method (Jensen et al., 2021).\n"
         "                                       - classic    classic stubborn set method (Valmari, 1990).\n"
@@ -191,6 +193,11 @@ void printHelp() {
         "                                       - aut            Automaton-driven heuristic. Guides search toward states\n"
         "                                                        that satisfy progressing formulae in the automaton.\n"
         "                                       - fire-count     Prioritises transitions that were fired less often.\n"
+        "                                       - potency        Automaton-driven heuristic weighted by transition potencies\n"
+        "                                                        learned during the search, seeded by LP unless\n"
+        "                                                        --init-potency-timeout is 0.\n"
+        "  --ltl-lasso                          Once an accepting state is found, guide the LTL search back toward\n"
+        "                                       its marking to close the accepting cycle quickly.\n"
         "  -a, --siphon-trap <timeout>          Siphon-Trap analysis timeout in seconds (default 0)\n"
         "      --siphon-depth <place count>     Search depth of siphon (default 0, which counts all places)\n"
         "  -n, --no-statistics                  Do not display any statistics (default is to display it)\n"
@@ -204,6 +211,16 @@ void printHelp() {
         "                                       - ndfs      Nested depth first search algorithm\n"
         "                                       - tarjan    On-the-fly Tarjan's algorithm\n"
         "                                       - none      Run preprocessing steps only.\n"
+        "  --ltl-share-markings                 Verify all LTL queries over one marking graph. The successors of each\n"
+        "                                       marking are computed once and kept for all formulae, each formula is\n"
+        "                                       checked on its own product with the graph and reported when decided.\n"
+        "                                       Uses more memory, and disables partial order reduction and heuristics.\n"
+        "                                       Formulae verified with --trace and hyper-LTL are searched on their own.\n"
+        "  --ltl-terminal-reach                 Decide LTL formulae with terminal Büchi automata by reachability of an\n"
+        "                                       accepting state, using the search strategy given by -s (BFS, DFS, RDFS\n"
+        "                                       or best-first on --ltl-heur) instead of Tarjan/NDFS. Disabled by --noweak.\n"
+        "  --ltl-stack-memory <MB>              Keep at most <MB> megabytes of the Tarjan search stacks in memory,\n"
+        "                                       paging the least recently used segments out to a temporary file.\n"
         "  --noweak                             Disable optimizations for weak Büchi automata when doing \n"
         "                                       LTL model checking. Not recommended.\n"
         "  --noreach                            Force use of CTL/LTL engine, even when queries are reachability.\n"
@@ -214,8 +231,20 @@ void printHelp() {
         "  --disable-cfp                        Disable the computation of possible colors in the Petri Net (CPN only)\n"
         "  --disable-partitioning               Disable the partitioning of colors in the Petri Net (CPN only)\n"
         "  --disable-symmetry-vars              Disable search for symmetric variables (CPN only)\n"
+        "  --disable-partial-unfolding          Also unfold what is outside the cone of influence of reachability\n"
+        "                                       queries; the cone is otherwise used even with -R 0 (CPN only)\n"
+        "  --disable-state-symmetry             Disable storing one marking per orbit of the scalar-set color\n"
+        "                                       symmetries in reachability search; always off with traces (CPN only)\n"
+        "  --unfold-cache <dir>                 Reuse the reduced and unfolded net of an earlier run on the same model,\n"
+        "                                       options and preserved query atoms, storing it in <dir> (CPN only)\n"
+        "  --explore-colored                    Answer EF/AG queries by exploring the colored state space directly,\n"
+        "                                       without unfolding; other queries and those not answered in time are\n"
+        "                                       unfolded (CPN only). The exploration is breadth-first with -s BFS and\n"
+        "                                       depth-first for every other strategy\n"
+        "  --explore-colored-timeout <timeout>  Time in seconds shared by the queries explored with --explore-colored\n"
+        "                                       (default 30)\n"
 #ifdef VERIFYPN_MC_Simplification
-        "  -z, --cores <number of cores>        Number of cores to use (currently only query simplification)\n"
+        "  -z, --cores <number of cores>        Number of cores to use (model parsing, query simplification, unfolding and reduction)\n"
 #endif
         "  -tar, --trace-abstraction            Enables Trace Abstraction Refinement for reachability properties\n"
         "  --max-intervals <interval count>     The max amount of intervals kept when computing the color fixpoint\n"
@@ -224,6 +253,9 @@ void printHelp() {
         "  --write-unfolded-queries <filename>  Outputs the queries to the given file before query reduction but after unfolding\n"
         "  --keep-solved                        Keeps queries reduced to TRUE and FALSE in the output (--write-simplified, --write-unfolded-queries)\n"
         "  --write-reduced <filename>           Outputs the model to the given file after structural reduction\n"
+        "  --write-reduced-binary <filename>    Outputs the model to the given file after structural reduction, in the\n"
+        "                                       binary format read by --binary-model\n"
+        "  --binary-model                       The model file is a P/T net in the binary format of --write-reduced-binary\n"
         "  --write-col-reduced <filename>       Outputs the model to the given file after colored structural reduction\n"
         "  --write-unfolded-net <filename>      Outputs the model to the given file before structural reduction but after unfolding\n"
         "  --binary-query-io <0,1,2,3>          Determines the input/output format of the query-file\n"
@@ -248,6 +280,12 @@ void printHelp() {
         "                                       Using optimization levels above 1 may cause exponential blowups and is not recommended.\n"
         "  --strategy-output <file>             Outputs the synthesized strategy (if a such exist) to <filename>\n"
         "                                           Use '-' (dash) for outputting to standard output.\n"
+        "  --json-results <file>                Also writes each answer to <filename> as a line of JSON, e.g.\n"
+        "                                       {\"index\":0,\"query\":\"Q\",\"result\":true,\"techniques\":[...]}\n"
+        "                                       with \"bound\":<n> instead of \"result\" for upper bounds.\n"
+        "                                       Use '-' (dash) for outputting to standard output.\n"
+        "                                       The file is written uncompressed; traces and strategies keep\n"
+        "                                       their own formats and are not compressed either.\n"
         "\n"
         "Return Values:\n"
         "  0   Successful, query satisfiable\n"
@@ -465,6 +503,8 @@ bool options_t::parse(int argc, const char** argv) {
             }
         } else if (std::strcmp(argv[i], "-p") == 0 || std::strcmp(argv[i], "--disable-partial-order") == 0) {
             stubbornreduction = false;
+        } else if (std::strcmp(argv[i], "--locality-order") == 0) {
+            locality_order = true;
         } else if (std::strcmp(argv[i], "-a") == 0 || std::strcmp(argv[i], "--siphon-trap") == 0) {
             if (i == argc - 1) {
                 throw base_error("Missing number after ", std::quoted(argv[i]));
@@ -502,6 +542,10 @@ bool options_t::parse(int argc, const char** argv) {
             }
         } else if (std::strcmp(argv[i], "--write-reduced") == 0) {
             model_out_file = std::string(argv[++i]);
+        } else if (std::strcmp(argv[i], "--write-reduced-binary") == 0) {
+            model_binary_out_file = std::string(argv[++i]);
+        } else if (std::strcmp(argv[i], "--binary-model") == 0) {
+            binary_model = true;
         } else if (std::strcmp(argv[i], "--write-col-reduced") == 0) {
             model_col_out_file = std::string(argv[++i]);
         } else if (std::strcmp(argv[i], "--write-unfolded-net") == 0) {
@@ -612,11 +656,26 @@ bool options_t::parse(int argc, const char** argv) {
                 ltlHeuristic = LTL::LTLHeuristic::Distance;
             } else if (std::strcmp(argv[i + 1], "fire-count") == 0) {
                 ltlHeuristic = LTL::LTLHeuristic::FireCount;
+            } else if (std::strcmp(argv[i + 1], "potency") == 0) {
+                ltlHeuristic = LTL::LTLHeuristic::Potency;
             } else {
                 throw base_error("Unknown --ltl-heur value ", std::quoted(argv[i+1]));
             }
 
             ++i;
+        } else if (std::strcmp(argv[i], "--ltl-lasso") == 0) {
+            ltl_lasso = true;
+        } else if (std::strcmp(argv[i], "--ltl-share-markings") == 0) {
+            ltl_shared_markings = true;
+        } else if (std::strcmp(argv[i], "--ltl-terminal-reach") == 0) {
+            ltl_terminal_reach = true;
+        } else if (std::strcmp(argv[i], "--ltl-stack-memory") == 0) {
+            if (i == argc - 1) {
+                throw base_error("Missing number after ", std::quoted(argv[i]));
+            }
+            if (sscanf(argv[++i], "%zu", &ltl_stack_memory) != 1 || ltl_stack_memory == 0) {
+                throw base_error("Argument Error: Invalid stack memory limit ", std::quoted(argv[i]));
+            }
         } else if (std::strcmp(argv[i], "-noweak") == 0 || std::strcmp(argv[i], "--noweak") == 0) {
             ltluseweak = false;
         } else if (std::strcmp(argv[i], "-c") == 0 || std::strcmp(argv[i], "--cpn-overapproximation") == 0) {
@@ -631,12 +690,35 @@ bool options_t::parse(int argc, const char** argv) {
             doUnfolding = false;
         } else if (std::strcmp(argv[i], "--disable-symmetry-vars") == 0) {
             symmetricVariables = false;
+        } else if (std::strcmp(argv[i], "--disable-partial-unfolding") == 0) {
+            partialUnfolding = false;
+        } else if (std::strcmp(argv[i], "--disable-state-symmetry") == 0) {
+            stateSymmetry = false;
+        } else if (std::strcmp(argv[i], "--unfold-cache") == 0) {
+            if (argc == i + 1) {
+                throw base_error("Missing argument to --unfold-cache");
+            }
+            unfold_cache = argv[++i];
+        } else if (std::strcmp(argv[i], "--explore-colored") == 0) {
+            exploreColored = true;
+        } else if (std::strcmp(argv[i], "--explore-colored-timeout") == 0) {
+            if (i == argc - 1) {
+                throw base_error("Missing number after ", std::quoted(argv[i]));
+            }
+            if (sscanf(argv[++i], "%d", &exploreColoredTimeout) != 1 || exploreColoredTimeout < 0) {
+                throw base_error("Argument Error: Invalid colored exploration timeout argument ", std::quoted(argv[i]));
+            }
         } else if (std::strcmp(argv[i], "--strategy-output") == 0) {
             if (argc == i + 1) {
                 throw base_error("Missing argument to --strategy-output");
             }
             ++i;
             strategy_output = argv[i];
+        } else if (std::strcmp(argv[i], "--json-results") == 0) {
+            if (argc == i + 1) {
+                throw base_error("Missing argument to --json-results");
+            }
+            json_results_file = argv[++i];
         }
         else if (std::strcmp(argv[i], "-h") == 0 || std::strcmp(argv[i], "--help") == 0) {
             printHelp();
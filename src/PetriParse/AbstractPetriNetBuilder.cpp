@@ -1,6 +1,8 @@
 
 #include "utils/errors.h"
 #include "PetriParse/PNMLParser.h"
+#include "PetriParse/PNMLStreamParser.h"
+#include "utils/mapped_file.h"
 
 #include <fstream>
 #include <iomanip>
@@ -8,24 +10,27 @@
 
 
 namespace PetriEngine {
-    void AbstractPetriNetBuilder::parse_model(const std::string&& model)
+    void AbstractPetriNetBuilder::parse_model(const std::string&& model, uint32_t threads)
     {
         std::ifstream mfile(model, std::ifstream::in);
         if (!mfile) {
             throw base_error("Model file ", std::quoted(model), " could not be opened");
         }
         try {
-            parse_model(mfile);
+            // P/T nets are read straight from the mapped file, colored nets need the DOM built by PNMLParser
+            mapped_file file(model);
+            if (!PNMLStreamParser().parse(file.data(), file.size(), this))
+                parse_model(mfile, threads);
         } catch(const base_error& err) {
             throw base_error("Model file ", std::quoted(model), "\n\t", err.what());
         }
         mfile.close();
     }
 
-    void AbstractPetriNetBuilder::parse_model(std::istream& model)
+    void AbstractPetriNetBuilder::parse_model(std::istream& model, uint32_t threads)
     {
         //Parse and build the petri net
         PNMLParser parser;
-        parser.parse(model, this);
+        parser.parse(model, this, threads);
     }
 }
\ No newline at end of file
@@ -24,10 +24,12 @@
 #include <iostream>
 #include <limits>
 #include <cstring>
+#include <mutex>
 
 
 #include "PetriParse/PNMLParser.h"
 #include "utils/errors.h"
+#include "utils/parallel_for.h"
 #include "PetriEngine/Colored/EvaluationVisitor.h"
 #include "PetriEngine/Colored/ConstantVisitor.h"
 
@@ -36,7 +38,8 @@ using namespace PetriEngine::PQL;
 using namespace PetriEngine::Colored;
 
 void PNMLParser::parse(std::istream& xml,
-        AbstractPetriNetBuilder* builder) {
+        AbstractPetriNetBuilder* builder,
+        uint32_t threads) {
     //Clear any left overs
     id2name.clear();
     arcs.clear();
@@ -72,6 +75,7 @@ void PNMLParser::parse(std::istream& xml,
     }
 
     parseElement(root);
+    parseDeferredExpressions(threads);
 
     //Add all the transition
     for (auto & transition : _transitions)
@@ -132,9 +136,62 @@ void PNMLParser::parse(std::istream& xml,
     arcs.clear();
     _transitions.clear();
     colorTypes.clear();
+    deferred.clear();
+    pool.clear();
     builder->sort();
 }
 
+void PNMLParser::parseDeferredExpressions(uint32_t threads) {
+    // an error is reported for the first failing expression in document order, as when parsed one at a time
+    parallel_for(deferred.size(), threads, [&](size_t i) {
+        const auto& expression = deferred[i];
+        if (expression.guard) {
+            _transitions[expression.index].expr = parseGuardExpression(expression.node, false);
+        } else {
+            auto expr = parseArcExpression(expression.node);
+            if (!arcs[expression.index].inhib)
+                arcs[expression.index].expr = std::move(expr);
+        }
+    });
+}
+
+template<typename K, typename V, typename F>
+V PNMLParser::ExpressionPool::get(std::unordered_map<K, V>& map, const K& key, F&& make) {
+    {
+        std::shared_lock lock(_mutex);
+        auto it = map.find(key);
+        if (it != map.end())
+            return it->second;
+    }
+    // made without the lock, as a sort is made of its colors; if two threads race, the first one wins
+    auto value = make();
+    std::unique_lock lock(_mutex);
+    return map.try_emplace(key, std::move(value)).first->second;
+}
+
+ColorExpression_ptr PNMLParser::ExpressionPool::color(const Color* color) {
+    return get(_colors, color, [&]() -> ColorExpression_ptr { return std::make_shared<UserOperatorExpression>(color); });
+}
+
+ColorExpression_ptr PNMLParser::ExpressionPool::variable(const Variable* variable) {
+    return get(_variables, variable, [&]() -> ColorExpression_ptr { return std::make_shared<VariableExpression>(variable); });
+}
+
+std::vector<ColorExpression_ptr> PNMLParser::ExpressionPool::colors(const ColorType* sort) {
+    return get(_sorts, sort, [&] {
+        std::vector<ColorExpression_ptr> colors;
+        for (auto& c : *sort)
+            colors.emplace_back(color(&c));
+        return colors;
+    });
+}
+
+void PNMLParser::ExpressionPool::clear() {
+    _colors.clear();
+    _variables.clear();
+    _sorts.clear();
+}
+
 void PNMLParser::parseDeclarations(rapidxml::xml_node<>* element) {
     for (auto it = element->first_node(); it; it = it->next_sibling()) {
         if (strcmp(it->name(), "namedsort") == 0) {
@@ -334,7 +391,7 @@ void PNMLParser::collectColorsInTuple(rapidxml::xml_node<>* element, std::vector
         auto constantMap = Colored::ConstantVisitor::get_constants(*expr);
         for (const auto& positionColors : constantMap) {
             for (const auto& color : positionColors.second) {
-                expressionsToAdd.push_back(std::make_shared<UserOperatorExpression>(color));
+                expressionsToAdd.push_back(pool.color(color));
             }
         }
         collectedColors.push_back(expressionsToAdd);
@@ -362,7 +419,7 @@ void PNMLParser::collectColorsInTuple(rapidxml::xml_node<>* element, std::vector
         auto intRangeElement = element->first_node("finiteintrange");
         const char* start = intRangeElement->first_attribute("start")->value();
         const char* end = intRangeElement->first_attribute("end")->value();
-        expressionsToAdd.push_back(std::make_shared<UserOperatorExpression>(findColorForIntRange(value, start, end)));
+        expressionsToAdd.push_back(pool.color(findColorForIntRange(value, start, end)));
         collectedColors.push_back(expressionsToAdd);
     } else if (strcmp(element->name(), "useroperator") == 0 || strcmp(element->name(), "dotconstant") == 0 || strcmp(element->name(), "variable") == 0
             || strcmp(element->name(), "successor") == 0 || strcmp(element->name(), "predecessor") == 0) {
@@ -470,11 +527,12 @@ GuardExpression_ptr PNMLParser::parseGuardExpression(rapidxml::xml_node<>* eleme
 
 std::vector<ColorExpression_ptr> PNMLParser::parseColorExpression(rapidxml::xml_node<>* element) {
     if (strcmp(element->name(), "dotconstant") == 0) {
-        return {std::make_shared<DotConstantExpression>()};
+        return {pool.dot()};
     } else if (strcmp(element->name(), "variable") == 0) {
-        return {std::make_shared<VariableExpression>(variables[element->first_attribute("refvariable")->value()])};
+        auto var = variables.find(element->first_attribute("refvariable")->value());
+        return {pool.variable(var != variables.end() ? var->second : nullptr)};
     } else if (strcmp(element->name(), "useroperator") == 0) {
-        return {std::make_shared<UserOperatorExpression>(findColor(element->first_attribute("declaration")->value()))};
+        return {pool.color(findColor(element->first_attribute("declaration")->value()))};
     } else if (strcmp(element->name(), "successor") == 0) {
         auto expr = parseColorExpression(element->first_node());
         for(auto& e : expr)
@@ -490,7 +548,7 @@ std::vector<ColorExpression_ptr> PNMLParser::parseColorExpression(rapidxml::xml_
         auto intRangeElement = element->first_node("finiteintrange");
         const char* start = intRangeElement->first_attribute("start")->value();
         const char* end = intRangeElement->first_attribute("end")->value();
-        return {std::make_shared<UserOperatorExpression>(findColorForIntRange(value, start, end))};
+        return {pool.color(findColorForIntRange(value, start, end))};
 
     } else if (strcmp(element->name(), "tuple") == 0) {
         std::vector<std::vector<ColorExpression_ptr>> products;
@@ -518,11 +576,7 @@ std::vector<ColorExpression_ptr> PNMLParser::parseColorExpression(rapidxml::xml_
     } else if (strcmp(element->name(), "subterm") == 0 || strcmp(element->name(), "structure") == 0) {
         return parseColorExpression(element->first_node());
     } else if (strcmp(element->name(), "all") == 0) {
-        auto* sort = parseUserSort(element);
-        std::vector<ColorExpression_ptr> colors;
-        for(auto& c : *sort)
-            colors.emplace_back(std::make_shared<UserOperatorExpression>(&c));
-        return colors;
+        return pool.colors(parseUserSort(element));
     }
     throw base_error("Unhandled color type");
     return {};
@@ -542,7 +596,8 @@ const ColorType* PNMLParser::parseUserSort(rapidxml::xml_node<>* element) {
     if (element) {
         for (auto it = element->first_node(); it; it = it->next_sibling()) {
             if (strcmp(it->name(), "usersort") == 0) {
-                return colorTypes[it->first_attribute("declaration")->value()];
+                auto type = colorTypes.find(it->first_attribute("declaration")->value());
+                return type != colorTypes.end() ? type->second : nullptr;
             } else if (strcmp(it->name(), "structure") == 0
                     || strcmp(it->name(), "type") == 0
                     || strcmp(it->name(), "subterm") == 0) {
@@ -746,10 +801,10 @@ void PNMLParser::parseArc(rapidxml::xml_node<>* element, bool inhibitor) {
         }
     }
 
-    ArcExpression_ptr expr;
+    rapidxml::xml_node<>* expr = nullptr;
     first = true;
     for (auto it = element->first_node("hlinscription"); it; it = it->next_sibling("hlinscription")) {
-        expr = parseArcExpression(it->first_node("structure"));
+        expr = it->first_node("structure");
         if(!first)
         {
             throw base_error("Multiple hlinscription tags in xml of a arc from ", source, " to ", target, ".");
@@ -764,12 +819,12 @@ void PNMLParser::parseArc(rapidxml::xml_node<>* element, bool inhibitor) {
     arc.target = target;
     arc.weight = weight;
     arc.inhib = inhibitor;
-    if(!inhibitor)
-        arc.expr = expr;
     assert(weight > 0);
 
     if(weight != 0)
     {
+        if(expr)
+            deferred.push_back({expr, arcs.size(), false});
         arcs.push_back(arc);
     }
     else
@@ -809,13 +864,14 @@ void PNMLParser::parseTransition(rapidxml::xml_node<>* element) {
     t.y = 0;
     t.id = element->first_attribute("id")->value();
     t.expr = nullptr;
+    rapidxml::xml_node<>* guard = nullptr;
 
     for (auto it = element->first_node(); it; it = it->next_sibling()) {
         // name element is ignored
         if (strcmp(it->name(), "graphics") == 0) {
             parsePosition(it, t.x, t.y);
         } else if (strcmp(it->name(), "condition") == 0) {
-            t.expr = parseGuardExpression(it->first_node("structure"), false);
+            guard = it->first_node("structure");
         } else if (strcmp(it->name(), "conditions") == 0) {
             throw base_error("conditions not supported");
         } else if (strcmp(it->name(), "assignments") == 0) {
@@ -836,6 +892,8 @@ void PNMLParser::parseTransition(rapidxml::xml_node<>* element) {
 
 
     //Add transition to list
+    if (guard)
+        deferred.push_back({guard, _transitions.size(), true});
     _transitions.push_back(t);
     //Map id to name
     NodeName nn;
@@ -939,7 +997,7 @@ std::vector<ColorExpression_ptr> PNMLParser::findPartitionColors(rapidxml::xml_n
         if (strcmp(partition.name.c_str(), name) == 0){
             for(auto color : partition.colors){
 
-                colorExpressions.push_back(std::make_shared<UserOperatorExpression>(color));
+                colorExpressions.push_back(pool.color(color));
 
             }
         }
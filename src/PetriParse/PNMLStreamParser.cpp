@@ -0,0 +1,483 @@
+#include "PetriParse/PNMLStreamParser.h"
+#include "utils/errors.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace PetriEngine;
+
+namespace {
+    bool is_space(char c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    void append_utf8(std::string& out, unsigned long code) {
+        if (code < 0x80) {
+            out += (char)code;
+        } else if (code < 0x800) {
+            out += (char)(0xC0 | (code >> 6));
+            out += (char)(0x80 | (code & 0x3F));
+        } else if (code < 0x10000) {
+            out += (char)(0xE0 | (code >> 12));
+            out += (char)(0x80 | ((code >> 6) & 0x3F));
+            out += (char)(0x80 | (code & 0x3F));
+        } else {
+            out += (char)(0xF0 | (code >> 18));
+            out += (char)(0x80 | ((code >> 12) & 0x3F));
+            out += (char)(0x80 | ((code >> 6) & 0x3F));
+            out += (char)(0x80 | (code & 0x3F));
+        }
+    }
+}
+
+bool PNMLStreamParser::parse(const char* data, size_t size, AbstractPetriNetBuilder* builder) {
+    // colored nets have their declarations after the pages in MCC models, so they are looked for up front
+    std::string_view document(data, size);
+    for (auto at = document.find("<declaration"); at != std::string_view::npos; at = document.find("<declaration", at + 1)) {
+        auto after = at + std::strlen("<declaration");
+        if (after == size || is_space(data[after]) || data[after] == '>' || data[after] == '/')
+            return false;
+    }
+
+    _builder = builder;
+    _pos = data;
+    _end = data + size;
+    _open.clear();
+    _ids.clear();
+    _nodes.clear();
+    _decoded.clear();
+    _deferred.clear();
+    _element = element_t::None;
+    _elementDepth = _skipDepth = _positionDepth = _captureDepth = _valueDepth = none;
+    _capture = capture_t::None;
+    _valuePending = false;
+
+    bool root = false;
+    while (next())
+        root = true;
+    if (!root)
+        throw base_error("expecting <pnml> tag as root-node in xml tree.");
+    if (!_open.empty())
+        throw base_error("Unexpected end of PNML document, <", _open.back(), "> is not closed");
+
+    // arcs between nodes that were never declared are reported here
+    for (auto& arc : _deferred)
+        emitArc(arc);
+    _deferred.clear();
+    _builder->sort();
+    _builder = nullptr;
+    return true;
+}
+
+bool PNMLStreamParser::next() {
+    auto lt = static_cast<const char*>(std::memchr(_pos, '<', _end - _pos));
+    // like in rapidxml, the value of an element is its first run of text
+    if (_valuePending && _open.size() == _valueDepth + 1 && lt != _pos) {
+        _captured = decode(std::string_view(_pos, (lt ? lt : _end) - _pos));
+        _valuePending = false;
+    }
+    _pos = lt;
+    if (_pos == nullptr) {
+        _pos = _end;
+        return false;
+    }
+    ++_pos;
+    if (_pos == _end)
+        throw base_error("Unexpected end of PNML document");
+
+    if (*_pos == '?') {
+        skipPast("?>");
+        return true;
+    }
+    if (*_pos == '!') {
+        std::string_view rest(_pos, _end - _pos);
+        if (rest.substr(0, 3) == "!--") {
+            skipPast("-->");
+        } else if (rest.substr(0, 8) == "![CDATA[") {
+            skipPast("]]>");
+        } else {
+            // a document type declaration, possibly with an internal subset
+            int brackets = 0;
+            for (; _pos != _end; ++_pos) {
+                if (*_pos == '[') ++brackets;
+                else if (*_pos == ']') --brackets;
+                else if (*_pos == '>' && brackets <= 0) break;
+            }
+            if (_pos == _end)
+                throw base_error("Unexpected end of PNML document");
+            ++_pos;
+        }
+        return true;
+    }
+    if (*_pos == '/') {
+        ++_pos;
+        auto closing = name();
+        skipPast(">");
+        if (_open.empty() || _open.back() != closing)
+            throw base_error("Unexpected closing tag </", closing, "> in PNML document");
+        _open.pop_back();
+        endElement(_open.size());
+        return true;
+    }
+
+    auto element = name();
+    bool empty = false;
+    _attributes.clear();
+    while (true) {
+        while (_pos != _end && is_space(*_pos))
+            ++_pos;
+        if (_pos == _end)
+            throw base_error("Unexpected end of PNML document");
+        if (*_pos == '>') {
+            ++_pos;
+            break;
+        }
+        if (*_pos == '/') {
+            skipPast(">");
+            empty = true;
+            break;
+        }
+        auto key = name();
+        while (_pos != _end && is_space(*_pos))
+            ++_pos;
+        if (_pos == _end || *_pos != '=')
+            throw base_error("Expected a value for the attribute ", key, " of <", element, ">");
+        ++_pos;
+        while (_pos != _end && is_space(*_pos))
+            ++_pos;
+        if (_pos == _end || (*_pos != '"' && *_pos != '\''))
+            throw base_error("Expected a quoted value for the attribute ", key, " of <", element, ">");
+        auto quote = static_cast<const char*>(std::memchr(_pos + 1, *_pos, _end - _pos - 1));
+        if (quote == nullptr)
+            throw base_error("Unexpected end of PNML document");
+        _attributes.emplace_back(key, std::string_view(_pos + 1, quote - _pos - 1));
+        _pos = quote + 1;
+    }
+
+    const size_t depth = _open.size();
+    if (depth == 0 && element != "pnml")
+        throw base_error("expecting <pnml> tag as root-node in xml tree.");
+    _open.push_back(element);
+    startElement(element, depth, empty);
+    if (empty) {
+        _open.pop_back();
+        endElement(depth);
+    }
+    return true;
+}
+
+void PNMLStreamParser::skipPast(const char* terminator) {
+    std::string_view rest(_pos, _end - _pos);
+    auto at = rest.find(terminator);
+    if (at == std::string_view::npos)
+        throw base_error("Unexpected end of PNML document");
+    _pos += at + std::strlen(terminator);
+}
+
+std::string_view PNMLStreamParser::name() {
+    auto start = _pos;
+    while (_pos != _end && !is_space(*_pos) && *_pos != '>' && *_pos != '/' && *_pos != '=')
+        ++_pos;
+    if (_pos == start)
+        throw base_error("Invalid tag in PNML document");
+    return std::string_view(start, _pos - start);
+}
+
+std::string_view PNMLStreamParser::attribute(const char* name) {
+    for (auto& [key, value] : _attributes)
+        if (key == name)
+            return value;
+    return {};
+}
+
+std::string PNMLStreamParser::decode(std::string_view raw) const {
+    std::string out;
+    out.reserve(raw.size());
+    for (size_t i = 0; i < raw.size(); ++i) {
+        auto semi = raw[i] == '&' ? raw.find(';', i) : std::string_view::npos;
+        if (semi == std::string_view::npos) {
+            out += raw[i];
+            continue;
+        }
+        auto entity = raw.substr(i + 1, semi - i - 1);
+        if (entity == "lt") out += '<';
+        else if (entity == "gt") out += '>';
+        else if (entity == "amp") out += '&';
+        else if (entity == "quot") out += '"';
+        else if (entity == "apos") out += '\'';
+        else if (entity.size() > 1 && entity[0] == '#') {
+            const bool hex = entity[1] == 'x';
+            append_utf8(out, std::strtoul(std::string(entity.substr(hex ? 2 : 1)).c_str(), nullptr, hex ? 16 : 10));
+        } else {
+            // unknown entities are kept as they are
+            out += raw[i];
+            continue;
+        }
+        i = semi;
+    }
+    return out;
+}
+
+void PNMLStreamParser::startElement(std::string_view name, size_t depth, bool empty) {
+    if (_skipDepth != none)
+        return;
+
+    if (_element == element_t::None) {
+        if (name == "place") {
+            startNode(element_t::Place, depth);
+        } else if (name == "transition") {
+            startNode(element_t::Transition, depth);
+        } else if (name == "arc" || name == "inputArc" || name == "outputArc") {
+            startNode(element_t::Arc, depth);
+        } else if (name == "inhibitorArc") {
+            startNode(element_t::Arc, depth);
+            _inhib = true;
+        } else if (name == "transportArc") {
+            startNode(element_t::TransportArc, depth);
+        } else if (name == "variable") {
+            throw base_error("variable not supported");
+        } else if (name == "queries") {
+            _skipDepth = depth;
+        } else if (name == "k-bound") {
+            throw base_error("k-bound should be given as command line option -k");
+        } else if (name == "query") {
+            throw base_error("query tag not supported, please use PQL or XML-style queries instead");
+        }
+        return;
+    }
+
+    // the text of a value is the value of a text or value element within it, and the last of those counts
+    if (_valueDepth != none)
+        return;
+    if (_capture != capture_t::None && (name == "text" || name == "value")) {
+        _captured.clear();
+        _valueDepth = depth;
+        _valuePending = !empty;
+        return;
+    }
+    // the position is looked for along the chain of first children of a graphics element
+    if (_positionDepth != none && depth == _positionDepth + 1) {
+        if (name == "position") {
+            _x = std::atof(decode(attribute("x")).c_str());
+            _y = std::atof(decode(attribute("y")).c_str());
+        }
+        _positionDepth = depth;
+    }
+    if (depth != _elementDepth + 1)
+        return;
+
+    auto capture = [&](capture_t what) {
+        _capture = what;
+        _captureDepth = depth;
+        _captured.clear();
+    };
+    switch (_element) {
+        case element_t::Place:
+            if (name == "graphics")
+                _positionDepth = depth;
+            else if (name == "initialMarking")
+                capture(capture_t::Marking);
+            break;
+        case element_t::Transition:
+            if (name == "graphics") {
+                _positionDepth = depth;
+            } else if (name == "conditions") {
+                throw base_error("conditions not supported");
+            } else if (name == "assignments") {
+                throw base_error("assignments not supported");
+            } else if (name == "player" && !_hasPlayer) {
+                _hasPlayer = true;
+                capture(capture_t::Player);
+            }
+            break;
+        case element_t::Arc:
+            if (name == "inscription" && !_hasWeight)
+                capture(capture_t::Inscription);
+            break;
+        case element_t::TransportArc:
+            if (name == "inscription")
+                capture(capture_t::Inscription);
+            break;
+        case element_t::None:
+            break;
+    }
+}
+
+void PNMLStreamParser::endElement(size_t depth) {
+    if (_skipDepth != none) {
+        if (depth == _skipDepth)
+            _skipDepth = none;
+        return;
+    }
+    if (depth == _valueDepth) {
+        _valueDepth = none;
+        _valuePending = false;
+        return;
+    }
+    if (depth == _positionDepth)
+        _positionDepth = none;
+    if (depth == _captureDepth) {
+        switch (_capture) {
+            case capture_t::Marking:
+                _tokens = std::atoll(_captured.c_str());
+                break;
+            case capture_t::Player:
+                _player = std::atoi(_captured.c_str());
+                break;
+            case capture_t::Inscription:
+                _weight = std::atoi(_captured.c_str());
+                if (_element == element_t::TransportArc)
+                    break;
+                if (std::find_if(_captured.begin(), _captured.end(), [](char c) { return !std::isdigit(c) && !std::isblank(c); }) != _captured.end())
+                {
+                    throw base_error("Found non-integer-text in inscription-tag (weight) on arc from ", _source, " to ", _target, " with value \"", _captured, "\". An integer was expected.");
+                }
+                if (_hasInscription)
+                {
+                    throw base_error("Multiple inscription tags in xml of a arc from ", _source, " to ", _target, ".");
+                }
+                _hasInscription = true;
+                break;
+            case capture_t::None:
+                break;
+        }
+        _capture = capture_t::None;
+        _captureDepth = none;
+        return;
+    }
+    if (depth == _elementDepth)
+        endNode();
+}
+
+void PNMLStreamParser::startNode(element_t element, size_t depth) {
+    _element = element;
+    _elementDepth = depth;
+    _tokens = 0;
+    _x = _y = 0;
+    _player = 0;
+    _weight = 1;
+    _inhib = false;
+    _hasWeight = _hasPlayer = _hasInscription = false;
+
+    switch (element) {
+        case element_t::Place:
+            _id = id("id");
+            if (auto initial = attribute("initialMarking"); initial.data() != nullptr)
+                _tokens = std::atoll(decode(initial).c_str());
+            break;
+        case element_t::Transition:
+            _id = id("id");
+            if (auto player = attribute("player"); player.data() != nullptr)
+                _player = std::atoi(decode(player).c_str());
+            break;
+        case element_t::Arc: {
+            _source = id("source");
+            _target = id("target");
+            auto type = attribute("type");
+            if (type == "timed")
+                throw base_error("timed arcs are not supported");
+            else if (type == "inhibitor")
+                _inhib = true;
+            if (auto weight = attribute("weight"); weight.data() != nullptr) {
+                _hasWeight = true;
+                _weight = std::atoi(decode(weight).c_str());
+            }
+            break;
+        }
+        case element_t::TransportArc:
+            _source = id("source");
+            _transition = id("transition");
+            _target = id("target");
+            break;
+        case element_t::None:
+            break;
+    }
+}
+
+void PNMLStreamParser::endNode() {
+    switch (_element) {
+        case element_t::Place:
+            if (_tokens > std::numeric_limits<uint32_t>::max())
+                throw base_error("Number of tokens in ", _id, " exceeded ", std::numeric_limits<uint32_t>::max());
+            _builder->addPlace(std::string(_id), _tokens, _x, _y);
+            _nodes[node(_id)]._kind = node_kind_t::Place;
+            break;
+        case element_t::Transition:
+            _builder->addTransition(std::string(_id), _player, _x, _y);
+            _nodes[node(_id)]._kind = node_kind_t::Transition;
+            break;
+        case element_t::Arc:
+            if (_weight == 0)
+                throw base_error("Arc from ", _source, " to ", _target, " has non-sensible weight 0.");
+            addArc(node(_source), node(_target), _weight, _inhib);
+            break;
+        case element_t::TransportArc: {
+            const auto transition = node(_transition);
+            addArc(node(_source), transition, _weight, false);
+            addArc(transition, node(_target), _weight, false);
+            break;
+        }
+        case element_t::None:
+            break;
+    }
+    _element = element_t::None;
+    _elementDepth = _positionDepth = _captureDepth = _valueDepth = none;
+    _capture = capture_t::None;
+    _valuePending = false;
+}
+
+uint32_t PNMLStreamParser::node(std::string_view id) {
+    auto [it, inserted] = _ids.emplace(id, _nodes.size());
+    if (inserted)
+        _nodes.push_back(node_t{id, node_kind_t::Unknown});
+    return it->second;
+}
+
+std::string_view PNMLStreamParser::id(const char* name) {
+    auto raw = attribute(name);
+    if (raw.data() == nullptr)
+        throw base_error("Missing attribute ", name, " of <", _open.back(), "> in PNML document");
+    if (raw.find('&') == std::string_view::npos)
+        return raw;
+    // the decoded id must outlive the tag, as it is a key of _ids
+    return _decoded.emplace_back(decode(raw));
+}
+
+void PNMLStreamParser::addArc(uint32_t source, uint32_t target, uint32_t weight, bool inhib) {
+    const arc_t arc{source, target, weight, inhib};
+    if (_nodes[source]._kind == node_kind_t::Unknown || _nodes[target]._kind == node_kind_t::Unknown)
+        _deferred.push_back(arc);
+    else
+        emitArc(arc);
+}
+
+void PNMLStreamParser::emitArc(const arc_t& arc) {
+    const auto& source = _nodes[arc._source];
+    const auto& target = _nodes[arc._target];
+    if (source._kind == node_kind_t::Unknown) {
+        fprintf(stderr,
+                "XML Parsing error: Arc source with id=\"%s\" wasn't found!\n",
+                std::string(source._id).c_str());
+        return;
+    }
+    if (target._kind == node_kind_t::Unknown) {
+        fprintf(stderr,
+                "XML Parsing error: Arc target with id=\"%s\" wasn't found!\n",
+                std::string(target._id).c_str());
+        return;
+    }
+
+    if (source._kind == node_kind_t::Place && target._kind == node_kind_t::Transition) {
+        _builder->addInputArc(std::string(source._id), std::string(target._id), arc._inhib, arc._weight);
+    } else if (source._kind == node_kind_t::Transition && target._kind == node_kind_t::Place) {
+        _builder->addOutputArc(std::string(source._id), std::string(target._id), arc._weight);
+    } else {
+        fprintf(stderr,
+                "XML Parsing error: Arc from \"%s\" to \"%s\" is neither input nor output!\n",
+                std::string(source._id).c_str(),
+                std::string(target._id).c_str());
+    }
+}
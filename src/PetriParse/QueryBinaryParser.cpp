@@ -18,53 +18,105 @@
 
 #include "PetriParse/QueryBinaryParser.h"
 #include "PetriEngine/PQL/Expressions.h"
+#include "PetriEngine/PQL/BinaryPrinter.h"
 
-bool QueryBinaryParser::parse(std::istream& bin, const std::set<size_t>& parse_only) {
-    //Parse the xml
-    uint32_t numq;
-    bin.read(reinterpret_cast<char*>(&numq), sizeof(uint32_t));
-    std::vector<shared_const_string> names;
-    uint32_t nnames;
-    bin.read(reinterpret_cast<char*>(&nnames), sizeof(uint32_t));
-    names.resize(nnames);
+#include <cstring>
+
+bool QueryBinaryParser::parse(const char* data, size_t size, const std::set<size_t>& parse_only) {
+    if(size < sizeof(binary_query_magic) || std::memcmp(data, binary_query_magic, sizeof(binary_query_magic)) != 0)
+        return parseUnindexed(data, size, parse_only);
+    mapped_reader in(data + sizeof(binary_query_magic), size - sizeof(binary_query_magic));
+    uint32_t numq = in.read<uint32_t>();
+    uint32_t nnames = in.read<uint32_t>();
+    _names.assign(nnames, std::string_view());
+    _interned.assign(nnames, nullptr);
     for(uint32_t i = 0; i < nnames; ++i)
     {
-        uint32_t id;
-        bin.read(reinterpret_cast<char*>(&id), sizeof(uint32_t));
-        std::string tmp;
-        std::getline(bin, tmp, '\0');
-        names[id] = *_string_set.emplace(std::make_shared<const_string>(tmp)).first;
+        uint32_t id = in.read<uint32_t>();
+        uint32_t length = in.read<uint32_t>();
+        if(id >= nnames)
+            throw base_error("Invalid place id ", id, " in binary query file");
+        _names[id] = std::string_view(in.bytes(length), length);
     }
 
+    const size_t offsets_size = (size_t(numq) + 1) * sizeof(uint64_t);
+    const char* raw_offsets = in.bytes(offsets_size);
+    std::vector<uint64_t> offsets(size_t(numq) + 1);
+    std::memcpy(offsets.data(), raw_offsets, offsets_size);
+    const char* start = in.bytes(0);
+
     bool parsingOK = true;
     for(uint32_t i = 0; i < numq; ++i)
     {
         queries.emplace_back();
-        std::getline(bin, queries.back().id, '\0');
-        queries.back().query = parseQuery(bin, names);
-        if(queries.back().query == nullptr)
-        {
-            queries.back().parsingResult = QueryItem::UNSUPPORTED_QUERY;
-            parsingOK = false;
-        }
+        if(!parse_only.empty() && parse_only.count(i) == 0)
+            continue;
+        if(offsets[i] > offsets[i + 1] || offsets[i + 1] > size - (start - data))
+            throw base_error("Invalid offset of query ", i, " in binary query file");
+        mapped_reader query(start + offsets[i], offsets[i + 1] - offsets[i]);
+        parsingOK &= parseRecord(query, queries.back());
+    }
+    return parsingOK;
+}
+
+bool QueryBinaryParser::parseUnindexed(const char* data, size_t size, const std::set<size_t>& parse_only) {
+    mapped_reader in(data, size);
+    uint32_t numq = in.read<uint32_t>();
+    uint32_t nnames = in.read<uint32_t>();
+    _names.assign(nnames, std::string_view());
+    _interned.assign(nnames, nullptr);
+    for(uint32_t i = 0; i < nnames; ++i)
+    {
+        uint32_t id = in.read<uint32_t>();
+        if(id >= nnames)
+            throw base_error("Invalid place id ", id, " in binary query file");
+        _names[id] = in.read_cstring();
+    }
+
+    // without offsets, every query has to be decoded to find the next one
+    bool parsingOK = true;
+    for(uint32_t i = 0; i < numq; ++i)
+    {
+        queries.emplace_back();
+        bool ok = parseRecord(in, queries.back());
+        if(!parse_only.empty() && parse_only.count(i) == 0)
+            queries.back() = QueryItem();
         else
-            queries.back().parsingResult = QueryItem::PARSING_OK;
+            parsingOK &= ok;
     }
-    //Release DOM tree
     return parsingOK;
 }
 
-Condition_ptr QueryBinaryParser::parseQuery(std::istream& binary, const std::vector<shared_const_string>& names)
+bool QueryBinaryParser::parseRecord(mapped_reader& in, QueryItem& item) {
+    item.id = in.read_cstring();
+    item.query = parseQuery(in);
+    if(item.query == nullptr)
+    {
+        item.parsingResult = QueryItem::UNSUPPORTED_QUERY;
+        return false;
+    }
+    item.parsingResult = QueryItem::PARSING_OK;
+    return true;
+}
+
+const shared_const_string& QueryBinaryParser::name(uint32_t id)
+{
+    if(id >= _names.size())
+        throw base_error("Unknown place ", id, " in binary query file");
+    if(!_interned[id])
+        _interned[id] = *_string_set.emplace(std::make_shared<const_string>(_names[id])).first;
+    return _interned[id];
+}
+
+Condition_ptr QueryBinaryParser::parseQuery(mapped_reader& in)
 {
-    Path p;
-    binary.read(reinterpret_cast<char*>(&p), sizeof(Path));
-    Quantifier q;
-    binary.read(reinterpret_cast<char*>(&q), sizeof(Quantifier));
+    Path p = in.read<Path>();
+    Quantifier q = in.read<Quantifier>();
     if(p == pError)
     {
         if(q == Quantifier::NEG)
         {
-            auto c = parseQuery(binary, names);
+            auto c = parseQuery(in);
             if(c == nullptr)
             {
                 assert(false);
@@ -78,18 +130,16 @@ Condition_ptr QueryBinaryParser::parseQuery(std::istream& binary, const std::vec
         }
         else if(q == Quantifier::PN_BOOLEAN)
         {
-            bool val;
-            binary.read(reinterpret_cast<char*>(&val), sizeof(bool));
+            bool val = in.read<bool>();
             return BooleanCondition::getShared(val);
         }
         else if(q == Quantifier::AND || q == Quantifier::OR)
         {
-            uint32_t size;
-            binary.read(reinterpret_cast<char*>(&size), sizeof(uint32_t));
+            uint32_t size = in.read<uint32_t>();
             std::vector<Condition_ptr> conds;
             for(uint32_t i = 0; i < size; ++i)
             {
-                conds.push_back(parseQuery(binary, names));
+                conds.push_back(parseQuery(in));
                 if(conds.back() == nullptr) return nullptr;
             }
             if(q == Quantifier::AND)
@@ -99,27 +149,24 @@ Condition_ptr QueryBinaryParser::parseQuery(std::istream& binary, const std::vec
         }
         else if(q == Quantifier::COMPCONJ)
         {
-            bool neg;
-            binary.read(reinterpret_cast<char*>(&neg), sizeof(bool));
+            bool neg = in.read<bool>();
             std::vector<CompareConjunction::cons_t> cons;
-            uint32_t size;
-            binary.read(reinterpret_cast<char*>(&size), sizeof(uint32_t));
+            uint32_t size = in.read<uint32_t>();
             for(uint32_t i = 0; i < size; ++i)
             {
                 cons.emplace_back();
-                binary.read(reinterpret_cast<char*>(&cons.back()._place), sizeof(uint32_t));
-                binary.read(reinterpret_cast<char*>(&cons.back()._lower), sizeof(uint32_t));
-                binary.read(reinterpret_cast<char*>(&cons.back()._upper), sizeof(uint32_t));
-                cons.back()._name = names[cons.back()._place];
+                cons.back()._place = in.read<uint32_t>();
+                cons.back()._lower = in.read<uint32_t>();
+                cons.back()._upper = in.read<uint32_t>();
+                cons.back()._name = name(cons.back()._place);
             }
             return std::make_shared<CompareConjunction>(std::move(cons), neg);
         }
         else if(q == Quantifier::EMPTY)
         {
-            std::string sop;
-            std::getline(binary, sop, '\0');
-            auto e1 = parseExpr(binary, names);
-            auto e2 = parseExpr(binary, names);
+            std::string sop(in.read_cstring());
+            auto e1 = parseExpr(in);
+            auto e2 = parseExpr(in);
             if(e1 == nullptr || e2 == nullptr)
             {
                 assert(false);
@@ -145,19 +192,15 @@ Condition_ptr QueryBinaryParser::parseQuery(std::istream& binary, const std::vec
         }
         else if(q == Quantifier::UPPERBOUNDS)
         {
-            uint32_t size;
-            double max, offset;
-            binary.read(reinterpret_cast<char*>(&size), sizeof(uint32_t));
-            binary.read(reinterpret_cast<char*>(&max), sizeof(double));
-            binary.read(reinterpret_cast<char*>(&offset), sizeof(double));
+            uint32_t size = in.read<uint32_t>();
+            double max = in.read<double>();
+            double offset = in.read<double>();
             std::vector<UnfoldedUpperBoundsCondition::place_t> places;
             for(size_t i = 0; i < size; ++i)
             {
-                uint32_t id;
-                double pmax;
-                binary.read(reinterpret_cast<char*>(&id), sizeof(uint32_t));
-                binary.read(reinterpret_cast<char*>(&pmax), sizeof(double));
-                places.emplace_back(names[id]);
+                uint32_t id = in.read<uint32_t>();
+                double pmax = in.read<double>();
+                places.emplace_back(name(id));
                 places.back()._place = id;
                 places.back()._max = pmax;
             }
@@ -165,7 +208,7 @@ Condition_ptr QueryBinaryParser::parseQuery(std::istream& binary, const std::vec
         }
         else if (q == Quantifier::A || q == Quantifier::E)
         {
-            Condition_ptr cond1 = parseQuery(binary, names);
+            Condition_ptr cond1 = parseQuery(in);
             assert(cond1);
             if (!cond1) return nullptr;
             if (q == Quantifier::A)
@@ -181,7 +224,7 @@ Condition_ptr QueryBinaryParser::parseQuery(std::istream& binary, const std::vec
     }
     else
     {
-        Condition_ptr cond1 = parseQuery(binary, names);
+        Condition_ptr cond1 = parseQuery(in);
         assert(cond1);
         if(!cond1) return nullptr;
         if(p == Path::X)
@@ -213,7 +256,7 @@ Condition_ptr QueryBinaryParser::parseQuery(std::istream& binary, const std::vec
         }
         else if(p == Path::U)
         {
-            auto cond2 = parseQuery(binary, names);
+            auto cond2 = parseQuery(in);
             if(cond2 == nullptr)
             {
                 assert(false);
@@ -240,29 +283,25 @@ Condition_ptr QueryBinaryParser::parseQuery(std::istream& binary, const std::vec
     return nullptr;
 }
 
-Expr_ptr QueryBinaryParser::parseExpr(std::istream& bin, const std::vector<shared_const_string>& names) {
-    char t;
-    bin.read(&t, sizeof(char));
+Expr_ptr QueryBinaryParser::parseExpr(mapped_reader& in) {
+    char t = in.read<char>();
     if(t == 'l')
     {
-        int val;
-        bin.read(reinterpret_cast<char*>(&val), sizeof(int));
+        int val = in.read<int>();
         return std::make_shared<LiteralExpr>(val);
     }
     else if(t == 'i')
     {
-        int offset;
-        bin.read(reinterpret_cast<char*>(&offset), sizeof(int));
-        return std::make_shared<UnfoldedIdentifierExpr>(names[offset], offset);
+        int offset = in.read<int>();
+        return std::make_shared<UnfoldedIdentifierExpr>(name(offset), offset);
     }
     else if(t == '-')
     {
-        uint32_t size;
-        bin.read(reinterpret_cast<char*>(&size), sizeof(uint32_t));
+        uint32_t size = in.read<uint32_t>();
         std::vector<Expr_ptr> exprs;
         for(uint32_t i = 0; i < size; ++i)
         {
-            exprs.push_back(parseExpr(bin, names));
+            exprs.push_back(parseExpr(in));
             if(exprs.back() == nullptr)
             {
                 assert(false);
@@ -273,23 +312,20 @@ Expr_ptr QueryBinaryParser::parseExpr(std::istream& bin, const std::vector<share
     }
     else if(t == '*' || t == '+')
     {
-        int32_t constant;
-        uint32_t idsize;
-        uint32_t exprssize;
-        bin.read(reinterpret_cast<char*>(&constant), sizeof(int32_t));
-        bin.read(reinterpret_cast<char*>(&idsize), sizeof(uint32_t));
-        bin.read(reinterpret_cast<char*>(&exprssize), sizeof(uint32_t));
+        int32_t constant = in.read<int32_t>();
+        uint32_t idsize = in.read<uint32_t>();
+        uint32_t exprssize = in.read<uint32_t>();
         std::vector<uint32_t> ids(idsize);
-        bin.read(reinterpret_cast<char*>(ids.data()), sizeof(uint32_t)*idsize);
+        std::memcpy(ids.data(), in.bytes(sizeof(uint32_t)*idsize), sizeof(uint32_t)*idsize);
         std::vector<Expr_ptr> exprs;
         exprs.push_back(std::make_shared<LiteralExpr>(constant));
         for(auto i : ids)
         {
-            exprs.push_back(std::make_shared<UnfoldedIdentifierExpr>(names[i], i));
+            exprs.push_back(std::make_shared<UnfoldedIdentifierExpr>(name(i), i));
         }
         for(uint32_t i = 0; i < exprssize; ++i)
         {
-            exprs.push_back(parseExpr(bin, names));
+            exprs.push_back(parseExpr(in));
             if(exprs.back() == nullptr)
             {
                 assert(false);
@@ -51,6 +51,8 @@
 #include "PetriEngine/PQL/ColoredUseVisitor.h"
 #include "LTL/LTLValidator.h"
 #include "LTL/Simplification/SpotToPQL.h"
+#include "utils/mapped_file.h"
+#include "utils/output.h"
 
 #include <mutex>
 
@@ -59,21 +61,12 @@ using namespace PetriEngine::PQL;
 using namespace PetriEngine::Reachability;
 
 
-bool reduceColored(ColoredPetriNetBuilder &cpnBuilder, std::vector<std::shared_ptr<PQL::Condition> > &queries,
-                   TemporalLogic logic, uint32_t timeout, std::ostream &out, int reduceMode,
-                   std::vector<uint32_t>& userSequence) {
-    if (!cpnBuilder.isColored()) return false;
-
-    if (reduceMode == 0) {
-        out << "\nSkipping colored structural reductions (-R 0)" << std::endl;
-        out << "Net consists of " << cpnBuilder.getPlaceCount() << " places and " << cpnBuilder.getTransitionCount() << " transitions" << std::endl;
-        return false;
-    }
-
-    ColoredUseVisitor useVisitor(cpnBuilder.colored_placenames(), cpnBuilder.getPlaceCount(),
-                                 cpnBuilder.colored_transitionnames(), cpnBuilder.getTransitionCount());
-    bool preserveLoops = false;
-    bool preserveStutter = false;
+// Collects the colored places and transitions used by the queries and what the colored reductions must preserve
+// for them. Returns false if the queries are neither all CTL nor all LTL.
+static bool coloredQueryUse(const std::vector<std::shared_ptr<PQL::Condition> > &queries, ColoredUseVisitor& useVisitor,
+                            Colored::Reduction::QueryType& queryType, bool& preserveLoops, bool& preserveStutter) {
+    preserveLoops = false;
+    preserveStutter = false;
     bool allReach = true;
     bool allLtl = true;
     bool allCtl = true;
@@ -97,16 +90,33 @@ bool reduceColored(ColoredPetriNetBuilder &cpnBuilder, std::vector<std::shared_p
         }
     }
 
-    if (!allCtl && !allLtl)
+    queryType = allReach ? Colored::Reduction::QueryType::Reach :
+            (allCtl ? Colored::Reduction::QueryType::CTL : Colored::Reduction::QueryType::LTL);
+    return allCtl || allLtl;
+}
+
+bool reduceColored(ColoredPetriNetBuilder &cpnBuilder, std::vector<std::shared_ptr<PQL::Condition> > &queries,
+                   TemporalLogic logic, uint32_t timeout, std::ostream &out, int reduceMode,
+                   std::vector<uint32_t>& userSequence, uint32_t threads) {
+    if (!cpnBuilder.isColored()) return false;
+
+    if (reduceMode == 0) {
+        out << "\nSkipping colored structural reductions (-R 0)" << std::endl;
+        out << "Net consists of " << cpnBuilder.getPlaceCount() << " places and " << cpnBuilder.getTransitionCount() << " transitions" << std::endl;
+        return false;
+    }
+
+    ColoredUseVisitor useVisitor(cpnBuilder.colored_placenames(), cpnBuilder.getPlaceCount(),
+                                 cpnBuilder.colored_transitionnames(), cpnBuilder.getTransitionCount());
+    Colored::Reduction::QueryType queryType;
+    bool preserveLoops, preserveStutter;
+    if (!coloredQueryUse(queries, useVisitor, queryType, preserveLoops, preserveStutter))
     {
         out << "Warning: Could not correctly detect query type in colored reducer" << std::endl;
         return false;
     }
 
-    Colored::Reduction::QueryType queryType = allReach ? Colored::Reduction::QueryType::Reach :
-            (allCtl ? Colored::Reduction::QueryType::CTL : Colored::Reduction::QueryType::LTL);
-
-    Colored::Reduction::ColoredReducer reducer(cpnBuilder);
+    Colored::Reduction::ColoredReducer reducer(cpnBuilder, threads);
     bool anyReduction = reducer.reduce(timeout, useVisitor, queryType, preserveLoops, preserveStutter, reduceMode, userSequence);
 
     auto removedPlacesCount = (int32_t)reducer.origPlaceCount() - (int32_t)reducer.unskippedPlacesCount();
@@ -128,9 +138,79 @@ bool reduceColored(ColoredPetriNetBuilder &cpnBuilder, std::vector<std::shared_p
     return anyReduction;
 }
 
+bool reduceToQueryCone(ColoredPetriNetBuilder &cpnBuilder, const std::vector<std::shared_ptr<PQL::Condition> > &queries,
+                       uint32_t timeout, std::ostream &out) {
+    if (!cpnBuilder.isColored()) return false;
+
+    ColoredUseVisitor useVisitor(cpnBuilder.colored_placenames(), cpnBuilder.getPlaceCount(),
+                                 cpnBuilder.colored_transitionnames(), cpnBuilder.getTransitionCount());
+    Colored::Reduction::QueryType queryType;
+    bool preserveLoops, preserveStutter;
+    if (!coloredQueryUse(queries, useVisitor, queryType, preserveLoops, preserveStutter))
+        return false;
+
+    const auto places = cpnBuilder.unskippedPlacesCount();
+    const auto transitions = cpnBuilder.unskippedTransitionsCount();
+    Colored::Reduction::ColoredReducer reducer(cpnBuilder);
+    if (!reducer.reduceToQueryCone(timeout, useVisitor, queryType, preserveLoops, preserveStutter))
+        return false;
+
+    out << "\nCone of influence of the queries computed in " << reducer.time() << " seconds" << std::endl;
+    out << "Unfolding " << cpnBuilder.unskippedPlacesCount() << " of " << places << " places and " <<
+        cpnBuilder.unskippedTransitionsCount() << " of " << transitions << " transitions" << std::endl;
+    return true;
+}
+
+Colored::UnfoldCache unfoldCache(const ColoredPetriNetBuilder& cpnBuilder, const std::vector<std::shared_ptr<PQL::Condition> >& queries,
+                                 const options_t& options, bool scalar_sets) {
+    Colored::UnfoldCache cache(options.unfold_cache);
+    cache.add_file(options.modelfile);
+    cache.add(options.enablecolreduction);
+    cache.add(options.colreductions);
+    cache.add(options.colReductionTimeout);
+    cache.add(options.computePartition);
+    cache.add(options.partitionTimeout);
+    cache.add(options.symmetricVariables);
+    cache.add(options.computeCFP);
+    cache.add(options.max_intervals);
+    cache.add(options.max_intervals_reduced);
+    cache.add(options.intervalTimeout);
+    cache.add(options.cpnOverApprox);
+    cache.add(options.print_bindings);
+    cache.add(options.partialUnfolding);
+    cache.add(scalar_sets);
+    if (options.enablecolreduction == 0 && !options.partialUnfolding)
+        return cache;
+
+    // the colored reductions (and the cone of influence) only depend on the queries through what they preserve, so any query file with the
+    // same footprint shares the entry
+    ColoredUseVisitor useVisitor(cpnBuilder.colored_placenames(), cpnBuilder.getPlaceCount(),
+                                 cpnBuilder.colored_transitionnames(), cpnBuilder.getTransitionCount());
+    Colored::Reduction::QueryType queryType;
+    bool preserveLoops, preserveStutter;
+    const bool known = coloredQueryUse(queries, useVisitor, queryType, preserveLoops, preserveStutter);
+    cache.add(known);
+    if (known) {
+        cache.add(queryType);
+        cache.add(preserveLoops);
+        cache.add(preserveStutter);
+        cache.add(useVisitor.anyTransitionUsed());
+        std::vector<uint32_t> used;
+        for (uint32_t p = 0; p < cpnBuilder.getPlaceCount(); ++p)
+            if (useVisitor.isPlaceUsed(p)) used.push_back(p);
+        cache.add(used);
+        used.clear();
+        for (uint32_t t = 0; t < cpnBuilder.getTransitionCount(); ++t)
+            if (useVisitor.isTransitionUsed(t)) used.push_back(t);
+        cache.add(used);
+    }
+    return cache;
+}
+
 std::tuple<PetriNetBuilder, shared_name_name_map, shared_place_color_map>
 unfold(ColoredPetriNetBuilder& cpnBuilder, bool compute_partiton, bool compute_symmetry, bool computed_fixed_point,
-    std::ostream& out, int32_t partitionTimeout, int32_t max_intervals, int32_t intervals_reduced, int32_t interval_timeout, bool over_approx, bool print_bindings) {
+    std::ostream& out, int32_t partitionTimeout, int32_t max_intervals, int32_t intervals_reduced, int32_t interval_timeout, bool over_approx, bool print_bindings,
+    uint32_t threads, std::vector<Structures::place_blocks_t>* scalar_sets, const Colored::UnfoldCache* cache) {
     Colored::PartitionBuilder partition(cpnBuilder.transitions(), cpnBuilder.places());
 
     if(!cpnBuilder.isColored())
@@ -146,13 +226,15 @@ unfold(ColoredPetriNetBuilder& cpnBuilder, bool compute_partiton, bool compute_s
 
     Colored::ForwardFixedPoint fixed_point(cpnBuilder, partition);
     if (computed_fixed_point && !over_approx) {
-        fixed_point.compute(max_intervals, intervals_reduced, interval_timeout);
+        fixed_point.compute(max_intervals, intervals_reduced, interval_timeout, threads);
     } else fixed_point.set_default();
 
-    Colored::Unfolder unfolder(cpnBuilder, partition, symmetry, fixed_point, print_bindings);
+    Colored::Unfolder unfolder(cpnBuilder, partition, symmetry, fixed_point, print_bindings, threads);
     if(over_approx)
     {
         auto r = unfolder.strip_colors();
+        if (cache != nullptr)
+            cache->store(r, unfolder.transition_names(), unfolder.place_names(), "", nullptr, unfolder.number_of_arcs());
         return std::make_tuple<PetriNetBuilder, shared_name_name_map, shared_place_color_map>
             (std::move(r),
             shared_name_name_map{unfolder.transition_names()},
@@ -179,8 +261,16 @@ unfold(ColoredPetriNetBuilder& cpnBuilder, bool compute_partiton, bool compute_s
         }
         out << "Unfolded in " << unfolder.time() << " seconds\n" << std::endl;
         
-        unfolder.printBinding();
-        
+        std::stringstream bindings;
+        unfolder.printBinding(bindings);
+        std::cout << bindings.str();
+
+        if (scalar_sets != nullptr)
+            *scalar_sets = unfolder.scalar_sets();
+        if (cache != nullptr)
+            cache->store(r, unfolder.transition_names(), unfolder.place_names(), bindings.str(), scalar_sets,
+                         unfolder.number_of_arcs());
+
         return std::make_tuple<PetriNetBuilder, shared_name_name_map, shared_place_color_map>
             (std::move(r),
             shared_name_name_map{unfolder.transition_names()},
@@ -202,30 +292,10 @@ ReturnValue contextAnalysis(bool colored, const shared_name_name_map& transition
 
 
 
-std::vector<Condition_ptr>
-parseXMLQueries(shared_string_set& string_set, std::vector<std::string>& qstrings, std::istream& qfile, const std::set<size_t>& qnums, bool binary) {
-    std::vector<QueryItem> queries;
+// the conditions of the selected queries, reporting those that could not be parsed
+static std::vector<Condition_ptr>
+selectedConditions(std::vector<QueryItem>& queries, std::vector<std::string>& qstrings, const std::set<size_t>& qnums) {
     std::vector<Condition_ptr> conditions;
-    if (binary) {
-        QueryBinaryParser parser(string_set);
-        if (!parser.parse(qfile, qnums)) {
-            fprintf(stderr, "Error: Failed parsing binary query file\n");
-            fprintf(stdout, "DO_NOT_COMPETE\n");
-            conditions.clear();
-            return conditions;
-        }
-        queries = std::move(parser.queries);
-    } else {
-        QueryXMLParser parser(string_set);
-        if (!parser.parse(qfile, qnums)) {
-            fprintf(stderr, "Error: Failed parsing XML query file\n");
-            fprintf(stdout, "DO_NOT_COMPETE\n");
-            conditions.clear();
-            return conditions;
-        }
-        queries = std::move(parser.queries);
-    }
-
     size_t i = 0;
     for (auto& q : queries) {
         if (!qnums.empty()
@@ -254,6 +324,43 @@ parseXMLQueries(shared_string_set& string_set, std::vector<std::string>& qstring
     return conditions;
 }
 
+static std::vector<Condition_ptr>
+parseBinaryQueries(shared_string_set& string_set, std::vector<std::string>& qstrings, const char* data, size_t size,
+                   const std::set<size_t>& qnums) {
+    QueryBinaryParser parser(string_set);
+    if (!parser.parse(data, size, qnums)) {
+        fprintf(stderr, "Error: Failed parsing binary query file\n");
+        fprintf(stdout, "DO_NOT_COMPETE\n");
+        return {};
+    }
+    return selectedConditions(parser.queries, qstrings, qnums);
+}
+
+std::vector<Condition_ptr>
+parseXMLQueries(shared_string_set& string_set, std::vector<std::string>& qstrings, std::istream& qfile, const std::set<size_t>& qnums, bool binary) {
+    if (binary) {
+        std::string data{std::istreambuf_iterator<char>(qfile), std::istreambuf_iterator<char>()};
+        return parseBinaryQueries(string_set, qstrings, data.data(), data.size(), qnums);
+    }
+    QueryXMLParser parser(string_set);
+    if (!parser.parse(qfile, qnums)) {
+        fprintf(stderr, "Error: Failed parsing XML query file\n");
+        fprintf(stdout, "DO_NOT_COMPETE\n");
+        return {};
+    }
+    return selectedConditions(parser.queries, qstrings, qnums);
+}
+
+std::vector<Condition_ptr>
+parseXMLQueries(shared_string_set& string_set, std::vector<std::string>& qstrings, const std::string& filename, const std::set<size_t>& qnums, bool binary) {
+    if (binary) {
+        mapped_file qfile(filename);
+        return parseBinaryQueries(string_set, qstrings, qfile.data(), qfile.size(), qnums);
+    }
+    std::ifstream qfile(filename, std::ifstream::in);
+    return parseXMLQueries(string_set, qstrings, qfile, qnums, false);
+}
+
 std::vector<Condition_ptr >
 readQueries(shared_string_set& string_set, options_t& options, std::vector<std::string>& qstrings) {
 
@@ -280,7 +387,7 @@ readQueries(shared_string_set& string_set, options_t& options, std::vector<std::
                 throw base_error("Error parsing: ", qstrings.back());
             conditions.emplace_back(q);
         } else {
-            conditions = parseXMLQueries(string_set, qstrings, qfile, options.querynumbers, options.binary_query_io & 1);
+            conditions = parseXMLQueries(string_set, qstrings, options.queryfile, options.querynumbers, options.binary_query_io & 1);
         }
         qfile.close();
         return conditions;
@@ -318,8 +425,12 @@ void writeQueries(const std::vector<std::shared_ptr<Condition>>&queries, std::ve
     std::string& filename, bool binary, const shared_name_index_map& place_names, bool keep_solved, bool compact) {
     std::fstream out;
 
+    // the queries of a binary file are written to memory first, as the offsets of them precede them
+    std::stringstream body;
+    std::vector<uint64_t> offsets{0};
     if (binary) {
         out.open(filename, std::ios::binary | std::ios::out);
+        out.write(binary_query_magic, sizeof (binary_query_magic));
         uint32_t cnt = 0;
         for (uint32_t j = 0; j < queries.size(); j++) {
             if ((queries[j]->isTriviallyTrue() || queries[j]->isTriviallyFalse()) && !keep_solved) continue;
@@ -329,9 +440,10 @@ void writeQueries(const std::vector<std::shared_ptr<Condition>>&queries, std::ve
         cnt = place_names.size();
         out.write(reinterpret_cast<const char *> (&cnt), sizeof (uint32_t));
         for (auto& kv : place_names) {
+            uint32_t length = kv.first->size();
             out.write(reinterpret_cast<const char *> (&kv.second), sizeof (uint32_t));
-            out.write(kv.first->data(), kv.first->size());
-            out.write("\0", sizeof (char));
+            out.write(reinterpret_cast<const char *> (&length), sizeof (uint32_t));
+            out.write(kv.first->data(), length);
         }
     } else {
         out.open(filename, std::ios::out);
@@ -342,17 +454,22 @@ void writeQueries(const std::vector<std::shared_ptr<Condition>>&queries, std::ve
         auto i = order[j];
         if ((queries[i]->isTriviallyTrue() || queries[i]->isTriviallyFalse()) && !keep_solved) continue;
         if (binary) {
-            out.write(querynames[i].data(), querynames[i].size());
-            out.write("\0", sizeof (char));
-            BinaryPrinter binary_printer(out);
+            body.write(querynames[i].data(), querynames[i].size());
+            body.write("\0", sizeof (char));
+            BinaryPrinter binary_printer(body);
             Visitor::visit(binary_printer, queries[i]);
+            offsets.push_back(body.tellp());
         } else {
             XMLPrinter xml_printer(out, compact ? 0 : 3, compact ? 0 : 2, !compact);
             xml_printer.print(*queries[i], querynames[i]);
         }
     }
 
-    if (binary == 0) {
+    if (binary) {
+        out.write(reinterpret_cast<const char *> (offsets.data()), offsets.size() * sizeof (uint64_t));
+        if (offsets.size() > 1)
+            out << body.rdbuf();
+    } else {
         out << "</property-set>\n";
     }
     out.close();
@@ -538,13 +655,12 @@ void simplify_queries(const MarkVal* marking,
         std::atomic<uint32_t> cnt(0);
 #ifdef VERIFYPN_MC_Simplification
         std::vector<std::thread> threads;
-        std::mutex out_lock;
+        ordered_output ordered(outstream);
 #endif
         uint32_t old = to_handle;
         for (size_t c = 0; c < std::min<uint32_t>(options.cores, old); ++c) {
 #ifdef VERIFYPN_MC_Simplification
             threads.push_back(std::thread([&, c]() {
-            std::stringstream out;
 #else
             auto simplify = [&, c]() {
 
@@ -555,6 +671,10 @@ void simplify_queries(const MarkVal* marking,
                 while (true) {
                     auto i = cnt++;
                     if (i >= queries.size()) return;
+#ifdef VERIFYPN_MC_Simplification
+                    // passed on when the query is done with, in the order of the queries
+                    ordered_output::block out(ordered, i);
+#endif
                     if (!hadTo[i]) continue;
                     hadTo[i] = false;
                     negstat_t stats;
@@ -579,12 +699,6 @@ void simplify_queries(const MarkVal* marking,
                             options.lpsolveTimeout, &cache);
                         queries[i] = simplify_ltl_query(queries[i], options,
                             context, simplificationContext, out);
-#ifdef VERIFYPN_MC_Simplification
-                        out_lock.lock();
-                        outstream << out.str();
-                        out.clear();
-                        out_lock.unlock();
-#endif
                         continue;
                     }
                     queries[i] = pushNegation(initialMarkingRW([&]() {
@@ -648,12 +762,6 @@ void simplify_queries(const MarkVal* marking,
                         double redPerc = preSize - postSize == 0 ? 0 : ((double) (preSize - postSize) / (double) preSize)*100;
                         out << "Query size reduced from " << preSize << " to " << postSize << " nodes ( " << redPerc << " percent reduction).\n";
                     }
-#ifdef VERIFYPN_MC_Simplification
-                    out_lock.lock();
-                    outstream << out.str();
-                    out.clear();
-                    out_lock.unlock();
-#endif
                 }
             }
 #ifdef VERIFYPN_MC_Simplification
@@ -695,13 +803,12 @@ void initialize_potency(const MarkVal* marking,
         std::atomic<uint32_t> cnt(0);
 #ifdef VERIFYPN_MC_Simplification
         std::vector<std::thread> threads;
-        std::mutex out_lock;
+        ordered_output ordered(outstream);
 #endif
         uint32_t old = to_handle;
         for (size_t c = 0; c < std::min<uint32_t>(options.cores, old); ++c) {
 #ifdef VERIFYPN_MC_Simplification
             threads.push_back(std::thread([&, c]() {
-            std::stringstream out;
 #else
             auto initPot = [&, c]() {
 
@@ -712,6 +819,10 @@ void initialize_potency(const MarkVal* marking,
                 while (true) {
                     auto i = cnt++;
                     if (i >= queries.size()) return;
+#ifdef VERIFYPN_MC_Simplification
+                    // passed on when the query is done with, in the order of the queries
+                    ordered_output::block out(ordered, i);
+#endif
                     if (!hadTo[i]) continue;
                     hadTo[i] = false;
 
@@ -750,13 +861,6 @@ void initialize_potency(const MarkVal* marking,
                     } else if (options.printstatistics == StatisticsLevel::Full) {
                         out << "Skipping potency initialization" << std::endl;
                     }
-
-#ifdef VERIFYPN_MC_Simplification
-                    out_lock.lock();
-                    outstream << out.str();
-                    out.clear();
-                    out_lock.unlock();
-#endif
                 }
             }
 #ifdef VERIFYPN_MC_Simplification
@@ -46,10 +46,12 @@
 
 
 #include <PetriEngine/Colored/PnmlWriter.h>
+#include "PetriEngine/Colored/ColoredExplorer.h"
 #include "VerifyPN.h"
 #include "PetriEngine/Synthesis/SimpleSynthesis.h"
 #include "LTL/LTLSearch.h"
 #include "PetriEngine/PQL/PQL.h"
+#include "utils/output.h"
 
 using namespace PetriEngine;
 using namespace PetriEngine::PQL;
@@ -71,9 +73,22 @@ int main(int argc, const char** argv) {
         }
         options.print();
 
+        std::unique_ptr<std::ofstream> json_file;
+        if (options.json_results_file == "-") {
+            options.json_results = &std::cout;
+        } else if (!options.json_results_file.empty()) {
+            json_file = std::make_unique<std::ofstream>(options.json_results_file);
+            if (!*json_file)
+                throw base_error("Could not open ", options.json_results_file, " for writing");
+            options.json_results = json_file.get();
+        }
+
         ColoredPetriNetBuilder cpnBuilder(string_set);
         try {
-            cpnBuilder.parse_model(options.modelfile);
+            if (options.binary_model)
+                cpnBuilder.parse_binary_model(options.modelfile);
+            else
+                cpnBuilder.parse_model(options.modelfile, options.cores);
             options.isCPN = cpnBuilder.isColored(); // TODO: this is really nasty, should be moved in a refactor
         } catch (const base_error &err) {
             throw base_error("CANNOT_COMPUTE\nError parsing the model\n", err.what());
@@ -142,7 +157,19 @@ int main(int argc, const char** argv) {
 
         std::stringstream ss;
         std::ostream& out = options.printstatistics == StatisticsLevel::Full ? std::cout : ss;
-        reduceColored(cpnBuilder, queries, options.logic, options.colReductionTimeout, out, options.enablecolreduction, options.colreductions);
+        // symmetries of the scalar-set color types, verified on the final net before the reachability search
+        const bool state_symmetry = options.stateSymmetry && options.trace == TraceLevel::None;
+        std::optional<Colored::UnfoldCache> unfold_cache;
+        if (!options.unfold_cache.empty() && cpnBuilder.isColored() && options.doUnfolding)
+            unfold_cache.emplace(unfoldCache(cpnBuilder, queries, options, state_symmetry));
+        auto cached = unfold_cache ? unfold_cache->load(string_set) : std::nullopt;
+
+        // the reduced colored net is still needed to write it or to explore it
+        if (!cached || options.model_col_out_file.size() > 0 || options.exploreColored) {
+            reduceColored(cpnBuilder, queries, options.logic, options.colReductionTimeout, out, options.enablecolreduction, options.colreductions, options.cores);
+            if (options.partialUnfolding)
+                reduceToQueryCone(cpnBuilder, queries, options.colReductionTimeout, out);
+        }
 
         if (options.model_col_out_file.size() > 0) {
             std::fstream file;
@@ -151,18 +178,61 @@ int main(int argc, const char** argv) {
             writer.toColPNML();
         }
 
+        // queries answered on the colored net keep their index, they are replaced by their answer and not printed again
+        std::vector<ResultPrinter::Result> results(queries.size(), ResultPrinter::Unknown);
+        if (options.exploreColored && cpnBuilder.isColored() && !options.cpnOverApprox && !options.statespaceexploration) {
+            Colored::ColoredExplorer explorer(cpnBuilder);
+            ResultPrinter colored_printer(nullptr, &options, querynames);
+            colored_printer.setColoredExploration(true);
+            // the queries share one time budget, those not decided in time are unfolded
+            const auto start = std::chrono::high_resolution_clock::now();
+            for (size_t qid = 0; qid < queries.size(); ++qid) {
+                if (!explorer.supports(queries[qid]))
+                    continue;
+                const auto elapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+                auto result = explorer.check(queries[qid], options.strategy, options.trace != TraceLevel::None,
+                                             options.exploreColoredTimeout - elapsed);
+                out << "Colored exploration discovered " << explorer.discovered() << " markings and fired "
+                    << explorer.explored() << " bindings\n" << std::endl;
+                if (result == Colored::ColoredExplorer::Result::Unknown)
+                    continue;
+                const bool satisfied = result == Colored::ColoredExplorer::Result::Satisfied;
+                queries[qid] = satisfied ? BooleanCondition::TRUE_CONSTANT : BooleanCondition::FALSE_CONSTANT;
+                // the witness, if any, was printed by the explorer
+                results[qid] = colored_printer.handle(qid, queries[qid].get(),
+                    satisfied ? ResultPrinter::Satisfied : ResultPrinter::NotSatisfied,
+                    nullptr, 0, 0, 0, 0, nullptr, 0, nullptr, false).first;
+                if (options.printstatistics == StatisticsLevel::Full)
+                    std::cout << "Query solved by Colored Exploration.\n" << std::endl;
+            }
+            if (std::find(results.begin(), results.end(), ResultPrinter::Unknown) == results.end())
+                return to_underlying(ReturnValue::SuccessCode);
+        }
+
         if (!options.doUnfolding) {
             return 0;
         }
 
-        auto [builder, transition_names, place_names] = unfold(cpnBuilder,
-            options.computePartition, options.symmetricVariables,
-            options.computeCFP, out,
-            options.partitionTimeout, options.max_intervals, options.max_intervals_reduced,
-            options.intervalTimeout, options.cpnOverApprox, options.print_bindings);
+        std::vector<Structures::place_blocks_t> scalar_sets;
+        if (cached) {
+            out << "Size of unfolded net: " <<
+                cached->_builder.numberOfPlaces() << " places, " <<
+                cached->_builder.numberOfTransitions() << " transitions, and " <<
+                cached->_arcs << " arcs" << std::endl;
+            out << "Unfolded net loaded from " << unfold_cache->path() << "\n" << std::endl;
+            std::cout << cached->_bindings;
+            scalar_sets = std::move(cached->_scalar_sets);
+        }
+        auto [builder, transition_names, place_names] = cached
+            ? std::make_tuple(std::move(cached->_builder), std::move(cached->_transition_names), std::move(cached->_place_names))
+            : unfold(cpnBuilder,
+                options.computePartition, options.symmetricVariables,
+                options.computeCFP, out,
+                options.partitionTimeout, options.max_intervals, options.max_intervals_reduced,
+                options.intervalTimeout, options.cpnOverApprox, options.print_bindings, options.cores,
+                state_symmetry ? &scalar_sets : nullptr, unfold_cache ? &*unfold_cache : nullptr);
 
         builder.sort();
-        std::vector<ResultPrinter::Result> results(queries.size(), ResultPrinter::Result::Unknown);
         ResultPrinter printer(&builder, &options, querynames);
 
         if (options.unfolded_out_file.size() > 0) {
@@ -227,7 +297,10 @@ int main(int argc, const char** argv) {
 
             if (!options.statespaceexploration) {
                 for (size_t i = 0; i < queries.size(); ++i) {
-                    if (queries[i]->isTriviallyTrue()) {
+                    if (results[i] != ResultPrinter::Unknown) {
+                        // answered by colored exploration
+                        continue;
+                    } else if (queries[i]->isTriviallyTrue()) {
                         if(initial_marking_solved.count(i) > 0 && options.trace != TraceLevel::None)
                         {
                             // we misuse the implementation to make sure we print the empty-trace
@@ -281,7 +354,7 @@ int main(int argc, const char** argv) {
                     }
                 }
 
-                if (alldone && options.model_out_file.size() == 0)
+                if (alldone && options.model_out_file.size() == 0 && options.model_binary_out_file.size() == 0)
                     return to_underlying(ReturnValue::SuccessCode);
             }
         }
@@ -300,13 +373,13 @@ int main(int argc, const char** argv) {
             // Compute structural reductions
             builder.startTimer();
             builder.reduce(queries, results, options.enablereduction, options.trace != TraceLevel::None, nullptr,
-                           options.reductionTimeout, options.reductions);
+                           options.reductionTimeout, options.reductions, options.cores);
             printer.setReducer(builder.getReducer());
         }
 
         printStats(builder, options);
 
-        auto net = std::unique_ptr<PetriNet>(builder.makePetriNet());
+        auto net = std::unique_ptr<PetriNet>(builder.makePetriNet(true, options.locality_order));
 
         if (options.model_out_file.size() > 0) {
             std::fstream file;
@@ -314,6 +387,13 @@ int main(int argc, const char** argv) {
             net->toXML(file);
         }
 
+        if (options.model_binary_out_file.size() > 0) {
+            std::ofstream file(options.model_binary_out_file, std::ios::binary);
+            BinaryNet::write(*net, file);
+            if (!file)
+                throw base_error("Could not write the model to ", options.model_binary_out_file);
+        }
+
         if (alldone)
             return to_underlying(ReturnValue::SuccessCode);
 
@@ -405,30 +485,64 @@ int main(int argc, const char** argv) {
             if (!ltl_ids.empty() && options.ltlalgorithm != LTL::Algorithm::None) {
                 options.usedltl = true;
 
+                // one marking graph for all formulae; each formula only adds its own product layer on top.
+                std::unique_ptr<LTL::Structures::MarkingGraph> marking_graph;
+                if (options.ltl_shared_markings)
+                    marking_graph = std::make_unique<LTL::Structures::MarkingGraph>(*net, options.kbound);
+
                 for (auto qid : ltl_ids) {
                     LTL::LTLSearch search(*net, queries[qid], options.buchiOptimization, options.ltl_compress_aps);
+                    search.set_marking_graph(marking_graph.get());
+                    search.set_stack_memory(options.ltl_stack_memory * 1024 * 1024);
+                    if (options.ltlHeuristic == LTL::LTLHeuristic::Potency && options.initPotencyTimeout > 0) {
+                        // seed from the formula the Büchi automaton accepts, so that the LPs steer towards
+                        // a counterexample; the time budget is shared between the LTL queries.
+                        std::vector<Condition_ptr> potency_queries{search.searched_formula()};
+                        std::vector<MarkVal> potencies(net->numberOfTransitions(), 0);
+                        std::unique_ptr<MarkVal[]> qm0(net->makeInitialMarking());
+                        auto potency_options = options;
+                        potency_options.initPotencyTimeout = std::max<int>(1, options.initPotencyTimeout / static_cast<int>(ltl_ids.size()));
+                        try {
+                            initialize_potency(qm0.get(), net.get(), potency_queries, potency_options, std::cout, potencies);
+                            search.set_initial_potencies(std::move(potencies));
+                        } catch (const base_error&) {
+                            // formula outside the fragment handled by the potency LPs; learn from scratch.
+                        }
+                    }
                     auto res = search.solve(options.trace != TraceLevel::None, options.kbound,
                         options.ltlalgorithm, options.stubbornreduction ? options.ltl_por : LTL::LTLPartialOrder::None,
-                        options.strategy, options.ltlHeuristic, options.ltluseweak, options.seed_offset);
+                        options.strategy, options.ltlHeuristic, options.ltluseweak, options.seed_offset, options.ltl_lasso,
+                        options.ltl_terminal_reach);
 
                     if(options.printstatistics != StatisticsLevel::None)
                         search.print_stats(std::cout);
 
-                    std::cout << "FORMULA " << querynames[qid]
-                        << (res ? " TRUE" : " FALSE") << " TECHNIQUES EXPLICIT "
-                        << LTL::to_string(options.ltlalgorithm)
-                        << (search.is_weak() ? " WEAK_SKIP" : "")
-                        << (search.used_partial_order() != LTL::LTLPartialOrder::None ? " STUBBORN" : "")
-                        << (search.used_partial_order() == LTL::LTLPartialOrder::Visible ? " CLASSIC_STUB" : "")
-                        << (search.used_partial_order() == LTL::LTLPartialOrder::Automaton ? " AUT_STUB" : "")
-                        << (search.used_partial_order() == LTL::LTLPartialOrder::Liebke ? " LIEBKE_STUB" : "");
-                    auto heur = search.heuristic_type();
-                    if (!heur.empty())
-                        std::cout << " HEURISTIC " << heur;
-                    std::cout << " OPTIM-" << to_underlying(options.buchiOptimization) << std::endl;
-
-                    std::cout << "\nQuery index " << qid << " was solved\n";
-                    std::cout << "Query is " << (res ? "" : "NOT ") << "satisfied." << std::endl;
+                    {
+                        std::string techniques = std::string("EXPLICIT ") + LTL::to_string(options.ltlalgorithm)
+                            + (search.is_weak() ? " WEAK_SKIP" : "")
+                            + (search.used_terminal_reach() ? " TERMINAL_REACH" : "")
+                            + (search.used_partial_order() != LTL::LTLPartialOrder::None ? " STUBBORN" : "")
+                            + (search.used_partial_order() == LTL::LTLPartialOrder::Visible ? " CLASSIC_STUB" : "")
+                            + (search.used_partial_order() == LTL::LTLPartialOrder::Automaton ? " AUT_STUB" : "")
+                            + (search.used_partial_order() == LTL::LTLPartialOrder::Liebke ? " LIEBKE_STUB" : "");
+                        auto heur = search.heuristic_type();
+                        if (!heur.empty())
+                            techniques += " HEURISTIC " + heur;
+                        techniques += " OPTIM-" + std::to_string(to_underlying(options.buchiOptimization));
+
+                        buffered_output out(std::cout);
+                        out << "FORMULA " << querynames[qid]
+                            << (res ? " TRUE" : " FALSE") << " TECHNIQUES " << techniques << "\n";
+
+                        out << "\nQuery index " << qid << " was solved\n";
+                        out << "Query is " << (res ? "" : "NOT ") << "satisfied.\n";
+
+                        if (options.json_results != nullptr) {
+                            json_record record(*options.json_results);
+                            record.number("index", qid).string("query", querynames[qid]).boolean("result", res)
+                                .words("techniques", techniques);
+                        }
+                    }
 
                     if(options.trace != TraceLevel::None)
                         search.print_trace(std::cerr, *builder.getReducer());
@@ -514,6 +628,22 @@ int main(int argc, const char** argv) {
             } else {
                 ReachabilitySearch strategy(*net, printer, options.kbound);
 
+                std::unique_ptr<Structures::StateSymmetry> symmetry;
+                if (!scalar_sets.empty()) {
+                    std::vector<Condition_ptr> open_queries;
+                    for (size_t i = 0; i < queries.size(); ++i) {
+                        if (results[i] == ResultPrinter::Unknown)
+                            open_queries.push_back(queries[i]);
+                    }
+                    symmetry = std::make_unique<Structures::StateSymmetry>(*net, scalar_sets, open_queries);
+                    if (options.printstatistics == StatisticsLevel::Full) {
+                        std::cout << "State symmetry: " << symmetry->size() << " of " << scalar_sets.size()
+                                  << " scalar sets preserve the net and the queries" << std::endl;
+                    }
+                    if (!symmetry->empty())
+                        strategy.setSymmetry(symmetry.get());
+                }
+
                 // Change default place-holder to default strategy
                 if (options.strategy == Strategy::DEFAULT) options.strategy = Strategy::HEUR;
 